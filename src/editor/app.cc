@@ -1,8 +1,14 @@
 ﻿#include "editor/app.h"
 #include "wx/stdpaths.h"
 #include "wx/filefn.h"
+#include "wx/evtloop.h"
 #include "editor/main_frame.h"
 #include "editor/config.h"
+#include "editor/latency_tracker.h"
+#include "editor/line_index.h"
+#include "editor/symbol_index.h"
+#include "editor/text_file.h"
+#include "editor/trace.h"
 
 namespace editor {
 
@@ -10,6 +16,10 @@ DECLARE_APP(App);
 IMPLEMENT_APP(App);
 
 const wxString kFilePath = wxT("/config.xml");
+const wxString kLatencyFilePath = wxT("/latency.json");
+const wxString kSessionFilePath = wxT("/session.xml");
+const wxString kLineIndexDir = wxT("/line_index");
+const wxString kSymbolIndexDir = wxT("/symbol_index");
 
 bool App::OnInit() {
   wxApp::OnInit();
@@ -25,16 +35,35 @@ bool App::OnInit() {
   file_path = file_path + kFilePath;
   config_ = new Config();
   config_->LoadFile(file_path);
+  LineIndex::SetCacheDir(paths.GetUserDataDir() + kLineIndexDir);
+  SymbolIndex::SetCacheDir(paths.GetUserDataDir() + kSymbolIndexDir);
+  const unsigned long long kMb = 1024 * 1024;
+  TextFile::SetPagedLimits(config_->paged_file_size_mb_ * kMb, static_cast<size_t>(config_->page_cache_mb_ * kMb));
 
-  MainFrame* frame = new MainFrame(config_);
-  frame->Create(NULL, wxID_ANY, wxT("Text Editor"));
-  frame->Show();
+  main_frame_ = new MainFrame(config_);
+  main_frame_->Create(NULL, wxID_ANY, wxT("Text Editor"));
+  main_frame_->RestoreSession(paths.GetUserDataDir() + kSessionFilePath);
+  main_frame_->Show();
 
   return true;
 }
 
+void App::OnEventLoopEnter(wxEventLoopBase* loop) {
+  if (loop->IsMain() && main_frame_ != NULL) {
+    main_frame_->CreateFileWatcher();
+  }
+}
+
+void App::HandleEvent(wxEvtHandler* handler, wxEventFunction func, wxEvent& event) const {
+  TRACE_SCOPE("App::HandleEvent");
+  wxApp::HandleEvent(handler, func, event);
+}
+
 int App::OnExit() {
   wxApp::OnExit();
+  if (LatencyTracker::Get().total_count() != 0) {
+    LatencyTracker::Get().WriteJson(wxStandardPaths::Get().GetUserDataDir() + kLatencyFilePath);
+  }
   delete config_;
   return 0;
 }
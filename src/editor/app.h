@@ -7,14 +7,25 @@
 namespace editor {
 
 class Config;
+class MainFrame;
 
 class App : public wxApp {
 public:
   virtual bool OnInit() override;
   virtual int OnExit() override;
 
+  // The file watcher of the frame needs a running event loop.
+  virtual void OnEventLoopEnter(wxEventLoopBase* loop) override;
+
+  // Every event handler is called through it, so it's where the time spent
+  // in the handlers is traced.
+  virtual void HandleEvent(wxEvtHandler* handler,
+                           wxEventFunction func,
+                           wxEvent& event) const override;
+
 private:
   Config* config_;
+  MainFrame* main_frame_;
 };
 
 }  // namespace editor
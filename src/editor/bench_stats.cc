@@ -0,0 +1,139 @@
+#include "editor/bench_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace editor {
+
+static double NowMicros() {
+  typedef std::chrono::steady_clock Clock;
+  return std::chrono::duration<double, std::micro>(Clock::now().time_since_epoch()).count();
+}
+
+static void WriteJsonString(std::ostream& os, const std::string& str) {
+  os << '"';
+  for (char ch : str) {
+    if (ch == '"' || ch == '\\') {
+      os << '\\';
+    }
+    os << ch;
+  }
+  os << '"';
+}
+
+// BenchTimer
+
+BenchTimer::BenchTimer() : start_(NowMicros()) {
+}
+
+void BenchTimer::Restart() {
+  start_ = NowMicros();
+}
+
+double BenchTimer::ElapsedMicros() const {
+  return NowMicros() - start_;
+}
+
+// BenchStats
+
+BenchStats::BenchStats(const std::string& name)
+    : name_(name),
+      is_sorted_(true),
+      units_(0),
+      unit_name_("ops"),
+      peak_rss_kb_(0) {
+}
+
+void BenchStats::AddSample(double micros) {
+  samples_.push_back(micros);
+  is_sorted_ = false;
+}
+
+// The nearest-rank percentile.
+double BenchStats::Percentile(double percent) const {
+  if (samples_.empty()) {
+    return 0;
+  }
+  if (!is_sorted_) {
+    std::vector<double>& samples = const_cast<std::vector<double>&>(samples_);
+    std::sort(samples.begin(), samples.end());
+    is_sorted_ = true;
+  }
+  size_t rank = static_cast<size_t>(std::ceil(percent / 100 * samples_.size()));
+  return samples_[rank == 0 ? 0 : rank - 1];
+}
+
+double BenchStats::TotalMicros() const {
+  double total = 0;
+  for (double sample : samples_) {
+    total += sample;
+  }
+  return total;
+}
+
+void BenchStats::WriteJson(std::ostream& os) const {
+  double total = TotalMicros();
+  size_t units = units_ != 0 ? units_ : samples_.size();
+  double throughput = total > 0 ? units * 1e6 / total : 0;
+
+  os << "{\"name\": ";
+  WriteJsonString(os, name_);
+  os << ", \"ops\": " << samples_.size()
+     << ", \"p50_us\": " << Percentile(50)
+     << ", \"p99_us\": " << Percentile(99)
+     << ", \"max_us\": " << Percentile(100)
+     << ", \"total_ms\": " << total / 1000
+     << ", \"throughput\": " << throughput
+     << ", \"unit\": ";
+  WriteJsonString(os, unit_name_ + "/s");
+  os << ", \"peak_rss_kb\": " << peak_rss_kb_ << "}";
+}
+
+// BenchReport
+
+BenchReport::BenchReport(const std::string& name) : name_(name) {
+}
+
+void BenchReport::AddCase(const BenchStats& stats) {
+  cases_.push_back(stats);
+  cases_.back().peak_rss_kb_ = GetPeakRssKb();
+}
+
+void BenchReport::WriteJson(std::ostream& os) const {
+  os << "{\"benchmark\": ";
+  WriteJsonString(os, name_);
+  os << ", \"peak_rss_kb\": " << GetPeakRssKb() << ", \"cases\": [";
+  for (size_t i = 0; i < cases_.size(); ++i) {
+    os << (i == 0 ? "\n  " : ",\n  ");
+    cases_[i].WriteJson(os);
+  }
+  os << "\n]}\n";
+}
+
+size_t GetPeakRssKb() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return 0;
+  }
+  return counters.PeakWorkingSetSize / 1024;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#if defined(__APPLE__)
+  return usage.ru_maxrss / 1024;  // In bytes on macOS.
+#else
+  return usage.ru_maxrss;
+#endif
+#endif
+}
+
+}  // namespace editor
@@ -0,0 +1,76 @@
+#ifndef EDITOR_BENCH_STATS_H_
+#define EDITOR_BENCH_STATS_H_
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace editor {
+
+// Measures the wall time in microseconds.
+class BenchTimer {
+public:
+  BenchTimer();
+
+  void Restart();
+  double ElapsedMicros() const;
+
+private:
+  double start_;
+};
+
+// The latencies of the operations of a benchmark case.
+class BenchStats {
+public:
+  explicit BenchStats(const std::string& name);
+
+  const std::string& name() const { return name_; }
+
+  void AddSample(double micros);
+  size_t sample_count() const { return samples_.size(); }
+
+  // The amount of work done, e.g. chars typed or lines pasted, reported as
+  // units per second.
+  void AddUnits(size_t units) { units_ += units; }
+  void set_unit_name(const std::string& unit_name) { unit_name_ = unit_name; }
+
+  double Percentile(double percent) const;
+  double TotalMicros() const;
+
+  void WriteJson(std::ostream& os) const;
+
+private:
+  std::string name_;
+  std::vector<double> samples_;
+  mutable bool is_sorted_;
+  size_t units_;
+  std::string unit_name_;
+  size_t peak_rss_kb_;
+
+  friend class BenchReport;
+};
+
+// Collects the cases of a benchmark run and writes them as one JSON object,
+// so the runs can be compared by a script.
+class BenchReport {
+public:
+  explicit BenchReport(const std::string& name);
+
+  // The peak RSS of the process is recorded when a case is added.
+  void AddCase(const BenchStats& stats);
+
+  void WriteJson(std::ostream& os) const;
+
+private:
+  std::string name_;
+  std::vector<BenchStats> cases_;
+};
+
+// The peak resident set size of the process in KB, or 0 if unknown.
+size_t GetPeakRssKb();
+
+}  // namespace editor
+
+#endif  // EDITOR_BENCH_STATS_H_
@@ -0,0 +1,359 @@
+#include "editor/bracket_index.h"
+#include <algorithm>
+#include <cassert>
+#include "editor/memory_usage.h"
+#include "editor/text_file.h"
+#include "editor/trace.h"
+
+namespace editor {
+
+BracketIndex::BracketIndex()
+    : text_file_(NULL),
+      is_scanned_(false),
+      leaf_count_(0),
+      stale_first_(0),
+      stale_end_(0) {
+}
+
+void BracketIndex::Reset(const TextFile* text_file) {
+  Clear();
+  text_file_ = text_file;
+}
+
+void BracketIndex::Clear() {
+  text_file_ = NULL;
+  is_scanned_ = false;
+  std::vector<LineBrackets>().swap(lines_);
+  std::vector<Depth>().swap(tree_);
+  std::vector<syntax::Token>().swap(tokens_);
+  leaf_count_ = 0;
+  stale_first_ = 0;
+  stale_end_ = 0;
+}
+
+// The brackets of the tokens are kept, so the ones in strings and comments
+// are skipped.
+bool BracketIndex::ScanLine(size_t line, bool is_in_comment, std::vector<Bracket>* brackets) {
+  const wxString& data = text_file_->GetLine(line).GetData();
+  brackets->clear();
+
+  syntax::CppParser::State state =
+      is_in_comment ? syntax::CppParser::STATE_BLOCK_COMMENT : syntax::CppParser::STATE_NORMAL;
+  tokens_.clear();
+  state = syntax::CppParser::ParseLine(data, state, &tokens_);
+  for (const syntax::Token& token : tokens_) {
+    if (token.kind != syntax::TOKEN_PUNCTUATION) {
+      continue;
+    }
+    Bracket bracket = { token.column, 0, true };
+    switch (data[token.column]) {
+    case wxT('('):
+      break;
+    case wxT(')'):
+      bracket.is_open = false;
+      break;
+    case wxT('['):
+      bracket.kind = 1;
+      break;
+    case wxT(']'):
+      bracket.kind = 1;
+      bracket.is_open = false;
+      break;
+    case wxT('{'):
+      bracket.kind = 2;
+      break;
+    case wxT('}'):
+      bracket.kind = 2;
+      bracket.is_open = false;
+      break;
+    default:
+      continue;
+    }
+    brackets->push_back(bracket);
+  }
+  return state == syntax::CppParser::STATE_BLOCK_COMMENT;
+}
+
+static bool IsBracket(wxChar ch) {
+  return ch == wxT('(') || ch == wxT(')') || ch == wxT('[') || ch == wxT(']') ||
+         ch == wxT('{') || ch == wxT('}');
+}
+
+bool BracketIndex::IsColumnBefore(const Bracket& bracket, int column) {
+  return bracket.column < column;
+}
+
+BracketIndex::Depth BracketIndex::JoinDepths(const Depth& lhs, const Depth& rhs) {
+  Depth depth;
+  depth.sum = lhs.sum + rhs.sum;
+  depth.min_prefix = std::min(lhs.min_prefix, lhs.sum + rhs.min_prefix);
+  depth.max_suffix = std::max(rhs.max_suffix, rhs.sum + lhs.max_suffix);
+  return depth;
+}
+
+void BracketIndex::ScanLines() {
+  if (is_scanned_) {
+    return;
+  }
+  TRACE_SCOPE("BracketIndex::ScanLines");
+  lines_.resize(text_file_->GetLineCount());
+  bool is_in_comment = false;
+  for (size_t i = 0; i < lines_.size(); ++i) {
+    is_in_comment = ScanLine(i, is_in_comment, &lines_[i].brackets);
+    lines_[i].is_in_comment = is_in_comment;
+  }
+  is_scanned_ = true;
+  leaf_count_ = 0;
+}
+
+bool BracketIndex::IsInCommentBefore(size_t line) const {
+  return line != 0 && lines_[line - 1].is_in_comment;
+}
+
+void BracketIndex::OnLinesChanged(size_t first_line, size_t old_count, size_t new_count) {
+  if (!is_active() || !is_scanned_) {
+    return;
+  }
+  assert(first_line + old_count <= lines_.size());
+
+  bool was_in_comment = IsInCommentBefore(first_line + old_count);
+  if (old_count != new_count) {
+    lines_.erase(lines_.begin() + first_line, lines_.begin() + first_line + old_count);
+    lines_.insert(lines_.begin() + first_line, new_count, LineBrackets());
+  }
+
+  bool is_in_comment = IsInCommentBefore(first_line);
+  size_t line = first_line;
+  for (; line != first_line + new_count; ++line) {
+    is_in_comment = ScanLine(line, is_in_comment, &lines_[line].brackets);
+    lines_[line].is_in_comment = is_in_comment;
+  }
+  // A block comment is opened or closed for the lines after.
+  for (; line < lines_.size() && is_in_comment != was_in_comment; ++line) {
+    was_in_comment = lines_[line].is_in_comment;
+    is_in_comment = ScanLine(line, is_in_comment, &lines_[line].brackets);
+    lines_[line].is_in_comment = is_in_comment;
+  }
+
+  // The lines after are moved to other blocks if the count is changed.
+  size_t first_block = first_line / kBlockLineCount;
+  size_t end_block = kNoBlock;
+  if (old_count == new_count) {
+    end_block = (std::max(line, first_line + 1) - 1) / kBlockLineCount + 1;
+  }
+  if (stale_first_ >= stale_end_) {
+    stale_first_ = first_block;
+    stale_end_ = end_block;
+  } else {
+    stale_first_ = std::min(stale_first_, first_block);
+    stale_end_ = std::max(stale_end_, end_block);
+  }
+}
+
+void BracketIndex::UpdateBlock(size_t block) {
+  Depth* leaf = &tree_[(leaf_count_ + block) * kKindCount];
+  for (size_t k = 0; k < kKindCount; ++k) {
+    leaf[k].sum = 0;
+    leaf[k].min_prefix = 0;
+    leaf[k].max_suffix = 0;
+  }
+
+  size_t end_line = std::min((block + 1) * kBlockLineCount, lines_.size());
+  for (size_t i = block * kBlockLineCount; i < end_line; ++i) {
+    const std::vector<Bracket>& brackets = lines_[i].brackets;
+    for (size_t j = 0; j < brackets.size(); ++j) {
+      Depth& depth = leaf[brackets[j].kind];
+      depth.sum += brackets[j].is_open ? 1 : -1;
+      depth.min_prefix = std::min(depth.min_prefix, depth.sum);
+    }
+  }
+
+  // The highest suffix sum is the sum less the lowest prefix sum before it.
+  for (size_t k = 0; k < kKindCount; ++k) {
+    leaf[k].max_suffix = leaf[k].sum - leaf[k].min_prefix;
+  }
+}
+
+void BracketIndex::UpdateTree() {
+  size_t block_count = (lines_.size() + kBlockLineCount - 1) / kBlockLineCount;
+  size_t leaf_count = 1;
+  while (leaf_count < block_count) {
+    leaf_count <<= 1;
+  }
+  if (leaf_count != leaf_count_) {
+    leaf_count_ = leaf_count;
+    tree_.resize(leaf_count_ * 2 * kKindCount);
+    stale_first_ = 0;
+    stale_end_ = leaf_count_;
+  }
+
+  stale_end_ = std::min(stale_end_, leaf_count_);
+  if (stale_first_ >= stale_end_) {
+    return;
+  }
+  TRACE_SCOPE("BracketIndex::UpdateTree");
+
+  for (size_t block = stale_first_; block != stale_end_; ++block) {
+    UpdateBlock(block);
+  }
+  // The parents of the nodes updated, level by level up to the root.
+  size_t first_node = (leaf_count_ + stale_first_) / 2;
+  size_t last_node = (leaf_count_ + stale_end_ - 1) / 2;
+  for (; first_node != 0; first_node /= 2, last_node /= 2) {
+    for (size_t node = first_node; node <= last_node; ++node) {
+      for (size_t k = 0; k < kKindCount; ++k) {
+        tree_[node * kKindCount + k] = JoinDepths(tree_[node * 2 * kKindCount + k],
+                                                  tree_[(node * 2 + 1) * kKindCount + k]);
+      }
+    }
+  }
+  stale_first_ = 0;
+  stale_end_ = 0;
+}
+
+// The first block from |first_block| on where the depth drops to 0.
+size_t BracketIndex::FindForward(size_t node, size_t begin, size_t end, size_t first_block, size_t kind, int* depth) const {
+  if (end <= first_block) {
+    return kNoBlock;
+  }
+  const Depth& node_depth = tree_[node * kKindCount + kind];
+  if (begin >= first_block && *depth + node_depth.min_prefix > 0) {
+    *depth += node_depth.sum;
+    return kNoBlock;
+  }
+  if (end - begin == 1) {
+    return begin;
+  }
+  size_t mid = begin + (end - begin) / 2;
+  size_t block = FindForward(node * 2, begin, mid, first_block, kind, depth);
+  if (block != kNoBlock) {
+    return block;
+  }
+  return FindForward(node * 2 + 1, mid, end, first_block, kind, depth);
+}
+
+// The last block before |end_block| where the depth drops to 0, going back.
+size_t BracketIndex::FindBackward(size_t node, size_t begin, size_t end, size_t end_block, size_t kind, int* depth) const {
+  if (begin >= end_block) {
+    return kNoBlock;
+  }
+  const Depth& node_depth = tree_[node * kKindCount + kind];
+  if (end <= end_block && *depth - node_depth.max_suffix > 0) {
+    *depth -= node_depth.sum;
+    return kNoBlock;
+  }
+  if (end - begin == 1) {
+    return begin;
+  }
+  size_t mid = begin + (end - begin) / 2;
+  size_t block = FindBackward(node * 2 + 1, mid, end, end_block, kind, depth);
+  if (block != kNoBlock) {
+    return block;
+  }
+  return FindBackward(node * 2, begin, mid, end_block, kind, depth);
+}
+
+bool BracketIndex::FindForwardInLines(size_t first_line, size_t end_line, size_t kind, int* depth, wxPoint* match) const {
+  for (size_t i = first_line; i < end_line; ++i) {
+    const std::vector<Bracket>& brackets = lines_[i].brackets;
+    for (size_t j = 0; j < brackets.size(); ++j) {
+      if (brackets[j].kind != kind) {
+        continue;
+      }
+      *depth += brackets[j].is_open ? 1 : -1;
+      if (*depth == 0) {
+        *match = wxPoint(brackets[j].column, static_cast<int>(i));
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool BracketIndex::FindBackwardInLines(size_t first_line, size_t end_line, size_t kind, int* depth, wxPoint* match) const {
+  for (size_t i = end_line; i > first_line; --i) {
+    const std::vector<Bracket>& brackets = lines_[i - 1].brackets;
+    for (size_t j = brackets.size(); j > 0; --j) {
+      if (brackets[j - 1].kind != kind) {
+        continue;
+      }
+      *depth += brackets[j - 1].is_open ? -1 : 1;
+      if (*depth == 0) {
+        *match = wxPoint(brackets[j - 1].column, static_cast<int>(i - 1));
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// The rest of the line and of its block are searched first, then the tree
+// finds the block of the match. The lines aren't scanned until there's a
+// bracket to match.
+bool BracketIndex::FindMatch(const wxPoint& pos, wxPoint* match) {
+  if (!is_active() || pos.y < 0 || static_cast<size_t>(pos.y) >= text_file_->GetLineCount()) {
+    return false;
+  }
+  const wxString& line_data = text_file_->GetLine(pos.y).GetData();
+  if (pos.x < 0 || static_cast<size_t>(pos.x) >= line_data.Len() || !IsBracket(line_data[pos.x])) {
+    return false;
+  }
+  ScanLines();
+  const std::vector<Bracket>& brackets = lines_[pos.y].brackets;
+  std::vector<Bracket>::const_iterator iter =
+      std::lower_bound(brackets.begin(), brackets.end(), pos.x, IsColumnBefore);
+  if (iter == brackets.end() || iter->column != pos.x) {
+    return false;
+  }
+  UpdateTree();
+
+  size_t line = pos.y;
+  size_t kind = iter->kind;
+  size_t block = line / kBlockLineCount;
+  int depth = 1;
+  if (iter->is_open) {
+    for (++iter; iter != brackets.end(); ++iter) {
+      if (iter->kind == kind && (depth += iter->is_open ? 1 : -1) == 0) {
+        *match = wxPoint(iter->column, pos.y);
+        return true;
+      }
+    }
+    size_t end_line = std::min((block + 1) * kBlockLineCount, lines_.size());
+    if (FindForwardInLines(line + 1, end_line, kind, &depth, match)) {
+      return true;
+    }
+    block = FindForward(1, 0, leaf_count_, block + 1, kind, &depth);
+    if (block == kNoBlock) {
+      return false;
+    }
+    end_line = std::min((block + 1) * kBlockLineCount, lines_.size());
+    return FindForwardInLines(block * kBlockLineCount, end_line, kind, &depth, match);
+  }
+
+  while (iter != brackets.begin()) {
+    --iter;
+    if (iter->kind == kind && (depth += iter->is_open ? -1 : 1) == 0) {
+      *match = wxPoint(iter->column, pos.y);
+      return true;
+    }
+  }
+  if (FindBackwardInLines(block * kBlockLineCount, line, kind, &depth, match)) {
+    return true;
+  }
+  block = FindBackward(1, 0, leaf_count_, block, kind, &depth);
+  if (block == kNoBlock) {
+    return false;
+  }
+  size_t end_line = std::min((block + 1) * kBlockLineCount, lines_.size());
+  return FindBackwardInLines(block * kBlockLineCount, end_line, kind, &depth, match);
+}
+
+size_t BracketIndex::GetMemoryUsage() const {
+  size_t bytes = GetVectorMemoryUsage(lines_) + GetVectorMemoryUsage(tree_) + GetVectorMemoryUsage(tokens_);
+  for (size_t i = 0; i < lines_.size(); ++i) {
+    bytes += GetVectorMemoryUsage(lines_[i].brackets);
+  }
+  return bytes;
+}
+
+}  // namespace editor
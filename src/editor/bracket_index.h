@@ -0,0 +1,108 @@
+#ifndef EDITOR_BRACKET_INDEX_H_
+#define EDITOR_BRACKET_INDEX_H_
+#pragma once
+
+#include <vector>
+#include "wx/gdicmn.h"
+#include "wx/string.h"
+#include "syntax/cpp_parser.h"
+
+namespace editor {
+
+class TextFile;
+
+// The brackets of a text file, to find the one matching a bracket. Each
+// line keeps its brackets which are not in a string or a comment, from the
+// tokens of syntax::CppParser. The lines are grouped in blocks, and a
+// segment tree over the blocks keeps the depth summary of each kind of
+// bracket, so a match is found by skipping the blocks it can't be in, in
+// O(log n) and the brackets of two blocks.
+//
+// A line is scanned again when it's changed, and so are the lines after it
+// while a block comment it starts or ends changes them. The summaries of
+// the blocks changed are rebuilt when a match is looked for.
+class BracketIndex {
+public:
+  BracketIndex();
+
+  void Reset(const TextFile* text_file);
+  void Clear();
+
+  bool is_active() const { return text_file_ != NULL; }
+
+  // The lines [first_line, first_line + old_count) were replaced by
+  // [first_line, first_line + new_count).
+  void OnLinesChanged(size_t first_line, size_t old_count, size_t new_count);
+
+  // Set |match| to the bracket which matches the one at |pos|. Return false
+  // if there is no bracket at |pos|, it's in a string or a comment, or it
+  // isn't matched.
+  bool FindMatch(const wxPoint& pos, wxPoint* match);
+
+  size_t GetMemoryUsage() const;
+
+private:
+  // The depth of a kind of brackets through some of them, with an open
+  // bracket as 1 and a close one as -1. The lowest prefix sum and the
+  // highest suffix sum are never above or below 0, the sum of none.
+  struct Depth {
+    int sum;
+    int min_prefix;
+    int max_suffix;
+  };
+
+  struct Bracket {
+    int column;
+    unsigned char kind;
+    bool is_open;
+  };
+
+  struct LineBrackets {
+    std::vector<Bracket> brackets;
+    bool is_in_comment;  // the line ends in a block comment
+  };
+
+  static const size_t kBlockLineCount = 64;
+  static const size_t kKindCount = 3;
+  static const size_t kNoBlock = static_cast<size_t>(-1);
+
+  static bool IsColumnBefore(const Bracket& bracket, int column);
+  static Depth JoinDepths(const Depth& lhs, const Depth& rhs);
+
+  // Return true if the line ends in a block comment.
+  bool ScanLine(size_t line, bool is_in_comment, std::vector<Bracket>* brackets);
+  void ScanLines();
+  bool IsInCommentBefore(size_t line) const;
+
+  void UpdateTree();
+  void UpdateBlock(size_t block);
+
+  size_t FindForward(size_t node, size_t begin, size_t end, size_t first_block, size_t kind, int* depth) const;
+  size_t FindBackward(size_t node, size_t begin, size_t end, size_t end_block, size_t kind, int* depth) const;
+
+  // Find the match in the lines [first_line, end_line) of the brackets with
+  // the depth left, and update the depth if it's not there.
+  bool FindForwardInLines(size_t first_line, size_t end_line, size_t kind, int* depth, wxPoint* match) const;
+  bool FindBackwardInLines(size_t first_line, size_t end_line, size_t kind, int* depth, wxPoint* match) const;
+
+private:
+  const TextFile* text_file_;
+
+  // The lines are scanned when the first match is looked for.
+  bool is_scanned_;
+  std::vector<LineBrackets> lines_;
+
+  // The tree has a leaf per block, padded to a power of 2, and the Depth
+  // of each kind per node, with the root at 1. The blocks
+  // [stale_first_, stale_end_) are rebuilt before it's used.
+  std::vector<Depth> tree_;
+  size_t leaf_count_;
+  size_t stale_first_;
+  size_t stale_end_;
+
+  std::vector<syntax::Token> tokens_;  // of the line scanned
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_BRACKET_INDEX_H_
@@ -0,0 +1,93 @@
+#include "editor/bracket_index.h"
+#include "editor/text_file.h"
+#include "editor/text_listener.h"
+#include "gtest/gtest.h"
+
+using namespace editor;
+
+namespace {
+
+// Keeps the bracket index up to date with the edits of the text, as a view
+// does.
+class BracketIndexTest : public testing::Test, public TextListener {
+protected:
+  virtual void SetUp() override {
+    bracket_index_.Reset(&text_file_);
+    text_file_.AttachListener(this);
+  }
+
+  virtual void OnLineUpdate(const wxPoint& position, bool is_multi_lines) override {
+  }
+
+  virtual void OnLinesChanged(size_t first_line, size_t old_count, size_t new_count) override {
+    bracket_index_.OnLinesChanged(first_line, old_count, new_count);
+  }
+
+  // Expect the brackets at the two positions to match each other.
+  void ExpectMatch(const wxPoint& pos, const wxPoint& expected) {
+    wxPoint match;
+    ASSERT_TRUE(bracket_index_.FindMatch(pos, &match));
+    EXPECT_EQ(expected, match);
+    ASSERT_TRUE(bracket_index_.FindMatch(expected, &match));
+    EXPECT_EQ(pos, match);
+  }
+
+  TextFile text_file_;
+  BracketIndex bracket_index_;
+};
+
+}  // namespace
+
+TEST_F(BracketIndexTest, SameLine) {
+  text_file_.AddLine(wxT("f(a[1], {b}) )"));
+  ExpectMatch(wxPoint(1, 0), wxPoint(11, 0));
+  ExpectMatch(wxPoint(3, 0), wxPoint(5, 0));
+  ExpectMatch(wxPoint(8, 0), wxPoint(10, 0));
+
+  wxPoint match;
+  EXPECT_FALSE(bracket_index_.FindMatch(wxPoint(13, 0), &match));  // unmatched
+  EXPECT_FALSE(bracket_index_.FindMatch(wxPoint(0, 0), &match));  // not a bracket
+  EXPECT_FALSE(bracket_index_.FindMatch(wxPoint(20, 0), &match));
+}
+
+TEST_F(BracketIndexTest, AcrossBlocks) {
+  // The lines are grouped by 64, so the match is many blocks away.
+  text_file_.AddLine(wxT("void f() {"));
+  for (int i = 0; i < 1000; ++i) {
+    text_file_.AddLine(i % 3 == 0 ? wxT("  if (a) { b(c[0]); }") : wxT("  d();"));
+  }
+  text_file_.AddLine(wxT("}"));
+  ExpectMatch(wxPoint(9, 0), wxPoint(0, 1001));
+  ExpectMatch(wxPoint(9, 301), wxPoint(20, 301));
+
+  // A brace inserted in the middle leaves the first one unmatched.
+  text_file_.InsertText(wxPoint(0, 500), wxT("{"));
+  wxPoint match;
+  EXPECT_FALSE(bracket_index_.FindMatch(wxPoint(9, 0), &match));
+  ExpectMatch(wxPoint(0, 500), wxPoint(0, 1001));
+}
+
+TEST_F(BracketIndexTest, CommentsAndStrings) {
+  text_file_.AddLine(wxT("g({"));
+  text_file_.AddLine(wxT("  /* ) }"));
+  for (int i = 0; i < 200; ++i) {
+    text_file_.AddLine(wxT("  } ]"));
+  }
+  text_file_.AddLine(wxT("  */ \"})\" ')' // )"));
+  text_file_.AddLine(wxT("})"));
+  ExpectMatch(wxPoint(1, 0), wxPoint(1, 203));
+  ExpectMatch(wxPoint(2, 0), wxPoint(0, 203));
+
+  wxPoint match;
+  EXPECT_FALSE(bracket_index_.FindMatch(wxPoint(5, 1), &match));
+  EXPECT_FALSE(bracket_index_.FindMatch(wxPoint(2, 100), &match));
+
+  // Closing the comment early lets the braces in it close the ones before.
+  text_file_.InsertText(wxPoint(4, 1), wxT("*/"));
+  ExpectMatch(wxPoint(1, 0), wxPoint(7, 1));
+  ExpectMatch(wxPoint(2, 0), wxPoint(9, 1));
+
+  // And opening it again hides them.
+  text_file_.DeleteText(wxPoint(4, 1), wxT("*/"));
+  ExpectMatch(wxPoint(1, 0), wxPoint(1, 203));
+}
@@ -0,0 +1,251 @@
+#include "editor/completion_index.h"
+#include <algorithm>
+#include <cassert>
+#include "editor/memory_usage.h"
+#include "editor/text_file.h"
+#include "editor/trace.h"
+
+namespace editor {
+
+// The words not used are compacted when they're more than this and more
+// than the words used.
+const size_t kMinUnusedCount = 1024;
+
+// A word found, as its count and its index in the sorted words.
+typedef std::pair<size_t, size_t> FoundWord;
+
+static bool IsMoreUsed(const FoundWord& lhs, const FoundWord& rhs) {
+  return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+}
+
+CompletionIndex::CompletionIndex()
+    : text_file_(NULL),
+      unused_count_(0) {
+}
+
+CompletionIndex::~CompletionIndex() {
+  Clear();
+}
+
+void CompletionIndex::Reset(TextFile* text_file) {
+  Clear();
+  text_file_ = text_file;
+  text_file_->AttachListener(this);
+}
+
+void CompletionIndex::Clear() {
+  if (text_file_ != NULL) {
+    text_file_->DetachListener(this);
+    text_file_ = NULL;
+  }
+  std::vector<LineWords>().swap(lines_);
+  std::vector<Word>().swap(words_);
+  std::vector<unsigned int>().swap(sorted_words_);
+  std::vector<unsigned int>().swap(free_words_);
+  unused_count_ = 0;
+}
+
+bool CompletionIndex::HasStaleLines() const {
+  return is_active() && lines_.size() < text_file_->GetLineCount();
+}
+
+bool CompletionIndex::ScanStaleLines(size_t max_count) {
+  if (!HasStaleLines()) {
+    return false;
+  }
+  TRACE_SCOPE("CompletionIndex::ScanStaleLines");
+  size_t line_count = text_file_->GetLineCount();
+  size_t first_line = lines_.size();
+  size_t end_line = std::min(first_line + max_count, line_count);
+  bool is_in_comment = first_line != 0 && lines_[first_line - 1].is_in_comment;
+  lines_.resize(end_line);
+  for (size_t i = first_line; i < end_line; ++i) {
+    ScanLine(i, is_in_comment, &lines_[i]);
+    is_in_comment = lines_[i].is_in_comment;
+  }
+  return end_line < line_count;
+}
+
+// The lines after the changed ones are lexed again while the block comment
+// state they start with differs from the one before the change.
+void CompletionIndex::OnLinesChanged(size_t first_line, size_t old_count, size_t new_count) {
+  if (!is_active() || first_line >= lines_.size()) {
+    return;
+  }
+  TRACE_SCOPE("CompletionIndex::OnLinesChanged");
+
+  // The lines not lexed yet are lexed in idle time.
+  if (first_line + old_count > lines_.size()) {
+    for (size_t i = first_line; i < lines_.size(); ++i) {
+      RemoveLineWords(&lines_[i]);
+    }
+    lines_.resize(first_line);
+    return;
+  }
+
+  bool is_in_comment = first_line != 0 && lines_[first_line - 1].is_in_comment;
+  bool old_is_in_comment = old_count != 0 ? lines_[first_line + old_count - 1].is_in_comment : is_in_comment;
+  for (size_t i = first_line; i < first_line + old_count; ++i) {
+    RemoveLineWords(&lines_[i]);
+  }
+  if (old_count != new_count) {
+    lines_.erase(lines_.begin() + first_line, lines_.begin() + first_line + old_count);
+    LineWords line_words = { std::vector<unsigned int>(), false };
+    lines_.insert(lines_.begin() + first_line, new_count, line_words);
+  }
+
+  size_t end_line = first_line + new_count;
+  for (size_t i = first_line; i < end_line; ++i) {
+    ScanLine(i, is_in_comment, &lines_[i]);
+    is_in_comment = lines_[i].is_in_comment;
+  }
+  for (size_t i = end_line; i < lines_.size() && is_in_comment != old_is_in_comment; ++i) {
+    old_is_in_comment = lines_[i].is_in_comment;
+    RemoveLineWords(&lines_[i]);
+    ScanLine(i, is_in_comment, &lines_[i]);
+    is_in_comment = lines_[i].is_in_comment;
+  }
+}
+
+void CompletionIndex::ScanLine(size_t line, bool is_in_comment, LineWords* line_words) {
+  const wxString& data = text_file_->GetLine(line).GetData();
+  syntax::CppParser::State state =
+      is_in_comment ? syntax::CppParser::STATE_BLOCK_COMMENT : syntax::CppParser::STATE_NORMAL;
+  tokens_.clear();
+  state = syntax::CppParser::ParseLine(data, state, &tokens_);
+
+  // The ids are gathered first, so the line takes no more memory than it
+  // needs.
+  line_word_ids_.clear();
+  for (const syntax::Token& token : tokens_) {
+    size_t length = static_cast<size_t>(token.length);
+    if (token.kind != syntax::TOKEN_IDENTIFIER || length < kMinWordLength || length > kMaxWordLength) {
+      continue;
+    }
+    word_text_.assign(data, token.column, length);
+    unsigned int word = AddWord(word_text_);
+    if (word != kNoWord) {
+      line_word_ids_.push_back(word);
+    }
+  }
+  std::vector<unsigned int>(line_word_ids_).swap(line_words->words);
+  line_words->is_in_comment = state == syntax::CppParser::STATE_BLOCK_COMMENT;
+}
+
+void CompletionIndex::RemoveLineWords(LineWords* line_words) {
+  for (unsigned int word : line_words->words) {
+    RemoveWord(word);
+  }
+  line_words->words.clear();
+}
+
+size_t CompletionIndex::FindSorted(const wxString& text) const {
+  size_t low = 0;
+  size_t high = sorted_words_.size();
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (words_[sorted_words_[mid]].text < text) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+unsigned int CompletionIndex::AddWord(const wxString& text) {
+  size_t index = FindSorted(text);
+  if (index != sorted_words_.size() && words_[sorted_words_[index]].text == text) {
+    Word& word = words_[sorted_words_[index]];
+    if (word.count++ == 0) {
+      --unused_count_;
+    }
+    return sorted_words_[index];
+  }
+
+  if (sorted_words_.size() >= kMaxWordCount) {
+    if (unused_count_ == 0) {
+      return kNoWord;
+    }
+    CompactWords();
+    index = FindSorted(text);
+  }
+
+  unsigned int word = 0;
+  if (!free_words_.empty()) {
+    word = free_words_.back();
+    free_words_.pop_back();
+  } else {
+    word = static_cast<unsigned int>(words_.size());
+    words_.push_back(Word());
+  }
+  words_[word].text = text;
+  words_[word].count = 1;
+  sorted_words_.insert(sorted_words_.begin() + index, word);
+  return word;
+}
+
+void CompletionIndex::RemoveWord(unsigned int word) {
+  assert(words_[word].count > 0);
+  if (--words_[word].count == 0) {
+    ++unused_count_;
+    if (unused_count_ > kMinUnusedCount && unused_count_ * 2 > sorted_words_.size()) {
+      CompactWords();
+    }
+  }
+}
+
+void CompletionIndex::CompactWords() {
+  TRACE_SCOPE("CompletionIndex::CompactWords");
+  std::vector<unsigned int>::iterator end = sorted_words_.begin();
+  for (std::vector<unsigned int>::iterator iter = sorted_words_.begin(); iter != sorted_words_.end(); ++iter) {
+    Word& word = words_[*iter];
+    if (word.count != 0) {
+      *end++ = *iter;
+    } else {
+      wxString().swap(word.text);
+      free_words_.push_back(*iter);
+    }
+  }
+  sorted_words_.erase(end, sorted_words_.end());
+  unused_count_ = 0;
+}
+
+// Only the words returned are sorted by their counts. The words used as
+// many times are kept in alphabetical order.
+void CompletionIndex::Find(const wxString& prefix, size_t max_count, std::vector<wxString>* words) const {
+  TRACE_SCOPE("CompletionIndex::Find");
+  words->clear();
+  std::vector<FoundWord> found;
+  for (size_t i = FindSorted(prefix); i < sorted_words_.size(); ++i) {
+    const Word& word = words_[sorted_words_[i]];
+    if (!word.text.StartsWith(prefix)) {
+      break;
+    }
+    if (word.count != 0 && word.text.Len() > prefix.Len()) {
+      found.push_back(FoundWord(word.count, i));
+    }
+  }
+
+  size_t count = std::min(found.size(), max_count);
+  std::partial_sort(found.begin(), found.begin() + count, found.end(), IsMoreUsed);
+  for (size_t i = 0; i < count; ++i) {
+    words->push_back(words_[sorted_words_[found[i].second]].text);
+  }
+}
+
+size_t CompletionIndex::GetMemoryUsage() const {
+  size_t bytes = GetVectorMemoryUsage(lines_) + GetVectorMemoryUsage(words_) +
+      GetVectorMemoryUsage(sorted_words_) + GetVectorMemoryUsage(free_words_) +
+      GetVectorMemoryUsage(tokens_) + GetVectorMemoryUsage(line_word_ids_) +
+      GetStringMemoryUsage(word_text_);
+  for (const LineWords& line_words : lines_) {
+    bytes += GetVectorMemoryUsage(line_words.words);
+  }
+  for (const Word& word : words_) {
+    bytes += GetStringMemoryUsage(word.text);
+  }
+  return bytes;
+}
+
+}  // namespace editor
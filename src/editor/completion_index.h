@@ -0,0 +1,97 @@
+#ifndef EDITOR_COMPLETION_INDEX_H_
+#define EDITOR_COMPLETION_INDEX_H_
+#pragma once
+
+#include <vector>
+#include "wx/string.h"
+#include "syntax/cpp_parser.h"
+#include "editor/text_listener.h"
+
+namespace editor {
+
+class TextFile;
+
+// The identifiers of a text for word completion, and how many times each
+// is used. The lines are lexed by syntax::CppParser, and each keeps the ids
+// of its words, so a changed line only takes its old words out and puts its
+// new ones in. The ids are kept sorted by their words, so the words with a
+// prefix are a range found by a binary search.
+//
+// The lines are lexed from the first one on in idle time, and the words of
+// the lines not lexed yet aren't found. At most kMaxWordCount words are
+// kept, and the words longer than kMaxWordLength aren't.
+class CompletionIndex : public TextListener {
+public:
+  static const size_t kMinWordLength = 2;
+  static const size_t kMaxWordLength = 64;
+  static const size_t kMaxWordCount = 256 * 1024;
+
+  CompletionIndex();
+  ~CompletionIndex();
+
+  // Listen to the text. Paged and hex texts aren't indexed.
+  void Reset(TextFile* text_file);
+  void Clear();
+
+  bool is_active() const { return text_file_ != NULL; }
+
+  bool HasStaleLines() const;
+
+  // Lex at most |max_count| lines more. Return true if there are more.
+  bool ScanStaleLines(size_t max_count);
+
+  // Set |words| to at most |max_count| words which start with |prefix| and
+  // are longer, the most used first.
+  void Find(const wxString& prefix, size_t max_count, std::vector<wxString>* words) const;
+
+  size_t GetMemoryUsage() const;
+
+  virtual void OnLineUpdate(const wxPoint& position, bool is_multi_lines) override {}
+  virtual void OnLinesChanged(size_t first_line, size_t old_count, size_t new_count) override;
+
+private:
+  struct Word {
+    wxString text;
+    size_t count;  // a word not used is kept until the words are compacted
+  };
+
+  struct LineWords {
+    std::vector<unsigned int> words;
+    bool is_in_comment;  // the line ends in a block comment
+  };
+
+  static const unsigned int kNoWord = static_cast<unsigned int>(-1);
+
+  void ScanLine(size_t line, bool is_in_comment, LineWords* line_words);
+  void RemoveLineWords(LineWords* line_words);
+
+  // The index in sorted_words_ of the first word not before |text|.
+  size_t FindSorted(const wxString& text) const;
+
+  // Count a use of the word. Return kNoWord if it's not kept.
+  unsigned int AddWord(const wxString& text);
+  void RemoveWord(unsigned int word);
+
+  // Drop the words not used, and reuse their ids.
+  void CompactWords();
+
+private:
+  TextFile* text_file_;
+
+  // The lines lexed, from the first one.
+  std::vector<LineWords> lines_;
+
+  std::vector<Word> words_;
+  std::vector<unsigned int> sorted_words_;
+  std::vector<unsigned int> free_words_;
+  size_t unused_count_;
+
+  // Reused by ScanLine().
+  std::vector<syntax::Token> tokens_;
+  std::vector<unsigned int> line_word_ids_;
+  wxString word_text_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_COMPLETION_INDEX_H_
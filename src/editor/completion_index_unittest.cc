@@ -0,0 +1,101 @@
+#include "editor/completion_index.h"
+#include "editor/text_file.h"
+#include "gtest/gtest.h"
+
+using namespace editor;
+
+namespace {
+
+class CompletionIndexTest : public testing::Test {
+protected:
+  virtual void TearDown() override {
+    completion_index_.Clear();
+  }
+
+  void Index(const wxChar* const* lines, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      text_file_.AddLine(lines[i]);
+    }
+    completion_index_.Reset(&text_file_);
+    while (completion_index_.ScanStaleLines(2)) {
+    }
+  }
+
+  std::vector<wxString> Find(const wxString& prefix) {
+    std::vector<wxString> words;
+    completion_index_.Find(prefix, 100, &words);
+    return words;
+  }
+
+  TextFile text_file_;
+  CompletionIndex completion_index_;
+};
+
+}  // namespace
+
+TEST_F(CompletionIndexTest, Find) {
+  const wxChar* lines[] = {
+    wxT("int value = compute(value_a, value_b);"),
+    wxT("value_b = value_b + valid;"),
+  };
+  Index(lines, 2);
+
+  // The most used first, then in order.
+  std::vector<wxString> words = Find(wxT("val"));
+  ASSERT_EQ(4u, words.size());
+  EXPECT_EQ(wxT("value_b"), words[0]);
+  EXPECT_EQ(wxT("valid"), words[1]);
+  EXPECT_EQ(wxT("value"), words[2]);
+  EXPECT_EQ(wxT("value_a"), words[3]);
+
+  // Only the words longer than the prefix, and no keywords.
+  words = Find(wxT("value"));
+  ASSERT_EQ(2u, words.size());
+  EXPECT_EQ(wxT("value_b"), words[0]);
+  EXPECT_EQ(wxT("value_a"), words[1]);
+  EXPECT_TRUE(Find(wxT("compute")).empty());
+  EXPECT_TRUE(Find(wxT("in")).empty());
+
+  // At most |max_count| words.
+  completion_index_.Find(wxT("v"), 2, &words);
+  EXPECT_EQ(2u, words.size());
+}
+
+TEST_F(CompletionIndexTest, CommentsAndStrings) {
+  const wxChar* lines[] = {
+    wxT("name1 = \"name2\"; // name3"),
+    wxT("/* name4"),
+    wxT("name5 */ name6"),
+  };
+  Index(lines, 3);
+
+  std::vector<wxString> words = Find(wxT("name"));
+  ASSERT_EQ(2u, words.size());
+  EXPECT_EQ(wxT("name1"), words[0]);
+  EXPECT_EQ(wxT("name6"), words[1]);
+}
+
+TEST_F(CompletionIndexTest, Edits) {
+  const wxChar* lines[] = {
+    wxT("alpha beta"),
+    wxT("gamma"),
+  };
+  Index(lines, 2);
+
+  text_file_.InsertText(wxPoint(0, 1), wxT("alpha2 alpha2\r"));
+  std::vector<wxString> words = Find(wxT("al"));
+  ASSERT_EQ(2u, words.size());
+  EXPECT_EQ(wxT("alpha2"), words[0]);
+
+  // The words of a line deleted are taken out.
+  text_file_.DeleteText(wxPoint(0, 0), wxT("alpha beta\r"));
+  words = Find(wxT("al"));
+  ASSERT_EQ(1u, words.size());
+  EXPECT_EQ(wxT("alpha2"), words[0]);
+  EXPECT_TRUE(Find(wxT("be")).empty());
+
+  // A comment opened by an edit hides the words of the lines after.
+  text_file_.InsertText(wxPoint(0, 0), wxT("/*"));
+  EXPECT_TRUE(Find(wxT("al")).empty());
+  EXPECT_TRUE(Find(wxT("ga")).empty());
+}
@@ -7,6 +7,9 @@ namespace editor {
 const char* kTabSizeKey = "tab_size";
 const char* kFontSizeKey = "font_point_size";
 const char* kFontNameKey = "font_face_name";
+const char* kFollowMaxLinesKey = "follow_max_lines";
+const char* kPagedFileSizeKey = "paged_file_size_mb";
+const char* kPageCacheKey = "page_cache_mb";
 const char* kDefaultFontName = "Consolas";
 const int kDefaulTabtSize = 4;
 const int kDefaultFontSize = 11;
@@ -14,8 +17,17 @@ const int kMaxTabSize = 40;
 const int kMaxFontSize = 50;
 const int kMinTabSize = 0;
 const int kMinFontSize = 0;
+const size_t kDefaultFollowMaxLines = 1000000;
+const size_t kMinFollowMaxLines = 1000;
+const size_t kDefaultPagedFileSizeMb = 1024;
+const size_t kDefaultPageCacheMb = 256;
+const size_t kMinPageCacheMb = 16;
 
-Config::Config() : tab_size_(kDefaulTabtSize) {
+Config::Config()
+    : tab_size_(kDefaulTabtSize),
+      follow_max_lines_(kDefaultFollowMaxLines),
+      paged_file_size_mb_(kDefaultPagedFileSizeMb),
+      page_cache_mb_(kDefaultPageCacheMb) {
   font_.SetPointSize(kDefaultFontSize);
   font_.SetFaceName(kDefaultFontName);
 }
@@ -69,6 +81,14 @@ bool Config::LoadFile(const wxString& file_path) {
       int font_point_size = kDefaultFontSize;
       font_point_size = (size > kMinFontSize && size < kMaxFontSize) ? size : kDefaultFontSize;
       font_.SetPointSize(font_point_size);
+    } else if (!strcmp(kFollowMaxLinesKey, key)) {
+      size_t count = strtoul(value, NULL, 10);
+      follow_max_lines_ = count >= kMinFollowMaxLines ? count : kDefaultFollowMaxLines;
+    } else if (!strcmp(kPagedFileSizeKey, key)) {
+      paged_file_size_mb_ = strtoul(value, NULL, 10);
+    } else if (!strcmp(kPageCacheKey, key)) {
+      size_t size = strtoul(value, NULL, 10);
+      page_cache_mb_ = size >= kMinPageCacheMb ? size : kDefaultPageCacheMb;
     }
   }
 
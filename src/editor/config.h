@@ -21,6 +21,15 @@ public:
 public:
   wxFont font_;
   int tab_size_;
+
+  // The lines kept of a followed file. The first lines are dropped as it
+  // grows.
+  size_t follow_max_lines_;
+
+  // Files of this many MB or more are opened read only and paged, with
+  // page_cache_mb_ MB of their lines kept in memory. 0 pages no file.
+  size_t paged_file_size_mb_;
+  size_t page_cache_mb_;
 };
 
 }  // namespace editor
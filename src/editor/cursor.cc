@@ -0,0 +1,32 @@
+#include "editor/cursor.h"
+
+namespace editor {
+
+Cursor::Cursor() {
+}
+
+Cursor::Cursor(const wxPoint& caret_pos, const wxPoint& anchor_pos)
+    : caret_pos_(caret_pos),
+      anchor_pos_(anchor_pos) {
+}
+
+SelectionRegion Cursor::GetSelectionRegion() const {
+  if (anchor_pos_.y < caret_pos_.y ||
+      (anchor_pos_.y == caret_pos_.y && anchor_pos_.x < caret_pos_.x)) {
+    return SelectionRegion(anchor_pos_, caret_pos_);
+  }
+  return SelectionRegion(caret_pos_, anchor_pos_);
+}
+
+bool Cursor::operator<(const Cursor& cursor) const {
+  if (caret_pos_.y != cursor.caret_pos_.y) {
+    return caret_pos_.y < cursor.caret_pos_.y;
+  }
+  return caret_pos_.x < cursor.caret_pos_.x;
+}
+
+bool Cursor::operator==(const Cursor& cursor) const {
+  return caret_pos_ == cursor.caret_pos_;
+}
+
+}  // namespace editor
@@ -0,0 +1,36 @@
+#ifndef EDITOR_CURSOR_H_
+#define EDITOR_CURSOR_H_
+#pragma once
+
+#include "wx/gdicmn.h"
+#include "editor/selection_region.h"
+
+namespace editor {
+
+// A caret together with the anchor of its selection.
+// Used for the additional carets of multi-cursor editing.
+class Cursor {
+public:
+  Cursor();
+  Cursor(const wxPoint& caret_pos, const wxPoint& anchor_pos);
+
+  wxPoint caret_pos() const { return caret_pos_; }
+  void set_caret_pos(const wxPoint& caret_pos) { caret_pos_ = caret_pos; }
+
+  wxPoint anchor_pos() const { return anchor_pos_; }
+  void set_anchor_pos(const wxPoint& anchor_pos) { anchor_pos_ = anchor_pos; }
+
+  bool HasSelection() const { return caret_pos_ != anchor_pos_; }
+  SelectionRegion GetSelectionRegion() const;
+
+  bool operator<(const Cursor& cursor) const;
+  bool operator==(const Cursor& cursor) const;
+
+private:
+  wxPoint caret_pos_;
+  wxPoint anchor_pos_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_CURSOR_H_
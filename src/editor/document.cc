@@ -0,0 +1,319 @@
+#include "editor/document.h"
+#include <algorithm>
+#include <cassert>
+#include "wx/filename.h"
+#include "editor/edit_command.h"
+#include "editor/line_diff.h"
+#include "editor/memory_usage.h"
+#include "editor/text_file.h"
+#include "editor/text_scroll_window.h"
+#include "editor/trace.h"
+
+namespace editor {
+
+// More lines inserted and deleted than this are replaced as one block, which
+// bounds the time and memory of the diff.
+const size_t kMaxDiffEditCount = 2000;
+
+Document::Document(const wxString& path)
+    : path_(path),
+      text_file_(NULL),
+      last_used_(0),
+      is_following_(false) {
+}
+
+Document::~Document() {
+  assert(views_.empty());
+  Unload();
+}
+
+wxString Document::GetTitle() const {
+  if (is_new()) {
+    return wxT("Untitled");
+  }
+  return wxFileName(path_).GetFullName();
+}
+
+bool Document::IsModified() const {
+  return text_file_ != NULL && text_file_->IsModified();
+}
+
+bool Document::CanUnload() const {
+  // Read again, a followed file would be read whole and untrimmed, and a
+  // paged file would be scanned whole again. A hex text is only mapped.
+  return IsLoaded() && !is_new() && !IsModified() && !is_following_ && !text_file_->IsPaged();
+}
+
+// Only the lines with tabs are copied. The text isn't in any view yet, or
+// is in a batch, so no worker reads the lines set.
+static void ExpandTabs(TextFile* text_file, int tab_size, size_t first_line = 0) {
+  wxString tab(wxT('\t'), tab_size);
+  for (size_t i = first_line; i != text_file->GetLineCount(); ++i) {
+    const wxString& data = text_file->GetLine(i).GetData();
+    if (data.find(wxT('\t')) == wxString::npos) {
+      continue;
+    }
+    wxString line = data;
+    line.Replace(wxT("\t"), tab, true);
+    text_file->GetLine(i).SetData(line);
+  }
+}
+
+// It touches no window, so it's also called by the threads which read the
+// files ahead. The lines of a paged file get their tabs expanded as they're
+// read, and a binary file is shown in hex, whatever its size.
+TextFile* Document::ReadTextFile(const wxString& path, int tab_size) {
+  TextFile* text_file = new TextFile(path);
+  if (!path.IsEmpty()) {
+    bool is_read = false;
+    if (TextFile::IsBinaryFile(path)) {
+      is_read = text_file->ReadHex();
+    } else if (TextFile::IsPagedFile(path)) {
+      is_read = text_file->ReadPaged(tab_size);
+    } else {
+      is_read = text_file->Read();
+    }
+    if (!is_read) {
+      delete text_file;
+      return NULL;
+    }
+    if (!text_file->IsFileLines()) {
+      ExpandTabs(text_file, tab_size);
+    }
+  }
+  if (text_file->GetLineCount() == 0) {
+    text_file->AddLine(wxT(""), LINE_END_TYPE_NONE);
+  }
+  return text_file;
+}
+
+bool Document::Load(int tab_size) {
+  if (IsLoaded()) {
+    return true;
+  }
+
+  TextFile* text_file = ReadTextFile(path_, tab_size);
+  if (text_file == NULL) {
+    return false;
+  }
+  SetTextFile(text_file);
+  return true;
+}
+
+void Document::SetTextFile(TextFile* text_file) {
+  assert(!IsLoaded());
+  text_file_ = text_file;
+  if (!text_file_->IsFileLines()) {
+    completion_index_.Reset(text_file_);
+  }
+  for (TextScrollWindow* view : views_) {
+    view->AttachTextFile();
+  }
+}
+
+void Document::Unload() {
+  if (!IsLoaded()) {
+    return;
+  }
+  for (TextScrollWindow* view : views_) {
+    view->DetachTextFile();
+  }
+  completion_index_.Clear();
+  delete text_file_;
+  text_file_ = NULL;
+}
+
+// The tabs of the lines appended are expanded before the views are told
+// about them. The lines are trimmed after, since the views keep their carets
+// on the lines left only if they're told about the lines dropped on their own.
+bool Document::ReadAppended(int tab_size, size_t max_line_count) {
+  if (!IsLoaded()) {
+    return true;
+  }
+  text_file_->BeginBatch();
+  size_t first_line = 0;
+  bool is_read = text_file_->ReadAppended(&first_line);
+  if (is_read && !text_file_->IsFileLines()) {
+    ExpandTabs(text_file_, tab_size, first_line);
+  }
+  text_file_->EndBatch();
+
+  if (is_read) {
+    text_file_->TrimLines(max_line_count);
+  }
+  return is_read;
+}
+
+bool Document::IsFileChanged() const {
+  return IsLoaded() && !is_new() && text_file_->IsFileChanged();
+}
+
+void Document::IgnoreFileChange() {
+  if (IsLoaded()) {
+    text_file_->UpdateFileStamp();
+  }
+}
+
+static wxString JoinLines(const TextFile* text_file, size_t first, size_t count, bool is_separator_first) {
+  wxString text;
+  for (size_t i = first; i < first + count; ++i) {
+    if (is_separator_first) {
+      text.Append(wxT('\r'));
+    }
+    text.Append(text_file->GetLine(i).GetData());
+    if (!is_separator_first && i + 1 != first + count) {
+      text.Append(wxT('\r'));
+    }
+  }
+  return text;
+}
+
+// A hunk followed by other lines replaces whole lines with their line breaks.
+// A hunk at the end replaces from the end of the line above it, or the whole
+// text if there is none.
+static ReplaceTextCommand* NewHunkCommand(TextFile* old_file, const TextFile* new_file, const DiffHunk& hunk) {
+  size_t old_end = hunk.old_first + hunk.old_count;
+  if (old_end != old_file->GetLineCount()) {
+    wxString old_text = JoinLines(old_file, hunk.old_first, hunk.old_count, false);
+    wxString new_text = JoinLines(new_file, hunk.new_first, hunk.new_count, false);
+    if (hunk.old_count != 0) {
+      old_text.Append(wxT('\r'));
+    }
+    if (hunk.new_count != 0) {
+      new_text.Append(wxT('\r'));
+    }
+    return new ReplaceTextCommand(old_file, wxPoint(0, hunk.old_first), old_text, new_text);
+  }
+  if (hunk.old_first != 0) {
+    int line = static_cast<int>(hunk.old_first - 1);
+    wxPoint position(old_file->GetLine(line).Len(), line);
+    return new ReplaceTextCommand(old_file,
+                                  position,
+                                  JoinLines(old_file, hunk.old_first, hunk.old_count, true),
+                                  JoinLines(new_file, hunk.new_first, hunk.new_count, true));
+  }
+  return new ReplaceTextCommand(old_file,
+                                wxPoint(0, 0),
+                                JoinLines(old_file, 0, hunk.old_count, false),
+                                JoinLines(new_file, 0, hunk.new_count, false));
+}
+
+static bool IsSameLine(const TextFile* old_file, size_t old_line, const TextFile* new_file, size_t new_line) {
+  return old_file->GetLine(old_line).GetData() == new_file->GetLine(new_line).GetData();
+}
+
+// The common head and tail are compared as they are, and only the lines
+// between them are hashed and diffed.
+static void DiffTextFiles(const TextFile* old_file, const TextFile* new_file, std::vector<DiffHunk>* hunks) {
+  size_t old_count = old_file->GetLineCount();
+  size_t new_count = new_file->GetLineCount();
+  size_t head = 0;
+  while (head < old_count && head < new_count && IsSameLine(old_file, head, new_file, head)) {
+    ++head;
+  }
+  size_t tail = 0;
+  while (tail < old_count - head && tail < new_count - head &&
+         IsSameLine(old_file, old_count - 1 - tail, new_file, new_count - 1 - tail)) {
+    ++tail;
+  }
+
+  std::vector<DiffLine> old_lines(old_count - head - tail);
+  std::vector<DiffLine> new_lines(new_count - head - tail);
+  for (size_t i = 0; i < old_lines.size(); ++i) {
+    old_lines[i].text = &old_file->GetLine(head + i).GetData();
+    old_lines[i].hash = HashLine(*old_lines[i].text);
+  }
+  for (size_t i = 0; i < new_lines.size(); ++i) {
+    new_lines[i].text = &new_file->GetLine(head + i).GetData();
+    new_lines[i].hash = HashLine(*new_lines[i].text);
+  }
+  DiffLines(old_lines, new_lines, kMaxDiffEditCount, hunks);
+
+  for (DiffHunk& hunk : *hunks) {
+    hunk.old_first += head;
+    hunk.new_first += head;
+  }
+}
+
+bool Document::Reload(int tab_size) {
+  TRACE_SCOPE("Document::Reload");
+  if (!IsLoaded()) {
+    return true;
+  }
+  // A paged or a hex text has no lines to diff, it would be read whole.
+  if (text_file_->IsFileLines()) {
+    Unload();
+    return Load(tab_size);
+  }
+  TextFile* text_file = ReadTextFile(path_, tab_size);
+  if (text_file == NULL) {
+    return false;
+  }
+  // The file grew to be paged, or turned binary. The diff keeps the lines
+  // it compares, which a page cache may drop, so the text is replaced.
+  if (text_file->IsFileLines()) {
+    Unload();
+    SetTextFile(text_file);
+    return true;
+  }
+
+  std::vector<DiffHunk> hunks;
+  DiffTextFiles(text_file_, text_file, &hunks);
+  if (!hunks.empty()) {
+    std::vector<ReplaceTextCommand*> commands;
+    for (const DiffHunk& hunk : hunks) {
+      commands.push_back(NewHunkCommand(text_file_, text_file, hunk));
+    }
+    text_file_->Execute(new CompositeEditCommand(text_file_, commands));
+  }
+  text_file_->SetFileState(*text_file);
+  delete text_file;
+  return true;
+}
+
+// The expanded tabs are written as tabs while the lines are encoded, so the
+// lines aren't changed under the views and their workers. A trimmed text
+// would truncate the file, and a paged text is read only. A hex text has
+// no tabs.
+bool Document::Save(int tab_size) {
+  if (!IsLoaded() || is_new() || text_file_->IsTrimmed() || text_file_->IsPaged()) {
+    return false;
+  }
+  if (text_file_->IsHex()) {
+    return text_file_->Write(path_);
+  }
+  return text_file_->Write(path_, tab_size);
+}
+
+bool Document::SaveAs(const wxString& path, int tab_size) {
+  wxString old_path = path_;
+  path_ = path;
+  if (IsLoaded()) {
+    text_file_->SetPath(path);
+  }
+  if (!Save(tab_size)) {
+    path_ = old_path;
+    if (IsLoaded()) {
+      text_file_->SetPath(old_path);
+    }
+    return false;
+  }
+  return true;
+}
+
+void Document::AddView(TextScrollWindow* view) {
+  views_.push_back(view);
+}
+
+void Document::RemoveView(TextScrollWindow* view) {
+  views_.erase(std::remove(views_.begin(), views_.end(), view), views_.end());
+}
+
+void Document::GetMemoryUsage(MemoryUsage* usage) const {
+  if (text_file_ != NULL) {
+    text_file_->GetMemoryUsage(usage);
+  }
+  usage->Add(MEMORY_COMPLETION_INDEX, completion_index_.GetMemoryUsage());
+}
+
+}  // namespace editor
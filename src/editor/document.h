@@ -0,0 +1,98 @@
+#ifndef EDITOR_DOCUMENT_H_
+#define EDITOR_DOCUMENT_H_
+#pragma once
+
+#include <vector>
+#include "wx/string.h"
+#include "editor/completion_index.h"
+
+namespace editor {
+
+class TextFile;
+class TextScrollWindow;
+class MemoryUsage;
+
+// A file opened in the editor. All views of the file share its TextFile,
+// which is only loaded while it's needed. An unloaded document keeps its
+// path, and its views keep their carets and scroll positions.
+class Document {
+public:
+  // A document with an empty path is a new file.
+  explicit Document(const wxString& path);
+  ~Document();
+
+  const wxString& path() const { return path_; }
+  bool is_new() const { return path_.IsEmpty(); }
+
+  // The file name, or "Untitled" for a new file.
+  wxString GetTitle() const;
+
+  TextFile* text_file() const { return text_file_; }
+  bool IsLoaded() const { return text_file_ != NULL; }
+  bool IsModified() const;
+
+  // Only a document which can be read again as it is can be unloaded.
+  bool CanUnload() const;
+
+  // Read the file and attach the views to it. Each tab is expanded to
+  // |tab_size| tab chars, so a column is a char. A binary file is shown in
+  // hex.
+  bool Load(int tab_size);
+
+  // Read the file the way Load() does. Return NULL if it can't be read.
+  static TextFile* ReadTextFile(const wxString& path, int tab_size);
+
+  // Take the text read by ReadTextFile() and attach the views to it.
+  void SetTextFile(TextFile* text_file);
+
+  // Detach the views and free the text.
+  void Unload();
+
+  bool Save(int tab_size);
+  bool SaveAs(const wxString& path, int tab_size);
+
+  // Follow mode. The lines appended to the file are added to the text, and
+  // the first lines are dropped if there are more than |max_line_count|.
+  // Return false if the file should be read again, see
+  // TextFile::ReadAppended().
+  bool is_following() const { return is_following_; }
+  void set_following(bool is_following) { is_following_ = is_following; }
+  bool ReadAppended(int tab_size, size_t max_line_count);
+
+  // True if the file is changed by another program since it was loaded or
+  // saved. IgnoreFileChange() takes the file as it is now as the one loaded.
+  bool IsFileChanged() const;
+  void IgnoreFileChange();
+
+  // Read the file again and change the text to it with one edit, which only
+  // replaces the lines which differ. The edit can be undone, and the views
+  // keep their carets and scroll positions. Return false if it can't be read.
+  // A paged or a hex file is only loaded again.
+  bool Reload(int tab_size);
+
+  // The words of the text for completion, shared by its views.
+  CompletionIndex& completion_index() { return completion_index_; }
+
+  void AddView(TextScrollWindow* view);
+  void RemoveView(TextScrollWindow* view);
+  const std::vector<TextScrollWindow*>& views() const { return views_; }
+
+  // The tick of the last activation, for unloading the least recently used
+  // documents first.
+  unsigned long last_used() const { return last_used_; }
+  void set_last_used(unsigned long last_used) { last_used_ = last_used; }
+
+  void GetMemoryUsage(MemoryUsage* usage) const;
+
+private:
+  wxString path_;
+  TextFile* text_file_;
+  CompletionIndex completion_index_;
+  std::vector<TextScrollWindow*> views_;
+  unsigned long last_used_;
+  bool is_following_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_DOCUMENT_H_
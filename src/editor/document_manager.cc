@@ -0,0 +1,118 @@
+#include "editor/document_manager.h"
+#include <algorithm>
+#include "wx/filename.h"
+#include "editor/config.h"
+#include "editor/document.h"
+#include "editor/text_scroll_window.h"
+
+namespace editor {
+
+const size_t DocumentManager::kMaxInactiveLoadedCount;
+
+static wxString NormalizePath(const wxString& path) {
+  wxFileName file_name(path);
+  file_name.Normalize(wxPATH_NORM_DOTS | wxPATH_NORM_ABSOLUTE | wxPATH_NORM_LONG);
+  return file_name.GetFullPath();
+}
+
+static bool IsShown(const Document* document) {
+  for (const TextScrollWindow* view : document->views()) {
+    if (view->IsShownOnScreen()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool IsUsedLater(const Document* lhs, const Document* rhs) {
+  return lhs->last_used() > rhs->last_used();
+}
+
+DocumentManager::DocumentManager(Config* config)
+    : config_(config),
+      use_count_(0) {
+}
+
+DocumentManager::~DocumentManager() {
+  for (Document* document : documents_) {
+    delete document;
+  }
+}
+
+Document* DocumentManager::Open(const wxString& path) {
+  Document* document = Find(path);
+  if (document == NULL) {
+    document = new Document(NormalizePath(path));
+    documents_.push_back(document);
+  }
+  return document;
+}
+
+Document* DocumentManager::NewDocument() {
+  Document* document = new Document(wxEmptyString);
+  documents_.push_back(document);
+  return document;
+}
+
+// wxFileName::SameAs() is case insensitive on the platforms which are.
+Document* DocumentManager::Find(const wxString& path) const {
+  wxFileName file_name(NormalizePath(path));
+  for (Document* document : documents_) {
+    if (!document->is_new() && file_name.SameAs(wxFileName(document->path()))) {
+      return document;
+    }
+  }
+  return NULL;
+}
+
+void DocumentManager::Release(Document* document) {
+  if (!document->views().empty()) {
+    return;
+  }
+  documents_.erase(std::remove(documents_.begin(), documents_.end(), document), documents_.end());
+  delete document;
+}
+
+bool DocumentManager::Activate(Document* document) {
+  document->set_last_used(++use_count_);
+  if (!document->Load(config_->tab_size_)) {
+    return false;
+  }
+  UnloadInactive();
+  return true;
+}
+
+size_t DocumentManager::GetLoadedCount() const {
+  size_t count = 0;
+  for (const Document* document : documents_) {
+    if (document->IsLoaded()) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+void DocumentManager::UnloadInactive() {
+  std::vector<Document*> documents;
+  for (Document* document : documents_) {
+    if (document->CanUnload() && document->last_used() != use_count_ && !IsShown(document)) {
+      documents.push_back(document);
+    }
+  }
+  if (documents.size() <= kMaxInactiveLoadedCount) {
+    return;
+  }
+
+  std::sort(documents.begin(), documents.end(), IsUsedLater);
+  for (size_t i = kMaxInactiveLoadedCount; i < documents.size(); ++i) {
+    documents[i]->Unload();
+  }
+}
+
+void DocumentManager::GetMemoryUsage(MemoryUsage* usage) const {
+  for (const Document* document : documents_) {
+    document->GetMemoryUsage(usage);
+  }
+}
+
+}  // namespace editor
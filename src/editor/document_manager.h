@@ -0,0 +1,61 @@
+#ifndef EDITOR_DOCUMENT_MANAGER_H_
+#define EDITOR_DOCUMENT_MANAGER_H_
+#pragma once
+
+#include <vector>
+#include "wx/string.h"
+
+namespace editor {
+
+class Config;
+class Document;
+class MemoryUsage;
+
+// Owns the open documents. A path is opened only once, and its document is
+// shared by all its views. Only the documents used lately are kept loaded,
+// so the memory grows with what's being worked on, not with the number of
+// open files.
+class DocumentManager {
+public:
+  // The number of unmodified documents kept loaded besides the active and
+  // the shown ones.
+  static const size_t kMaxInactiveLoadedCount = 4;
+
+  explicit DocumentManager(Config* config);
+  ~DocumentManager();
+
+  // Return the document of the path, which is created without loading the
+  // file if it isn't open.
+  Document* Open(const wxString& path);
+  Document* NewDocument();
+
+  // The open document of the path, or NULL.
+  Document* Find(const wxString& path) const;
+
+  // Close the document if it has no view any more.
+  void Release(Document* document);
+
+  // Load the document if needed and mark it as the latest used one. Return
+  // false if it can't be read.
+  bool Activate(Document* document);
+
+  const std::vector<Document*>& documents() const { return documents_; }
+  size_t GetLoadedCount() const;
+
+  // Add the memory of the loaded documents.
+  void GetMemoryUsage(MemoryUsage* usage) const;
+
+private:
+  // Unload the least recently used documents which can be unloaded, but
+  // keep the latest ones for switching back quickly.
+  void UnloadInactive();
+
+private:
+  Config* config_;
+  std::vector<Document*> documents_;
+  unsigned long use_count_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_DOCUMENT_MANAGER_H_
@@ -1,4 +1,6 @@
 #include "editor/edit_command.h"
+#include <algorithm>
+#include "editor/memory_usage.h"
 #include "editor/text_file.h"
 
 namespace editor {
@@ -11,6 +13,10 @@ EditCommand::EditCommand(TextFile* text_file, const wxPoint& position, const wxS
       text_(text) {
 }
 
+size_t EditCommand::GetMemoryUsage() const {
+  return sizeof(EditCommand) + GetStringMemoryUsage(text_);
+}
+
 // DeleteTextCommand
 
 DeleteTextCommand::DeleteTextCommand(TextFile* text_file, const wxPoint& position, const wxString& text)
@@ -39,4 +45,193 @@ void InsertTextCommand::Undo() {
   text_file_->DeleteText(position_, text_);
 }
 
+// ReplaceTextCommand
+
+ReplaceTextCommand::ReplaceTextCommand(TextFile* text_file,
+                                       const wxPoint& position,
+                                       const wxString& old_text,
+                                       const wxString& new_text)
+    : EditCommand(text_file, position, old_text),
+      new_text_(new_text) {
+}
+
+void ReplaceTextCommand::Execute() {
+  text_file_->DeleteText(position_, text_);
+  text_file_->InsertText(position_, new_text_);
+}
+
+void ReplaceTextCommand::Undo() {
+  text_file_->DeleteText(position_, new_text_);
+  text_file_->InsertText(position_, text_);
+}
+
+size_t ReplaceTextCommand::GetMemoryUsage() const {
+  return sizeof(ReplaceTextCommand) + GetStringMemoryUsage(text_) + GetStringMemoryUsage(new_text_);
+}
+
+// CompositeEditCommand
+
+static bool IsCommandBefore(const ReplaceTextCommand* lhs, const ReplaceTextCommand* rhs) {
+  const wxPoint& l = lhs->position();
+  const wxPoint& r = rhs->position();
+  return l.y < r.y || (l.y == r.y && l.x < r.x);
+}
+
+CompositeEditCommand::CompositeEditCommand(TextFile* text_file,
+                                           const std::vector<ReplaceTextCommand*>& commands)
+    : EditCommand(text_file, wxPoint(0, 0), wxEmptyString),
+      commands_(commands),
+      has_line_breaks_(false) {
+  std::stable_sort(commands_.begin(), commands_.end(), IsCommandBefore);
+  if (!commands_.empty()) {
+    position_ = commands_.front()->position();
+  }
+  CalcEndPositions();
+}
+
+CompositeEditCommand::~CompositeEditCommand() {
+  for (ReplaceTextCommand* command : commands_) {
+    delete command;
+  }
+}
+
+void CompositeEditCommand::Execute() {
+  if (has_line_breaks_) {
+    std::vector<TextReplacement> replacements(commands_.size());
+    for (size_t i = 0; i < commands_.size(); ++i) {
+      TextReplacement replacement = { commands_[i]->position(), &commands_[i]->old_text(), &commands_[i]->new_text() };
+      replacements[i] = replacement;
+    }
+    text_file_->ReplaceTexts(replacements, true);
+    return;
+  }
+  text_file_->BeginBatch();
+  for (size_t i = commands_.size(); i > 0; --i) {
+    commands_[i - 1]->Execute();
+  }
+  text_file_->EndBatch();
+}
+
+void CompositeEditCommand::Undo() {
+  if (has_line_breaks_) {
+    std::vector<TextReplacement> replacements(commands_.size());
+    for (size_t i = 0; i < commands_.size(); ++i) {
+      TextReplacement replacement = { start_positions_[i], &commands_[i]->new_text(), &commands_[i]->old_text() };
+      replacements[i] = replacement;
+    }
+    text_file_->ReplaceTexts(replacements, false);
+    return;
+  }
+  text_file_->BeginBatch();
+  for (size_t i = 0; i < commands_.size(); ++i) {
+    commands_[i]->Undo();
+  }
+  text_file_->EndBatch();
+}
+
+size_t CompositeEditCommand::GetMemoryUsage() const {
+  size_t bytes = sizeof(CompositeEditCommand) +
+      GetVectorMemoryUsage(commands_) +
+      GetVectorMemoryUsage(end_positions_) +
+      GetVectorMemoryUsage(start_positions_);
+  for (const ReplaceTextCommand* command : commands_) {
+    bytes += command->GetMemoryUsage();
+  }
+  return bytes;
+}
+
+// Maps every command into the coordinates after the whole batch in one pass.
+// Only the commands above can move a command: the line delta accumulates, and
+// the column shifts only if the previous command ended on the same line.
+void CompositeEditCommand::CalcEndPositions() {
+  end_positions_.clear();
+  end_positions_.reserve(commands_.size());
+  start_positions_.clear();
+  start_positions_.reserve(commands_.size());
+
+  int line_delta = 0;
+  wxPoint prev_old_end(-1, -1);
+  wxPoint prev_new_end(-1, -1);
+
+  for (ReplaceTextCommand* command : commands_) {
+    const wxPoint& old_start = command->position();
+    wxPoint old_end = GetTextEndPosition(old_start, command->old_text());
+
+    wxPoint new_start(old_start.x, old_start.y + line_delta);
+    if (old_start.y == prev_old_end.y) {
+      new_start.x = prev_new_end.x + old_start.x - prev_old_end.x;
+    }
+    wxPoint new_end = GetTextEndPosition(new_start, command->new_text());
+    if (old_end.y != old_start.y || new_end.y != new_start.y) {
+      has_line_breaks_ = true;
+    }
+
+    line_delta += (new_end.y - new_start.y) - (old_end.y - old_start.y);
+    prev_old_end = old_end;
+    prev_new_end = new_end;
+    start_positions_.push_back(new_start);
+    end_positions_.push_back(new_end);
+  }
+}
+
+// ConvertLineEndingsCommand
+
+ConvertLineEndingsCommand::ConvertLineEndingsCommand(TextFile* text_file, LineEndType type)
+    : EditCommand(text_file, wxPoint(0, 0), wxEmptyString),
+      type_(type) {
+}
+
+void ConvertLineEndingsCommand::Execute() {
+  old_runs_.clear();
+  text_file_->ConvertLineEnds(type_, &old_runs_);
+}
+
+void ConvertLineEndingsCommand::Undo() {
+  text_file_->RestoreLineEnds(old_runs_);
+}
+
+size_t ConvertLineEndingsCommand::GetMemoryUsage() const {
+  return sizeof(ConvertLineEndingsCommand) + old_runs_.capacity() * sizeof(LineEndRun);
+}
+
+// OverwriteBytesCommand
+
+OverwriteBytesCommand::OverwriteBytesCommand(TextFile* text_file,
+                                             unsigned long long offset,
+                                             const std::string& old_bytes,
+                                             const std::string& new_bytes,
+                                             const wxPoint& position,
+                                             const wxPoint& end_position)
+    : EditCommand(text_file, position, wxEmptyString),
+      offset_(offset),
+      old_bytes_(old_bytes),
+      new_bytes_(new_bytes),
+      end_position_(end_position) {
+}
+
+void OverwriteBytesCommand::Execute() {
+  text_file_->OverwriteBytes(offset_, new_bytes_, end_position_);
+}
+
+void OverwriteBytesCommand::Undo() {
+  text_file_->OverwriteBytes(offset_, old_bytes_, position_);
+}
+
+size_t OverwriteBytesCommand::GetMemoryUsage() const {
+  return sizeof(OverwriteBytesCommand) + old_bytes_.capacity() + new_bytes_.capacity();
+}
+
+wxPoint GetTextEndPosition(const wxPoint& position, const wxString& text) {
+  wxPoint end(position);
+  for (wxString::const_iterator it = text.begin(); it != text.end(); ++it) {
+    if (*it == '\r') {
+      ++end.y;
+      end.x = 0;
+    } else {
+      ++end.x;
+    }
+  }
+  return end;
+}
+
 }  // namespace editor
@@ -2,8 +2,12 @@
 #define EDITOR_EDIT_COMMAND_H_
 #pragma once
 
+#include <string>
+#include <vector>
 #include "wx/chartype.h"
 #include "wx/gdicmn.h"
+#include "wx/string.h"
+#include "editor/text_line.h"
 
 namespace editor {
 
@@ -19,6 +23,9 @@ public:
   virtual void Execute() = 0;
   virtual void Undo() = 0;
 
+  // The bytes of the command and the text it owns.
+  virtual size_t GetMemoryUsage() const;
+
 protected:
   TextFile* text_file_;
   wxPoint position_;
@@ -43,6 +50,109 @@ public:
   virtual void Undo() override;
 };
 
+// ReplaceTextCommand
+// Deletes the old text at the position and inserts the new text there.
+// Either text can be empty, so it also covers a plain insert or delete.
+class ReplaceTextCommand : public EditCommand {
+public:
+  ReplaceTextCommand(TextFile* text_file,
+                     const wxPoint& position,
+                     const wxString& old_text,
+                     const wxString& new_text);
+
+  virtual void Execute() override;
+  virtual void Undo() override;
+
+  const wxPoint& position() const { return position_; }
+  const wxString& old_text() const { return text_; }
+  const wxString& new_text() const { return new_text_; }
+
+  virtual size_t GetMemoryUsage() const override;
+
+private:
+  wxString new_text_;
+};
+
+// CompositeEditCommand
+// Runs several non-overlapping replacements as one undo step. The commands
+// are executed bottom-up so that the positions of the ones above stay valid,
+// and the text file sends a single notification for the whole batch. If any
+// of them adds or removes lines, they're done by one TextFile::ReplaceTexts()
+// instead, so the lines after each one aren't moved again for every one.
+class CompositeEditCommand : public EditCommand {
+public:
+  // Takes the ownership of the commands.
+  CompositeEditCommand(TextFile* text_file, const std::vector<ReplaceTextCommand*>& commands);
+  virtual ~CompositeEditCommand();
+
+  virtual void Execute() override;
+  virtual void Undo() override;
+
+  // The commands in document order.
+  const std::vector<ReplaceTextCommand*>& commands() const { return commands_; }
+
+  // The end of each inserted text after the whole batch is executed, in the
+  // same order as commands(). Used to put the carets back.
+  const std::vector<wxPoint>& end_positions() const { return end_positions_; }
+
+  virtual size_t GetMemoryUsage() const override;
+
+private:
+  void CalcEndPositions();
+
+private:
+  std::vector<ReplaceTextCommand*> commands_;
+  std::vector<wxPoint> end_positions_;
+
+  // The start of each inserted text after the batch, where it's undone.
+  std::vector<wxPoint> start_positions_;
+  bool has_line_breaks_;
+};
+
+// ConvertLineEndingsCommand
+// Makes every line end the same way. The old line ends are kept as runs, so
+// undoing the command restores a file of mixed line ends too.
+class ConvertLineEndingsCommand : public EditCommand {
+public:
+  ConvertLineEndingsCommand(TextFile* text_file, LineEndType type);
+
+  virtual void Execute() override;
+  virtual void Undo() override;
+
+  virtual size_t GetMemoryUsage() const override;
+
+private:
+  LineEndType type_;
+  std::vector<LineEndRun> old_runs_;
+};
+
+// OverwriteBytesCommand
+// Overwrites bytes of a hex text. The caret goes to |end_position| when the
+// command is executed and back to |position| when it's undone.
+class OverwriteBytesCommand : public EditCommand {
+public:
+  OverwriteBytesCommand(TextFile* text_file,
+                        unsigned long long offset,
+                        const std::string& old_bytes,
+                        const std::string& new_bytes,
+                        const wxPoint& position,
+                        const wxPoint& end_position);
+
+  virtual void Execute() override;
+  virtual void Undo() override;
+
+  virtual size_t GetMemoryUsage() const override;
+
+private:
+  unsigned long long offset_;
+  std::string old_bytes_;
+  std::string new_bytes_;
+  wxPoint end_position_;
+};
+
+// Returns the position after |text| if it is inserted at |position|.
+wxPoint GetTextEndPosition(const wxPoint& position, const wxString& text);
+
 }  // namespace editor
 
 #endif  // EDITOR_EDIT_COMMAND_H_
@@ -0,0 +1,137 @@
+#include "editor/edit_trace.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace editor {
+
+const size_t kDefaultLineCount = 10000;
+const size_t kDefaultLineLength = 60;
+
+static wxString DecodeText(const std::string& str) {
+  std::string text;
+  for (size_t i = 0; i < str.size(); ++i) {
+    if (str[i] != '\\' || i + 1 == str.size()) {
+      text += str[i];
+      continue;
+    }
+    char ch = str[++i];
+    if (ch == 'n') {
+      text += '\r';
+    } else if (ch == 't') {
+      text += '\t';
+    } else {
+      text += ch;
+    }
+  }
+  return wxString::FromUTF8(text.c_str(), text.size());
+}
+
+EditTrace::EditTrace()
+    : initial_line_count_(kDefaultLineCount),
+      initial_line_length_(kDefaultLineLength) {
+}
+
+bool EditTrace::Read(const wxString& path) {
+  std::ifstream ifs(path.fn_str(), std::ios::in);
+  if (!ifs.is_open() || !ifs.good()) {
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(ifs, line)) {
+    if (!line.empty() && line[line.size() - 1] == '\r') {
+      line.erase(line.size() - 1);
+    }
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    std::istringstream iss(line);
+    std::string name;
+    iss >> name;
+    if (name == "generate") {
+      size_t line_count = 0;
+      size_t line_length = 0;
+      if (!(iss >> line_count >> line_length)) {
+        return false;
+      }
+      SetInitialSize(line_count, line_length);
+    } else if (name == "insert") {
+      wxPoint position;
+      if (!(iss >> position.y >> position.x)) {
+        return false;
+      }
+      // The text is the rest of the line after one space.
+      std::string text;
+      if (iss.get() == ' ') {
+        std::getline(iss, text);
+      }
+      AddInsert(position, DecodeText(text));
+    } else if (name == "delete") {
+      wxPoint position;
+      wxPoint end_position;
+      if (!(iss >> position.y >> position.x >> end_position.y >> end_position.x)) {
+        return false;
+      }
+      AddDelete(position, end_position);
+    } else if (name == "undo") {
+      AddUndo();
+    } else if (name == "redo") {
+      AddRedo();
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+void EditTrace::SetInitialSize(size_t line_count, size_t line_length) {
+  initial_line_count_ = line_count == 0 ? 1 : line_count;
+  initial_line_length_ = line_length;
+}
+
+void EditTrace::AddInsert(const wxPoint& position, const wxString& text) {
+  Op op;
+  op.type = kInsert;
+  op.position = position;
+  op.text = text;
+  ops_.push_back(op);
+}
+
+void EditTrace::AddDelete(const wxPoint& position, const wxPoint& end_position) {
+  Op op;
+  op.type = kDelete;
+  op.position = position;
+  op.end_position = end_position;
+  ops_.push_back(op);
+}
+
+void EditTrace::AddUndo() {
+  Op op;
+  op.type = kUndo;
+  ops_.push_back(op);
+}
+
+void EditTrace::AddRedo() {
+  Op op;
+  op.type = kRedo;
+  ops_.push_back(op);
+}
+
+const char* EditTrace::GetOpName(OpType type) {
+  switch (type) {
+    case kInsert:
+      return "insert";
+    case kDelete:
+      return "delete";
+    case kUndo:
+      return "undo";
+    case kRedo:
+      return "redo";
+    default:
+      return "";
+  }
+}
+
+}  // namespace editor
@@ -0,0 +1,66 @@
+#ifndef EDITOR_EDIT_TRACE_H_
+#define EDITOR_EDIT_TRACE_H_
+#pragma once
+
+#include <vector>
+#include "wx/string.h"
+#include "wx/gdicmn.h"
+
+namespace editor {
+
+// A sequence of edits to replay on a text file. A trace is built by a
+// generator or read from a file with one edit per line:
+//
+//   # A comment.
+//   generate <line_count> <line_length>
+//   insert <line> <column> <text>
+//   delete <line> <column> <end_line> <end_column>
+//   undo
+//   redo
+//
+// Lines and columns start at 0 and are clamped to the text when the trace is
+// replayed. In <text>, "\n", "\t" and "\\" are a new line, a tab and a
+// backslash. "generate" gives the size of the file the edits are made on.
+class EditTrace {
+public:
+  enum OpType {
+    kInsert = 0,
+    kDelete,
+    kUndo,
+    kRedo,
+    kOpTypeCount,
+  };
+
+  struct Op {
+    OpType type;
+    wxPoint position;
+    wxPoint end_position;
+    wxString text;  // Lines are separated by '\r'.
+  };
+
+  EditTrace();
+
+  bool Read(const wxString& path);
+
+  void SetInitialSize(size_t line_count, size_t line_length);
+  size_t initial_line_count() const { return initial_line_count_; }
+  size_t initial_line_length() const { return initial_line_length_; }
+
+  void AddInsert(const wxPoint& position, const wxString& text);
+  void AddDelete(const wxPoint& position, const wxPoint& end_position);
+  void AddUndo();
+  void AddRedo();
+
+  const std::vector<Op>& ops() const { return ops_; }
+
+  static const char* GetOpName(OpType type);
+
+private:
+  size_t initial_line_count_;
+  size_t initial_line_length_;
+  std::vector<Op> ops_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_EDIT_TRACE_H_
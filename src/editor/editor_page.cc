@@ -0,0 +1,105 @@
+#include "editor/editor_page.h"
+#include "editor/document.h"
+#include "editor/text_scroll_window.h"
+
+namespace editor {
+
+wxBEGIN_EVENT_TABLE(EditorPage, wxSplitterWindow)
+EVT_CHILD_FOCUS(EditorPage::OnChildFocus)
+wxEND_EVENT_TABLE()
+
+const int kMinPaneSize = 100;
+
+EditorPage::EditorPage(Config* config)
+    : config_(config),
+      document_(NULL),
+      active_view_(NULL) {
+  views_[0] = NULL;
+  views_[1] = NULL;
+}
+
+EditorPage::~EditorPage() {
+  CloseDocument();
+}
+
+bool EditorPage::Create(wxWindow* parent, Document* document) {
+  if (!wxSplitterWindow::Create(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize,
+                                wxSP_3D | wxSP_LIVE_UPDATE)) {
+    return false;
+  }
+  SetMinimumPaneSize(kMinPaneSize);
+  SetSashGravity(0.5);
+
+  document_ = document;
+  views_[0] = NewView();
+  active_view_ = views_[0];
+  Initialize(views_[0]);
+  return true;
+}
+
+TextScrollWindow* EditorPage::NewView() {
+  TextScrollWindow* view = new TextScrollWindow(config_);
+  view->Create(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxVSCROLL | wxHSCROLL);
+  view->SetDocument(document_);
+  return view;
+}
+
+// The new view starts at the top of the text, the other one stays where it is.
+void EditorPage::SplitView() {
+  if (IsSplit()) {
+    return;
+  }
+  views_[1] = NewView();
+  SplitVertically(views_[0], views_[1]);
+  views_[1]->SetFocus();
+}
+
+void EditorPage::UnsplitView() {
+  if (IsSplit()) {
+    Unsplit(views_[1]);
+  }
+}
+
+// Also called when the sash is double clicked. The window removed may be
+// either view, the one left is always the first one.
+void EditorPage::OnUnsplit(wxWindow* removed) {
+  TextScrollWindow* view = static_cast<TextScrollWindow*>(removed);
+  if (view == views_[0]) {
+    views_[0] = views_[1];
+  }
+  views_[1] = NULL;
+  active_view_ = views_[0];
+
+  view->SetDocument(NULL);
+  view->Destroy();
+}
+
+void EditorPage::CloseDocument() {
+  for (TextScrollWindow* view : views_) {
+    if (view != NULL) {
+      view->SetDocument(NULL);
+    }
+  }
+  document_ = NULL;
+}
+
+void EditorPage::GetMemoryUsage(MemoryUsage* usage) const {
+  for (const TextScrollWindow* view : views_) {
+    if (view != NULL) {
+      view->GetMemoryUsage(usage);
+    }
+  }
+}
+
+// The focus is on a panel of the view.
+void EditorPage::OnChildFocus(wxChildFocusEvent& event) {
+  for (wxWindow* window = event.GetWindow(); window != NULL; window = window->GetParent()) {
+    if (window == views_[0] || window == views_[1]) {
+      active_view_ = static_cast<TextScrollWindow*>(window);
+      break;
+    }
+  }
+  event.Skip();
+}
+
+}  // namespace editor
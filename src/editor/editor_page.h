@@ -0,0 +1,56 @@
+#ifndef EDITOR_EDITOR_PAGE_H_
+#define EDITOR_EDITOR_PAGE_H_
+#pragma once
+
+#include "wx/splitter.h"
+
+namespace editor {
+
+class Config;
+class Document;
+class MemoryUsage;
+class TextScrollWindow;
+
+// The tab of a document. It shows one view of the document, or two views
+// side by side which share the text but scroll and select on their own.
+class EditorPage : public wxSplitterWindow {
+  wxDECLARE_EVENT_TABLE();
+
+public:
+  explicit EditorPage(Config* config);
+  ~EditorPage();
+
+  bool Create(wxWindow* parent, Document* document);
+
+  Document* GetDocument() const { return document_; }
+
+  // The view which had the focus last.
+  TextScrollWindow* GetActiveView() const { return active_view_; }
+
+  void SplitView();
+  void UnsplitView();
+
+  // Detach the views from the document before it's released.
+  void CloseDocument();
+
+  void GetMemoryUsage(MemoryUsage* usage) const;
+
+protected:
+  virtual void OnUnsplit(wxWindow* removed) override;
+
+private:
+  TextScrollWindow* NewView();
+  void OnChildFocus(wxChildFocusEvent& event);
+
+private:
+  Config* config_;
+  Document* document_;
+
+  // The second view is only there while the page is split.
+  TextScrollWindow* views_[2];
+  TextScrollWindow* active_view_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_EDITOR_PAGE_H_
@@ -0,0 +1,265 @@
+#include "editor/encoding.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EDITOR_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace editor {
+
+// The bytes looked at for the zeros of UTF-16 text without a byte order mark.
+const size_t kDetectSampleSize = 4096;
+
+const unsigned long kReplacementChar = 0xFFFD;
+
+FileEncoding DetectEncoding(const char* data, size_t size, size_t* bom_size) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  *bom_size = 0;
+  if (size >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF) {
+    *bom_size = 3;
+    return FILE_ENCODING_UTF8;
+  }
+  if (size >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE) {
+    *bom_size = 2;
+    return FILE_ENCODING_UTF16LE;
+  }
+  if (size >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF) {
+    *bom_size = 2;
+    return FILE_ENCODING_UTF16BE;
+  }
+
+  // Every other byte of ASCII text in UTF-16 is a zero, which is rare in
+  // the other encodings.
+  size_t sample_size = std::min(size, kDetectSampleSize) & ~static_cast<size_t>(1);
+  size_t even_zeros = 0;
+  size_t odd_zeros = 0;
+  for (size_t i = 0; i < sample_size; i += 2) {
+    even_zeros += bytes[i] == 0 ? 1 : 0;
+    odd_zeros += bytes[i + 1] == 0 ? 1 : 0;
+  }
+  size_t unit_count = sample_size / 2;
+  if (unit_count != 0) {
+    if (odd_zeros > unit_count / 2 && even_zeros * 8 < odd_zeros) {
+      return FILE_ENCODING_UTF16LE;
+    }
+    if (even_zeros > unit_count / 2 && odd_zeros * 8 < even_zeros) {
+      return FILE_ENCODING_UTF16BE;
+    }
+  }
+
+  return IsValidUtf8(data, size) ? FILE_ENCODING_UTF8 : FILE_ENCODING_LATIN1;
+}
+
+size_t FindNonAscii(const char* data, size_t size) {
+  size_t i = 0;
+#if defined(EDITOR_USE_SSE2)
+  for (; i + 16 <= size; i += 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    if (_mm_movemask_epi8(block) != 0) {
+      break;
+    }
+  }
+#else
+  for (; i + 8 <= size; i += 8) {
+    unsigned long long block = 0;
+    memcpy(&block, data + i, sizeof(block));
+    if ((block & 0x8080808080808080ULL) != 0) {
+      break;
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    if (static_cast<unsigned char>(data[i]) >= 0x80) {
+      return i;
+    }
+  }
+  return size;
+}
+
+bool IsValidUtf8(const char* data, size_t size) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  size_t i = 0;
+  while (true) {
+    i += FindNonAscii(data + i, size - i);
+    if (i == size) {
+      return true;
+    }
+
+    unsigned char lead = bytes[i];
+    size_t length = 0;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      length = 3;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      length = 4;
+    } else {
+      return false;
+    }
+    if (size - i < length) {
+      return false;
+    }
+    for (size_t k = 1; k < length; ++k) {
+      if ((bytes[i + k] & 0xC0) != 0x80) {
+        return false;
+      }
+    }
+    // The overlong forms, the surrogates and the code points beyond
+    // U+10FFFF are told by the second byte.
+    unsigned char second = bytes[i + 1];
+    if ((lead == 0xE0 && second < 0xA0) ||
+        (lead == 0xED && second > 0x9F) ||
+        (lead == 0xF0 && second < 0x90) ||
+        (lead == 0xF4 && second > 0x8F)) {
+      return false;
+    }
+    i += length;
+  }
+}
+
+static void AppendUtf8(unsigned long c, std::string* bytes) {
+  if (c < 0x80) {
+    bytes->push_back(static_cast<char>(c));
+  } else if (c < 0x800) {
+    bytes->push_back(static_cast<char>(0xC0 | (c >> 6)));
+    bytes->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+  } else if (c < 0x10000) {
+    bytes->push_back(static_cast<char>(0xE0 | (c >> 12)));
+    bytes->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+    bytes->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+  } else {
+    bytes->push_back(static_cast<char>(0xF0 | (c >> 18)));
+    bytes->push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+    bytes->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+    bytes->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+  }
+}
+
+static void AppendUtf16Unit(unsigned long unit, bool is_big_endian, std::string* bytes) {
+  char high = static_cast<char>(unit >> 8);
+  char low = static_cast<char>(unit & 0xFF);
+  bytes->push_back(is_big_endian ? high : low);
+  bytes->push_back(is_big_endian ? low : high);
+}
+
+static void AppendUtf16(unsigned long c, bool is_big_endian, std::string* bytes) {
+  if (c < 0x10000) {
+    AppendUtf16Unit(c, is_big_endian, bytes);
+  } else {
+    c -= 0x10000;
+    AppendUtf16Unit(0xD800 | (c >> 10), is_big_endian, bytes);
+    AppendUtf16Unit(0xDC00 | (c & 0x3FF), is_big_endian, bytes);
+  }
+}
+
+static bool IsHighSurrogate(unsigned long c) {
+  return c >= 0xD800 && c <= 0xDBFF;
+}
+
+static bool IsLowSurrogate(unsigned long c) {
+  return c >= 0xDC00 && c <= 0xDFFF;
+}
+
+static unsigned long GetUtf16Unit(const unsigned char* bytes, size_t i, bool is_big_endian) {
+  return is_big_endian ? (bytes[2 * i] << 8 | bytes[2 * i + 1]) : (bytes[2 * i + 1] << 8 | bytes[2 * i]);
+}
+
+void Utf16ToUtf8(const char* data, size_t size, bool is_big_endian, std::string* utf8) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  size_t unit_count = size / 2;
+  // Exact for ASCII text, which is the most of it usually.
+  utf8->reserve(utf8->size() + unit_count);
+  for (size_t i = 0; i < unit_count; ++i) {
+    unsigned long c = GetUtf16Unit(bytes, i, is_big_endian);
+    if (c < 0x80) {
+      utf8->push_back(static_cast<char>(c));
+      continue;
+    }
+    if (IsHighSurrogate(c) && i + 1 < unit_count) {
+      unsigned long low = GetUtf16Unit(bytes, i + 1, is_big_endian);
+      if (IsLowSurrogate(low)) {
+        c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+        ++i;
+      }
+    }
+    if (IsHighSurrogate(c) || IsLowSurrogate(c)) {
+      c = kReplacementChar;
+    }
+    AppendUtf8(c, utf8);
+  }
+  if (size % 2 != 0) {
+    AppendUtf8(kReplacementChar, utf8);
+  }
+}
+
+wxString DecodeLine(const char* data, size_t size, FileEncoding encoding) {
+  if (FindNonAscii(data, size) == size) {
+    return wxString::FromAscii(data, size);
+  }
+  if (encoding == FILE_ENCODING_LATIN1) {
+    return wxString(data, wxConvISO8859_1, size);
+  }
+  return wxString::FromUTF8Unchecked(data, size);
+}
+
+// The wide chars of wxString are UTF-16 where wchar_t has 2 bytes.
+static unsigned long GetCodePoint(const wchar_t* chars, size_t size, size_t* i) {
+  unsigned long c = static_cast<unsigned long>(chars[(*i)++]);
+  if (sizeof(wchar_t) == 2 && IsHighSurrogate(c) && *i < size) {
+    unsigned long low = static_cast<unsigned long>(chars[*i]);
+    if (IsLowSurrogate(low)) {
+      c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+      ++*i;
+    }
+  }
+  return c;
+}
+
+bool IsLatin1(const wxString& text) {
+  const wchar_t* chars = text.wc_str();
+  for (size_t i = 0; i < text.length(); ++i) {
+    if (static_cast<unsigned long>(chars[i]) > 0xFF) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void EncodeText(const wxString& text, FileEncoding encoding, std::string* bytes) {
+  const wchar_t* chars = text.wc_str();
+  size_t size = text.length();
+  bool is_big_endian = encoding == FILE_ENCODING_UTF16BE;
+  size_t i = 0;
+  while (i < size) {
+    unsigned long c = GetCodePoint(chars, size, &i);
+    switch (encoding) {
+      case FILE_ENCODING_UTF8:
+        AppendUtf8(c, bytes);
+        break;
+      case FILE_ENCODING_UTF16LE:
+      case FILE_ENCODING_UTF16BE:
+        AppendUtf16(c, is_big_endian, bytes);
+        break;
+      case FILE_ENCODING_LATIN1:
+        bytes->push_back(static_cast<char>(c));
+        break;
+    }
+  }
+}
+
+std::string GetBom(FileEncoding encoding) {
+  switch (encoding) {
+    case FILE_ENCODING_UTF8:
+      return std::string("\xEF\xBB\xBF");
+    case FILE_ENCODING_UTF16LE:
+      return std::string("\xFF\xFE");
+    case FILE_ENCODING_UTF16BE:
+      return std::string("\xFE\xFF");
+    default:
+      return std::string();
+  }
+}
+
+}  // namespace editor
@@ -0,0 +1,51 @@
+#ifndef EDITOR_ENCODING_H_
+#define EDITOR_ENCODING_H_
+#pragma once
+
+#include <string>
+#include "wx/string.h"
+
+namespace editor {
+
+enum FileEncoding {
+  FILE_ENCODING_UTF8 = 0,
+  FILE_ENCODING_UTF16LE,
+  FILE_ENCODING_UTF16BE,
+  FILE_ENCODING_LATIN1,
+};
+
+// The encoding of the bytes of a file, by its byte order mark, or else by
+// the zeros of UTF-16 text and whether it's valid UTF-8. |bom_size| is set
+// to the size of the byte order mark, 0 if there is none.
+FileEncoding DetectEncoding(const char* data, size_t size, size_t* bom_size);
+
+// The index of the first byte which isn't ASCII, or |size| if there is none.
+// The bytes are checked 16 at a time with SSE2, or 8 at a time without it.
+size_t FindNonAscii(const char* data, size_t size);
+
+// Overlong forms, surrogates and code points beyond U+10FFFF are invalid.
+// The ASCII runs are skipped with FindNonAscii().
+bool IsValidUtf8(const char* data, size_t size);
+
+// Transcode UTF-16 bytes to UTF-8 in one pass, appended to |utf8|, so the
+// lines are found and decoded the same way as in a UTF-8 file. Unpaired
+// surrogates and an odd last byte become U+FFFD.
+void Utf16ToUtf8(const char* data, size_t size, bool is_big_endian, std::string* utf8);
+
+// Decode a line of a Latin-1 file, or of a UTF-8 file, which UTF-16 files
+// are transcoded to first. An ASCII line is only widened.
+wxString DecodeLine(const char* data, size_t size, FileEncoding encoding);
+
+// True if every char of the text can be written in Latin-1.
+bool IsLatin1(const wxString& text);
+
+// Encode the text and append it to |bytes|. A Latin-1 text must be checked
+// with IsLatin1() first.
+void EncodeText(const wxString& text, FileEncoding encoding, std::string* bytes);
+
+// The byte order mark of the encoding, empty for Latin-1.
+std::string GetBom(FileEncoding encoding);
+
+}  // namespace editor
+
+#endif  // EDITOR_ENCODING_H_
@@ -0,0 +1,104 @@
+#include "editor/encoding.h"
+#include <string>
+#include "gtest/gtest.h"
+
+using namespace editor;
+
+namespace {
+
+const size_t kSampleSize = 4096;
+
+FileEncoding Detect(const std::string& bytes, size_t* bom_size) {
+  return DetectEncoding(bytes.data(), bytes.size(), bom_size);
+}
+
+// ASCII text as UTF-16 little endian.
+std::string Utf16Le(const std::string& ascii) {
+  std::string bytes;
+  for (size_t i = 0; i < ascii.size(); ++i) {
+    bytes += ascii[i];
+    bytes += '\0';
+  }
+  return bytes;
+}
+
+}  // namespace
+
+TEST(EncodingTest, Bom) {
+  size_t bom_size = 0;
+  EXPECT_EQ(FILE_ENCODING_UTF8, Detect("\xEF\xBB\xBF" "abc", &bom_size));
+  EXPECT_EQ(3u, bom_size);
+  EXPECT_EQ(FILE_ENCODING_UTF16LE, Detect(std::string("\xFF\xFE" "a\0", 4), &bom_size));
+  EXPECT_EQ(2u, bom_size);
+  EXPECT_EQ(FILE_ENCODING_UTF16BE, Detect(std::string("\xFE\xFF\0a", 4), &bom_size));
+  EXPECT_EQ(2u, bom_size);
+  EXPECT_EQ(FILE_ENCODING_UTF8, Detect("", &bom_size));
+  EXPECT_EQ(0u, bom_size);
+}
+
+TEST(EncodingTest, Utf16WithoutBom) {
+  size_t bom_size = 0;
+  std::string text(3000, 'a');
+  EXPECT_EQ(FILE_ENCODING_UTF16LE, Detect(Utf16Le(text), &bom_size));
+  EXPECT_EQ(0u, bom_size);
+  EXPECT_EQ(FILE_ENCODING_UTF16BE, Detect(Utf16Le(text).substr(1) + '\0', &bom_size));
+
+  // An odd last byte is out of the sample.
+  EXPECT_EQ(FILE_ENCODING_UTF16LE, Detect(Utf16Le(std::string(kSampleSize / 2, 'a')) + 'b', &bom_size));
+}
+
+TEST(EncodingTest, SampleBoundary) {
+  size_t bom_size = 0;
+
+  // Only the sample is checked for the zeros of UTF-16.
+  std::string ascii(kSampleSize, 'a');
+  EXPECT_EQ(FILE_ENCODING_UTF8, Detect(ascii + Utf16Le(std::string(kSampleSize, 'b')), &bom_size));
+
+  // But all bytes are checked for UTF-8, e.g. a char across the end of the
+  // sample, or an invalid byte after it.
+  std::string across = std::string(kSampleSize - 1, 'a') + "\xC3\xA9" + "b";
+  EXPECT_EQ(FILE_ENCODING_UTF8, Detect(across, &bom_size));
+  std::string cut = std::string(kSampleSize - 1, 'a') + "\xC3";
+  EXPECT_EQ(FILE_ENCODING_LATIN1, Detect(cut, &bom_size));
+  std::string invalid = ascii + "\xE9" + "t\xE9";
+  EXPECT_EQ(FILE_ENCODING_LATIN1, Detect(invalid, &bom_size));
+}
+
+TEST(EncodingTest, FindNonAscii) {
+  std::string bytes(40, 'a');
+  EXPECT_EQ(40u, FindNonAscii(bytes.data(), bytes.size()));
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    std::string other(bytes);
+    other[i] = '\x80';
+    EXPECT_EQ(i, FindNonAscii(other.data(), other.size()));
+  }
+}
+
+TEST(EncodingTest, IsValidUtf8) {
+  EXPECT_TRUE(IsValidUtf8("\xE4\xB8\xAD\xF0\x9F\x98\x80", 7));
+  EXPECT_FALSE(IsValidUtf8("\xC0\xAF", 2));  // overlong
+  EXPECT_FALSE(IsValidUtf8("\xED\xA0\x80", 3));  // surrogate
+  EXPECT_FALSE(IsValidUtf8("\xF4\x90\x80\x80", 4));  // beyond U+10FFFF
+  EXPECT_FALSE(IsValidUtf8("\xE4\xB8", 2));  // cut
+}
+
+TEST(EncodingTest, Utf16ToUtf8) {
+  std::string utf8;
+  // "a", U+4E2D, U+1F600 and an unpaired surrogate.
+  const char bytes[] = { 'a', 0, 0x2D, 0x4E, 0x3D, '\xD8', 0x00, '\xDE', 0x00, '\xD8' };
+  Utf16ToUtf8(bytes, sizeof(bytes), false, &utf8);
+  EXPECT_EQ("a\xE4\xB8\xAD\xF0\x9F\x98\x80\xEF\xBF\xBD", utf8);
+}
+
+TEST(EncodingTest, EncodeText) {
+  std::string bytes;
+  EncodeText(wxT("a\x00E9"), FILE_ENCODING_LATIN1, &bytes);
+  EXPECT_EQ("a\xE9", bytes);
+  EXPECT_TRUE(IsLatin1(wxT("a\x00E9")));
+  EXPECT_FALSE(IsLatin1(wxT("\x4E2D")));
+
+  bytes.clear();
+  EncodeText(wxT("a\x00E9"), FILE_ENCODING_UTF8, &bytes);
+  EXPECT_EQ("a\xC3\xA9", bytes);
+  EXPECT_EQ("", GetBom(FILE_ENCODING_LATIN1));
+}
@@ -0,0 +1,167 @@
+#include "editor/fenwick_tree.h"
+#include <cassert>
+
+namespace editor {
+
+static inline size_t LowBit(size_t i) {
+  return i & (~i + 1);
+}
+
+FenwickTree::FenwickTree() : high_bit_(0), depth_(0), gap_start_(0), gap_end_(0) {
+}
+
+void FenwickTree::Assign(const std::vector<int>& values) {
+  tree_ = values;
+  Build();
+}
+
+// The values are turned into the tree in place, each added to its parent.
+void FenwickTree::Build() {
+  size_t n = tree_.size();
+  for (size_t i = 1; i <= n; ++i) {
+    size_t parent = i + LowBit(i);
+    if (parent <= n) {
+      tree_[parent - 1] += tree_[i - 1];
+    }
+  }
+  gap_start_ = gap_end_ = n;
+
+  high_bit_ = 1;
+  depth_ = 1;
+  while (high_bit_ <= n / 2) {
+    high_bit_ <<= 1;
+    ++depth_;
+  }
+}
+
+void FenwickTree::Clear() {
+  tree_.clear();
+  high_bit_ = 0;
+  depth_ = 0;
+  gap_start_ = gap_end_ = 0;
+}
+
+// A node is the sum of its value and the nodes of its children, which are
+// the nodes before it down to its low bit.
+int FenwickTree::GetAt(size_t slot) const {
+  size_t i = slot + 1;
+  int value = tree_[i - 1];
+  size_t stop = i - LowBit(i);
+  for (size_t j = i - 1; j > stop; j -= LowBit(j)) {
+    value -= tree_[j - 1];
+  }
+  return value;
+}
+
+int FenwickTree::Get(size_t index) const {
+  return GetAt(ToSlot(index));
+}
+
+void FenwickTree::AddAt(size_t slot, int delta) {
+  for (size_t i = slot + 1; i <= tree_.size(); i += LowBit(i)) {
+    tree_[i - 1] += delta;
+  }
+}
+
+int FenwickTree::SumTo(size_t slot_count) const {
+  int sum = 0;
+  for (size_t i = slot_count; i > 0; i -= LowBit(i)) {
+    sum += tree_[i - 1];
+  }
+  return sum;
+}
+
+int FenwickTree::PrefixSum(size_t count) const {
+  return SumTo(count <= gap_start_ ? count : count + (gap_end_ - gap_start_));
+}
+
+size_t FenwickTree::FindCount(int sum) const {
+  size_t count = 0;
+  for (size_t bit = high_bit_; bit != 0; bit >>= 1) {
+    size_t next = count + bit;
+    if (next <= tree_.size() && tree_[next - 1] <= sum) {
+      count = next;
+      sum -= tree_[next - 1];
+    }
+  }
+  if (count <= gap_start_) {
+    return count;
+  }
+  return count < gap_end_ ? gap_start_ : count - (gap_end_ - gap_start_);
+}
+
+void FenwickTree::Insert(size_t index, size_t count, int value) {
+  assert(index <= size());
+  if (count == 0) {
+    return;
+  }
+  size_t gap_size = gap_end_ - gap_start_;
+  if (gap_size < count) {
+    gap_size = count + size() / 16 + 16;
+  }
+  MoveGap(index, gap_size);
+  if (value != 0) {
+    for (size_t slot = gap_start_; slot != gap_start_ + count; ++slot) {
+      AddAt(slot, value);
+    }
+  }
+  gap_start_ += count;
+}
+
+void FenwickTree::Erase(size_t index, size_t count) {
+  assert(index + count <= size());
+  if (count == 0) {
+    return;
+  }
+  MoveGap(index + count, gap_end_ - gap_start_);
+  for (size_t slot = index; slot != gap_start_; ++slot) {
+    AddAt(slot, -GetAt(slot));
+  }
+  gap_start_ = index;
+}
+
+// A value is moved across the gap in O(log n), so the tree is rebuilt
+// instead if more than n / log n values would be.
+void FenwickTree::MoveGap(size_t index, size_t gap_size) {
+  size_t distance = index < gap_start_ ? gap_start_ - index : index - gap_start_;
+  if (gap_size != gap_end_ - gap_start_ || distance * depth_ > tree_.size()) {
+    Rebuild(index, gap_size);
+    return;
+  }
+
+  for (; gap_start_ > index; --gap_start_, --gap_end_) {
+    int value = GetAt(gap_start_ - 1);
+    AddAt(gap_start_ - 1, -value);
+    AddAt(gap_end_ - 1, value);
+  }
+  for (; gap_start_ < index; ++gap_start_, ++gap_end_) {
+    int value = GetAt(gap_end_);
+    AddAt(gap_end_, -value);
+    AddAt(gap_start_, value);
+  }
+}
+
+// The tree is turned back into the values by subtracting each node from its
+// parent, from the last one.
+void FenwickTree::Rebuild(size_t index, size_t gap_size) {
+  size_t n = tree_.size();
+  for (size_t i = n; i > 0; --i) {
+    size_t parent = i + LowBit(i);
+    if (parent <= n) {
+      tree_[parent - 1] -= tree_[i - 1];
+    }
+  }
+
+  std::vector<int> values;
+  values.reserve(size() + gap_size);
+  values.insert(values.end(), tree_.begin(), tree_.begin() + gap_start_);
+  values.insert(values.end(), tree_.begin() + gap_end_, tree_.end());
+  values.insert(values.begin() + index, gap_size, 0);
+
+  tree_.swap(values);
+  Build();
+  gap_start_ = index;
+  gap_end_ = index + gap_size;
+}
+
+}  // namespace editor
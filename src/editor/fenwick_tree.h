@@ -0,0 +1,74 @@
+#ifndef EDITOR_FENWICK_TREE_H_
+#define EDITOR_FENWICK_TREE_H_
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace editor {
+
+// A binary indexed tree of ints. Prefix sums, point updates and the search
+// of a prefix sum are O(log n). Building it from the values is O(n).
+//
+// The tree is over a gap buffer: the values are kept in a wider array with
+// a run of zeros, the gap, at the last place values were inserted or erased.
+// A zero changes no sum, so values are inserted into or erased next to the
+// gap by updating their slots, in O(log n) each. Moving the gap moves the
+// values between its old and new places, or rebuilds the tree in O(n) if
+// that's faster, as does growing the gap, by a sixteenth of the size, when
+// it's full.
+class FenwickTree {
+public:
+  FenwickTree();
+
+  void Assign(const std::vector<int>& values);
+  void Clear();
+
+  size_t size() const { return tree_.size() - (gap_end_ - gap_start_); }
+
+  int Get(size_t index) const;
+  void Set(size_t index, int value) { Add(index, value - Get(index)); }
+  void Add(size_t index, int delta) { AddAt(ToSlot(index), delta); }
+
+  // Insert |count| values of |value| before |index|.
+  void Insert(size_t index, size_t count, int value);
+  void Erase(size_t index, size_t count);
+
+  // The sum of the first |count| values.
+  int PrefixSum(size_t count) const;
+  int TotalSum() const { return SumTo(tree_.size()); }
+
+  // The largest count whose prefix sum is not greater than |sum|. The
+  // values must not be negative.
+  size_t FindCount(int sum) const;
+
+  size_t GetMemoryUsage() const { return tree_.capacity() * sizeof(int); }
+
+private:
+  size_t ToSlot(size_t index) const {
+    return index < gap_start_ ? index : index + (gap_end_ - gap_start_);
+  }
+
+  int GetAt(size_t slot) const;
+  void AddAt(size_t slot, int delta);
+  int SumTo(size_t slot_count) const;
+
+  void Build();
+
+  // Move the gap before |index|, and make it |gap_size| wide if it isn't.
+  void MoveGap(size_t index, size_t gap_size);
+  void Rebuild(size_t index, size_t gap_size);
+
+private:
+  std::vector<int> tree_;
+  size_t high_bit_;
+  size_t depth_;  // the bits of high_bit_ and below
+
+  // The slots of the gap.
+  size_t gap_start_;
+  size_t gap_end_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_FENWICK_TREE_H_
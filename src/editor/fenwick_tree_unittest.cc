@@ -0,0 +1,145 @@
+#include "editor/fenwick_tree.h"
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace editor;
+
+namespace {
+
+// Check the tree against the values it should have.
+void ExpectValues(const FenwickTree& tree, const std::vector<int>& values) {
+  ASSERT_EQ(values.size(), tree.size());
+  int sum = 0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(sum, tree.PrefixSum(i));
+    EXPECT_EQ(values[i], tree.Get(i));
+    sum += values[i];
+  }
+  EXPECT_EQ(sum, tree.PrefixSum(values.size()));
+  EXPECT_EQ(sum, tree.TotalSum());
+
+  // The largest count whose prefix sum is not greater than each sum.
+  for (int target = 0; target <= sum + 1; ++target) {
+    size_t count = 0;
+    int prefix = 0;
+    for (size_t i = 0; i < values.size() && prefix + values[i] <= target; ++i) {
+      prefix += values[i];
+      count = i + 1;
+    }
+    EXPECT_EQ(count, tree.FindCount(target));
+  }
+}
+
+}  // namespace
+
+TEST(FenwickTreeTest, Empty) {
+  FenwickTree tree;
+  tree.Assign(std::vector<int>());
+  EXPECT_EQ(0u, tree.size());
+  EXPECT_EQ(0, tree.TotalSum());
+  EXPECT_EQ(0u, tree.FindCount(0));
+  EXPECT_EQ(0u, tree.FindCount(5));
+}
+
+TEST(FenwickTreeTest, PrefixSum) {
+  int values[] = { 3, 1, 4, 1, 5, 9, 2, 6, 5 };
+  std::vector<int> v(values, values + 9);
+  FenwickTree tree;
+  tree.Assign(v);
+
+  EXPECT_EQ(0, tree.PrefixSum(0));
+  EXPECT_EQ(3, tree.PrefixSum(1));
+  EXPECT_EQ(9, tree.PrefixSum(4));
+  EXPECT_EQ(36, tree.PrefixSum(9));
+  ExpectValues(tree, v);
+}
+
+TEST(FenwickTreeTest, FindCount) {
+  // Zeros, e.g. the rows of hidden lines, are skipped by the search.
+  int values[] = { 1, 0, 0, 2, 1, 0, 3 };
+  std::vector<int> v(values, values + 7);
+  FenwickTree tree;
+  tree.Assign(v);
+
+  EXPECT_EQ(0u, tree.FindCount(0));
+  EXPECT_EQ(3u, tree.FindCount(1));
+  EXPECT_EQ(3u, tree.FindCount(2));
+  EXPECT_EQ(4u, tree.FindCount(3));
+  EXPECT_EQ(6u, tree.FindCount(4));
+  EXPECT_EQ(6u, tree.FindCount(6));
+  EXPECT_EQ(7u, tree.FindCount(7));
+  EXPECT_EQ(7u, tree.FindCount(100));
+}
+
+TEST(FenwickTreeTest, SetAndAdd) {
+  std::vector<int> v(20, 1);
+  FenwickTree tree;
+  tree.Assign(v);
+
+  tree.Set(5, 4);
+  v[5] = 4;
+  tree.Add(19, 2);
+  v[19] += 2;
+  tree.Set(0, 0);
+  v[0] = 0;
+  ExpectValues(tree, v);
+}
+
+TEST(FenwickTreeTest, InsertAndErase) {
+  std::vector<int> v(10, 1);
+  FenwickTree tree;
+  tree.Assign(v);
+
+  tree.Insert(4, 3, 2);
+  v.insert(v.begin() + 4, 3, 2);
+  ExpectValues(tree, v);
+
+  // Next to the gap.
+  tree.Insert(7, 1, 5);
+  v.insert(v.begin() + 7, 1, 5);
+  tree.Erase(2, 3);
+  v.erase(v.begin() + 2, v.begin() + 5);
+  ExpectValues(tree, v);
+
+  // Away from the gap, at both ends.
+  tree.Insert(0, 2, 3);
+  v.insert(v.begin(), 2, 3);
+  tree.Insert(v.size(), 1, 7);
+  v.push_back(7);
+  tree.Erase(v.size() - 4, 4);
+  v.erase(v.end() - 4, v.end());
+  ExpectValues(tree, v);
+
+  tree.Erase(0, v.size());
+  v.clear();
+  ExpectValues(tree, v);
+  tree.Insert(0, 3, 1);
+  v.assign(3, 1);
+  ExpectValues(tree, v);
+}
+
+TEST(FenwickTreeTest, ManyEdits) {
+  std::vector<int> v(100, 1);
+  FenwickTree tree;
+  tree.Assign(v);
+
+  unsigned int seed = 1;
+  for (int i = 0; i < 500; ++i) {
+    seed = seed * 1103515245 + 12345;
+    size_t index = (seed >> 8) % (v.size() + 1);
+    size_t count = (seed >> 4) % 5;
+    if (seed % 3 == 0 && index + count <= v.size()) {
+      tree.Erase(index, count);
+      v.erase(v.begin() + index, v.begin() + index + count);
+    } else if (seed % 3 == 1) {
+      int value = (seed >> 16) % 4;
+      tree.Insert(index, count, value);
+      v.insert(v.begin() + index, count, value);
+    } else if (index < v.size()) {
+      int value = (seed >> 16) % 4;
+      tree.Set(index, value);
+      v[index] = value;
+    }
+  }
+  ExpectValues(tree, v);
+}
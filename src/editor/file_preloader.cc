@@ -0,0 +1,56 @@
+#include "editor/file_preloader.h"
+#include "wx/event.h"
+#include "editor/document.h"
+#include "editor/text_file.h"
+#include "editor/trace.h"
+
+namespace editor {
+
+FilePreloader::FilePreloader(wxEvtHandler* handler,
+                             int event_id,
+                             const std::vector<wxString>& paths,
+                             int tab_size)
+    : wxThread(wxTHREAD_JOINABLE),
+      handler_(handler),
+      event_id_(event_id),
+      paths_(paths),
+      tab_size_(tab_size) {
+}
+
+FilePreloader::~FilePreloader() {
+  for (TextFile* text_file : text_files_) {
+    delete text_file;
+  }
+}
+
+void FilePreloader::TakeTextFiles(std::vector<TextFile*>* text_files) {
+  wxMutexLocker locker(mutex_);
+  text_files->insert(text_files->end(), text_files_.begin(), text_files_.end());
+  text_files_.clear();
+}
+
+wxThread::ExitCode FilePreloader::Entry() {
+  for (const wxString& path : paths_) {
+    if (TestDestroy()) {
+      break;
+    }
+
+    TextFile* text_file = NULL;
+    {
+      TRACE_SCOPE("FilePreloader::ReadTextFile");
+      text_file = Document::ReadTextFile(path, tab_size_);
+    }
+    if (text_file == NULL) {
+      continue;
+    }
+
+    {
+      wxMutexLocker locker(mutex_);
+      text_files_.push_back(text_file);
+    }
+    wxQueueEvent(handler_, new wxThreadEvent(wxEVT_THREAD, event_id_));
+  }
+  return static_cast<ExitCode>(0);
+}
+
+}  // namespace editor
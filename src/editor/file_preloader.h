@@ -0,0 +1,47 @@
+#ifndef EDITOR_FILE_PRELOADER_H_
+#define EDITOR_FILE_PRELOADER_H_
+#pragma once
+
+#include <vector>
+#include "wx/string.h"
+#include "wx/thread.h"
+
+class wxEvtHandler;
+
+namespace editor {
+
+class TextFile;
+
+// Reads files in a thread before they're shown. A wxThreadEvent of
+// |event_id| is queued to |handler| after each file, and the handler takes
+// the texts read on the main thread.
+class FilePreloader : public wxThread {
+public:
+  FilePreloader(wxEvtHandler* handler,
+                int event_id,
+                const std::vector<wxString>& paths,
+                int tab_size);
+
+  // Delete the texts which aren't taken.
+  ~FilePreloader();
+
+  // Move the texts read so far to |text_files|. A file which can't be read
+  // is skipped.
+  void TakeTextFiles(std::vector<TextFile*>* text_files);
+
+protected:
+  virtual ExitCode Entry() override;
+
+private:
+  wxEvtHandler* handler_;
+  int event_id_;
+  std::vector<wxString> paths_;
+  int tab_size_;
+
+  wxMutex mutex_;
+  std::vector<TextFile*> text_files_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_FILE_PRELOADER_H_
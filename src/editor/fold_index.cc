@@ -0,0 +1,736 @@
+#include "editor/fold_index.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include "editor/memory_usage.h"
+#include "editor/text_file.h"
+#include "editor/trace.h"
+
+namespace editor {
+
+static bool IsFoldBefore(const Interval& lhs, const Interval& rhs) {
+  return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.last > rhs.last);
+}
+
+static bool IsFirstBefore(const Interval& lhs, size_t first) {
+  return lhs.first < first;
+}
+
+static bool IsFirstAfter(size_t first, const Interval& rhs) {
+  return first < rhs.first;
+}
+
+FoldIndex::FoldIndex()
+    : text_file_(NULL),
+      is_scanned_(false),
+      leaf_count_(0),
+      stale_first_(0),
+      stale_end_(0),
+      is_regions_built_(false),
+      is_dirty_(false),
+      dirty_first_(0),
+      dirty_end_(0),
+      dirty_shift_(0),
+      hidden_counts_(1, 0) {
+}
+
+void FoldIndex::Reset(const TextFile* text_file) {
+  Clear();
+  text_file_ = text_file;
+}
+
+void FoldIndex::Clear() {
+  text_file_ = NULL;
+  is_scanned_ = false;
+  std::vector<LineScan>().swap(line_scans_);
+  std::vector<BlockSummary>().swap(tree_);
+  leaf_count_ = 0;
+  stale_first_ = 0;
+  stale_end_ = 0;
+  regions_.Clear();
+  is_regions_built_ = false;
+  unmatched_lines_.clear();
+  is_dirty_ = false;
+  folds_.clear();
+  hidden_ranges_.clear();
+  hidden_counts_.assign(1, 0);
+}
+
+void FoldIndex::AddLineDepth(const LineScan& scan, Depth* depth) {
+  depth->sum -= scan.close_count;
+  depth->min_prefix = std::min(depth->min_prefix, depth->sum);
+  depth->sum += scan.open_count;
+}
+
+FoldIndex::Depth FoldIndex::JoinDepths(const Depth& lhs, const Depth& rhs) {
+  Depth depth;
+  depth.sum = lhs.sum + rhs.sum;
+  depth.min_prefix = std::min(lhs.min_prefix, lhs.sum + rhs.min_prefix);
+  return depth;
+}
+
+FoldIndex::BlockSummary FoldIndex::JoinSummaries(const BlockSummary& lhs, const BlockSummary& rhs) {
+  BlockSummary summary;
+  summary.depth = JoinDepths(lhs.depth, rhs.depth);
+  summary.min_indent = std::min(lhs.min_indent, rhs.min_indent);
+  return summary;
+}
+
+// The braces of the tokens are counted, so the ones in strings and comments
+// are skipped. Other text is still folded by its indent.
+void FoldIndex::ScanLine(size_t line, bool is_in_comment, LineScan* scan) {
+  const wxString& data = text_file_->GetLine(line).GetData();
+  scan->indent = -1;
+  scan->close_count = 0;
+  scan->open_count = 0;
+
+  int indent = 0;
+  for (wxString::const_iterator it = data.begin(); it != data.end(); ++it, ++indent) {
+    if (*it != wxT(' ') && *it != wxT('\t')) {
+      scan->indent = indent;
+      break;
+    }
+  }
+
+  syntax::CppParser::State state =
+      is_in_comment ? syntax::CppParser::STATE_BLOCK_COMMENT : syntax::CppParser::STATE_NORMAL;
+  tokens_.clear();
+  state = syntax::CppParser::ParseLine(data, state, &tokens_);
+  for (const syntax::Token& token : tokens_) {
+    if (token.kind != syntax::TOKEN_PUNCTUATION) {
+      continue;
+    }
+    wxChar ch = data[token.column];
+    if (ch == wxT('{')) {
+      ++scan->open_count;
+    } else if (ch == wxT('}')) {
+      if (scan->open_count > 0) {
+        --scan->open_count;
+      } else {
+        ++scan->close_count;
+      }
+    }
+  }
+  scan->is_in_comment = state == syntax::CppParser::STATE_BLOCK_COMMENT;
+}
+
+void FoldIndex::ScanLines() {
+  if (is_scanned_) {
+    return;
+  }
+  TRACE_SCOPE("FoldIndex::ScanLines");
+  line_scans_.resize(text_file_->GetLineCount());
+  bool is_in_comment = false;
+  for (size_t i = 0; i < line_scans_.size(); ++i) {
+    ScanLine(i, is_in_comment, &line_scans_[i]);
+    is_in_comment = line_scans_[i].is_in_comment;
+  }
+  is_scanned_ = true;
+  leaf_count_ = 0;
+  is_regions_built_ = false;
+}
+
+bool FoldIndex::IsInCommentBefore(size_t line) const {
+  return line != 0 && line_scans_[line - 1].is_in_comment;
+}
+
+void FoldIndex::UpdateBlock(size_t block) {
+  BlockSummary& leaf = tree_[leaf_count_ + block];
+  leaf.depth.sum = 0;
+  leaf.depth.min_prefix = 0;
+  leaf.min_indent = INT_MAX;
+
+  size_t end_line = std::min((block + 1) * kBlockLineCount, line_scans_.size());
+  for (size_t i = block * kBlockLineCount; i < end_line; ++i) {
+    const LineScan& scan = line_scans_[i];
+    AddLineDepth(scan, &leaf.depth);
+    if (scan.indent >= 0) {
+      leaf.min_indent = std::min(leaf.min_indent, scan.indent);
+    }
+  }
+}
+
+void FoldIndex::UpdateTree() {
+  size_t block_count = (line_scans_.size() + kBlockLineCount - 1) / kBlockLineCount;
+  size_t leaf_count = 1;
+  while (leaf_count < block_count) {
+    leaf_count <<= 1;
+  }
+  if (leaf_count != leaf_count_) {
+    leaf_count_ = leaf_count;
+    tree_.resize(leaf_count_ * 2);
+    stale_first_ = 0;
+    stale_end_ = leaf_count_;
+  }
+
+  stale_end_ = std::min(stale_end_, leaf_count_);
+  if (stale_first_ >= stale_end_) {
+    return;
+  }
+  TRACE_SCOPE("FoldIndex::UpdateTree");
+
+  for (size_t block = stale_first_; block != stale_end_; ++block) {
+    UpdateBlock(block);
+  }
+  // The parents of the nodes updated, level by level up to the root.
+  size_t first_node = (leaf_count_ + stale_first_) / 2;
+  size_t last_node = (leaf_count_ + stale_end_ - 1) / 2;
+  for (; first_node != 0; first_node /= 2, last_node /= 2) {
+    for (size_t node = first_node; node <= last_node; ++node) {
+      tree_[node] = JoinSummaries(tree_[node * 2], tree_[node * 2 + 1]);
+    }
+  }
+  stale_first_ = 0;
+  stale_end_ = 0;
+}
+
+FoldIndex::Depth FoldIndex::GetDepthFrom(size_t first_line) const {
+  Depth depth = { 0, 0 };
+  size_t block = first_line / kBlockLineCount;
+  size_t end_line = std::min((block + 1) * kBlockLineCount, line_scans_.size());
+  for (size_t i = first_line; i < end_line; ++i) {
+    AddLineDepth(line_scans_[i], &depth);
+  }
+
+  // The nodes over the blocks after, joined from both ends of their range.
+  Depth right_depth = { 0, 0 };
+  size_t begin = leaf_count_ + block + 1;
+  size_t end = leaf_count_ * 2;
+  for (; begin < end; begin /= 2, end /= 2) {
+    if (begin % 2 == 1) {
+      depth = JoinDepths(depth, tree_[begin++].depth);
+    }
+    if (end % 2 == 1) {
+      right_depth = JoinDepths(tree_[--end].depth, right_depth);
+    }
+  }
+  return JoinDepths(depth, right_depth);
+}
+
+size_t FoldIndex::FindDepthLine(size_t first_line, int depth) const {
+  size_t line_count = line_scans_.size();
+  size_t block = first_line / kBlockLineCount;
+  size_t line = first_line;
+  for (int pass = 0; pass < 2; ++pass) {
+    size_t end_line = std::min((block + 1) * kBlockLineCount, line_count);
+    for (; line < end_line; ++line) {
+      const LineScan& scan = line_scans_[line];
+      if (depth - scan.close_count <= 0) {
+        return line;
+      }
+      depth += scan.open_count - scan.close_count;
+    }
+    if (pass == 0) {
+      block = FindDepthBlock(1, 0, leaf_count_, block + 1, &depth);
+      if (block == kNoBlock) {
+        break;
+      }
+      line = block * kBlockLineCount;
+    }
+  }
+  return line_count;
+}
+
+// The first block from |first_block| on where the depth drops to 0.
+size_t FoldIndex::FindDepthBlock(size_t node, size_t begin, size_t end, size_t first_block, int* depth) const {
+  if (end <= first_block) {
+    return kNoBlock;
+  }
+  const Depth& node_depth = tree_[node].depth;
+  if (begin >= first_block && *depth + node_depth.min_prefix > 0) {
+    *depth += node_depth.sum;
+    return kNoBlock;
+  }
+  if (end - begin == 1) {
+    return begin;
+  }
+  size_t mid = begin + (end - begin) / 2;
+  size_t block = FindDepthBlock(node * 2, begin, mid, first_block, depth);
+  if (block != kNoBlock) {
+    return block;
+  }
+  return FindDepthBlock(node * 2 + 1, mid, end, first_block, depth);
+}
+
+size_t FoldIndex::FindIndentLine(size_t first_line, int indent) const {
+  size_t line_count = line_scans_.size();
+  size_t block = first_line / kBlockLineCount;
+  size_t line = first_line;
+  for (int pass = 0; pass < 2; ++pass) {
+    size_t end_line = std::min((block + 1) * kBlockLineCount, line_count);
+    for (; line < end_line; ++line) {
+      int line_indent = line_scans_[line].indent;
+      if (line_indent >= 0 && line_indent <= indent) {
+        return line;
+      }
+    }
+    if (pass == 0) {
+      block = FindIndentBlock(1, 0, leaf_count_, block + 1, indent);
+      if (block == kNoBlock) {
+        break;
+      }
+      line = block * kBlockLineCount;
+    }
+  }
+  return line_count;
+}
+
+size_t FoldIndex::FindIndentBlock(size_t node, size_t begin, size_t end, size_t first_block, int indent) const {
+  if (end <= first_block || (begin >= first_block && tree_[node].min_indent > indent)) {
+    return kNoBlock;
+  }
+  if (end - begin == 1) {
+    return begin;
+  }
+  size_t mid = begin + (end - begin) / 2;
+  size_t block = FindIndentBlock(node * 2, begin, mid, first_block, indent);
+  if (block != kNoBlock) {
+    return block;
+  }
+  return FindIndentBlock(node * 2 + 1, mid, end, first_block, indent);
+}
+
+// The braces a line leaves open are closed from the last one, so the one
+// of the longest region is the first brace which is closed, where the
+// depth after the line first drops to the braces never closed.
+bool FoldIndex::FindBraceRegion(size_t first, Interval* region, bool* is_unmatched) const {
+  int open_count = line_scans_[first].open_count;
+  if (open_count == 0) {
+    return false;
+  }
+  int unmatched_count = std::max(0, open_count + GetDepthFrom(first + 1).min_prefix);
+  *is_unmatched = unmatched_count > 0;
+  if (unmatched_count == open_count) {
+    return false;
+  }
+  size_t close_line = FindDepthLine(first + 1, open_count - unmatched_count);
+  if (close_line <= first + 1) {
+    return false;
+  }
+  region->first = first;
+  region->last = close_line - 1;
+  return true;
+}
+
+bool FoldIndex::FindIndentRegion(size_t first, Interval* region) const {
+  int indent = line_scans_[first].indent;
+  if (indent < 0) {
+    return false;
+  }
+  size_t last = FindIndentLine(first + 1, indent);
+  do {
+    --last;
+  } while (line_scans_[last].indent < 0);
+  if (last == first) {
+    return false;
+  }
+  region->first = first;
+  region->last = last;
+  return true;
+}
+
+// A brace region is kept rather than an indent region, as BuildRegions()
+// does.
+bool FoldIndex::FindRegion(size_t first, Interval* region, bool* is_unmatched) const {
+  *is_unmatched = false;
+  return FindBraceRegion(first, region, is_unmatched) || FindIndentRegion(first, region);
+}
+
+// A brace region ends at the line before its closing brace, so the brace
+// stays shown. An indent region ends at the last line indented deeper than
+// its first line, and is kept only if no brace region starts there too.
+// One region, the longest, is kept per first line.
+void FoldIndex::BuildRegions() {
+  TRACE_SCOPE("FoldIndex::BuildRegions");
+  size_t line_count = line_scans_.size();
+  std::vector<Interval> regions;
+  std::vector<bool> is_brace_first(line_count, false);
+
+  std::vector<size_t> open_lines;
+  for (size_t i = 0; i < line_count; ++i) {
+    const LineScan& scan = line_scans_[i];
+    for (int j = 0; j < scan.close_count && !open_lines.empty(); ++j) {
+      size_t open_line = open_lines.back();
+      open_lines.pop_back();
+      if (i > open_line + 1) {
+        Interval region = { open_line, i - 1 };
+        regions.push_back(region);
+        is_brace_first[open_line] = true;
+      }
+    }
+    open_lines.insert(open_lines.end(), scan.open_count, i);
+  }
+  unmatched_lines_.assign(open_lines.begin(), std::unique(open_lines.begin(), open_lines.end()));
+
+  std::vector<size_t> indent_lines;
+  size_t last_line = 0;
+  for (size_t i = 0; i <= line_count; ++i) {
+    int indent = i < line_count ? line_scans_[i].indent : 0;
+    if (indent < 0) {
+      continue;
+    }
+    while (!indent_lines.empty() && line_scans_[indent_lines.back()].indent >= indent) {
+      size_t first_line = indent_lines.back();
+      indent_lines.pop_back();
+      if (last_line > first_line && !is_brace_first[first_line]) {
+        Interval region = { first_line, last_line };
+        regions.push_back(region);
+      }
+    }
+    indent_lines.push_back(i);
+    last_line = i;
+  }
+
+  std::sort(regions.begin(), regions.end(), IsFoldBefore);
+  std::vector<Interval>::iterator end = regions.begin();
+  for (std::vector<Interval>::iterator iter = regions.begin(); iter != regions.end(); ++iter) {
+    if (end == regions.begin() || (end - 1)->first != iter->first) {
+      *end++ = *iter;
+    }
+  }
+  regions.erase(end, regions.end());
+
+  regions_.Assign(&regions);
+  is_regions_built_ = true;
+  is_dirty_ = false;
+}
+
+// The regions which start before the dirty lines and end in or after them
+// have the last line which isn't blank before them, or start there, unless
+// they're of braces never closed. They're found again with the ones which
+// start in the dirty lines. The regions after are moved.
+void FoldIndex::UpdateRegions() {
+  if (!is_regions_built_) {
+    BuildRegions();
+    return;
+  }
+  if (!is_dirty_) {
+    return;
+  }
+  TRACE_SCOPE("FoldIndex::UpdateRegions");
+  size_t old_end_line = dirty_end_ - dirty_shift_;
+
+  std::vector<size_t> firsts;
+  size_t line = dirty_first_;
+  while (line > 0 && line_scans_[line - 1].indent < 0) {
+    --line;
+  }
+  if (line > 0) {
+    std::vector<size_t> indexes;
+    regions_.FindContaining(line - 1, &indexes);
+    for (size_t index : indexes) {
+      firsts.push_back(regions_[index].first);
+    }
+    firsts.push_back(line - 1);
+  }
+  std::vector<size_t>::iterator unmatched_end =
+      std::lower_bound(unmatched_lines_.begin(), unmatched_lines_.end(), dirty_first_);
+  firsts.insert(firsts.end(), unmatched_lines_.begin(), unmatched_end);
+  std::sort(firsts.begin(), firsts.end());
+  firsts.erase(std::unique(firsts.begin(), firsts.end()), firsts.end());
+  for (line = dirty_first_; line != dirty_end_; ++line) {
+    firsts.push_back(line);
+  }
+
+  std::vector<Interval> found_regions;
+  std::vector<size_t> unmatched_lines;
+  for (size_t first : firsts) {
+    Interval region;
+    bool is_unmatched = false;
+    if (FindRegion(first, &region, &is_unmatched)) {
+      found_regions.push_back(region);
+    }
+    if (is_unmatched) {
+      unmatched_lines.push_back(first);
+    }
+  }
+  for (std::vector<size_t>::iterator iter = unmatched_lines_.begin(); iter != unmatched_lines_.end(); ++iter) {
+    if (*iter >= old_end_line) {
+      unmatched_lines.push_back(*iter + dirty_shift_);
+    }
+  }
+  unmatched_lines_.swap(unmatched_lines);
+
+  // Merge the regions found into the ones kept.
+  std::vector<Interval> regions;
+  regions.reserve(regions_.size() + found_regions.size());
+  size_t found_index = 0;
+  for (size_t i = 0; i < regions_.size(); ++i) {
+    Interval region = regions_[i];
+    if (region.first < dirty_first_) {
+      if (std::binary_search(firsts.begin(), firsts.end(), region.first)) {
+        continue;
+      }
+    } else if (region.first < old_end_line) {
+      continue;
+    } else {
+      region.first += dirty_shift_;
+      region.last += dirty_shift_;
+    }
+    for (; found_index < found_regions.size() && found_regions[found_index].first < region.first; ++found_index) {
+      regions.push_back(found_regions[found_index]);
+    }
+    regions.push_back(region);
+  }
+  regions.insert(regions.end(), found_regions.begin() + found_index, found_regions.end());
+
+  regions_.Assign(&regions);
+  is_dirty_ = false;
+}
+
+// The lines after the ones changed are scanned again while a block comment
+// is opened or closed for them.
+void FoldIndex::UpdateScans(size_t first_line, size_t old_count, size_t new_count) {
+  assert(first_line + old_count <= line_scans_.size());
+  bool was_in_comment = IsInCommentBefore(first_line + old_count);
+  if (old_count != new_count) {
+    line_scans_.erase(line_scans_.begin() + first_line,
+                      line_scans_.begin() + first_line + old_count);
+    line_scans_.insert(line_scans_.begin() + first_line, new_count, LineScan());
+  }
+
+  bool is_in_comment = IsInCommentBefore(first_line);
+  size_t line = first_line;
+  for (; line != first_line + new_count; ++line) {
+    ScanLine(line, is_in_comment, &line_scans_[line]);
+    is_in_comment = line_scans_[line].is_in_comment;
+  }
+  for (; line < line_scans_.size() && is_in_comment != was_in_comment; ++line) {
+    was_in_comment = line_scans_[line].is_in_comment;
+    ScanLine(line, is_in_comment, &line_scans_[line]);
+    is_in_comment = line_scans_[line].is_in_comment;
+  }
+
+  // The lines after are moved to other blocks if the count is changed.
+  size_t first_block = first_line / kBlockLineCount;
+  size_t end_block = kNoBlock;
+  if (old_count == new_count) {
+    end_block = (std::max(line, first_line + 1) - 1) / kBlockLineCount + 1;
+  }
+  if (stale_first_ >= stale_end_) {
+    stale_first_ = first_block;
+    stale_end_ = end_block;
+  } else {
+    stale_first_ = std::min(stale_first_, first_block);
+    stale_end_ = std::max(stale_end_, end_block);
+  }
+
+  if (!is_regions_built_) {
+    return;
+  }
+  // The dirty lines so far are moved by this change too, unless they're
+  // before it.
+  if (!is_dirty_) {
+    dirty_first_ = first_line;
+    dirty_end_ = line;
+    dirty_shift_ = new_count - old_count;
+    is_dirty_ = true;
+    return;
+  }
+  size_t dirty_end = dirty_end_;
+  if (dirty_end >= first_line + old_count) {
+    dirty_end = dirty_end + new_count - old_count;
+  } else if (dirty_end > first_line) {
+    dirty_end = first_line + new_count;
+  }
+  dirty_first_ = std::min(dirty_first_, first_line);
+  dirty_end_ = std::max(dirty_end, line);
+  dirty_shift_ += new_count - old_count;
+}
+
+bool FoldIndex::OnLinesChanged(size_t first_line, size_t old_count, size_t new_count) {
+  if (!is_active()) {
+    return false;
+  }
+
+  if (is_scanned_) {
+    UpdateScans(first_line, old_count, new_count);
+  }
+
+  if (folds_.empty()) {
+    return false;
+  }
+
+  bool is_unfolded = false;
+  std::vector<Interval> folds;
+  for (size_t i = 0; i < folds_.size(); ++i) {
+    Interval fold = folds_[i];
+    if (fold.first >= first_line + old_count) {
+      fold.first = fold.first + new_count - old_count;
+      fold.last = fold.last + new_count - old_count;
+    } else if (fold.last >= first_line) {
+      is_unfolded = true;
+      continue;
+    }
+    folds.push_back(fold);
+  }
+
+  if (old_count != new_count || is_unfolded) {
+    folds_.swap(folds);
+    UpdateHiddenRanges();
+  }
+  return is_unfolded;
+}
+
+bool FoldIndex::Fold(size_t line, Interval* lines) {
+  if (!is_active()) {
+    return false;
+  }
+  ScanLines();
+  UpdateTree();
+  UpdateRegions();
+
+  size_t index = regions_.FindFirst(line);
+  if (index == regions_.size()) {
+    std::vector<size_t> indexes;
+    regions_.FindContaining(line, &indexes);
+    if (indexes.empty()) {
+      return false;
+    }
+    index = indexes.back();
+  }
+
+  Interval fold = { regions_[index].first + 1, regions_[index].last };
+  std::vector<Interval>::iterator iter =
+      std::lower_bound(folds_.begin(), folds_.end(), fold, IsFoldBefore);
+  if (iter != folds_.end() && iter->first == fold.first && iter->last == fold.last) {
+    return false;
+  }
+  folds_.insert(iter, fold);
+  UpdateHiddenRanges();
+
+  *lines = fold;
+  return true;
+}
+
+// The folds which hide the line after a shown line all start there, so
+// unfolding a line is showing the next one.
+bool FoldIndex::ShowLine(size_t line, Interval* lines) {
+  std::vector<Interval> folds;
+  bool is_unfolded = false;
+  for (size_t i = 0; i < folds_.size(); ++i) {
+    const Interval& fold = folds_[i];
+    if (fold.first > line || fold.last < line) {
+      folds.push_back(fold);
+    } else if (!is_unfolded) {
+      *lines = fold;
+      is_unfolded = true;
+    } else {
+      lines->last = std::max(lines->last, fold.last);
+    }
+  }
+  if (!is_unfolded) {
+    return false;
+  }
+  folds_.swap(folds);
+  UpdateHiddenRanges();
+  return true;
+}
+
+void FoldIndex::UnfoldAll() {
+  folds_.clear();
+  UpdateHiddenRanges();
+}
+
+// Nested and adjacent folds are joined, so the ranges are sorted by both
+// their first and last lines.
+void FoldIndex::UpdateHiddenRanges() {
+  hidden_ranges_.clear();
+  for (size_t i = 0; i < folds_.size(); ++i) {
+    const Interval& fold = folds_[i];
+    if (!hidden_ranges_.empty() && fold.first <= hidden_ranges_.back().last + 1) {
+      hidden_ranges_.back().last = std::max(hidden_ranges_.back().last, fold.last);
+    } else {
+      hidden_ranges_.push_back(fold);
+    }
+  }
+
+  hidden_counts_.resize(hidden_ranges_.size() + 1);
+  hidden_counts_[0] = 0;
+  for (size_t i = 0; i < hidden_ranges_.size(); ++i) {
+    const Interval& range = hidden_ranges_[i];
+    hidden_counts_[i + 1] = hidden_counts_[i] + range.last - range.first + 1;
+  }
+}
+
+size_t FoldIndex::FindHiddenRange(size_t line) const {
+  std::vector<Interval>::const_iterator iter =
+      std::upper_bound(hidden_ranges_.begin(), hidden_ranges_.end(), line, IsFirstAfter);
+  if (iter == hidden_ranges_.begin() || (iter - 1)->last < line) {
+    return hidden_ranges_.size();
+  }
+  return iter - 1 - hidden_ranges_.begin();
+}
+
+bool FoldIndex::IsFolded(size_t line) const {
+  std::vector<Interval>::const_iterator iter =
+      std::lower_bound(folds_.begin(), folds_.end(), line + 1, IsFirstBefore);
+  return iter != folds_.end() && iter->first == line + 1;
+}
+
+bool FoldIndex::IsHidden(size_t line) const {
+  return FindHiddenRange(line) != hidden_ranges_.size();
+}
+
+size_t FoldIndex::GetShownLine(size_t line) const {
+  size_t index = FindHiddenRange(line);
+  return index == hidden_ranges_.size() ? line : hidden_ranges_[index].first - 1;
+}
+
+size_t FoldIndex::GetNextShownLine(size_t line) const {
+  size_t index = FindHiddenRange(line + 1);
+  return index == hidden_ranges_.size() ? line + 1 : hidden_ranges_[index].last + 1;
+}
+
+size_t FoldIndex::GetPrevShownLine(size_t line) const {
+  if (line == 0) {
+    return 0;
+  }
+  return GetShownLine(line - 1);
+}
+
+size_t FoldIndex::LineToRow(size_t line) const {
+  std::vector<Interval>::const_iterator iter =
+      std::upper_bound(hidden_ranges_.begin(), hidden_ranges_.end(), line, IsFirstAfter);
+  size_t index = iter - hidden_ranges_.begin();
+  if (index == 0) {
+    return line;
+  }
+  const Interval& range = hidden_ranges_[index - 1];
+  if (line <= range.last) {
+    return range.first - hidden_counts_[index - 1];
+  }
+  return line - hidden_counts_[index];
+}
+
+// The first line of each range has the row first - hidden_counts_[i], which
+// doesn't decrease, so the ranges before the row are found by a binary
+// search.
+size_t FoldIndex::RowToLine(size_t row) const {
+  size_t low = 0;
+  size_t high = hidden_ranges_.size();
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (hidden_ranges_[mid].first - hidden_counts_[mid] <= row) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  size_t line = row + hidden_counts_[low];
+
+  size_t line_count = text_file_ != NULL ? text_file_->GetLineCount() : 0;
+  if (line_count != 0 && line >= line_count) {
+    line = GetShownLine(line_count - 1);
+  }
+  return line;
+}
+
+size_t FoldIndex::GetMemoryUsage() const {
+  return GetVectorMemoryUsage(line_scans_) + GetVectorMemoryUsage(tokens_) +
+      GetVectorMemoryUsage(tree_) + regions_.GetMemoryUsage() + GetVectorMemoryUsage(unmatched_lines_) +
+      GetVectorMemoryUsage(folds_) + GetVectorMemoryUsage(hidden_ranges_) +
+      GetVectorMemoryUsage(hidden_counts_);
+}
+
+}  // namespace editor
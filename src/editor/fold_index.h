@@ -0,0 +1,185 @@
+#ifndef EDITOR_FOLD_INDEX_H_
+#define EDITOR_FOLD_INDEX_H_
+#pragma once
+
+#include <vector>
+#include "wx/string.h"
+#include "syntax/cpp_parser.h"
+#include "editor/interval_tree.h"
+
+namespace editor {
+
+class TextFile;
+
+// The fold regions of a text file and the lines a view hides by folding
+// them. A region is a line and the lines after it up to a matching brace,
+// or the lines indented deeper than it. Each line is scanned for its indent
+// and the braces of its syntax::CppParser tokens when it's changed, with the
+// block comment the line before leaves open, and the regions are kept in an
+// interval tree, built when the first fold is asked for.
+//
+// A region only depends on the lines from its first one to its end, so an
+// edit changes the regions which start in the lines edited and the ones
+// around them, which are found in the tree. The lines are grouped in blocks
+// with a tree over them of their brace depth and least indent, so the end
+// of a region is found in O(log n), and the other regions are only moved.
+//
+// The lines hidden are kept as sorted ranges with the hidden lines before
+// each, so a line and its row are mapped to each other in O(log n) of the
+// ranges, and folding a region of any size costs the same.
+class FoldIndex {
+public:
+  FoldIndex();
+
+  void Reset(const TextFile* text_file);
+  void Clear();
+
+  bool is_active() const { return text_file_ != NULL; }
+
+  // The lines [first_line, first_line + old_count) were replaced by
+  // [first_line, first_line + new_count). The folds after them are moved,
+  // and a fold whose hidden lines are changed is unfolded. Return true if
+  // any fold is unfolded.
+  bool OnLinesChanged(size_t first_line, size_t old_count, size_t new_count);
+
+  // Fold the region which starts at the line, or else the innermost one
+  // with it, and set |lines| to the lines it hides. The first line of the
+  // region stays shown. Return false if there is none or it's folded
+  // already.
+  bool Fold(size_t line, Interval* lines);
+
+  // Unfold the folds which start after the line, and set |lines| to the
+  // lines they hid. Some may still be hidden by other folds. Return false
+  // if there is none.
+  bool Unfold(size_t line, Interval* lines) { return ShowLine(line + 1, lines); }
+
+  // Unfold the folds which hide the line, as Unfold() does.
+  bool ShowLine(size_t line, Interval* lines);
+  void UnfoldAll();
+
+  bool HasFolds() const { return !folds_.empty(); }
+
+  // True if the line is the first line of a folded region.
+  bool IsFolded(size_t line) const;
+  bool IsHidden(size_t line) const;
+  size_t GetHiddenCount() const { return hidden_counts_.back(); }
+
+  // The line if it's shown, or else the first line of the fold hiding it.
+  size_t GetShownLine(size_t line) const;
+  size_t GetNextShownLine(size_t line) const;
+  size_t GetPrevShownLine(size_t line) const;
+
+  // A hidden line has the row of the next shown line.
+  size_t LineToRow(size_t line) const;
+  size_t RowToLine(size_t row) const;
+
+  size_t GetMemoryUsage() const;
+
+private:
+  // The braces a line leaves open or closes, and its indent, which is -1 if
+  // the line is blank.
+  struct LineScan {
+    int indent;
+    int close_count;
+    int open_count;
+    bool is_in_comment;  // the line ends in a block comment
+  };
+
+  // The depth of the braces through some lines, with an open brace as 1 and
+  // a close one as -1. The lowest prefix sum is never above 0, the sum of
+  // none. A line closes its braces before it opens others.
+  struct Depth {
+    int sum;
+    int min_prefix;
+  };
+
+  struct BlockSummary {
+    Depth depth;
+    int min_indent;  // INT_MAX if the lines are blank
+  };
+
+  static const size_t kBlockLineCount = 64;
+  static const size_t kNoBlock = static_cast<size_t>(-1);
+
+  static void AddLineDepth(const LineScan& scan, Depth* depth);
+  static Depth JoinDepths(const Depth& lhs, const Depth& rhs);
+  static BlockSummary JoinSummaries(const BlockSummary& lhs, const BlockSummary& rhs);
+
+  void ScanLine(size_t line, bool is_in_comment, LineScan* scan);
+  void ScanLines();
+  bool IsInCommentBefore(size_t line) const;
+  void UpdateScans(size_t first_line, size_t old_count, size_t new_count);
+
+  void UpdateTree();
+  void UpdateBlock(size_t block);
+
+  // Pair the braces and the indents of all the lines.
+  void BuildRegions();
+  void UpdateRegions();
+
+  // The region which starts at the line. |is_unmatched| is set if a brace
+  // the line opens is never closed.
+  bool FindRegion(size_t first, Interval* region, bool* is_unmatched) const;
+  bool FindBraceRegion(size_t first, Interval* region, bool* is_unmatched) const;
+  bool FindIndentRegion(size_t first, Interval* region) const;
+
+  // The depth through the lines from |first_line| on.
+  Depth GetDepthFrom(size_t first_line) const;
+
+  // The first line from |first_line| on where the |depth| left drops to 0,
+  // or the line count if there is none.
+  size_t FindDepthLine(size_t first_line, int depth) const;
+  size_t FindDepthBlock(size_t node, size_t begin, size_t end, size_t first_block, int* depth) const;
+
+  // The first line from |first_line| on which isn't blank and is indented
+  // no deeper than |indent|, or the line count if there is none.
+  size_t FindIndentLine(size_t first_line, int indent) const;
+  size_t FindIndentBlock(size_t node, size_t begin, size_t end, size_t first_block, int indent) const;
+
+  void UpdateHiddenRanges();
+
+  // The index of the hidden range with the line, or hidden_ranges_.size().
+  size_t FindHiddenRange(size_t line) const;
+
+private:
+  const TextFile* text_file_;
+
+  // The lines are scanned when the first fold is asked for.
+  bool is_scanned_;
+  std::vector<LineScan> line_scans_;
+  std::vector<syntax::Token> tokens_;
+
+  // The tree has a leaf per block, padded to a power of 2, with the root at
+  // 1. The blocks [stale_first_, stale_end_) are rebuilt before it's used.
+  std::vector<BlockSummary> tree_;
+  size_t leaf_count_;
+  size_t stale_first_;
+  size_t stale_end_;
+
+  IntervalTree regions_;
+  bool is_regions_built_;
+
+  // The lines with braces which are never closed, sorted.
+  std::vector<size_t> unmatched_lines_;
+
+  // The lines [dirty_first_, dirty_end_) were changed since the regions
+  // were updated, and the lines after them were moved by dirty_shift_, as a
+  // size_t which wraps around if they were moved up.
+  bool is_dirty_;
+  size_t dirty_first_;
+  size_t dirty_end_;
+  size_t dirty_shift_;
+
+  // The lines hidden by each fold, sorted by the first one. A fold may be
+  // in another.
+  std::vector<Interval> folds_;
+
+  // The folds joined into disjoint ranges, and the hidden lines before each
+  // range, with the total last.
+  std::vector<Interval> hidden_ranges_;
+  std::vector<size_t> hidden_counts_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_FOLD_INDEX_H_
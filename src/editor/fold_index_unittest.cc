@@ -0,0 +1,146 @@
+#include "editor/fold_index.h"
+#include "editor/text_file.h"
+#include "editor/text_listener.h"
+#include "gtest/gtest.h"
+
+using namespace editor;
+
+namespace {
+
+// Keeps the fold index up to date with the edits of the text, as a view
+// does.
+class FoldIndexTest : public testing::Test, public TextListener {
+protected:
+  virtual void OnLineUpdate(const wxPoint& position, bool is_multi_lines) override {
+  }
+
+  virtual void OnLinesChanged(size_t first_line, size_t old_count, size_t new_count) override {
+    fold_index_.OnLinesChanged(first_line, old_count, new_count);
+  }
+
+  void SetLines(const wxChar* const* lines, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      text_file_.AddLine(lines[i]);
+    }
+    fold_index_.Reset(&text_file_);
+    text_file_.AttachListener(this);
+  }
+
+  void ExpectFold(size_t line, size_t first, size_t last) {
+    Interval lines;
+    ASSERT_TRUE(fold_index_.Fold(line, &lines));
+    EXPECT_EQ(first, lines.first);
+    EXPECT_EQ(last, lines.last);
+  }
+
+  TextFile text_file_;
+  FoldIndex fold_index_;
+};
+
+}  // namespace
+
+TEST_F(FoldIndexTest, BraceRegion) {
+  const wxChar* lines[] = {
+    wxT("void f() {"),
+    wxT("  if (a) {"),
+    wxT("    b();"),
+    wxT("  }"),
+    wxT("}"),
+    wxT("int c;"),
+  };
+  SetLines(lines, 6);
+
+  // The closing brace stays shown.
+  ExpectFold(1, 2, 2);
+  ExpectFold(0, 1, 3);
+  EXPECT_TRUE(fold_index_.IsFolded(0));
+  EXPECT_TRUE(fold_index_.IsHidden(2));
+  EXPECT_FALSE(fold_index_.IsHidden(4));
+  EXPECT_EQ(3u, fold_index_.GetHiddenCount());
+
+  // A hidden line has the row of the next shown line.
+  EXPECT_EQ(1u, fold_index_.LineToRow(2));
+  EXPECT_EQ(1u, fold_index_.LineToRow(4));
+  EXPECT_EQ(4u, fold_index_.RowToLine(1));
+  EXPECT_EQ(0u, fold_index_.GetShownLine(3));
+  EXPECT_EQ(4u, fold_index_.GetNextShownLine(0));
+
+  Interval shown;
+  ASSERT_TRUE(fold_index_.Unfold(0, &shown));
+  EXPECT_EQ(1u, shown.first);
+  EXPECT_EQ(3u, shown.last);
+  // The inner fold is still there.
+  EXPECT_TRUE(fold_index_.IsHidden(2));
+  fold_index_.UnfoldAll();
+  EXPECT_FALSE(fold_index_.HasFolds());
+}
+
+TEST_F(FoldIndexTest, IndentRegion) {
+  const wxChar* lines[] = {
+    wxT("def f():"),
+    wxT("    a = 1"),
+    wxT(""),
+    wxT("    return a"),
+    wxT(""),
+    wxT("b = f()"),
+  };
+  SetLines(lines, 6);
+
+  // The blank lines after the region aren't in it.
+  ExpectFold(0, 1, 3);
+  Interval hidden;
+  EXPECT_FALSE(fold_index_.Fold(5, &hidden));
+}
+
+TEST_F(FoldIndexTest, BlockComment) {
+  const wxChar* lines[] = {
+    wxT("void f() {"),
+    wxT("/*} {"),
+    wxT("} */ int a; // }"),
+    wxT("const char* s = \"}\";"),
+    wxT("}"),
+  };
+  SetLines(lines, 5);
+
+  // The braces in the comments and the string are skipped. The lines
+  // aren't indented, so the region is of the braces only.
+  ExpectFold(0, 1, 3);
+  fold_index_.UnfoldAll();
+
+  // Without the comment, its closing brace closes the region of the first
+  // line, which is too short to fold.
+  text_file_.DeleteText(wxPoint(0, 1), wxT("/*"));
+  Interval hidden;
+  EXPECT_FALSE(fold_index_.Fold(0, &hidden));
+
+  // The comment is opened again by an edit before it.
+  text_file_.InsertText(wxPoint(0, 1), wxT("/*"));
+  ExpectFold(0, 1, 3);
+}
+
+TEST_F(FoldIndexTest, LinesChanged) {
+  const wxChar* lines[] = {
+    wxT("a {"),
+    wxT("  b;"),
+    wxT("}"),
+    wxT("c {"),
+    wxT("  d;"),
+    wxT("  e;"),
+    wxT("}"),
+  };
+  SetLines(lines, 7);
+  ExpectFold(3, 4, 5);
+
+  // The fold is moved by the lines inserted before it.
+  text_file_.InsertText(wxPoint(0, 1), wxT("  x;\r  y;\r"));
+  EXPECT_TRUE(fold_index_.IsFolded(5));
+  EXPECT_TRUE(fold_index_.IsHidden(6));
+  EXPECT_FALSE(fold_index_.IsHidden(4));
+
+  // The regions after the edit are found again.
+  ExpectFold(0, 1, 3);
+
+  // A fold whose hidden lines are changed is unfolded.
+  EXPECT_TRUE(fold_index_.OnLinesChanged(6, 1, 1));
+  EXPECT_FALSE(fold_index_.IsFolded(5));
+}
@@ -0,0 +1,347 @@
+#include "editor/hex_text.h"
+#include <algorithm>
+#include <cstring>
+#include "wx/ffile.h"
+#include "editor/encoding.h"
+#include "editor/memory_usage.h"
+#include "editor/trace.h"
+
+namespace editor {
+
+// The bytes searched or copied at a time. A match may span two chunks, so
+// they overlap by the size of the text less one byte.
+const size_t kHexChunkSize = 4 * 1024 * 1024;
+
+const size_t kNoLine = static_cast<size_t>(-1);
+
+const size_t HexText::kBytesPerLine;
+const size_t HexText::kCachedLineCount;
+
+static const wxChar kHexDigits[] = wxT("0123456789abcdef");
+
+static int GetHexDigitValue(wxChar ch) {
+  if (ch >= wxT('0') && ch <= wxT('9')) {
+    return ch - wxT('0');
+  }
+  if (ch >= wxT('a') && ch <= wxT('f')) {
+    return ch - wxT('a') + 10;
+  }
+  if (ch >= wxT('A') && ch <= wxT('F')) {
+    return ch - wxT('A') + 10;
+  }
+  return -1;
+}
+
+// Pairs of hex digits, which may be separated by spaces.
+static bool ParseHexBytes(const wxString& text, std::string* bytes) {
+  int high = -1;
+  for (size_t i = 0; i < text.Len(); ++i) {
+    if (text[i] == wxT(' ') && high == -1) {
+      continue;
+    }
+    int value = GetHexDigitValue(text[i]);
+    if (value == -1) {
+      return false;
+    }
+    if (high == -1) {
+      high = value;
+    } else {
+      bytes->push_back(static_cast<char>((high << 4) | value));
+      high = -1;
+    }
+  }
+  return high == -1 && !bytes->empty();
+}
+
+HexText::HexText()
+    : offset_digits_(0),
+      ascii_column_(0),
+      lines_(kCachedLineCount),
+      line_numbers_(kCachedLineCount, kNoLine) {
+}
+
+bool HexText::Open(const wxString& path) {
+  TRACE_SCOPE("HexText::Open");
+  path_ = path;
+  return MapFile();
+}
+
+// The offsets have at least 8 digits, more if the file is bigger than 4GB.
+bool HexText::MapFile() {
+  std::fill(line_numbers_.begin(), line_numbers_.end(), kNoLine);
+  if (!mapped_file_.Open(path_)) {
+    return false;
+  }
+  offset_digits_ = 8;
+  while (offset_digits_ < 16 && (GetSize() >> (offset_digits_ * 4)) != 0) {
+    ++offset_digits_;
+  }
+  ascii_column_ = GetHexColumn(kBytesPerLine - 1) + 5;
+  return true;
+}
+
+// The lines from the one of the old last byte on are made again, or all of
+// them if the offsets got longer.
+bool HexText::ReadAppended(size_t* first_line) {
+  TRACE_SCOPE("HexText::ReadAppended");
+  unsigned long long old_size = GetSize();
+  size_t old_digits = offset_digits_;
+  if (!MapFile() || GetSize() < old_size) {
+    return false;
+  }
+  if (GetSize() == old_size) {
+    *first_line = GetLineCount();
+  } else {
+    *first_line = offset_digits_ == old_digits ? static_cast<size_t>(old_size / kBytesPerLine) : 0;
+  }
+  return true;
+}
+
+size_t HexText::GetLineCount() const {
+  return std::max<size_t>(1, static_cast<size_t>((GetSize() + kBytesPerLine - 1) / kBytesPerLine));
+}
+
+// Two spaces follow the offset, a space each byte, and another one the
+// eighth byte.
+size_t HexText::GetHexColumn(size_t index) const {
+  return offset_digits_ + 2 + index * 3 + (index >= kBytesPerLine / 2 ? 1 : 0);
+}
+
+// The hex digits of a short last line are padded with spaces, so its chars
+// are in the ASCII column too.
+TextLine& HexText::GetLine(size_t line) const {
+  TextLine& text_line = lines_[line % kCachedLineCount];
+  if (line_numbers_[line % kCachedLineCount] == line) {
+    return text_line;
+  }
+
+  unsigned long long offset = static_cast<unsigned long long>(line) * kBytesPerLine;
+  size_t count = static_cast<size_t>(std::min<unsigned long long>(kBytesPerLine, GetSize() - offset));
+  std::string buffer;
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(GetBytes(offset, count, &buffer));
+
+  wxString data(wxT(' '), count == 0 ? offset_digits_ : ascii_column_ + count + 1);
+  for (size_t i = 0; i < offset_digits_; ++i) {
+    data[offset_digits_ - 1 - i] = kHexDigits[(offset >> (i * 4)) & 0xF];
+  }
+  if (count != 0) {
+    for (size_t i = 0; i < count; ++i) {
+      size_t column = GetHexColumn(i);
+      data[column] = kHexDigits[bytes[i] >> 4];
+      data[column + 1] = kHexDigits[bytes[i] & 0xF];
+      data[ascii_column_ + i] = bytes[i] >= 0x20 && bytes[i] < 0x7F ? static_cast<wxChar>(bytes[i]) : wxT('.');
+    }
+    data[ascii_column_ - 1] = wxT('|');
+    data[ascii_column_ + count] = wxT('|');
+  }
+
+  text_line.SetData(data);
+  text_line.SetLineEndType(line + 1 == GetLineCount() ? LINE_END_TYPE_NONE : kDefaultLineEndType);
+  line_numbers_[line % kCachedLineCount] = line;
+  return text_line;
+}
+
+unsigned char HexText::GetByte(unsigned long long offset) const {
+  std::map<unsigned long long, char>::const_iterator iter = changes_.find(offset);
+  char byte = iter == changes_.end() ? mapped_file_.data()[offset] : iter->second;
+  return static_cast<unsigned char>(byte);
+}
+
+// A byte set back to the one of the file is no longer a change.
+void HexText::SetBytes(unsigned long long offset, const std::string& bytes) {
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    if (mapped_file_.data()[offset + i] == bytes[i]) {
+      changes_.erase(offset + i);
+    } else {
+      changes_[offset + i] = bytes[i];
+    }
+    line_numbers_[static_cast<size_t>((offset + i) / kBytesPerLine) % kCachedLineCount] = kNoLine;
+  }
+}
+
+const char* HexText::GetBytes(unsigned long long offset, size_t size, std::string* buffer) const {
+  const char* data = mapped_file_.data() + offset;
+  std::map<unsigned long long, char>::const_iterator iter = changes_.lower_bound(offset);
+  if (iter == changes_.end() || iter->first >= offset + size) {
+    return data;
+  }
+  buffer->assign(data, size);
+  for (; iter != changes_.end() && iter->first < offset + size; ++iter) {
+    (*buffer)[static_cast<size_t>(iter->first - offset)] = iter->second;
+  }
+  return buffer->data();
+}
+
+bool HexText::GetByteAt(const wxPoint& pos, unsigned long long* offset, bool* is_ascii, bool* is_low_digit) const {
+  if (pos.x < 0 || pos.y < 0) {
+    return false;
+  }
+  size_t x = static_cast<size_t>(pos.x);
+  size_t index = kBytesPerLine;
+  *is_ascii = x >= ascii_column_;
+  *is_low_digit = false;
+  if (*is_ascii) {
+    index = x - ascii_column_;
+  } else {
+    for (size_t i = 0; i < kBytesPerLine; ++i) {
+      size_t column = GetHexColumn(i);
+      if (x == column || x == column + 1) {
+        index = i;
+        *is_low_digit = x != column;
+        break;
+      }
+    }
+  }
+  if (index >= kBytesPerLine) {
+    return false;
+  }
+  *offset = static_cast<unsigned long long>(pos.y) * kBytesPerLine + index;
+  return *offset < GetSize();
+}
+
+wxPoint HexText::GetBytePosition(unsigned long long offset, bool is_ascii) const {
+  size_t index = static_cast<size_t>(offset % kBytesPerLine);
+  size_t column = is_ascii ? ascii_column_ + index : GetHexColumn(index);
+  return wxPoint(static_cast<int>(column), static_cast<int>(offset / kBytesPerLine));
+}
+
+// The caret stays on the last byte.
+bool HexText::GetTypedByte(const wxPoint& pos, wxChar ch, unsigned long long* offset, char* byte, wxPoint* next_pos) const {
+  bool is_ascii = false;
+  bool is_low_digit = false;
+  if (!GetByteAt(pos, offset, &is_ascii, &is_low_digit)) {
+    return false;
+  }
+  if (is_ascii) {
+    if (ch < 0x20 || ch >= 0x7F) {
+      return false;
+    }
+    *byte = static_cast<char>(ch);
+  } else {
+    int value = GetHexDigitValue(ch);
+    if (value == -1) {
+      return false;
+    }
+    unsigned char old_byte = GetByte(*offset);
+    *byte = static_cast<char>(is_low_digit ? (old_byte & 0xF0) | value : (value << 4) | (old_byte & 0x0F));
+  }
+
+  if (!is_ascii && !is_low_digit) {
+    *next_pos = wxPoint(pos.x + 1, pos.y);
+  } else if (*offset + 1 < GetSize()) {
+    *next_pos = GetBytePosition(*offset + 1, is_ascii);
+  } else {
+    *next_pos = pos;
+  }
+  return true;
+}
+
+unsigned long long HexText::GetOffsetFrom(const wxPoint& pos) const {
+  if (pos.y < 0) {
+    return 0;
+  }
+  size_t x = static_cast<size_t>(std::max(pos.x, 0));
+  size_t index = 0;
+  if (x >= ascii_column_) {
+    index = std::min(x - ascii_column_, kBytesPerLine);
+  } else {
+    while (index < kBytesPerLine && GetHexColumn(index) < x) {
+      ++index;
+    }
+  }
+  return std::min(static_cast<unsigned long long>(pos.y) * kBytesPerLine + index, GetSize());
+}
+
+// The mapping is searched a chunk at a time, so only the chunks with bytes
+// overwritten are copied.
+bool HexText::Find(const wxString& text, const wxPoint& from, wxPoint* found) const {
+  TRACE_SCOPE("HexText::Find");
+  std::string pattern;
+  bool is_ascii = !ParseHexBytes(text, &pattern);
+  if (is_ascii) {
+    pattern.clear();
+    EncodeText(text, IsLatin1(text) ? FILE_ENCODING_LATIN1 : FILE_ENCODING_UTF8, &pattern);
+  }
+  if (pattern.empty() || pattern.size() > kHexChunkSize) {
+    return false;
+  }
+
+  std::string buffer;
+  unsigned long long offset = GetOffsetFrom(from);
+  while (offset + pattern.size() <= GetSize()) {
+    size_t size = static_cast<size_t>(std::min<unsigned long long>(kHexChunkSize, GetSize() - offset));
+    const char* data = GetBytes(offset, size, &buffer);
+    const char* end = data + size;
+    const char* p = data;
+    while (static_cast<size_t>(end - p) >= pattern.size() &&
+           (p = static_cast<const char*>(memchr(p, pattern[0], end - p - pattern.size() + 1))) != NULL) {
+      if (memcmp(p, pattern.data(), pattern.size()) == 0) {
+        *found = GetBytePosition(offset + (p - data), is_ascii);
+        return true;
+      }
+      ++p;
+    }
+    if (offset + size == GetSize()) {
+      break;
+    }
+    offset += size - (pattern.size() - 1);
+  }
+  return false;
+}
+
+// The file is mapped again after it's written, so the bytes shown are the
+// ones written.
+bool HexText::Write(const wxString& path) {
+  TRACE_SCOPE("HexText::Write");
+  if (path == path_) {
+    wxFFile file(path, wxT("r+b"));
+    if (!file.IsOpened()) {
+      return false;
+    }
+    std::map<unsigned long long, char>::const_iterator iter = changes_.begin();
+    while (iter != changes_.end()) {
+      unsigned long long offset = iter->first;
+      std::string run;
+      while (iter != changes_.end() && iter->first == offset + run.size()) {
+        run.push_back(iter->second);
+        ++iter;
+      }
+      if (!file.Seek(static_cast<wxFileOffset>(offset)) || file.Write(run.data(), run.size()) != run.size()) {
+        return false;
+      }
+    }
+    if (!file.Close()) {
+      return false;
+    }
+  } else {
+    wxFFile file(path, wxT("wb"));
+    if (!file.IsOpened()) {
+      return false;
+    }
+    std::string buffer;
+    for (unsigned long long offset = 0; offset < GetSize(); offset += kHexChunkSize) {
+      size_t size = static_cast<size_t>(std::min<unsigned long long>(kHexChunkSize, GetSize() - offset));
+      if (file.Write(GetBytes(offset, size, &buffer), size) != size) {
+        return false;
+      }
+    }
+    if (!file.Close()) {
+      return false;
+    }
+    path_ = path;
+  }
+  changes_.clear();
+  return MapFile();
+}
+
+void HexText::GetMemoryUsage(MemoryUsage* usage) const {
+  // A node of std::map has three links and a color besides the pair.
+  const size_t kMapNodeSize = sizeof(std::map<unsigned long long, char>::value_type) + 4 * sizeof(void*);
+  usage->Add(MEMORY_HEX_VIEW, GetVectorMemoryUsage(lines_) + GetVectorMemoryUsage(line_numbers_) +
+                              changes_.size() * kMapNodeSize);
+  for (const TextLine& line : lines_) {
+    line.GetMemoryUsage(usage);
+  }
+}
+
+}  // namespace editor
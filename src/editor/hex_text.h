@@ -0,0 +1,99 @@
+#ifndef EDITOR_HEX_TEXT_H_
+#define EDITOR_HEX_TEXT_H_
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "wx/gdicmn.h"
+#include "wx/string.h"
+#include "editor/mapped_file.h"
+#include "editor/text_line.h"
+
+namespace editor {
+
+class MemoryUsage;
+
+// The bytes of a binary file shown as lines of an offset, 16 bytes in hex
+// and their ASCII chars, the way "hexdump -C" prints them. The file is
+// mapped, and a line is made from its bytes when it's used, so a file of
+// any size takes the same memory. The bytes can be overwritten, but none
+// inserted or deleted; the bytes overwritten are kept until they're written.
+class HexText {
+public:
+  HexText();
+
+  bool Open(const wxString& path);
+
+  // Map the file again after bytes are appended to it. The lines from
+  // |first_line| on may have changed. Return false if the file is shorter.
+  bool ReadAppended(size_t* first_line);
+
+  unsigned long long GetSize() const { return mapped_file_.size(); }
+
+  // An empty file has a line of its offset only.
+  size_t GetLineCount() const;
+  size_t GetLineSize() const { return ascii_column_ + kBytesPerLine + 1; }
+
+  // The line stays valid until kCachedLineCount other lines are used.
+  TextLine& GetLine(size_t line) const;
+
+  unsigned char GetByte(unsigned long long offset) const;
+  void SetBytes(unsigned long long offset, const std::string& bytes);
+
+  // The byte shown at the position, in its hex digits or its ASCII char.
+  // Return false if there is none.
+  bool GetByteAt(const wxPoint& pos, unsigned long long* offset, bool* is_ascii, bool* is_low_digit) const;
+  wxPoint GetBytePosition(unsigned long long offset, bool is_ascii) const;
+
+  // The byte at |pos| after |ch| is typed there, a hex digit in the hex
+  // column or an ASCII char in the ASCII column, and the position of the
+  // next digit or char. Return false if |ch| can't be typed there.
+  bool GetTypedByte(const wxPoint& pos, wxChar ch, unsigned long long* offset, char* byte, wxPoint* next_pos) const;
+
+  // Find the bytes of |text| from the byte at or after |from| on. A text of
+  // hex digit pairs, e.g. "de ad be ef", is found as those bytes in the hex
+  // column, any other as its chars in the ASCII column.
+  bool Find(const wxString& text, const wxPoint& from, wxPoint* found) const;
+
+  // Write the file with the bytes overwritten. Only those bytes are written
+  // to the file itself, any other file is copied from it.
+  bool Write(const wxString& path);
+
+  // Add the memory of the lines made and the bytes overwritten.
+  void GetMemoryUsage(MemoryUsage* usage) const;
+
+  static const size_t kBytesPerLine = 16;
+  static const size_t kCachedLineCount = 256;
+
+private:
+  bool MapFile();
+
+  size_t GetHexColumn(size_t index) const;
+
+  // The bytes at the offset, overwritten, which may be copied to |buffer|.
+  const char* GetBytes(unsigned long long offset, size_t size, std::string* buffer) const;
+
+  // The offset of the first byte shown at or after the position.
+  unsigned long long GetOffsetFrom(const wxPoint& pos) const;
+
+private:
+  wxString path_;
+  MappedFile mapped_file_;
+
+  // The hex digits of the offsets, and where the ASCII chars start.
+  size_t offset_digits_;
+  size_t ascii_column_;
+
+  // The bytes overwritten, which differ from the ones of the file.
+  std::map<unsigned long long, char> changes_;
+
+  // Line n is made in lines_[n % kCachedLineCount], which
+  // line_numbers_ says it is.
+  mutable std::vector<TextLine> lines_;
+  mutable std::vector<size_t> line_numbers_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_HEX_TEXT_H_
@@ -0,0 +1,86 @@
+#include "editor/hex_text.h"
+#include <string>
+#include "wx/ffile.h"
+#include "wx/filefn.h"
+#include "wx/filename.h"
+#include "gtest/gtest.h"
+
+using namespace editor;
+
+namespace {
+
+const size_t kChunkSize = 4 * 1024 * 1024;
+
+class HexTextTest : public testing::Test {
+protected:
+  virtual void TearDown() override {
+    if (!path_.IsEmpty()) {
+      wxRemoveFile(path_);
+    }
+  }
+
+  // Write the bytes to a temp file and open it.
+  bool Open(const std::string& bytes) {
+    path_ = wxFileName::CreateTempFileName(wxT("hex"));
+    wxFFile file(path_, wxT("wb"));
+    if (!file.IsOpened() || file.Write(bytes.data(), bytes.size()) != bytes.size()) {
+      return false;
+    }
+    file.Close();
+    return hex_text_.Open(path_);
+  }
+
+  wxString path_;
+  HexText hex_text_;
+};
+
+}  // namespace
+
+TEST_F(HexTextTest, FindAscii) {
+  ASSERT_TRUE(Open("0123456789abcdef0123456789abcdef--needle--needle"));
+
+  wxPoint found;
+  ASSERT_TRUE(hex_text_.Find(wxT("needle"), wxPoint(0, 0), &found));
+  EXPECT_EQ(hex_text_.GetBytePosition(34, true), found);
+
+  // From the byte after it.
+  ASSERT_TRUE(hex_text_.Find(wxT("needle"), hex_text_.GetBytePosition(35, true), &found));
+  EXPECT_EQ(hex_text_.GetBytePosition(42, true), found);
+  EXPECT_FALSE(hex_text_.Find(wxT("needle"), hex_text_.GetBytePosition(43, true), &found));
+  EXPECT_FALSE(hex_text_.Find(wxT("needles"), wxPoint(0, 0), &found));
+}
+
+TEST_F(HexTextTest, FindHex) {
+  std::string bytes(40, 'x');
+  bytes[20] = '\xDE';
+  bytes[21] = '\xAD';
+  bytes[22] = '\xBE';
+  bytes[23] = '\xEF';
+  ASSERT_TRUE(Open(bytes));
+
+  wxPoint found;
+  ASSERT_TRUE(hex_text_.Find(wxT("de ad be ef"), wxPoint(0, 0), &found));
+  EXPECT_EQ(hex_text_.GetBytePosition(20, false), found);
+  EXPECT_FALSE(hex_text_.Find(wxT("de ad be ee"), wxPoint(0, 0), &found));
+}
+
+TEST_F(HexTextTest, FindOverwritten) {
+  ASSERT_TRUE(Open(std::string(100, 'x')));
+
+  wxPoint found;
+  EXPECT_FALSE(hex_text_.Find(wxT("abc"), wxPoint(0, 0), &found));
+  hex_text_.SetBytes(70, "abc");
+  ASSERT_TRUE(hex_text_.Find(wxT("abc"), wxPoint(0, 0), &found));
+  EXPECT_EQ(hex_text_.GetBytePosition(70, true), found);
+}
+
+TEST_F(HexTextTest, FindAcrossChunks) {
+  // The chunks searched overlap, so a text across two of them is found.
+  std::string bytes(kChunkSize + 100, 'x');
+  bytes.replace(kChunkSize - 3, 6, "needle");
+  ASSERT_TRUE(Open(bytes));
+
+  wxPoint found;
+  ASSERT_TRUE(hex_text_.Find(wxT("needle"), wxPoint(0, 0), &found));
+  EXPECT_EQ(hex_text_.GetBytePosition(kChunkSize - 3, true), found);
+}
@@ -0,0 +1,83 @@
+#include "editor/interval_tree.h"
+#include <algorithm>
+#include <cassert>
+#include "editor/memory_usage.h"
+
+namespace editor {
+
+static bool IsIntervalBefore(const Interval& lhs, const Interval& rhs) {
+  return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.last > rhs.last);
+}
+
+IntervalTree::IntervalTree() {
+}
+
+void IntervalTree::Assign(std::vector<Interval>* intervals) {
+  assert(std::is_sorted(intervals->begin(), intervals->end(), IsIntervalBefore));
+  intervals_.swap(*intervals);
+  intervals->clear();
+  max_lasts_.assign(intervals_.size(), 0);
+  BuildMaxLasts(0, intervals_.size());
+}
+
+void IntervalTree::Clear() {
+  intervals_.clear();
+  max_lasts_.clear();
+}
+
+void IntervalTree::BuildMaxLasts(size_t begin, size_t end) {
+  if (begin == end) {
+    return;
+  }
+  size_t mid = begin + (end - begin) / 2;
+  BuildMaxLasts(begin, mid);
+  BuildMaxLasts(mid + 1, end);
+  size_t max_last = intervals_[mid].last;
+  if (begin != mid) {
+    max_last = std::max(max_last, max_lasts_[begin + (mid - begin) / 2]);
+  }
+  if (mid + 1 != end) {
+    max_last = std::max(max_last, max_lasts_[mid + 1 + (end - mid - 1) / 2]);
+  }
+  max_lasts_[mid] = max_last;
+}
+
+size_t IntervalTree::FindFirst(size_t first) const {
+  Interval key = { first, static_cast<size_t>(-1) };
+  std::vector<Interval>::const_iterator iter =
+      std::lower_bound(intervals_.begin(), intervals_.end(), key, IsIntervalBefore);
+  if (iter == intervals_.end() || iter->first != first) {
+    return intervals_.size();
+  }
+  return iter - intervals_.begin();
+}
+
+void IntervalTree::FindContaining(size_t line, std::vector<size_t>* indexes) const {
+  FindContaining(0, intervals_.size(), line, indexes);
+}
+
+// A subtree whose intervals all end before the line is skipped, and so are
+// the nodes right of one which starts after it.
+void IntervalTree::FindContaining(size_t begin, size_t end, size_t line, std::vector<size_t>* indexes) const {
+  if (begin == end) {
+    return;
+  }
+  size_t mid = begin + (end - begin) / 2;
+  if (max_lasts_[mid] < line) {
+    return;
+  }
+  FindContaining(begin, mid, line, indexes);
+  if (intervals_[mid].first > line) {
+    return;
+  }
+  if (intervals_[mid].last >= line) {
+    indexes->push_back(mid);
+  }
+  FindContaining(mid + 1, end, line, indexes);
+}
+
+size_t IntervalTree::GetMemoryUsage() const {
+  return GetVectorMemoryUsage(intervals_) + GetVectorMemoryUsage(max_lasts_);
+}
+
+}  // namespace editor
@@ -0,0 +1,56 @@
+#ifndef EDITOR_INTERVAL_TREE_H_
+#define EDITOR_INTERVAL_TREE_H_
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace editor {
+
+// A closed interval of lines.
+struct Interval {
+  size_t first;
+  size_t last;
+};
+
+// A static interval tree. The intervals are sorted by their first line, the
+// longer one first, and kept in an implicit balanced tree over the sorted
+// array, each node with the greatest last line of its subtree. The intervals
+// with a line are found in O(log n + k). It's built in O(n) from the sorted
+// intervals, so a change is merged into them and the tree is built again
+// with no sort.
+class IntervalTree {
+public:
+  IntervalTree();
+
+  // Take the intervals, sorted as above, and leave |intervals| empty.
+  void Assign(std::vector<Interval>* intervals);
+  void Clear();
+
+  size_t size() const { return intervals_.size(); }
+  const Interval& operator[](size_t index) const { return intervals_[index]; }
+
+  // The index of the longest interval which starts at |first|, or size() if
+  // there is none.
+  size_t FindFirst(size_t first) const;
+
+  // Append the indexes of the intervals with |line|, outer ones first.
+  void FindContaining(size_t line, std::vector<size_t>* indexes) const;
+
+  size_t GetMemoryUsage() const;
+
+private:
+  void BuildMaxLasts(size_t begin, size_t end);
+  void FindContaining(size_t begin, size_t end, size_t line, std::vector<size_t>* indexes) const;
+
+private:
+  std::vector<Interval> intervals_;
+
+  // The greatest last line in the subtree of the node, which is the middle
+  // one of its range of the array.
+  std::vector<size_t> max_lasts_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_INTERVAL_TREE_H_
@@ -0,0 +1,143 @@
+#include "editor/latency_tracker.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace editor {
+
+// The number of the latest samples in the histogram.
+const size_t kLatencyWindowSize = 1000;
+
+// An input which isn't painted in time waited for the user, e.g. in a dialog
+// it opened. It's dropped instead of being counted as slow.
+const double kMaxLatencyMs = 1000;
+
+static const double kBucketBounds[] = { 1, 2, 4, 8, 16, 33, 50, 100, 200, 500 };
+const size_t kBucketBoundCount = sizeof(kBucketBounds) / sizeof(kBucketBounds[0]);
+
+LatencyTracker::LatencyTracker()
+    : is_in_input_(false),
+      input_time_(0),
+      samples_(kLatencyWindowSize),
+      next_sample_(0),
+      sample_count_(0),
+      bucket_sizes_(kBucketBoundCount + 1),
+      total_count_(0) {
+}
+
+LatencyTracker& LatencyTracker::Get() {
+  static LatencyTracker tracker;
+  return tracker;
+}
+
+double LatencyTracker::Now() {
+  typedef std::chrono::steady_clock Clock;
+  return std::chrono::duration<double, std::milli>(Clock::now().time_since_epoch()).count();
+}
+
+size_t LatencyTracker::GetBucketCount() {
+  return kBucketBoundCount + 1;
+}
+
+double LatencyTracker::GetBucketBound(size_t bucket) {
+  return bucket < kBucketBoundCount ? kBucketBounds[bucket] : -1;
+}
+
+static size_t GetBucket(double ms) {
+  return std::lower_bound(kBucketBounds, kBucketBounds + kBucketBoundCount, ms) - kBucketBounds;
+}
+
+void LatencyTracker::BeginInput() {
+  is_in_input_ = true;
+  input_time_ = Now();
+}
+
+void LatencyTracker::EndInput() {
+  is_in_input_ = false;
+}
+
+void LatencyTracker::AddRefresh() {
+  if (is_in_input_) {
+    pending_inputs_.push_back(input_time_);
+    is_in_input_ = false;
+  }
+}
+
+void LatencyTracker::AddPaint() {
+  if (pending_inputs_.empty()) {
+    return;
+  }
+  double now = Now();
+  for (double input_time : pending_inputs_) {
+    if (now - input_time <= kMaxLatencyMs) {
+      AddSample(now - input_time);
+    }
+  }
+  pending_inputs_.clear();
+}
+
+void LatencyTracker::AddSample(double ms) {
+  if (sample_count_ == samples_.size()) {
+    --bucket_sizes_[GetBucket(samples_[next_sample_])];
+  } else {
+    ++sample_count_;
+  }
+  samples_[next_sample_] = ms;
+  next_sample_ = (next_sample_ + 1) % samples_.size();
+  ++bucket_sizes_[GetBucket(ms)];
+  ++total_count_;
+}
+
+double LatencyTracker::Percentile(double percent) const {
+  if (sample_count_ == 0) {
+    return 0;
+  }
+  std::vector<double> sorted(samples_.begin(), samples_.begin() + sample_count_);
+  size_t rank = static_cast<size_t>(percent / 100 * sample_count_ + 0.5);
+  rank = std::min(std::max(rank, static_cast<size_t>(1)), sample_count_);
+  std::nth_element(sorted.begin(), sorted.begin() + rank - 1, sorted.end());
+  return sorted[rank - 1];
+}
+
+wxString LatencyTracker::FormatSummary() const {
+  if (sample_count_ == 0) {
+    return wxT("Input latency: no samples");
+  }
+  return wxString::Format(wxT("Input latency p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms (%u samples)"),
+                          Percentile(50),
+                          Percentile(90),
+                          Percentile(99),
+                          Percentile(100),
+                          static_cast<unsigned int>(sample_count_));
+}
+
+void LatencyTracker::WriteJson(std::ostream& os) const {
+  os << "{\"samples\": " << sample_count_
+     << ", \"total_samples\": " << total_count_
+     << ", \"p50_ms\": " << Percentile(50)
+     << ", \"p90_ms\": " << Percentile(90)
+     << ", \"p99_ms\": " << Percentile(99)
+     << ", \"max_ms\": " << Percentile(100)
+     << ", \"buckets\": [";
+  for (size_t i = 0; i < GetBucketCount(); ++i) {
+    os << (i == 0 ? "\n" : ",\n") << "  {\"le_ms\": ";
+    if (i < kBucketBoundCount) {
+      os << kBucketBounds[i];
+    } else {
+      os << "null";
+    }
+    os << ", \"count\": " << bucket_sizes_[i] << "}";
+  }
+  os << "\n]}\n";
+}
+
+bool LatencyTracker::WriteJson(const wxString& file_path) const {
+  std::ofstream ofs(file_path.fn_str());
+  if (!ofs) {
+    return false;
+  }
+  WriteJson(ofs);
+  return ofs.good();
+}
+
+}  // namespace editor
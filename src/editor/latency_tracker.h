@@ -0,0 +1,75 @@
+#ifndef EDITOR_LATENCY_TRACKER_H_
+#define EDITOR_LATENCY_TRACKER_H_
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+#include "wx/string.h"
+
+namespace editor {
+
+// Measures the keystroke to pixel latency: the time from the text panel
+// receiving a key event to the end of the first paint after the key
+// refreshed it. The latest samples are kept in a rolling histogram.
+class LatencyTracker {
+public:
+  static LatencyTracker& Get();
+
+  // Called when the text panel receives a key event, and when it's done
+  // with it. A key which doesn't refresh the text panel in between changed
+  // nothing on the screen, and is dropped.
+  void BeginInput();
+  void EndInput();
+
+  // Called when the text panel is refreshed or scrolled.
+  void AddRefresh();
+
+  // Called when a paint of the text panel finishes. It reflects all the
+  // inputs which refreshed it before.
+  void AddPaint();
+
+  // The number of buckets and the upper bound of a bucket in ms. The last
+  // bucket has no upper bound.
+  static size_t GetBucketCount();
+  static double GetBucketBound(size_t bucket);
+
+  // The histogram of the rolling window.
+  size_t sample_count() const { return sample_count_; }
+  size_t GetBucketSize(size_t bucket) const { return bucket_sizes_[bucket]; }
+  double Percentile(double percent) const;
+
+  // The count of all samples, also the ones out of the window.
+  size_t total_count() const { return total_count_; }
+
+  // A line for the status bar, e.g. "Input latency p50 3.2 ms, p99 9.8 ms".
+  wxString FormatSummary() const;
+
+  void WriteJson(std::ostream& os) const;
+  bool WriteJson(const wxString& file_path) const;
+
+private:
+  LatencyTracker();
+
+  static double Now();
+
+  void AddSample(double ms);
+
+  // The input being handled, which hasn't refreshed the text panel yet.
+  bool is_in_input_;
+  double input_time_;
+
+  // The times of the inputs not painted yet.
+  std::vector<double> pending_inputs_;
+
+  // The ring of the latest samples and their histogram.
+  std::vector<double> samples_;
+  size_t next_sample_;
+  size_t sample_count_;
+  std::vector<size_t> bucket_sizes_;
+  size_t total_count_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_LATENCY_TRACKER_H_
@@ -0,0 +1,146 @@
+#include "editor/line_diff.h"
+#include <algorithm>
+
+namespace editor {
+
+const unsigned long long kFnvOffsetBasis = 14695981039346656037ULL;
+const unsigned long long kFnvPrime = 1099511628211ULL;
+
+unsigned long long HashLine(const wxString& line) {
+  unsigned long long hash = kFnvOffsetBasis;
+  for (wxString::const_iterator it = line.begin(); it != line.end(); ++it) {
+    hash = (hash ^ static_cast<unsigned long long>(static_cast<wxChar>(*it))) * kFnvPrime;
+  }
+  return hash;
+}
+
+namespace {
+
+// The texts are compared only if the hashes are equal, which is rare for
+// lines that differ.
+inline bool IsSameLine(const DiffLine& lhs, const DiffLine& rhs) {
+  return lhs.hash == rhs.hash && *lhs.text == *rhs.text;
+}
+
+// A run of equal lines from (x, y), x in the old lines and y in the new.
+struct Snake {
+  long x;
+  long y;
+  long length;
+};
+
+void AddHunk(size_t old_first, size_t old_count, size_t new_first, size_t new_count, std::vector<DiffHunk>* hunks) {
+  DiffHunk hunk = { old_first, old_count, new_first, new_count };
+  hunks->push_back(hunk);
+}
+
+// Myers' greedy search of the shortest edit script. v[k] is the furthest x
+// reached on the diagonal k = x - y, and the v of each edit count is kept to
+// walk the path back. It takes O((n + m) * d) time and O(d * d) memory.
+bool FindSnakes(const DiffLine* a, long n,
+                const DiffLine* b, long m,
+                long max_d,
+                std::vector<Snake>* snakes) {
+  long offset = max_d + 1;
+  std::vector<long> v(2 * max_d + 3, 0);
+  std::vector<std::vector<long> > trace;
+
+  long found_d = -1;
+  for (long d = 0; d <= max_d && found_d < 0; ++d) {
+    for (long k = -d; k <= d; k += 2) {
+      long x = 0;
+      if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])) {
+        x = v[offset + k + 1];
+      } else {
+        x = v[offset + k - 1] + 1;
+      }
+      long y = x - k;
+      while (x < n && y < m && IsSameLine(a[x], b[y])) {
+        ++x;
+        ++y;
+      }
+      v[offset + k] = x;
+      if (x >= n && y >= m) {
+        found_d = d;
+        break;
+      }
+    }
+    // Only the diagonals reachable with d edits, [-d, d].
+    trace.push_back(std::vector<long>(v.begin() + offset - d, v.begin() + offset + d + 1));
+  }
+  if (found_d < 0) {
+    return false;
+  }
+
+  long x = n;
+  long y = m;
+  for (long d = found_d; d > 0; --d) {
+    const std::vector<long>& prev = trace[d - 1];
+    long k = x - y;
+    // prev[i] is the x of the diagonal i - (d - 1).
+    bool is_insertion = k == -d || (k != d && prev[k - 1 + d - 1] < prev[k + 1 + d - 1]);
+    long prev_k = is_insertion ? k + 1 : k - 1;
+    long prev_x = prev[prev_k + d - 1];
+    long start_x = is_insertion ? prev_x : prev_x + 1;
+    Snake snake = { start_x, start_x - k, x - start_x };
+    snakes->push_back(snake);
+    x = prev_x;
+    y = prev_x - prev_k;
+  }
+  Snake snake = { 0, 0, x };
+  snakes->push_back(snake);
+  std::reverse(snakes->begin(), snakes->end());
+  return true;
+}
+
+}  // namespace
+
+void DiffLines(const std::vector<DiffLine>& old_lines,
+               const std::vector<DiffLine>& new_lines,
+               size_t max_edit_count,
+               std::vector<DiffHunk>* hunks) {
+  size_t old_count = old_lines.size();
+  size_t new_count = new_lines.size();
+
+  size_t head = 0;
+  while (head < old_count && head < new_count && IsSameLine(old_lines[head], new_lines[head])) {
+    ++head;
+  }
+  size_t tail = 0;
+  while (tail < old_count - head && tail < new_count - head &&
+         IsSameLine(old_lines[old_count - 1 - tail], new_lines[new_count - 1 - tail])) {
+    ++tail;
+  }
+  long n = static_cast<long>(old_count - head - tail);
+  long m = static_cast<long>(new_count - head - tail);
+  if (n == 0 && m == 0) {
+    return;
+  }
+
+  std::vector<Snake> snakes;
+  long max_d = static_cast<long>(std::min(max_edit_count, static_cast<size_t>(n + m)));
+  if (n == 0 || m == 0 ||
+      !FindSnakes(&old_lines[0] + head, n, &new_lines[0] + head, m, max_d, &snakes)) {
+    AddHunk(head, n, head, m, hunks);
+    return;
+  }
+
+  // The hunks are the gaps between the snakes.
+  long x = 0;
+  long y = 0;
+  for (const Snake& snake : snakes) {
+    if (snake.length == 0) {
+      continue;
+    }
+    if (snake.x > x || snake.y > y) {
+      AddHunk(head + x, snake.x - x, head + y, snake.y - y, hunks);
+    }
+    x = snake.x + snake.length;
+    y = snake.y + snake.length;
+  }
+  if (x < n || y < m) {
+    AddHunk(head + x, n - x, head + y, m - y, hunks);
+  }
+}
+
+}  // namespace editor
@@ -0,0 +1,41 @@
+#ifndef EDITOR_LINE_DIFF_H_
+#define EDITOR_LINE_DIFF_H_
+#pragma once
+
+#include <vector>
+#include "wx/string.h"
+
+namespace editor {
+
+// The old lines [old_first, old_first + old_count) are replaced by the new
+// lines [new_first, new_first + new_count). Either count can be 0.
+struct DiffHunk {
+  size_t old_first;
+  size_t old_count;
+  size_t new_first;
+  size_t new_count;
+};
+
+// A line to diff, by its hash, and by its text if the hashes are equal, so
+// two lines whose hashes collide are still different.
+struct DiffLine {
+  unsigned long long hash;
+  const wxString* text;
+};
+
+// A 64-bit FNV-1a hash of the characters of the line.
+unsigned long long HashLine(const wxString& line);
+
+// Find the hunks which change the old lines into the new ones, in order.
+// It's Myers' O(ND) diff on the lines between the common head and tail, so
+// a small change of a big file is found fast. If more than |max_edit_count|
+// lines are inserted and deleted, the lines between the common head and
+// tail are replaced as one hunk instead.
+void DiffLines(const std::vector<DiffLine>& old_lines,
+               const std::vector<DiffLine>& new_lines,
+               size_t max_edit_count,
+               std::vector<DiffHunk>* hunks);
+
+}  // namespace editor
+
+#endif  // EDITOR_LINE_DIFF_H_
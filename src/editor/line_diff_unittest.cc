@@ -0,0 +1,131 @@
+#include "editor/line_diff.h"
+#include <string>
+#include "gtest/gtest.h"
+
+using namespace editor;
+
+namespace {
+
+// The lines named by a char each. Their texts are kept for the diff.
+std::vector<DiffLine> Lines(const char* lines) {
+  static wxString texts[128];
+  std::vector<DiffLine> diff_lines;
+  for (const char* p = lines; *p != '\0'; ++p) {
+    wxString& text = texts[static_cast<unsigned char>(*p) % 128];
+    text = wxString(*p);
+    DiffLine line = { HashLine(text), &text };
+    diff_lines.push_back(line);
+  }
+  return diff_lines;
+}
+
+void ExpectHunk(const DiffHunk& hunk, size_t old_first, size_t old_count, size_t new_first, size_t new_count) {
+  EXPECT_EQ(old_first, hunk.old_first);
+  EXPECT_EQ(old_count, hunk.old_count);
+  EXPECT_EQ(new_first, hunk.new_first);
+  EXPECT_EQ(new_count, hunk.new_count);
+}
+
+// Apply the hunks to the old lines, from the last one.
+std::string Apply(const char* old_lines, const char* new_lines, const std::vector<DiffHunk>& hunks) {
+  std::string lines(old_lines);
+  for (size_t i = hunks.size(); i > 0; --i) {
+    const DiffHunk& hunk = hunks[i - 1];
+    lines.replace(hunk.old_first, hunk.old_count, new_lines + hunk.new_first, hunk.new_count);
+  }
+  return lines;
+}
+
+}  // namespace
+
+TEST(LineDiffTest, HashLine) {
+  EXPECT_EQ(HashLine(wxT("abc")), HashLine(wxString(wxT("abc"))));
+  EXPECT_NE(HashLine(wxT("abc")), HashLine(wxT("acb")));
+  EXPECT_NE(HashLine(wxEmptyString), HashLine(wxT(" ")));
+}
+
+TEST(LineDiffTest, Empty) {
+  std::vector<DiffHunk> hunks;
+  DiffLines(Lines(""), Lines(""), 100, &hunks);
+  EXPECT_TRUE(hunks.empty());
+
+  DiffLines(Lines(""), Lines("ab"), 100, &hunks);
+  ASSERT_EQ(1u, hunks.size());
+  ExpectHunk(hunks[0], 0, 0, 0, 2);
+
+  hunks.clear();
+  DiffLines(Lines("ab"), Lines(""), 100, &hunks);
+  ASSERT_EQ(1u, hunks.size());
+  ExpectHunk(hunks[0], 0, 2, 0, 0);
+}
+
+TEST(LineDiffTest, AllEqual) {
+  std::vector<DiffHunk> hunks;
+  DiffLines(Lines("abcabc"), Lines("abcabc"), 100, &hunks);
+  EXPECT_TRUE(hunks.empty());
+}
+
+TEST(LineDiffTest, Hunks) {
+  std::vector<DiffHunk> hunks;
+  DiffLines(Lines("abcdefg"), Lines("abXdeYYfg"), 100, &hunks);
+  ASSERT_EQ(2u, hunks.size());
+  ExpectHunk(hunks[0], 2, 1, 2, 1);
+  ExpectHunk(hunks[1], 5, 0, 5, 2);
+
+  const char* old_lines = "xaybzcwd";
+  const char* new_lines = "abqcdrr";
+  hunks.clear();
+  DiffLines(Lines(old_lines), Lines(new_lines), 100, &hunks);
+  EXPECT_EQ(new_lines, Apply(old_lines, new_lines, hunks));
+}
+
+TEST(LineDiffTest, TooManyEdits) {
+  // 4 lines are replaced, with 8 edits. With fewer, the lines between the
+  // common head and tail are replaced as one hunk.
+  const char* old_lines = "headabcdefgtail";
+  const char* new_lines = "headAbCdEfGtail";
+  std::vector<DiffHunk> hunks;
+  DiffLines(Lines(old_lines), Lines(new_lines), 7, &hunks);
+  ASSERT_EQ(1u, hunks.size());
+  ExpectHunk(hunks[0], 4, 7, 4, 7);
+
+  hunks.clear();
+  DiffLines(Lines(old_lines), Lines(new_lines), 8, &hunks);
+  EXPECT_EQ(4u, hunks.size());
+  EXPECT_EQ(new_lines, Apply(old_lines, new_lines, hunks));
+}
+
+TEST(LineDiffTest, HashCollision) {
+  // Lines whose hashes are equal but whose texts aren't differ.
+  wxString a(wxT("a"));
+  wxString b(wxT("b"));
+  DiffLine old_line = { 1, &a };
+  DiffLine new_line = { 1, &b };
+  DiffLine same_line = { 1, &a };
+  std::vector<DiffLine> old_lines(3, old_line);
+  std::vector<DiffLine> new_lines(3, same_line);
+  new_lines[1] = new_line;
+
+  std::vector<DiffHunk> hunks;
+  DiffLines(old_lines, new_lines, 100, &hunks);
+  ASSERT_EQ(1u, hunks.size());
+  ExpectHunk(hunks[0], 1, 1, 1, 1);
+
+  // Not only in the common head and tail.
+  old_lines.insert(old_lines.begin(), Lines("x")[0]);
+  new_lines.push_back(Lines("y")[0]);
+  hunks.clear();
+  DiffLines(old_lines, new_lines, 100, &hunks);
+  std::vector<DiffLine> applied(old_lines);
+  for (size_t i = hunks.size(); i > 0; --i) {
+    const DiffHunk& hunk = hunks[i - 1];
+    applied.erase(applied.begin() + hunk.old_first, applied.begin() + hunk.old_first + hunk.old_count);
+    applied.insert(applied.begin() + hunk.old_first,
+                   new_lines.begin() + hunk.new_first,
+                   new_lines.begin() + hunk.new_first + hunk.new_count);
+  }
+  ASSERT_EQ(new_lines.size(), applied.size());
+  for (size_t i = 0; i < applied.size(); ++i) {
+    EXPECT_EQ(*new_lines[i].text, *applied[i].text);
+  }
+}
@@ -0,0 +1,231 @@
+#include "editor/line_index.h"
+#include <cstring>
+#include "wx/ffile.h"
+#include "wx/filefn.h"
+#include "wx/filename.h"
+#include "editor/trace.h"
+
+namespace editor {
+
+// Smaller files are scanned faster than their cache is checked.
+const size_t kMinCachedFileSize = 1024 * 1024;
+
+const char kCacheMagic[4] = { 'L', 'I', 'D', 'X' };
+const unsigned int kCacheVersion = 1;
+
+// The hash covers kSampleCount blocks of kSampleSize bytes, spread evenly
+// over the file, so checking a huge file reads only a few pages.
+const size_t kSampleCount = 16;
+const size_t kSampleSize = 4096;
+
+static wxString g_cache_dir;
+
+// 64-bit FNV-1a.
+const unsigned long long kFnvOffsetBasis = 14695981039346656037ULL;
+const unsigned long long kFnvPrime = 1099511628211ULL;
+
+static unsigned long long HashBytes(unsigned long long hash, const char* data, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * kFnvPrime;
+  }
+  return hash;
+}
+
+static unsigned long long HashSamples(const char* data, size_t size) {
+  if (size <= kSampleCount * kSampleSize) {
+    return HashBytes(kFnvOffsetBasis, data, size);
+  }
+  unsigned long long hash = kFnvOffsetBasis;
+  for (size_t i = 0; i < kSampleCount; ++i) {
+    size_t offset = (size - kSampleSize) / (kSampleCount - 1) * i;
+    hash = HashBytes(hash, data + offset, kSampleSize);
+  }
+  return hash;
+}
+
+static wxString GetCachePath(const wxString& path) {
+  wxScopedCharBuffer utf8 = path.ToUTF8();
+  unsigned long long hash = HashBytes(kFnvOffsetBasis, utf8.data(), utf8.length());
+  return g_cache_dir + wxT("/") + wxString::Format(wxT("%016") wxLongLongFmtSpec wxT("x.lidx"), hash);
+}
+
+// The cache header is followed by a varint of (length << 2 | line end type)
+// per line, which is one or two bytes for most lines.
+struct CacheHeader {
+  char magic[4];
+  unsigned int version;
+  unsigned long long file_size;
+  long long mtime;
+  unsigned long long sample_hash;
+  unsigned long long line_count;
+};
+
+LineIndex::LineIndex() : end_offset_(0) {
+}
+
+size_t LineIndex::GetLineLength(size_t line) const {
+  size_t end = line + 1 < line_offsets_.size() ? line_offsets_[line + 1] : end_offset_;
+  switch (line_end_types_[line]) {
+    case LINE_END_TYPE_DOS:
+      return end - line_offsets_[line] - 2;
+    case LINE_END_TYPE_UNIX:
+    case LINE_END_TYPE_MAC:
+      return end - line_offsets_[line] - 1;
+    default:
+      return end - line_offsets_[line];
+  }
+}
+
+// memchr() is much faster than comparing the bytes one by one, so the bytes
+// are searched for '\n' first, and only the byte before it and the bytes
+// between are checked for '\r'.
+void LineIndex::Build(const char* data, size_t size) {
+  TRACE_SCOPE("LineIndex::Build");
+  line_offsets_.clear();
+  line_end_types_.clear();
+  end_offset_ = size;
+
+  size_t start = 0;
+  while (start < size) {
+    const char* lf = static_cast<const char*>(memchr(data + start, '\n', size - start));
+    size_t lf_offset = lf == NULL ? size : lf - data;
+
+    // Old Mac line ends before the '\n', if any.
+    const char* cr = static_cast<const char*>(memchr(data + start, '\r', lf_offset - start));
+    while (cr != NULL && cr + 1 < data + lf_offset) {
+      line_offsets_.push_back(start);
+      line_end_types_.push_back(LINE_END_TYPE_MAC);
+      start = cr + 1 - data;
+      cr = static_cast<const char*>(memchr(data + start, '\r', lf_offset - start));
+    }
+
+    if (lf == NULL) {
+      if (cr != NULL) {
+        // A '\r' at the end of the file.
+        line_offsets_.push_back(start);
+        line_end_types_.push_back(LINE_END_TYPE_MAC);
+        start = size;
+      }
+      break;
+    }
+    line_offsets_.push_back(start);
+    line_end_types_.push_back(cr != NULL ? LINE_END_TYPE_DOS : LINE_END_TYPE_UNIX);
+    start = lf_offset + 1;
+  }
+
+  line_offsets_.push_back(start);
+  line_end_types_.push_back(LINE_END_TYPE_NONE);
+}
+
+void LineIndex::SetCacheDir(const wxString& cache_dir) {
+  g_cache_dir = cache_dir;
+}
+
+bool LineIndex::ReadCache(const wxString& path, const char* data, size_t size) {
+  TRACE_SCOPE("LineIndex::ReadCache");
+  if (g_cache_dir.IsEmpty() || size < kMinCachedFileSize) {
+    return false;
+  }
+
+  wxFFile file(GetCachePath(path), wxT("rb"));
+  if (!file.IsOpened()) {
+    return false;
+  }
+  CacheHeader header;
+  if (file.Read(&header, sizeof(header)) != sizeof(header) ||
+      memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+      header.version != kCacheVersion ||
+      header.file_size != size ||
+      header.mtime != static_cast<long long>(wxFileModificationTime(path)) ||
+      header.sample_hash != HashSamples(data, size)) {
+    return false;
+  }
+
+  std::vector<unsigned char> buffer(static_cast<size_t>(file.Length()) - sizeof(header));
+  if (buffer.empty() || file.Read(&buffer[0], buffer.size()) != buffer.size()) {
+    return false;
+  }
+
+  line_offsets_.clear();
+  line_end_types_.clear();
+  line_offsets_.reserve(static_cast<size_t>(header.line_count));
+  line_end_types_.reserve(static_cast<size_t>(header.line_count));
+
+  size_t offset = 0;
+  size_t i = 0;
+  while (i < buffer.size()) {
+    unsigned long long value = 0;
+    for (int shift = 0; i < buffer.size(); shift += 7) {
+      unsigned char byte = buffer[i++];
+      value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        break;
+      }
+    }
+    line_offsets_.push_back(offset);
+    line_end_types_.push_back(static_cast<unsigned char>(value & 3));
+    offset += static_cast<size_t>(value >> 2);
+  }
+  end_offset_ = size;
+
+  // A cache which doesn't add up is ignored.
+  if (line_end_types_.size() != header.line_count || offset != size) {
+    line_offsets_.clear();
+    line_end_types_.clear();
+    return false;
+  }
+  return true;
+}
+
+// The cache is written to a temporary file and renamed, so a reader never
+// sees a partial one, and the threads reading the same file don't write
+// over each other.
+bool LineIndex::WriteCache(const wxString& path, const char* data, size_t size) const {
+  TRACE_SCOPE("LineIndex::WriteCache");
+  if (g_cache_dir.IsEmpty() || size < kMinCachedFileSize) {
+    return false;
+  }
+  if (!wxDirExists(g_cache_dir) && !wxMkdir(g_cache_dir)) {
+    return false;
+  }
+
+  CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.version = kCacheVersion;
+  header.file_size = size;
+  header.mtime = static_cast<long long>(wxFileModificationTime(path));
+  header.sample_hash = HashSamples(data, size);
+  header.line_count = GetLineCount();
+
+  std::vector<unsigned char> buffer;
+  buffer.reserve(GetLineCount() * 2);
+  for (size_t line = 0; line < GetLineCount(); ++line) {
+    size_t end = line + 1 < line_offsets_.size() ? line_offsets_[line + 1] : end_offset_;
+    unsigned long long value = static_cast<unsigned long long>(end - line_offsets_[line]) << 2 | line_end_types_[line];
+    while (value >= 0x80) {
+      buffer.push_back(static_cast<unsigned char>(value | 0x80));
+      value >>= 7;
+    }
+    buffer.push_back(static_cast<unsigned char>(value));
+  }
+
+  wxString cache_path = GetCachePath(path);
+  wxString temp_path = wxFileName::CreateTempFileName(cache_path);
+  if (temp_path.IsEmpty()) {
+    return false;
+  }
+  {
+    wxFFile file(temp_path, wxT("wb"));
+    if (!file.IsOpened() ||
+        file.Write(&header, sizeof(header)) != sizeof(header) ||
+        file.Write(&buffer[0], buffer.size()) != buffer.size() ||
+        !file.Close()) {
+      wxRemoveFile(temp_path);
+      return false;
+    }
+  }
+  return wxRenameFile(temp_path, cache_path, true);
+}
+
+}  // namespace editor
@@ -0,0 +1,49 @@
+#ifndef EDITOR_LINE_INDEX_H_
+#define EDITOR_LINE_INDEX_H_
+#pragma once
+
+#include <ctime>
+#include <vector>
+#include "wx/string.h"
+#include "editor/text_line.h"
+
+namespace editor {
+
+// The lines of a file: where each line starts, how many bytes it has
+// without the line end, and how it ends. It's found by scanning the bytes
+// for line breaks, or read from a sidecar cache written by an earlier scan
+// of the same file.
+class LineIndex {
+public:
+  LineIndex();
+
+  // Scan |size| bytes for line breaks. A file of n line breaks has n + 1
+  // lines, the last one has no line end.
+  void Build(const char* data, size_t size);
+
+  size_t GetLineCount() const { return line_end_types_.size(); }
+  size_t GetLineOffset(size_t line) const { return line_offsets_[line]; }
+  size_t GetLineLength(size_t line) const;
+  LineEndType GetLineEndType(size_t line) const { return static_cast<LineEndType>(line_end_types_[line]); }
+
+  // The caches are kept in |cache_dir|. No cache is read or written if it's
+  // empty, which is the default. Set it before any file is read.
+  static void SetCacheDir(const wxString& cache_dir);
+
+  // Read the cache of the file of |path|, which has the bytes |data| now.
+  // The cache is used only if the size, the modification time and a hash of
+  // samples of the bytes are the same as when it was written.
+  bool ReadCache(const wxString& path, const char* data, size_t size);
+  bool WriteCache(const wxString& path, const char* data, size_t size) const;
+
+private:
+  std::vector<size_t> line_offsets_;
+  std::vector<unsigned char> line_end_types_;
+
+  // The offset after the last line, i.e. the file size.
+  size_t end_offset_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_LINE_INDEX_H_
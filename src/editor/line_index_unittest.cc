@@ -0,0 +1,73 @@
+#include "editor/line_index.h"
+#include <cstring>
+#include <string>
+#include "gtest/gtest.h"
+
+using namespace editor;
+
+namespace {
+
+std::string GetLine(const LineIndex& line_index, const char* data, size_t line) {
+  return std::string(data + line_index.GetLineOffset(line), line_index.GetLineLength(line));
+}
+
+}  // namespace
+
+TEST(LineIndexTest, Empty) {
+  LineIndex line_index;
+  line_index.Build("", 0);
+  ASSERT_EQ(1u, line_index.GetLineCount());
+  EXPECT_EQ(0u, line_index.GetLineLength(0));
+  EXPECT_EQ(LINE_END_TYPE_NONE, line_index.GetLineEndType(0));
+}
+
+TEST(LineIndexTest, LineEnds) {
+  const char* data = "unix\ndos\r\nmac\rlast";
+  LineIndex line_index;
+  line_index.Build(data, strlen(data));
+
+  ASSERT_EQ(4u, line_index.GetLineCount());
+  EXPECT_EQ("unix", GetLine(line_index, data, 0));
+  EXPECT_EQ(LINE_END_TYPE_UNIX, line_index.GetLineEndType(0));
+  EXPECT_EQ("dos", GetLine(line_index, data, 1));
+  EXPECT_EQ(LINE_END_TYPE_DOS, line_index.GetLineEndType(1));
+  EXPECT_EQ("mac", GetLine(line_index, data, 2));
+  EXPECT_EQ(LINE_END_TYPE_MAC, line_index.GetLineEndType(2));
+  EXPECT_EQ("last", GetLine(line_index, data, 3));
+  EXPECT_EQ(LINE_END_TYPE_NONE, line_index.GetLineEndType(3));
+}
+
+TEST(LineIndexTest, LineEndAtEnd) {
+  // A line break at the end is followed by an empty line.
+  const char* data = "a\r\n\r\r";
+  LineIndex line_index;
+  line_index.Build(data, strlen(data));
+
+  ASSERT_EQ(4u, line_index.GetLineCount());
+  EXPECT_EQ("a", GetLine(line_index, data, 0));
+  EXPECT_EQ(LINE_END_TYPE_DOS, line_index.GetLineEndType(0));
+  EXPECT_EQ(0u, line_index.GetLineLength(1));
+  EXPECT_EQ(LINE_END_TYPE_MAC, line_index.GetLineEndType(1));
+  EXPECT_EQ(LINE_END_TYPE_MAC, line_index.GetLineEndType(2));
+  EXPECT_EQ(0u, line_index.GetLineLength(3));
+  EXPECT_EQ(LINE_END_TYPE_NONE, line_index.GetLineEndType(3));
+}
+
+TEST(LineIndexTest, LongLines) {
+  // Lines longer than a scan step and a CR before a LF far after it.
+  std::string data(100000, 'x');
+  data += "\r";
+  data += std::string(70000, 'y');
+  data += "\n\n";
+  LineIndex line_index;
+  line_index.Build(data.data(), data.size());
+
+  ASSERT_EQ(4u, line_index.GetLineCount());
+  EXPECT_EQ(100000u, line_index.GetLineLength(0));
+  EXPECT_EQ(LINE_END_TYPE_MAC, line_index.GetLineEndType(0));
+  EXPECT_EQ(100001u, line_index.GetLineOffset(1));
+  EXPECT_EQ(70000u, line_index.GetLineLength(1));
+  EXPECT_EQ(LINE_END_TYPE_UNIX, line_index.GetLineEndType(1));
+  EXPECT_EQ(0u, line_index.GetLineLength(2));
+  EXPECT_EQ(0u, line_index.GetLineLength(3));
+}
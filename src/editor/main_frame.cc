@@ -1,38 +1,216 @@
 ﻿#include "editor/main_frame.h"
+#include <algorithm>
 #include "wx/menu.h"
 #include "wx/msgdlg.h"
 #include "wx/filedlg.h"
+#include "wx/dirdlg.h"
+#include "wx/choicdlg.h"
+#include "wx/textdlg.h"
 #include "wx/log.h"
 #include "wx/caret.h"
 #include "wx/accel.h"
+#include "wx/filefn.h"
+#include "wx/filename.h"
+#include "wx/fswatcher.h"
+#include "wx/notebook.h"
+#include "editor/config.h"
+#include "editor/document.h"
+#include "editor/document_manager.h"
+#include "editor/edit_command.h"
+#include "editor/editor_page.h"
+#include "editor/file_preloader.h"
+#include "editor/latency_tracker.h"
+#include "editor/memory_dialog.h"
+#include "editor/memory_usage.h"
+#include "editor/session.h"
+#include "editor/symbol_index.h"
+#include "editor/text_file.h"
 #include "editor/text_scroll_window.h"
+#include "editor/trace.h"
 
 namespace editor {
 
 wxBEGIN_EVENT_TABLE(MainFrame, wxFrame)
+EVT_MENU(wxID_NEW, MainFrame::OnNew)
 EVT_MENU(wxID_OPEN, MainFrame::OnOpen)
+EVT_MENU(wxID_CLOSE, MainFrame::OnClose)
 EVT_MENU(wxID_SAVE, MainFrame::OnSave)
+EVT_MENU(wxID_SAVEAS, MainFrame::OnSaveAs)
 EVT_MENU(wxID_EXIT, MainFrame::OnExit)
+EVT_CLOSE(MainFrame::OnCloseWindow)
+EVT_NOTEBOOK_PAGE_CHANGED(wxID_ANY, MainFrame::OnPageChanged)
+EVT_MENU(ID_SPLIT_VIEW, MainFrame::OnSplitView)
+EVT_MENU_RANGE(ID_LINE_END_DOS, ID_LINE_END_MAC, MainFrame::OnConvertLineEnds)
+EVT_THREAD(ID_PRELOAD, MainFrame::OnPreload)
+EVT_MENU(ID_FOLLOW, MainFrame::OnFollow)
+EVT_FSWATCHER(wxID_ANY, MainFrame::OnFileSystemEvent)
+EVT_TIMER(ID_FILE_CHANGE_TIMER, MainFrame::OnFileChangeTimer)
+EVT_MENU(ID_RECORD_TRACE, MainFrame::OnRecordTrace)
+EVT_MENU(ID_SAVE_TRACE, MainFrame::OnSaveTrace)
+EVT_MENU(ID_SHOW_LATENCY, MainFrame::OnShowLatency)
+EVT_TIMER(ID_LATENCY_TIMER, MainFrame::OnLatencyTimer)
+EVT_MENU(ID_MEMORY_USAGE, MainFrame::OnMemoryUsage)
+EVT_MENU(ID_INDEX_PROJECT, MainFrame::OnIndexProject)
+EVT_THREAD(ID_SYMBOL_INDEX, MainFrame::OnSymbolIndex)
+EVT_MENU(ID_GO_TO_DEFINITION, MainFrame::OnGoToDefinition)
+EVT_MENU(ID_GO_TO_SYMBOL, MainFrame::OnGoToSymbol)
 wxEND_EVENT_TABLE()
 
+// The most symbols offered by Go to Symbol.
+const size_t kMaxSymbolCount = 100;
+
 MainFrame::MainFrame(Config* config) 
     :  config_(config),
-       text_scroll_window_(NULL) {
+       notebook_(NULL),
+       document_manager_(NULL),
+       is_restoring_(false),
+       file_preloader_(NULL),
+       file_watcher_(NULL),
+       file_change_timer_(this, ID_FILE_CHANGE_TIMER),
+       latency_timer_(this, ID_LATENCY_TIMER),
+       memory_dialog_(NULL),
+       symbol_index_(NULL) {
+}
+
+// The views are destroyed before the documents they show.
+MainFrame::~MainFrame() {
+  if (file_preloader_ != NULL) {
+    file_preloader_->Delete();
+    delete file_preloader_;
+  }
+  delete symbol_index_;
+  delete file_watcher_;
+  DestroyChildren();
+  delete document_manager_;
 }
 
 bool MainFrame::Create(wxWindow* parent, wxWindowID id, const wxString& title) {
   wxFrame::Create(parent, id, title);
-  text_scroll_window_ = new TextScrollWindow(config_);
-  text_scroll_window_->Create(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxVSCROLL | wxHSCROLL);
+  document_manager_ = new DocumentManager(config_);
+  symbol_index_ = new SymbolIndex();
   InitMenuBar();
+  notebook_ = new wxNotebook(this, wxID_ANY);
   return true;
 }
 
+static bool IsUsedLater(const SessionFile* lhs, const SessionFile* rhs) {
+  return lhs->last_used_ > rhs->last_used_;
+}
+
+// The pages are added without being activated, and only the page shown reads
+// its file. The files used lately are read ahead in a thread, as many as the
+// document manager keeps loaded, and the others when they're shown.
+void MainFrame::RestoreSession(const wxString& session_path) {
+  TRACE_SCOPE("MainFrame::RestoreSession");
+  session_path_ = session_path;
+
+  Session session;
+  session.LoadFile(session_path);
+  if (!session.project_dir_.IsEmpty() && wxDirExists(session.project_dir_)) {
+    symbol_index_->Start(session.project_dir_, config_->tab_size_, this, ID_SYMBOL_INDEX);
+  }
+
+  is_restoring_ = true;
+  int active_page = 0;
+  std::vector<const SessionFile*> preload_files;
+  for (size_t i = 0; i < session.files_.size(); ++i) {
+    const SessionFile& session_file = session.files_[i];
+    if (!wxFileExists(session_file.path_) || document_manager_->Find(session_file.path_) != NULL) {
+      continue;
+    }
+
+    if (static_cast<int>(i) == session.active_file_) {
+      active_page = notebook_->GetPageCount();
+    } else {
+      preload_files.push_back(&session_file);
+    }
+
+    EditorPage* editor_page = AddPage(document_manager_->Open(session_file.path_), false);
+    TextScrollWindow* text_scroll_window = editor_page->GetActiveView();
+    text_scroll_window->SetWordWrap(session_file.is_word_wrap_);
+    // The lines may be others if the file is changed.
+    if (session_file.IsStampValid()) {
+      text_scroll_window->SetViewport(session_file.caret_pos_, session_file.top_line_);
+    }
+  }
+  is_restoring_ = false;
+
+  if (notebook_->GetPageCount() == 0) {
+    AddPage(document_manager_->NewDocument());
+    return;
+  }
+  notebook_->ChangeSelection(active_page);
+  ActivatePage();
+
+  std::sort(preload_files.begin(), preload_files.end(), IsUsedLater);
+  if (preload_files.size() > DocumentManager::kMaxInactiveLoadedCount) {
+    preload_files.resize(DocumentManager::kMaxInactiveLoadedCount);
+  }
+  if (!preload_files.empty()) {
+    std::vector<wxString> paths;
+    for (const SessionFile* session_file : preload_files) {
+      paths.push_back(session_file->path_);
+    }
+    file_preloader_ = new FilePreloader(this, ID_PRELOAD, paths, config_->tab_size_);
+    if (file_preloader_->Run() != wxTHREAD_NO_ERROR) {
+      delete file_preloader_;
+      file_preloader_ = NULL;
+    }
+  }
+}
+
+// The new files aren't kept, they're saved or discarded already.
+void MainFrame::SaveSession() {
+  if (session_path_.IsEmpty()) {
+    return;
+  }
+
+  Session session;
+  session.project_dir_ = symbol_index_->dir();
+  for (size_t i = 0; i < notebook_->GetPageCount(); ++i) {
+    EditorPage* editor_page = GetPage(i);
+    Document* document = editor_page->GetDocument();
+    if (document->is_new()) {
+      continue;
+    }
+    if (static_cast<int>(i) == notebook_->GetSelection()) {
+      session.active_file_ = session.files_.size();
+    }
+
+    SessionFile session_file(document->path());
+    session_file.UpdateStamp();
+    session_file.last_used_ = document->last_used();
+    TextScrollWindow* text_scroll_window = editor_page->GetActiveView();
+    session_file.caret_pos_ = text_scroll_window->GetCaretPosition();
+    session_file.top_line_ = text_scroll_window->GetTopLine();
+    session_file.is_word_wrap_ = text_scroll_window->IsWordWrap();
+    session.files_.push_back(session_file);
+  }
+  session.SaveFile(session_path_);
+}
+
+// A file shown or edited before it's read by the thread is read again, and
+// the text of the thread is dropped.
+void MainFrame::OnPreload(wxThreadEvent& event) {
+  std::vector<TextFile*> text_files;
+  file_preloader_->TakeTextFiles(&text_files);
+  for (TextFile* text_file : text_files) {
+    Document* document = document_manager_->Find(text_file->GetPath());
+    if (document != NULL && !document->IsLoaded()) {
+      document->SetTextFile(text_file);
+    } else {
+      delete text_file;
+    }
+  }
+}
+
 void MainFrame::InitMenuBar() {
   wxMenuBar* editor_menu_bar = new wxMenuBar();
 
   wxMenu* file_menu = new wxMenu();
+  file_menu->Append(wxID_NEW, wxT("New\tCtrl+N"));
   file_menu->Append(wxID_OPEN, wxT("Open...\tCtrl+O"));
+  file_menu->Append(wxID_CLOSE, wxT("Close\tCtrl+W"));
   file_menu->Append(wxID_SAVE, wxT("Save\tCtrl+S"));
   file_menu->Append(wxID_SAVEAS, wxT("Save As\tCtrl+Alt+S"));
   file_menu->Append(wxID_EXIT, wxT("Exit\tAlt+F4"));
@@ -44,76 +222,591 @@ void MainFrame::InitMenuBar() {
   edit_menu->Append(wxID_COPY, wxT("Copy\tCtrl+C"));
   edit_menu->Append(wxID_CUT, wxT("Cut\tCtrl+X"));
   edit_menu->Append(wxID_PASTE, wxT("Paste\tCtrl+V"));
+  edit_menu->Append(ID_SELECT_ALL_OCCURRENCES, wxT("Select All Occurrences\tCtrl+Shift+L"));
+  edit_menu->Append(wxID_FIND, wxT("Find...\tCtrl+F"));
+  edit_menu->Append(ID_FIND_NEXT, wxT("Find Next\tF3"));
+  edit_menu->Append(ID_GO_TO_LINE, wxT("Go to Line...\tCtrl+G"));
+  edit_menu->Append(ID_GO_TO_MATCHING_BRACKET, wxT("Go to Matching Bracket\tCtrl+]"));
+  edit_menu->Append(ID_COMPLETE_WORD, wxT("Complete Word\tCtrl+Space"));
+  edit_menu->Append(ID_GO_TO_DEFINITION, wxT("Go to Definition\tF12"));
+  edit_menu->Append(ID_GO_TO_SYMBOL, wxT("Go to Symbol...\tCtrl+T"));
+  wxMenu* line_end_menu = new wxMenu();
+  line_end_menu->Append(ID_LINE_END_DOS, wxT("Windows (CRLF)"));
+  line_end_menu->Append(ID_LINE_END_UNIX, wxT("Unix (LF)"));
+  line_end_menu->Append(ID_LINE_END_MAC, wxT("Mac (CR)"));
+  edit_menu->AppendSubMenu(line_end_menu, wxT("Convert Line Endings"));
   editor_menu_bar->Append(edit_menu, wxT("Edit"));
 
+  wxMenu* view_menu = new wxMenu();
+  view_menu->AppendCheckItem(ID_WORD_WRAP, wxT("Word Wrap\tAlt+Z"));
+  view_menu->AppendCheckItem(ID_SPLIT_VIEW, wxT("Split View\tCtrl+\\"));
+  view_menu->AppendCheckItem(ID_FOLLOW, wxT("Follow File\tCtrl+Shift+F"));
+  view_menu->Append(ID_TOGGLE_FOLD, wxT("Toggle Fold\tCtrl+Shift+["));
+  view_menu->Append(ID_UNFOLD_ALL, wxT("Unfold All"));
+  editor_menu_bar->Append(view_menu, wxT("View"));
+
+  wxMenu* tools_menu = new wxMenu();
+  tools_menu->AppendCheckItem(ID_RECORD_TRACE, wxT("Record Trace"));
+  tools_menu->Append(ID_SAVE_TRACE, wxT("Save Trace..."));
+  tools_menu->AppendCheckItem(ID_SHOW_LATENCY, wxT("Show Input Latency"));
+  tools_menu->Append(ID_MEMORY_USAGE, wxT("Memory Usage..."));
+  tools_menu->Append(ID_INDEX_PROJECT, wxT("Index Project Folder..."));
+  editor_menu_bar->Append(tools_menu, wxT("Tools"));
+
   SetMenuBar(editor_menu_bar);
 }
 
+static const wxChar* kFileWildcard = wxT("All types(*.*) | *.*| \
+                                         Normal text file(*.txt) | *.txt| \
+                                         C source file(*.c;*.h) | *.c;*.h| \
+                                         C++ source file(*.h;*.hpp,;*.cpp;*.cc) | *.h;*.hpp,;*.cpp;*.cc");
+
+EditorPage* MainFrame::GetCurrentPage() const {
+  return static_cast<EditorPage*>(notebook_->GetCurrentPage());
+}
+
+EditorPage* MainFrame::GetPage(size_t page) const {
+  return static_cast<EditorPage*>(notebook_->GetPage(page));
+}
+
+EditorPage* MainFrame::AddPage(Document* document, bool select) {
+  EditorPage* editor_page = new EditorPage(config_);
+  editor_page->Create(notebook_, document);
+  // The page changed event activates the document.
+  notebook_->AddPage(editor_page, document->GetTitle(), select);
+  WatchDocument(document);
+  return editor_page;
+}
+
+void MainFrame::UpdatePageTitles(Document* document) {
+  for (size_t i = 0; i < notebook_->GetPageCount(); ++i) {
+    if (GetPage(i)->GetDocument() == document) {
+      notebook_->SetPageText(i, document->GetTitle());
+    }
+  }
+}
+
+void MainFrame::OpenFile(const wxString& path) {
+  Document* document = document_manager_->Find(path);
+  if (document != NULL) {
+    for (size_t i = 0; i < notebook_->GetPageCount(); ++i) {
+      if (GetPage(i)->GetDocument() == document) {
+        notebook_->SetSelection(i);
+        return;
+      }
+    }
+  }
+  AddPage(document_manager_->Open(path));
+}
+
+void MainFrame::OnPageChanged(wxBookCtrlEvent& event) {
+  if (!is_restoring_) {
+    ActivatePage();
+  }
+}
+
+void MainFrame::ActivatePage() {
+  EditorPage* editor_page = GetCurrentPage();
+  if (editor_page == NULL) {
+    return;
+  }
+
+  Document* document = editor_page->GetDocument();
+  if (!document_manager_->Activate(document)) {
+    wxMessageBox(wxT("Can't read ") + document->path(), wxT("Open"), wxOK | wxICON_ERROR, this);
+    // Closed later, the notebook is still changing the page.
+    size_t page = notebook_->GetSelection();
+    CallAfter([this, page]() { ClosePage(page); });
+    return;
+  }
+
+  TextScrollWindow* text_scroll_window = editor_page->GetActiveView();
+  GetMenuBar()->Check(ID_WORD_WRAP, text_scroll_window->IsWordWrap());
+  GetMenuBar()->Check(ID_SPLIT_VIEW, editor_page->IsSplit());
+  GetMenuBar()->Check(ID_FOLLOW, document->is_following());
+  wxString title = document->GetTitle();
+  if (document->text_file()->IsPaged()) {
+    title += wxT(" (Read Only)");
+  } else if (document->text_file()->IsHex()) {
+    title += wxT(" (Hex)");
+  }
+  SetTitle(title + wxT(" - Text Editor"));
+  text_scroll_window->SetFocus();
+}
+
+void MainFrame::OnSplitView(wxCommandEvent& event) {
+  EditorPage* editor_page = GetCurrentPage();
+  if (editor_page == NULL) {
+    return;
+  }
+  if (editor_page->IsSplit()) {
+    editor_page->UnsplitView();
+  } else {
+    editor_page->SplitView();
+  }
+  GetMenuBar()->Check(ID_SPLIT_VIEW, editor_page->IsSplit());
+}
+
+void MainFrame::OnFollow(wxCommandEvent& event) {
+  EditorPage* editor_page = GetCurrentPage();
+  if (editor_page == NULL) {
+    return;
+  }
+  Document* document = editor_page->GetDocument();
+  if (document->is_following()) {
+    StopFollowing(document);
+  } else if (document->is_new() || document->IsModified()) {
+    wxMessageBox(wxT("Save the file before following it."), wxT("Follow File"), wxOK | wxICON_INFORMATION, this);
+  } else if (!StartFollowing(document)) {
+    wxMessageBox(wxT("Can't watch ") + document->path(), wxT("Follow File"), wxOK | wxICON_ERROR, this);
+  }
+  GetMenuBar()->Check(ID_FOLLOW, document->is_following());
+}
+
+// What's appended since the file was read is read at once.
+bool MainFrame::StartFollowing(Document* document) {
+  if (!WatchDocument(document)) {
+    return false;
+  }
+  document->set_following(true);
+  pending_documents_.insert(document);
+  if (!file_change_timer_.IsRunning()) {
+    file_change_timer_.StartOnce(1);
+  }
+  return true;
+}
+
+void MainFrame::StopFollowing(Document* document) {
+  document->set_following(false);
+}
+
+// The watcher needs the event loop, so it's created when the loop runs, and
+// the files opened before are watched then.
+void MainFrame::CreateFileWatcher() {
+  if (file_watcher_ != NULL) {
+    return;
+  }
+  file_watcher_ = new wxFileSystemWatcher();
+  file_watcher_->SetOwner(this);
+  for (size_t i = 0; i < notebook_->GetPageCount(); ++i) {
+    WatchDocument(GetPage(i)->GetDocument());
+  }
+}
+
+// The directory is watched instead of the file, since a file replaced by
+// another one, e.g. a rotated log or a file written by a build tool into a
+// temporary file and renamed, is no longer the file watched.
+bool MainFrame::WatchDocument(Document* document) {
+  if (watched_documents_.find(document) != watched_documents_.end()) {
+    return true;
+  }
+  if (file_watcher_ == NULL || document->is_new()) {
+    return false;
+  }
+  wxString dir = wxFileName(document->path()).GetPath();
+  int events = wxFSW_EVENT_MODIFY | wxFSW_EVENT_CREATE | wxFSW_EVENT_RENAME;
+  if (watched_dirs_[dir] == 0 && !file_watcher_->Add(wxFileName::DirName(dir), events)) {
+    watched_dirs_.erase(dir);
+    return false;
+  }
+  ++watched_dirs_[dir];
+  watched_documents_[document] = dir;
+  return true;
+}
+
+void MainFrame::UnwatchDocument(Document* document) {
+  StopFollowing(document);
+  pending_documents_.erase(document);
+
+  std::map<Document*, wxString>::iterator it = watched_documents_.find(document);
+  if (it == watched_documents_.end()) {
+    return;
+  }
+  if (--watched_dirs_[it->second] == 0) {
+    file_watcher_->Remove(wxFileName::DirName(it->second));
+    watched_dirs_.erase(it->second);
+  }
+  watched_documents_.erase(it);
+}
+
+void MainFrame::OnFileSystemEvent(wxFileSystemWatcherEvent& event) {
+  // About 20 updates per second at most.
+  const int kFileChangeUpdateMs = 50;
+
+  wxFileName file_name;
+  int change_type = event.GetChangeType();
+  if (change_type == wxFSW_EVENT_MODIFY || change_type == wxFSW_EVENT_CREATE) {
+    file_name = event.GetPath();
+  } else if (change_type == wxFSW_EVENT_RENAME) {
+    file_name = event.GetNewPath();
+  } else {
+    return;
+  }
+  Document* document = document_manager_->Find(file_name.GetFullPath());
+  if (document == NULL || watched_documents_.find(document) == watched_documents_.end()) {
+    return;
+  }
+  pending_documents_.insert(document);
+  if (!file_change_timer_.IsRunning()) {
+    file_change_timer_.StartOnce(kFileChangeUpdateMs);
+  }
+}
+
+// A document which isn't loaded reads the file when it's shown. The files
+// written by the editor itself have the stamps of the writes.
+void MainFrame::OnFileChangeTimer(wxTimerEvent& event) {
+  TRACE_SCOPE("MainFrame::OnFileChangeTimer");
+  std::set<Document*> documents;
+  documents.swap(pending_documents_);
+  for (Document* document : documents) {
+    if (!document->IsLoaded()) {
+      continue;
+    }
+    if (document->is_following()) {
+      ReadAppended(document);
+    } else if (document->IsFileChanged()) {
+      ReloadDocument(document);
+    }
+  }
+
+  EditorPage* editor_page = GetCurrentPage();
+  if (editor_page != NULL) {
+    GetMenuBar()->Check(ID_FOLLOW, editor_page->GetDocument()->is_following());
+  }
+}
+
+// An edited document isn't followed any more. A file which is truncated or
+// replaced, e.g. a rotated log, is read again.
+void MainFrame::ReadAppended(Document* document) {
+  if (document->IsModified()) {
+    StopFollowing(document);
+    return;
+  }
+  if (document->ReadAppended(config_->tab_size_, config_->follow_max_lines_)) {
+    return;
+  }
+  document->Unload();
+  if (!document->Load(config_->tab_size_)) {
+    StopFollowing(document);
+    return;
+  }
+  document->ReadAppended(config_->tab_size_, config_->follow_max_lines_);
+}
+
+// The edits of a modified document are kept if the user says so. The change
+// is ignored then, until the file is changed again. A file which can't be
+// read, e.g. it's still being written, is read on its next change.
+void MainFrame::ReloadDocument(Document* document) {
+  if (document->IsModified()) {
+    document->IgnoreFileChange();
+    int ret = wxMessageBox(document->GetTitle() + wxT(" is changed by another program. Reload it?"),
+                           wxT("Reload"),
+                           wxYES_NO,
+                           this);
+    if (ret != wxYES) {
+      return;
+    }
+  }
+  document->Reload(config_->tab_size_);
+}
+
+// The lines keep their chars, so the views aren't changed. A hex text has
+// no line ends of its own.
+void MainFrame::OnConvertLineEnds(wxCommandEvent& event) {
+  EditorPage* editor_page = GetCurrentPage();
+  if (editor_page == NULL || !editor_page->GetDocument()->IsLoaded() ||
+      editor_page->GetDocument()->text_file()->IsHex()) {
+    return;
+  }
+  LineEndType type = LINE_END_TYPE_DOS;
+  if (event.GetId() == ID_LINE_END_UNIX) {
+    type = LINE_END_TYPE_UNIX;
+  } else if (event.GetId() == ID_LINE_END_MAC) {
+    type = LINE_END_TYPE_MAC;
+  }
+  TextFile* text_file = editor_page->GetDocument()->text_file();
+  text_file->Execute(new ConvertLineEndingsCommand(text_file, type));
+}
+
+void MainFrame::OnNew(wxCommandEvent& event) {
+  AddPage(document_manager_->NewDocument());
+}
+
 void MainFrame::OnOpen(wxCommandEvent& event) {
   wxString caption = wxT("Open");
-  wxString wildcard = wxT("All types(*.*) | *.*| \
-                          Normal text file(*.txt) | *.txt| \
-                          C source file(*.c;*.h) | *.c;*.h| \
-                          C++ source file(*.h;*.hpp,;*.cpp;*.cc) | *.h;*.hpp,;*.cpp;*.cc");
   wxString default_dir = wxT("./");
   wxString default_file_name = wxEmptyString;
-  wxFileDialog file_dialog(this, caption, default_dir, default_file_name, wildcard, wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+  wxFileDialog file_dialog(this, caption, default_dir, default_file_name, kFileWildcard, wxFD_OPEN | wxFD_FILE_MUST_EXIST | wxFD_MULTIPLE);
 
   if (file_dialog.ShowModal() == wxID_OK) {
-    text_scroll_window_->SetTextFile(file_dialog.GetDirectory() + "\\" + file_dialog.GetFilename());
-    text_scroll_window_->SetFileNew(false);
+    wxArrayString paths;
+    file_dialog.GetPaths(paths);
+    for (size_t i = 0; i < paths.size(); ++i) {
+      OpenFile(paths[i]);
+    }
   }
 }
 
-void MainFrame::OnSave(wxCommandEvent& event) {
-  if (text_scroll_window_->IsNewFile()) {
-    wxString caption = wxT("Save");
-    wxString wildcard = wxT("All types(*.*) | *.*| \
-                            Normal text file(*.txt) | *.txt| \
-                            C source file(*.c;*.h) | *.c;*.h| \
-                            C++ source file(*.h;*.hpp,;*.cpp;*.cc) | *.h;*.hpp,;*.cpp;*.cc");
-    wxString default_dir = wxT("./");
-    wxString default_file_name = wxEmptyString;
-    wxFileDialog file_dialog(this, caption, default_dir, default_file_name, wildcard, wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
-    if (file_dialog.ShowModal() == wxID_OK) {
-      text_scroll_window_->CreateNewFile(file_dialog.GetDirectory() + "\\" + file_dialog.GetFilename());
-    }
-  } else {
-    text_scroll_window_->SaveFile();
+void MainFrame::OnClose(wxCommandEvent& event) {
+  if (notebook_->GetSelection() != wxNOT_FOUND) {
+    ClosePage(notebook_->GetSelection());
   }
 }
 
-void MainFrame::OnSaveAs(wxCommandEvent& event) {
+// A document is shown in one page only. There is always a page, a new file
+// if the last one is closed.
+bool MainFrame::ClosePage(size_t page) {
+  EditorPage* editor_page = GetPage(page);
+  Document* document = editor_page->GetDocument();
+  if (!ConfirmClose(document)) {
+    return false;
+  }
+
+  UnwatchDocument(document);
+  editor_page->CloseDocument();
+  document_manager_->Release(document);
+  notebook_->DeletePage(page);
+
+  if (notebook_->GetPageCount() == 0) {
+    AddPage(document_manager_->NewDocument());
+  }
+  return true;
+}
+
+bool MainFrame::ConfirmClose(Document* document) {
+  if (!document->IsModified()) {
+    return true;
+  }
+  int ret = wxMessageBox(wxT("Save changes to ") + document->GetTitle() + wxT("?"),
+                         wxT("Save"),
+                         wxYES_NO | wxCANCEL,
+                         this);
+  if (ret == wxCANCEL) {
+    return false;
+  }
+  return ret == wxNO || SaveDocument(document);
+}
+
+bool MainFrame::SaveDocument(Document* document) {
+  if (document->is_new()) {
+    return SaveDocumentAs(document);
+  }
+  if (!document->Save(config_->tab_size_)) {
+    wxMessageBox(wxT("Can't write ") + document->path(), wxT("Save"), wxOK | wxICON_ERROR, this);
+    return false;
+  }
+  return true;
+}
+
+bool MainFrame::SaveDocumentAs(Document* document) {
   wxString caption = wxT("Save As");
-  wxString wildcard = wxT("All types(*.*) | *.*| \
-                          Normal text file(*.txt) | *.txt| \
-                          C source file(*.c;*.h) | *.c;*.h| \
-                          C++ source file(*.h;*.hpp,;*.cpp;*.cc) | *.h;*.hpp,;*.cpp;*.cc");
   wxString default_dir = wxT("./");
-  wxString default_file_name = wxEmptyString;
-  wxFileDialog file_dialog(this, caption, default_dir, default_file_name, wildcard, wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+  wxString default_file_name = document->is_new() ? wxString() : document->GetTitle();
+  wxFileDialog file_dialog(this, caption, default_dir, default_file_name, kFileWildcard, wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+  if (file_dialog.ShowModal() != wxID_OK) {
+    return false;
+  }
+
+  // Saving over another open file would make two documents of one path.
+  Document* other = document_manager_->Find(file_dialog.GetPath());
+  if (other != NULL && other != document) {
+    wxMessageBox(file_dialog.GetPath() + wxT(" is open in another tab."), caption, wxOK | wxICON_ERROR, this);
+    return false;
+  }
+
+  UnwatchDocument(document);
+  bool is_saved = document->SaveAs(file_dialog.GetPath(), config_->tab_size_);
+  WatchDocument(document);
+  if (!is_saved) {
+    wxMessageBox(wxT("Can't write ") + file_dialog.GetPath(), caption, wxOK | wxICON_ERROR, this);
+    return false;
+  }
+  UpdatePageTitles(document);
+  SetTitle(document->GetTitle() + wxT(" - Text Editor"));
+  return true;
+}
+
+void MainFrame::OnSave(wxCommandEvent& event) {
+  EditorPage* editor_page = GetCurrentPage();
+  if (editor_page != NULL) {
+    SaveDocument(editor_page->GetDocument());
+  }
+}
+
+void MainFrame::OnSaveAs(wxCommandEvent& event) {
+  EditorPage* editor_page = GetCurrentPage();
+  if (editor_page != NULL) {
+    SaveDocumentAs(editor_page->GetDocument());
+  }
+}
+
+void MainFrame::GetMemoryUsage(MemoryUsage* usage) const {
+  document_manager_->GetMemoryUsage(usage);
+  for (size_t i = 0; i < notebook_->GetPageCount(); ++i) {
+    GetPage(i)->GetMemoryUsage(usage);
+  }
+  usage->Add(MEMORY_SYMBOL_INDEX, symbol_index_->GetMemoryUsage());
+}
+
+// A folder indexed before is read from its cache, and only its files changed
+// since are parsed again.
+void MainFrame::OnIndexProject(wxCommandEvent& event) {
+  wxString dir = wxDirSelector(wxT("Project Folder"),
+                               symbol_index_->dir(),
+                               wxDD_DEFAULT_STYLE | wxDD_DIR_MUST_EXIST,
+                               wxDefaultPosition,
+                               this);
+  if (!dir.IsEmpty()) {
+    symbol_index_->Start(dir, config_->tab_size_, this, ID_SYMBOL_INDEX);
+  }
+}
+
+// The event of a thread stopped since is ignored.
+void MainFrame::OnSymbolIndex(wxThreadEvent& event) {
+  symbol_index_->TakeIndex();
+}
 
-  if (wxID_CANCEL == file_dialog.ShowModal()) {
+void MainFrame::OnGoToDefinition(wxCommandEvent& event) {
+  const wxString kCaption = wxT("Go to Definition");
+  EditorPage* editor_page = GetCurrentPage();
+  if (editor_page == NULL) {
     return;
   }
+  wxString name = editor_page->GetActiveView()->GetWordAtCaret();
+  if (name.IsEmpty() || !CheckSymbolIndex(kCaption)) {
+    return;
+  }
+  std::vector<SymbolLocation> locations;
+  symbol_index_->FindDefinitions(name, &locations);
+  if (locations.empty()) {
+    wxMessageBox(wxT("No definition of ") + name + wxT(" is found."), kCaption, wxOK | wxICON_INFORMATION, this);
+    return;
+  }
+  GoToSymbol(locations, kCaption);
 }
 
-void MainFrame::OnExit(wxCommandEvent& event) {
-  if (!text_scroll_window_->IsFileChanged()) {
-    Close();
+void MainFrame::OnGoToSymbol(wxCommandEvent& event) {
+  const wxString kCaption = wxT("Go to Symbol");
+  if (!CheckSymbolIndex(kCaption)) {
+    return;
+  }
+  wxString prefix = wxGetTextFromUser(wxT("The name or the start of it:"), kCaption, wxEmptyString, this);
+  if (prefix.IsEmpty()) {
     return;
   }
-  int ret = wxMessageBox(wxT("Save file?"), wxT("Save"), wxYES_NO | wxCANCEL, this);
-  if (ret == wxOK) {
-    text_scroll_window_->SaveFile();
+  std::vector<SymbolLocation> locations;
+  symbol_index_->FindSymbols(prefix, kMaxSymbolCount, &locations);
+  if (locations.empty()) {
+    wxMessageBox(wxT("No symbol starts with ") + prefix + wxT("."), kCaption, wxOK | wxICON_INFORMATION, this);
+    return;
   }
-  if (ret == wxNO) {
-    text_scroll_window_->CloseFile();
+  GoToSymbol(locations, kCaption);
+}
+
+bool MainFrame::CheckSymbolIndex(const wxString& caption) {
+  if (symbol_index_->file_count() != 0) {
+    return true;
   }
-  if (ret == wxCANCEL) {
+  wxString message = wxT("Index a project folder first, in the Tools menu.");
+  if (symbol_index_->is_building()) {
+    message = symbol_index_->dir() + wxT(" is still being indexed.");
+  } else if (!symbol_index_->dir().IsEmpty()) {
+    message = wxT("No C++ file is found in ") + symbol_index_->dir() + wxT(".");
+  }
+  wxMessageBox(message, caption, wxOK | wxICON_INFORMATION, this);
+  return false;
+}
+
+// The file may be changed since it was indexed, so the caret is clamped to
+// its text.
+void MainFrame::GoToSymbol(const std::vector<SymbolLocation>& locations, const wxString& caption) {
+  size_t choice = 0;
+  if (locations.size() > 1) {
+    wxArrayString choices;
+    for (const SymbolLocation& location : locations) {
+      choices.push_back(location.name + wxT("  ") + location.path + wxString::Format(wxT(":%d"), location.line + 1));
+    }
+    int index = wxGetSingleChoiceIndex(wxT("Definitions:"), caption, choices, this);
+    if (index < 0) {
+      return;
+    }
+    choice = static_cast<size_t>(index);
+  }
+
+  const SymbolLocation& location = locations[choice];
+  OpenFile(location.path);
+  EditorPage* editor_page = GetCurrentPage();
+  if (editor_page != NULL && editor_page->GetDocument()->path() == location.path) {
+    editor_page->GetActiveView()->GoToPosition(wxPoint(location.column, location.line));
+  }
+}
+
+// Recording starts from an empty trace.
+void MainFrame::OnRecordTrace(wxCommandEvent& event) {
+  if (event.IsChecked()) {
+    Tracer::Get().Clear();
+  }
+  Tracer::Get().Enable(event.IsChecked());
+}
+
+// The trace can be loaded in chrome://tracing.
+void MainFrame::OnSaveTrace(wxCommandEvent& event) {
+  wxString wildcard = wxT("Trace file(*.json) | *.json");
+  wxFileDialog file_dialog(this, wxT("Save Trace"), wxT("./"), wxT("trace.json"), wildcard, wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+  if (file_dialog.ShowModal() != wxID_OK) {
     return;
   }
+  if (!Tracer::Get().WriteChromeJson(file_dialog.GetPath())) {
+    wxMessageBox(wxT("Can't write the trace file."), wxT("Save Trace"), wxOK | wxICON_ERROR, this);
+  }
+}
+
+// The latency is shown in a status bar which only exists while it's shown.
+void MainFrame::OnShowLatency(wxCommandEvent& event) {
+  const int kLatencyUpdateMs = 500;
+  if (event.IsChecked()) {
+    CreateStatusBar();
+    SetStatusText(LatencyTracker::Get().FormatSummary());
+    latency_timer_.Start(kLatencyUpdateMs);
+  } else {
+    latency_timer_.Stop();
+    wxStatusBar* status_bar = GetStatusBar();
+    SetStatusBar(NULL);
+    delete status_bar;
+  }
+  SendSizeEvent();
+}
+
+void MainFrame::OnLatencyTimer(wxTimerEvent& event) {
+  SetStatusText(LatencyTracker::Get().FormatSummary());
+}
+
+void MainFrame::OnMemoryUsage(wxCommandEvent& event) {
+  if (memory_dialog_ == NULL) {
+    memory_dialog_ = new MemoryDialog(this);
+    memory_dialog_->Create(this);
+  }
+  // It's updated when it's shown, and again if it's already shown.
+  if (memory_dialog_->IsShown()) {
+    memory_dialog_->UpdateUsage();
+  }
+  memory_dialog_->Show();
+  memory_dialog_->Raise();
+}
+
+void MainFrame::OnExit(wxCommandEvent& event) {
   Close();
 }
 
+void MainFrame::OnCloseWindow(wxCloseEvent& event) {
+  for (Document* document : document_manager_->documents()) {
+    if (!ConfirmClose(document) && event.CanVeto()) {
+      event.Veto();
+      return;
+    }
+  }
+  SaveSession();
+  Destroy();
+}
+
 }  // namespace editor
@@ -2,31 +2,162 @@
 #define EDITOR_MAIN_FRAME_H_
 #pragma once
 
+#include <map>
+#include <set>
+#include <vector>
 #include "wx/frame.h"
+#include "wx/timer.h"
+
+class wxNotebook;
+class wxBookCtrlEvent;
+class wxThreadEvent;
+class wxFileSystemWatcher;
+class wxFileSystemWatcherEvent;
 
 namespace editor {
 
-class TextScrollWindow;
+class EditorPage;
 class Config;
+class MemoryDialog;
+class MemoryUsage;
+class Document;
+class DocumentManager;
+class FilePreloader;
+class SymbolIndex;
+struct SymbolLocation;
+
+// Ids of the commands handled by the frame.
+enum {
+  ID_RECORD_TRACE = wxID_HIGHEST + 100,
+  ID_SAVE_TRACE,
+  ID_SHOW_LATENCY,
+  ID_LATENCY_TIMER,
+  ID_MEMORY_USAGE,
+  ID_SPLIT_VIEW,
+  ID_PRELOAD,
+  ID_FOLLOW,
+  ID_FILE_CHANGE_TIMER,
+  ID_LINE_END_DOS,
+  ID_LINE_END_UNIX,
+  ID_LINE_END_MAC,
+  ID_INDEX_PROJECT,
+  ID_SYMBOL_INDEX,
+  ID_GO_TO_DEFINITION,
+  ID_GO_TO_SYMBOL,
+};
 
 class MainFrame : public wxFrame {
   wxDECLARE_EVENT_TABLE();
 
 public:
   explicit MainFrame(Config* config);
+  ~MainFrame();
+
   bool Create(wxWindow* parent, wxWindowID id, const wxString& title);
 
+  // Watch the files of the documents for changes by other programs. Called
+  // once the event loop runs.
+  void CreateFileWatcher();
+
+  // Open the files of the last session, or a new file if there were none.
+  // The session is saved to the same path when the frame is closed.
+  void RestoreSession(const wxString& session_path);
+
+  // Show the file in a tab. A file which is open already isn't opened again,
+  // its tab is selected.
+  void OpenFile(const wxString& path);
+
+  // Add the memory of the documents and of the views.
+  void GetMemoryUsage(MemoryUsage* usage) const;
+
 private:
+  void OnNew(wxCommandEvent& event);
   void OnOpen(wxCommandEvent& event);
+  void OnClose(wxCommandEvent& event);
   void OnExit(wxCommandEvent& event);
   void OnSave(wxCommandEvent& event);
   void OnSaveAs(wxCommandEvent& event);
+  void OnCloseWindow(wxCloseEvent& event);
+  void OnPageChanged(wxBookCtrlEvent& event);
+  void OnSplitView(wxCommandEvent& event);
+  void OnConvertLineEnds(wxCommandEvent& event);
+  void OnPreload(wxThreadEvent& event);
+  void OnFollow(wxCommandEvent& event);
+  void OnFileSystemEvent(wxFileSystemWatcherEvent& event);
+  void OnFileChangeTimer(wxTimerEvent& event);
+  void OnRecordTrace(wxCommandEvent& event);
+  void OnSaveTrace(wxCommandEvent& event);
+  void OnShowLatency(wxCommandEvent& event);
+  void OnLatencyTimer(wxTimerEvent& event);
+  void OnMemoryUsage(wxCommandEvent& event);
+  void OnIndexProject(wxCommandEvent& event);
+  void OnSymbolIndex(wxThreadEvent& event);
+  void OnGoToDefinition(wxCommandEvent& event);
+  void OnGoToSymbol(wxCommandEvent& event);
 
   void InitMenuBar();
 
+  EditorPage* GetCurrentPage() const;
+  EditorPage* GetPage(size_t page) const;
+  EditorPage* AddPage(Document* document, bool select = true);
+  void ActivatePage();
+  void SaveSession();
+  void UpdatePageTitles(Document* document);
+
+  // Return false if the file can't be watched.
+  bool WatchDocument(Document* document);
+  void UnwatchDocument(Document* document);
+
+  // Read what's appended to the file of the document when it changes.
+  bool StartFollowing(Document* document);
+  void StopFollowing(Document* document);
+  void ReadAppended(Document* document);
+
+  // Change the text to the file changed by another program.
+  void ReloadDocument(Document* document);
+
+  // Return false if the page isn't closed, e.g. the user canceled saving.
+  bool ClosePage(size_t page);
+
+  // Ask to save the document if it's modified. Return false if canceled.
+  bool ConfirmClose(Document* document);
+  bool SaveDocument(Document* document);
+  bool SaveDocumentAs(Document* document);
+
+  // Return false, and tell the user why, if no symbol can be looked for.
+  bool CheckSymbolIndex(const wxString& caption);
+
+  // Show the location, or the one the user chooses if there are more.
+  void GoToSymbol(const std::vector<SymbolLocation>& locations, const wxString& caption);
+
 private:
-  TextScrollWindow* text_scroll_window_;
+  wxNotebook* notebook_;
+  DocumentManager* document_manager_;
   Config* config_;
+
+  // The pages aren't activated while the session is restored.
+  bool is_restoring_;
+  wxString session_path_;
+  FilePreloader* file_preloader_;
+
+  // The directories are watched once however many files in them are open.
+  wxFileSystemWatcher* file_watcher_;
+  std::map<wxString, int> watched_dirs_;
+  std::map<Document*, wxString> watched_documents_;
+
+  // The changes are read at most once per timer period, however often the
+  // files are written.
+  std::set<Document*> pending_documents_;
+  wxTimer file_change_timer_;
+
+  // Updates the input latency in the status bar.
+  wxTimer latency_timer_;
+
+  // Created when it's shown the first time.
+  MemoryDialog* memory_dialog_;
+
+  // The definitions of the project folder, kept in the session.
+  SymbolIndex* symbol_index_;
 };
 
 }  // namespace editor
@@ -0,0 +1,124 @@
+#include "editor/mapped_file.h"
+#if defined(__WINDOWS__)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace editor {
+
+#if defined(__WINDOWS__)
+
+MappedFile::MappedFile()
+    : file_(INVALID_HANDLE_VALUE),
+      mapping_(NULL),
+      data_(NULL),
+      size_(0) {
+}
+
+bool MappedFile::Open(const wxString& path) {
+  Close();
+
+  file_ = ::CreateFileW(path.wc_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file_ == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if (!::GetFileSizeEx(file_, &size) || static_cast<ULONGLONG>(size.QuadPart) > static_cast<size_t>(-1)) {
+    Close();
+    return false;
+  }
+  size_ = static_cast<size_t>(size.QuadPart);
+  if (size_ == 0) {
+    return true;
+  }
+
+  mapping_ = ::CreateFileMappingW(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping_ == NULL) {
+    Close();
+    return false;
+  }
+  data_ = static_cast<const char*>(::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  if (data_ == NULL) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_ != NULL) {
+    ::UnmapViewOfFile(data_);
+    data_ = NULL;
+  }
+  if (mapping_ != NULL) {
+    ::CloseHandle(mapping_);
+    mapping_ = NULL;
+  }
+  if (file_ != INVALID_HANDLE_VALUE) {
+    ::CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+  }
+  size_ = 0;
+}
+
+#else
+
+MappedFile::MappedFile()
+    : fd_(-1),
+      data_(NULL),
+      size_(0) {
+}
+
+bool MappedFile::Open(const wxString& path) {
+  Close();
+
+  fd_ = ::open(path.fn_str(), O_RDONLY);
+  if (fd_ == -1) {
+    return false;
+  }
+
+  struct stat st;
+  if (::fstat(fd_, &st) != 0 || static_cast<unsigned long long>(st.st_size) > static_cast<size_t>(-1)) {
+    Close();
+    return false;
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ == 0) {
+    return true;
+  }
+
+  void* data = ::mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (data == MAP_FAILED) {
+    Close();
+    return false;
+  }
+  ::madvise(data, size_, MADV_SEQUENTIAL);
+  data_ = static_cast<const char*>(data);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_ != NULL) {
+    ::munmap(const_cast<char*>(data_), size_);
+    data_ = NULL;
+  }
+  if (fd_ != -1) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  size_ = 0;
+}
+
+#endif  // __WINDOWS__
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+}  // namespace editor
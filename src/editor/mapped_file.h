@@ -0,0 +1,37 @@
+#ifndef EDITOR_MAPPED_FILE_H_
+#define EDITOR_MAPPED_FILE_H_
+#pragma once
+
+#include <cstddef>
+#include "wx/string.h"
+
+namespace editor {
+
+// A read-only memory mapping of a whole file. The pages are read by the
+// system when they're touched, so opening a huge file costs no read.
+class MappedFile {
+public:
+  MappedFile();
+  ~MappedFile();
+
+  bool Open(const wxString& path);
+  void Close();
+
+  // NULL if the file is empty.
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+#if defined(__WINDOWS__)
+  void* file_;
+  void* mapping_;
+#else
+  int fd_;
+#endif
+  const char* data_;
+  size_t size_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_MAPPED_FILE_H_
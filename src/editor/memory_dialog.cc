@@ -0,0 +1,74 @@
+#include "editor/memory_dialog.h"
+#include "wx/button.h"
+#include "wx/filename.h"
+#include "wx/listctrl.h"
+#include "wx/sizer.h"
+#include "editor/memory_usage.h"
+#include "editor/main_frame.h"
+
+namespace editor {
+
+wxBEGIN_EVENT_TABLE(MemoryDialog, wxDialog)
+EVT_BUTTON(wxID_REFRESH, MemoryDialog::OnRefresh)
+EVT_SHOW(MemoryDialog::OnShow)
+EVT_CLOSE(MemoryDialog::OnClose)
+wxEND_EVENT_TABLE()
+
+MemoryDialog::MemoryDialog(MainFrame* main_frame)
+    : main_frame_(main_frame),
+      list_ctrl_(NULL) {
+}
+
+bool MemoryDialog::Create(wxWindow* parent) {
+  if (!wxDialog::Create(parent, wxID_ANY, wxT("Memory Usage"), wxDefaultPosition, wxDefaultSize,
+                        wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER)) {
+    return false;
+  }
+
+  list_ctrl_ = new wxListCtrl(this, wxID_ANY, wxDefaultPosition, wxSize(360, 200), wxLC_REPORT);
+  list_ctrl_->InsertColumn(0, wxT("Category"), wxLIST_FORMAT_LEFT, 140);
+  list_ctrl_->InsertColumn(1, wxT("Size"), wxLIST_FORMAT_RIGHT, 90);
+  list_ctrl_->InsertColumn(2, wxT("Bytes"), wxLIST_FORMAT_RIGHT, 110);
+  for (int i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+    list_ctrl_->InsertItem(i, MemoryUsage::GetCategoryName(static_cast<MemoryCategory>(i)));
+  }
+  list_ctrl_->InsertItem(MEMORY_CATEGORY_COUNT, wxT("Total"));
+
+  wxBoxSizer* vsizer = new wxBoxSizer(wxVERTICAL);
+  vsizer->Add(list_ctrl_, 1, wxEXPAND | wxALL, 5);
+  vsizer->Add(new wxButton(this, wxID_REFRESH), 0, wxALIGN_RIGHT | wxLEFT | wxRIGHT | wxBOTTOM, 5);
+  SetSizerAndFit(vsizer);
+  return true;
+}
+
+static void SetItemSize(wxListCtrl* list_ctrl, long item, size_t bytes) {
+  list_ctrl->SetItem(item, 1, wxFileName::GetHumanReadableSize(wxULongLong(bytes), wxT("0 B")));
+  list_ctrl->SetItem(item, 2, wxString::Format(wxT("%lu"), static_cast<unsigned long>(bytes)));
+}
+
+void MemoryDialog::UpdateUsage() {
+  MemoryUsage usage;
+  main_frame_->GetMemoryUsage(&usage);
+  for (int i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+    SetItemSize(list_ctrl_, i, usage.Get(static_cast<MemoryCategory>(i)));
+  }
+  SetItemSize(list_ctrl_, MEMORY_CATEGORY_COUNT, usage.GetTotal());
+}
+
+void MemoryDialog::OnRefresh(wxCommandEvent& event) {
+  UpdateUsage();
+}
+
+void MemoryDialog::OnShow(wxShowEvent& event) {
+  if (event.IsShown()) {
+    UpdateUsage();
+  }
+  event.Skip();
+}
+
+// The dialog is kept for the next time.
+void MemoryDialog::OnClose(wxCloseEvent& event) {
+  Hide();
+}
+
+}  // namespace editor
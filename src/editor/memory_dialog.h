@@ -0,0 +1,38 @@
+#ifndef EDITOR_MEMORY_DIALOG_H_
+#define EDITOR_MEMORY_DIALOG_H_
+#pragma once
+
+#include "wx/dialog.h"
+
+class wxListCtrl;
+
+namespace editor {
+
+class MainFrame;
+
+// A modeless diagnostics dialog which shows the memory used by the editor
+// per category. The usage walks the lines of all the documents, so it's
+// updated only when the dialog is opened or refreshed, not while editing.
+class MemoryDialog : public wxDialog {
+  wxDECLARE_EVENT_TABLE();
+
+public:
+  explicit MemoryDialog(MainFrame* main_frame);
+
+  bool Create(wxWindow* parent);
+
+  void UpdateUsage();
+
+private:
+  void OnRefresh(wxCommandEvent& event);
+  void OnShow(wxShowEvent& event);
+  void OnClose(wxCloseEvent& event);
+
+private:
+  MainFrame* main_frame_;
+  wxListCtrl* list_ctrl_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_MEMORY_DIALOG_H_
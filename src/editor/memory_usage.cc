@@ -0,0 +1,68 @@
+#include "editor/memory_usage.h"
+
+namespace editor {
+
+MemoryUsage::MemoryUsage() {
+  for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+    bytes_[i] = 0;
+  }
+}
+
+size_t MemoryUsage::GetTotal() const {
+  size_t total = 0;
+  for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+    total += bytes_[i];
+  }
+  return total;
+}
+
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& usage) {
+  for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+    bytes_[i] += usage.bytes_[i];
+  }
+  return *this;
+}
+
+wxString MemoryUsage::GetCategoryName(MemoryCategory category) {
+  switch (category) {
+  case MEMORY_LINES:
+    return wxT("Lines");
+  case MEMORY_LINE_DATA:
+    return wxT("Line data");
+  case MEMORY_WRAP_CACHE:
+    return wxT("Wrap cache");
+  case MEMORY_UNDO:
+    return wxT("Undo history");
+  case MEMORY_REDO:
+    return wxT("Redo history");
+  case MEMORY_SELECTION:
+    return wxT("Selection");
+  case MEMORY_WRAP_INDEX:
+    return wxT("Wrap index");
+  case MEMORY_PAGE_INDEX:
+    return wxT("Page index");
+  case MEMORY_PAGE_CACHE:
+    return wxT("Page cache");
+  case MEMORY_HEX_VIEW:
+    return wxT("Hex view");
+  case MEMORY_FOLD_INDEX:
+    return wxT("Fold index");
+  case MEMORY_BRACKET_INDEX:
+    return wxT("Bracket index");
+  case MEMORY_MINIMAP:
+    return wxT("Minimap");
+  case MEMORY_COMPLETION_INDEX:
+    return wxT("Completion index");
+  case MEMORY_SYMBOL_INDEX:
+    return wxT("Symbol index");
+  default:
+    return wxEmptyString;
+  }
+}
+
+size_t GetStringMemoryUsage(const wxString& str) {
+  size_t bytes = (str.capacity() + 1) * sizeof(wxStringCharType);
+  return bytes > sizeof(wxString) ? bytes : 0;
+}
+
+}  // namespace editor
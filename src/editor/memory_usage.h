@@ -0,0 +1,60 @@
+#ifndef EDITOR_MEMORY_USAGE_H_
+#define EDITOR_MEMORY_USAGE_H_
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "wx/string.h"
+
+namespace editor {
+
+enum MemoryCategory {
+  MEMORY_LINES = 0,  // the line array of the files
+  MEMORY_LINE_DATA,  // the heap blocks of the line strings
+  MEMORY_WRAP_CACHE,  // the row breaks of the long wrapped lines
+  MEMORY_UNDO,  // the undo history
+  MEMORY_REDO,  // the redo history
+  MEMORY_SELECTION,  // the selected text and the extra carets
+  MEMORY_WRAP_INDEX,  // the row counts of the wrapped lines
+  MEMORY_PAGE_INDEX,  // where the pages of the paged files start
+  MEMORY_PAGE_CACHE,  // the lines of the pages read
+  MEMORY_HEX_VIEW,  // the hex lines made and the bytes overwritten
+  MEMORY_FOLD_INDEX,  // the fold regions and the folded lines
+  MEMORY_BRACKET_INDEX,  // the brackets of the lines and their depths
+  MEMORY_MINIMAP,  // the pixels of the minimap tiles
+  MEMORY_COMPLETION_INDEX,  // the words of the documents and their lines
+  MEMORY_SYMBOL_INDEX,  // the files and the definitions of the project
+  MEMORY_CATEGORY_COUNT,
+};
+
+// The bytes used by the editor per category. The sizes are estimated from
+// the capacities of the containers and strings, without the overhead of the
+// heap.
+class MemoryUsage {
+public:
+  MemoryUsage();
+
+  void Add(MemoryCategory category, size_t bytes) { bytes_[category] += bytes; }
+  size_t Get(MemoryCategory category) const { return bytes_[category]; }
+  size_t GetTotal() const;
+
+  MemoryUsage& operator+=(const MemoryUsage& usage);
+
+  static wxString GetCategoryName(MemoryCategory category);
+
+private:
+  size_t bytes_[MEMORY_CATEGORY_COUNT];
+};
+
+// The heap bytes of the buffer of a string, 0 if it's short enough to be
+// stored in the string object.
+size_t GetStringMemoryUsage(const wxString& str);
+
+template <typename T>
+size_t GetVectorMemoryUsage(const std::vector<T>& v) {
+  return v.capacity() * sizeof(T);
+}
+
+}  // namespace editor
+
+#endif  // EDITOR_MEMORY_USAGE_H_
@@ -0,0 +1,301 @@
+#include "editor/minimap.h"
+#include <algorithm>
+#include <cstring>
+#include "wx/event.h"
+#include "editor/memory_usage.h"
+#include "editor/text_file.h"
+#include "editor/trace.h"
+
+namespace editor {
+
+class MinimapBuilder : public wxThread {
+public:
+  explicit MinimapBuilder(Minimap* minimap)
+      : wxThread(wxTHREAD_JOINABLE),
+        minimap_(minimap) {
+  }
+
+protected:
+  virtual ExitCode Entry() override {
+    minimap_->BuildTiles();
+    return static_cast<ExitCode>(0);
+  }
+
+private:
+  Minimap* minimap_;
+};
+
+Minimap::Minimap()
+    : text_file_(NULL),
+      handler_(NULL),
+      event_id_(0),
+      builder_(NULL),
+      condition_(mutex_),
+      line_count_(0),
+      lines_per_row_(1),
+      row_count_(0),
+      layout_version_(0),
+      is_changed_(false),
+      is_paused_(false),
+      is_building_(false),
+      is_stopping_(false) {
+}
+
+Minimap::~Minimap() {
+  Clear();
+}
+
+void Minimap::Reset(const TextFile* text_file, wxEvtHandler* handler, int event_id) {
+  Clear();
+  text_file_ = text_file;
+  handler_ = handler;
+  event_id_ = event_id;
+  {
+    wxMutexLocker locker(mutex_);
+    UpdateLayout();
+  }
+
+  builder_ = new MinimapBuilder(this);
+  if (builder_->Run() != wxTHREAD_NO_ERROR) {
+    delete builder_;
+    builder_ = NULL;
+  }
+}
+
+void Minimap::Clear() {
+  if (builder_ != NULL) {
+    {
+      wxMutexLocker locker(mutex_);
+      is_stopping_ = true;
+      condition_.Broadcast();
+    }
+    builder_->Wait();
+    delete builder_;
+    builder_ = NULL;
+  }
+
+  wxMutexLocker locker(mutex_);
+  text_file_ = NULL;
+  handler_ = NULL;
+  line_count_ = 0;
+  lines_per_row_ = 1;
+  row_count_ = 0;
+  std::vector<Tile>().swap(tiles_);
+  is_changed_ = true;
+  is_paused_ = false;
+  is_building_ = false;
+  is_stopping_ = false;
+}
+
+// The tile being built reads the text, so it's finished before the text is
+// changed.
+void Minimap::Pause() {
+  wxMutexLocker locker(mutex_);
+  is_paused_ = true;
+  while (is_building_) {
+    condition_.Wait();
+  }
+}
+
+void Minimap::Resume() {
+  wxMutexLocker locker(mutex_);
+  if (is_paused_) {
+    is_paused_ = false;
+    condition_.Broadcast();
+  }
+}
+
+void Minimap::OnLinesChanged(size_t first_line, size_t old_count, size_t new_count) {
+  if (!is_active()) {
+    return;
+  }
+
+  {
+    wxMutexLocker locker(mutex_);
+    size_t lines_per_row = lines_per_row_;
+    UpdateLayout();
+    // All the tiles are made again if the rows are for other lines.
+    if (lines_per_row_ == lines_per_row) {
+      size_t tile_line_count = lines_per_row_ * kTileRowCount;
+      size_t last_line = first_line + std::max(new_count, static_cast<size_t>(1)) - 1;
+      size_t first_tile = first_line / tile_line_count;
+      size_t end_tile = last_line / tile_line_count + 1;
+      MarkStale(first_tile, end_tile, true);
+      if (old_count != new_count) {
+        MarkStale(end_tile, tiles_.size(), false);
+      }
+    }
+    is_changed_ = true;
+  }
+  Resume();
+}
+
+bool Minimap::CopyPixels(std::vector<unsigned char>* pixels) {
+  wxMutexLocker locker(mutex_);
+  if (!is_changed_) {
+    return false;
+  }
+  is_changed_ = false;
+
+  pixels->assign(row_count_ * kColumnCount, 0);
+  for (size_t i = 0; i < tiles_.size(); ++i) {
+    const std::vector<unsigned char>& tile_pixels = tiles_[i].pixels;
+    if (tile_pixels.empty()) {
+      continue;
+    }
+    size_t first_row = i * kTileRowCount;
+    size_t row_count = std::min(kTileRowCount, row_count_ - first_row);
+    memcpy(&(*pixels)[first_row * kColumnCount], &tile_pixels[0], row_count * kColumnCount);
+  }
+  return true;
+}
+
+size_t Minimap::GetMemoryUsage() const {
+  wxMutexLocker locker(mutex_);
+  size_t bytes = GetVectorMemoryUsage(tiles_);
+  for (size_t i = 0; i < tiles_.size(); ++i) {
+    bytes += GetVectorMemoryUsage(tiles_[i].pixels);
+  }
+  return bytes;
+}
+
+size_t Minimap::GetLinesPerRow(size_t line_count) {
+  size_t lines_per_row = 1;
+  while ((line_count + lines_per_row - 1) / lines_per_row > kMaxRowCount) {
+    lines_per_row *= 2;
+  }
+  return lines_per_row;
+}
+
+// The tiles are kept if the lines per row are the same. A new tile at the
+// end is stale.
+void Minimap::UpdateLayout() {
+  line_count_ = text_file_->GetLineCount();
+  size_t lines_per_row = GetLinesPerRow(line_count_);
+  row_count_ = (line_count_ + lines_per_row - 1) / lines_per_row;
+  size_t tile_count = (row_count_ + kTileRowCount - 1) / kTileRowCount;
+
+  Tile tile = { std::vector<unsigned char>(), true, false, 0 };
+  if (lines_per_row != lines_per_row_ || tiles_.empty()) {
+    lines_per_row_ = lines_per_row;
+    ++layout_version_;
+    tiles_.assign(tile_count, tile);
+  } else {
+    tiles_.resize(tile_count, tile);
+  }
+}
+
+bool Minimap::FindStaleTile(size_t* tile) const {
+  size_t stale_tile = tiles_.size();
+  for (size_t i = 0; i < tiles_.size(); ++i) {
+    if (tiles_[i].is_stale) {
+      if (tiles_[i].is_edited) {
+        *tile = i;
+        return true;
+      }
+      if (stale_tile == tiles_.size()) {
+        stale_tile = i;
+      }
+    }
+  }
+  *tile = stale_tile;
+  return stale_tile != tiles_.size();
+}
+
+void Minimap::MarkStale(size_t first_tile, size_t end_tile, bool is_edited) {
+  end_tile = std::min(end_tile, tiles_.size());
+  for (size_t i = first_tile; i < end_tile; ++i) {
+    Tile& tile = tiles_[i];
+    tile.is_stale = true;
+    tile.is_edited = tile.is_edited || is_edited;
+    ++tile.version;
+  }
+}
+
+// A tile is built without the lock. Its pixels are dropped if it's marked
+// stale again meanwhile.
+void Minimap::BuildTiles() {
+  std::vector<unsigned char> pixels;
+  while (true) {
+    size_t tile = 0;
+    unsigned int version = 0;
+    unsigned int layout_version = 0;
+    size_t lines_per_row = 0;
+    size_t line_count = 0;
+    {
+      wxMutexLocker locker(mutex_);
+      while (!is_stopping_ && (is_paused_ || !FindStaleTile(&tile))) {
+        condition_.Wait();
+      }
+      if (is_stopping_) {
+        break;
+      }
+      version = tiles_[tile].version;
+      layout_version = layout_version_;
+      lines_per_row = lines_per_row_;
+      line_count = line_count_;
+      is_building_ = true;
+    }
+
+    BuildTile(tile, lines_per_row, line_count, &pixels);
+
+    bool is_built = false;
+    {
+      wxMutexLocker locker(mutex_);
+      is_building_ = false;
+      condition_.Broadcast();
+      if (layout_version == layout_version_ && tile < tiles_.size() &&
+          tiles_[tile].version == version) {
+        tiles_[tile].pixels.swap(pixels);
+        tiles_[tile].is_stale = false;
+        tiles_[tile].is_edited = false;
+        is_changed_ = true;
+        is_built = true;
+      }
+    }
+    if (is_built) {
+      wxQueueEvent(handler_, new wxThreadEvent(wxEVT_THREAD, event_id_));
+    }
+  }
+}
+
+void Minimap::BuildTile(size_t tile,
+                        size_t lines_per_row,
+                        size_t line_count,
+                        std::vector<unsigned char>* pixels) const {
+  TRACE_SCOPE("Minimap::BuildTile");
+  pixels->assign(kTileRowCount * kColumnCount, 0);
+  size_t step = std::max(lines_per_row / kSampleLineCount, static_cast<size_t>(1));
+  const int max_column = kColumnCount * kCharsPerColumn;
+
+  for (size_t row = 0; row < kTileRowCount; ++row) {
+    size_t first_line = (tile * kTileRowCount + row) * lines_per_row;
+    if (first_line >= line_count) {
+      break;
+    }
+    size_t end_line = std::min(first_line + lines_per_row, line_count);
+
+    int counts[kColumnCount] = { 0 };
+    int sample_count = 0;
+    for (size_t i = first_line; i < end_line; i += step) {
+      ++sample_count;
+      const wxString& line = text_file_->GetLine(i).GetData();
+      int column = 0;
+      for (wxString::const_iterator it = line.begin(); it != line.end() && column < max_column; ++it) {
+        wxChar ch = *it;
+        if (ch != wxT(' ') && ch != wxT('\t')) {
+          ++counts[column / kCharsPerColumn];
+        }
+        ++column;
+      }
+    }
+
+    unsigned char* row_pixels = &(*pixels)[row * kColumnCount];
+    int full_count = sample_count * kCharsPerColumn;
+    for (int j = 0; j < kColumnCount; ++j) {
+      row_pixels[j] = static_cast<unsigned char>(counts[j] * 255 / full_count);
+    }
+  }
+}
+
+}  // namespace editor
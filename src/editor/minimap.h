@@ -0,0 +1,109 @@
+#ifndef EDITOR_MINIMAP_H_
+#define EDITOR_MINIMAP_H_
+#pragma once
+
+#include <vector>
+#include "wx/thread.h"
+
+class wxEvtHandler;
+
+namespace editor {
+
+class TextFile;
+class MinimapBuilder;
+
+// A downsampled overview of a whole text file. A row of the minimap stands
+// for a power of 2 of lines, so there are at most kMaxRowCount rows, and a
+// column for kCharsPerColumn chars. Each pixel is the density of the chars
+// which aren't spaces in its lines and columns, sampled from at most
+// kSampleLineCount lines.
+//
+// The rows are built in tiles on a worker thread. After an edit only the
+// tiles of the edited lines are built again first, then the ones whose
+// lines were moved, and the old pixels are shown until then. The worker
+// never reads the text while it's changed: it's paused before the change
+// and resumed once the lines are updated.
+class Minimap {
+public:
+  static const int kColumnCount = 80;
+  static const int kCharsPerColumn = 2;
+  static const size_t kTileRowCount = 64;
+  static const size_t kMaxRowCount = 4096;
+  static const size_t kSampleLineCount = 16;
+
+  Minimap();
+  ~Minimap();
+
+  // A wxThreadEvent of |event_id| is queued to |handler| after a tile is
+  // built.
+  void Reset(const TextFile* text_file, wxEvtHandler* handler, int event_id);
+  void Clear();
+
+  bool is_active() const { return text_file_ != NULL; }
+
+  // Called on the main thread before and after the text is changed.
+  void Pause();
+  void Resume();
+
+  // The lines [first_line, first_line + old_count) were replaced by
+  // [first_line, first_line + new_count). It resumes the worker.
+  void OnLinesChanged(size_t first_line, size_t old_count, size_t new_count);
+
+  size_t lines_per_row() const { return lines_per_row_; }
+  size_t row_count() const { return row_count_; }
+
+  // Copy the pixels of all rows, row by row, if any tile is changed since
+  // the last copy. A tile not built yet is blank.
+  bool CopyPixels(std::vector<unsigned char>* pixels);
+
+  size_t GetMemoryUsage() const;
+
+private:
+  friend class MinimapBuilder;
+
+  struct Tile {
+    std::vector<unsigned char> pixels;
+    bool is_stale;
+    bool is_edited;  // built before the other stale tiles
+    unsigned int version;
+  };
+
+  static size_t GetLinesPerRow(size_t line_count);
+
+  void UpdateLayout();
+  bool FindStaleTile(size_t* tile) const;
+  void MarkStale(size_t first_tile, size_t end_tile, bool is_edited);
+
+  // Run by the worker thread until it's stopped.
+  void BuildTiles();
+  void BuildTile(size_t tile,
+                 size_t lines_per_row,
+                 size_t line_count,
+                 std::vector<unsigned char>* pixels) const;
+
+private:
+  const TextFile* text_file_;
+  wxEvtHandler* handler_;
+  int event_id_;
+
+  MinimapBuilder* builder_;
+
+  // Guards the members below, which both threads use.
+  mutable wxMutex mutex_;
+  wxCondition condition_;
+
+  size_t line_count_;
+  size_t lines_per_row_;
+  size_t row_count_;
+  unsigned int layout_version_;
+  std::vector<Tile> tiles_;
+  bool is_changed_;
+
+  bool is_paused_;
+  bool is_building_;
+  bool is_stopping_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_MINIMAP_H_
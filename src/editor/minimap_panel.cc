@@ -0,0 +1,57 @@
+#include "editor/minimap_panel.h"
+#include "wx/dcbuffer.h"
+#include "editor/text_scroll_window.h"
+
+namespace editor {
+
+wxBEGIN_EVENT_TABLE(MinimapPanel, wxPanel)
+EVT_PAINT(MinimapPanel::OnPaint)
+EVT_LEFT_DOWN(MinimapPanel::OnMouseLeftDown)
+EVT_MOTION(MinimapPanel::OnMouseMotion)
+EVT_LEFT_UP(MinimapPanel::OnMouseLeftUp)
+EVT_THREAD(wxID_ANY, MinimapPanel::OnTileBuilt)
+wxEND_EVENT_TABLE()
+
+MinimapPanel::MinimapPanel() : owner_(NULL) {
+}
+
+bool MinimapPanel::Create(TextScrollWindow* parent) {
+  owner_ = parent;
+  wxPanel::Create(parent, wxID_ANY);
+  SetBackgroundColour(*wxWHITE);
+  SetBackgroundStyle(wxBG_STYLE_PAINT);
+  return true;
+}
+
+// The minimap isn't scrolled, so the dc isn't prepared.
+void MinimapPanel::OnPaint(wxPaintEvent& event) {
+  wxAutoBufferedPaintDC dc(this);
+  dc.Clear();
+  owner_->HandleMinimapPaint(dc);
+}
+
+void MinimapPanel::OnMouseLeftDown(wxMouseEvent& event) {
+  if (!HasCapture()) {
+    CaptureMouse();
+  }
+  owner_->HandleMinimapMouse(event.GetPosition());
+}
+
+void MinimapPanel::OnMouseMotion(wxMouseEvent& event) {
+  if (event.Dragging() && event.LeftIsDown()) {
+    owner_->HandleMinimapMouse(event.GetPosition());
+  }
+}
+
+void MinimapPanel::OnMouseLeftUp(wxMouseEvent& event) {
+  if (HasCapture()) {
+    ReleaseMouse();
+  }
+}
+
+// Sent by the minimap builder thread.
+void MinimapPanel::OnTileBuilt(wxThreadEvent& event) {
+  Refresh();
+}
+
+}  // namespace editor
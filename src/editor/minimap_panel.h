@@ -0,0 +1,33 @@
+#ifndef EDITOR_MINIMAP_PANEL_H_
+#define EDITOR_MINIMAP_PANEL_H_
+#pragma once
+
+#include "wx/panel.h"
+
+namespace editor {
+
+class TextScrollWindow;
+
+// Shows the minimap of the text beside it. A click or a drag scrolls the
+// text to the line under the mouse.
+class MinimapPanel : public wxPanel {
+  wxDECLARE_EVENT_TABLE();
+
+public:
+  MinimapPanel();
+  bool Create(TextScrollWindow* parent);
+
+private:
+  void OnPaint(wxPaintEvent& event);
+  void OnMouseLeftDown(wxMouseEvent& event);
+  void OnMouseMotion(wxMouseEvent& event);
+  void OnMouseLeftUp(wxMouseEvent& event);
+  void OnTileBuilt(wxThreadEvent& event);
+
+private:
+  TextScrollWindow* owner_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_MINIMAP_PANEL_H_
@@ -0,0 +1,402 @@
+#include "editor/paged_text.h"
+#include <algorithm>
+#include <cstring>
+#include "editor/line_index.h"
+#include "editor/memory_usage.h"
+#include "editor/trace.h"
+
+namespace editor {
+
+// A page ends at the first line end after kPageSize bytes or kPageLineCount
+// lines. A longer line has a page of its own, so a page of several lines is
+// never more than twice kPageSize bytes.
+const size_t kPageSize = 64 * 1024;
+const size_t kPageLineCount = 4096;
+
+// The pages last used are kept over the budget, so the lines the caller
+// still refers to aren't dropped.
+const size_t kMinPageCount = 2;
+
+const size_t kScanChunkSize = 4 * 1024 * 1024;
+
+// The encoding is detected from the head of the file.
+const size_t kDetectSize = 64 * 1024;
+
+const size_t PagedText::kMaxLineSize;
+
+struct PagedText::Page {
+  std::vector<TextLine> lines;
+  size_t bytes;
+  std::list<size_t>::iterator used;
+};
+
+// The bytes of the whole chars at the head of |size| UTF-8 bytes. A char is
+// no more than 4 bytes.
+static size_t GetUtf8HeadSize(const char* data, size_t size) {
+  size_t lead = size;
+  while (lead > 0 && size - lead < 4 && (static_cast<unsigned char>(data[lead - 1]) & 0xC0) == 0x80) {
+    --lead;
+  }
+  if (lead == 0) {
+    return size;
+  }
+  unsigned char c = static_cast<unsigned char>(data[lead - 1]);
+  size_t char_size = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+  return lead - 1 + char_size <= size ? size : lead - 1;
+}
+
+static bool IsBefore(const wxPoint& lhs, const wxPoint& rhs) {
+  return lhs.y < rhs.y || (lhs.y == rhs.y && lhs.x < rhs.x);
+}
+
+PagedText::PagedText()
+    : file_size_(0),
+      bom_size_(0),
+      encoding_(FILE_ENCODING_UTF8),
+      tab_size_(0),
+      line_count_(0),
+      max_line_size_(0),
+      cache_bytes_(0),
+      cache_size_(0) {
+}
+
+PagedText::~PagedText() {
+  DropPages(0);
+}
+
+// The head of the file is cut at a line break before the encoding is
+// detected, so no char is cut.
+bool PagedText::Open(const wxString& path, int tab_size, size_t cache_size) {
+  TRACE_SCOPE("PagedText::Open");
+  if (!file_.Open(path, wxT("rb"))) {
+    return false;
+  }
+  wxFileOffset length = file_.Length();
+  if (length < 0) {
+    return false;
+  }
+  file_size_ = static_cast<unsigned long long>(length);
+  tab_size_ = tab_size;
+  cache_size_ = cache_size;
+
+  std::vector<char> head;
+  if (!ReadBytes(0, static_cast<size_t>(std::min<unsigned long long>(kDetectSize, file_size_)), &head)) {
+    return false;
+  }
+  size_t head_size = head.size();
+  if (head_size < file_size_) {
+    while (head_size > 0 && head[head_size - 1] != '\n') {
+      --head_size;
+    }
+  }
+  encoding_ = DetectEncoding(head.empty() ? NULL : &head[0], head_size, &bom_size_);
+  if (encoding_ == FILE_ENCODING_UTF16LE || encoding_ == FILE_ENCODING_UTF16BE) {
+    return false;
+  }
+
+  page_offsets_.push_back(bom_size_);
+  page_first_lines_.push_back(0);
+  if (!Scan()) {
+    return false;
+  }
+  pages_.resize(page_offsets_.size(), NULL);
+  return true;
+}
+
+// The page of the last byte read is scanned again, since its last line and a
+// '\r' at its end, which may be the first half of a "\r\n", may go on.
+bool PagedText::ReadAppended(size_t* first_line) {
+  TRACE_SCOPE("PagedText::ReadAppended");
+  wxFileOffset length = file_.Length();
+  if (length < 0 || static_cast<unsigned long long>(length) < file_size_) {
+    return false;
+  }
+  if (static_cast<unsigned long long>(length) == file_size_) {
+    *first_line = line_count_;
+    return true;
+  }
+
+  while (page_offsets_.size() > 1 && page_offsets_.back() >= file_size_) {
+    page_offsets_.pop_back();
+    page_first_lines_.pop_back();
+  }
+  DropPages(page_offsets_.size() - 1);
+  *first_line = page_first_lines_.back();
+
+  file_size_ = static_cast<unsigned long long>(length);
+  if (!Scan()) {
+    return false;
+  }
+  pages_.resize(page_offsets_.size(), NULL);
+  return true;
+}
+
+bool PagedText::ReadBytes(unsigned long long offset, size_t size, std::vector<char>* bytes) const {
+  bytes->resize(size);
+  if (size == 0) {
+    return true;
+  }
+  return file_.Seek(static_cast<wxFileOffset>(offset)) && file_.Read(&(*bytes)[0], size) == size;
+}
+
+// The line breaks are found the way LineIndex::Build() finds them, but only
+// the pages are kept. A '\r' at the end of a chunk is held until the next
+// byte is read.
+bool PagedText::Scan() {
+  TRACE_SCOPE("PagedText::Scan");
+  unsigned long long line_start = page_offsets_.back();
+  line_count_ = page_first_lines_.back();
+  bool is_cr_pending = false;
+
+  std::vector<char> buffer(kScanChunkSize);
+  if (!file_.Seek(static_cast<wxFileOffset>(line_start))) {
+    return false;
+  }
+  for (unsigned long long base = line_start; base < file_size_; ) {
+    size_t size = static_cast<size_t>(std::min<unsigned long long>(kScanChunkSize, file_size_ - base));
+    if (file_.Read(&buffer[0], size) != size) {
+      return false;
+    }
+    const char* data = &buffer[0];
+    size_t start = 0;
+
+    if (is_cr_pending) {
+      is_cr_pending = false;
+      start = data[0] == '\n' ? 1 : 0;
+      EndLine(line_start, base - 1, base + start);
+      line_start = base + start;
+    }
+
+    while (start < size) {
+      const char* lf = static_cast<const char*>(memchr(data + start, '\n', size - start));
+      size_t lf_offset = lf == NULL ? size : lf - data;
+
+      const char* cr = static_cast<const char*>(memchr(data + start, '\r', lf_offset - start));
+      while (cr != NULL && cr + 1 < data + lf_offset) {
+        start = cr + 1 - data;
+        EndLine(line_start, base + (cr - data), base + start);
+        line_start = base + start;
+        cr = static_cast<const char*>(memchr(data + start, '\r', lf_offset - start));
+      }
+
+      if (lf == NULL) {
+        is_cr_pending = cr != NULL;
+        break;
+      }
+      start = lf_offset + 1;
+      EndLine(line_start, base + (cr != NULL ? cr - data : lf_offset), base + start);
+      line_start = base + start;
+    }
+    base += size;
+  }
+
+  if (is_cr_pending) {
+    EndLine(line_start, file_size_ - 1, file_size_);
+    line_start = file_size_;
+  }
+  // The last line, which has no line end, has a page of its own too if it's
+  // long.
+  if (file_size_ - line_start > kPageSize && line_count_ != page_first_lines_.back()) {
+    page_offsets_.push_back(line_start);
+    page_first_lines_.push_back(line_count_);
+  }
+  ++line_count_;
+  max_line_size_ = std::max(max_line_size_,
+                            static_cast<size_t>(std::min<unsigned long long>(file_size_ - line_start, kMaxLineSize)));
+  return true;
+}
+
+void PagedText::EndLine(unsigned long long line_start, unsigned long long line_end, unsigned long long next_line_start) {
+  if (next_line_start - line_start > kPageSize && line_count_ != page_first_lines_.back()) {
+    page_offsets_.push_back(line_start);
+    page_first_lines_.push_back(line_count_);
+  }
+  ++line_count_;
+  max_line_size_ = std::max(max_line_size_,
+                            static_cast<size_t>(std::min<unsigned long long>(line_end - line_start, kMaxLineSize)));
+
+  if (next_line_start - page_offsets_.back() >= kPageSize ||
+      line_count_ - page_first_lines_.back() >= kPageLineCount) {
+    page_offsets_.push_back(next_line_start);
+    page_first_lines_.push_back(line_count_);
+  }
+}
+
+size_t PagedText::FindLinePage(size_t line) const {
+  return std::upper_bound(page_first_lines_.begin(), page_first_lines_.end(), line) - page_first_lines_.begin() - 1;
+}
+
+size_t PagedText::FindOffsetPage(unsigned long long offset) const {
+  return std::upper_bound(page_offsets_.begin(), page_offsets_.end(), offset) - page_offsets_.begin() - 1;
+}
+
+unsigned long long PagedText::GetPageEnd(size_t page) const {
+  return page + 1 < page_offsets_.size() ? page_offsets_[page + 1] : file_size_;
+}
+
+// Bytes which aren't UTF-8 are read as Latin-1, line by line.
+wxString PagedText::DecodeBytes(const char* data, size_t size) const {
+  FileEncoding encoding = encoding_;
+  if (encoding == FILE_ENCODING_UTF8 && !IsValidUtf8(data, size)) {
+    encoding = FILE_ENCODING_LATIN1;
+  }
+  wxString line = DecodeLine(data, size, encoding);
+  line.Replace(wxT("\t"), wxString(wxT('\t'), tab_size_), true);
+  return line;
+}
+
+TextLine& PagedText::GetLine(size_t line) const {
+  size_t page = FindLinePage(line);
+  Page* p = pages_[page];
+  if (p == NULL) {
+    p = ReadPage(page);
+    pages_[page] = p;
+    used_pages_.push_front(page);
+    p->used = used_pages_.begin();
+    cache_bytes_ += p->bytes;
+
+    while (cache_bytes_ > cache_size_ && used_pages_.size() > kMinPageCount) {
+      size_t unused_page = used_pages_.back();
+      used_pages_.pop_back();
+      cache_bytes_ -= pages_[unused_page]->bytes;
+      delete pages_[unused_page];
+      pages_[unused_page] = NULL;
+    }
+  } else if (p->used != used_pages_.begin()) {
+    used_pages_.splice(used_pages_.begin(), used_pages_, p->used);
+  }
+  return p->lines[line - page_first_lines_[page]];
+}
+
+// A page which can't be read, e.g. the file was cut, has empty lines. Of a
+// line longer than kMaxLineSize only the head and the line end are read.
+PagedText::Page* PagedText::ReadPage(size_t page) const {
+  TRACE_SCOPE("PagedText::ReadPage");
+  unsigned long long offset = page_offsets_[page];
+  unsigned long long end = GetPageEnd(page);
+  size_t first_line = page_first_lines_[page];
+  size_t line_count = (page + 1 < page_first_lines_.size() ? page_first_lines_[page + 1] : line_count_) - first_line;
+
+  Page* p = new Page;
+  p->lines.reserve(line_count);
+  std::vector<char> bytes;
+  if (line_count == 1 && end - offset > kMaxLineSize + 2) {
+    std::vector<char> line_end;
+    if (ReadBytes(offset, kMaxLineSize, &bytes) && ReadBytes(end - 2, 2, &line_end)) {
+      size_t size = bytes.size();
+      if (encoding_ == FILE_ENCODING_UTF8) {
+        size = GetUtf8HeadSize(&bytes[0], size);
+      }
+      LineEndType type = LINE_END_TYPE_NONE;
+      if (line_end[1] == '\n') {
+        type = line_end[0] == '\r' ? LINE_END_TYPE_DOS : LINE_END_TYPE_UNIX;
+      } else if (line_end[1] == '\r') {
+        type = LINE_END_TYPE_MAC;
+      }
+      p->lines.push_back(TextLine(DecodeBytes(&bytes[0], size), type));
+    }
+  } else if (ReadBytes(offset, static_cast<size_t>(end - offset), &bytes)) {
+    const char* data = bytes.empty() ? NULL : &bytes[0];
+    LineIndex line_index;
+    line_index.Build(data, bytes.size());
+    for (size_t i = 0; i < line_count && i < line_index.GetLineCount(); ++i) {
+      p->lines.push_back(TextLine(DecodeBytes(data + line_index.GetLineOffset(i), line_index.GetLineLength(i)),
+                                  line_index.GetLineEndType(i)));
+    }
+  }
+  while (p->lines.size() < line_count) {
+    p->lines.push_back(TextLine(wxEmptyString, LINE_END_TYPE_NONE));
+  }
+
+  p->bytes = GetVectorMemoryUsage(p->lines);
+  for (const TextLine& text_line : p->lines) {
+    p->bytes += GetStringMemoryUsage(text_line.GetData());
+  }
+  return p;
+}
+
+void PagedText::DropPages(size_t first_page) const {
+  for (size_t i = first_page; i < pages_.size(); ++i) {
+    if (pages_[i] != NULL) {
+      used_pages_.erase(pages_[i]->used);
+      cache_bytes_ -= pages_[i]->bytes;
+      delete pages_[i];
+    }
+  }
+  if (first_page < pages_.size()) {
+    pages_.resize(first_page);
+  }
+}
+
+// The bytes are read in chunks which overlap by the size of the text less
+// one, so a text across two chunks is found. A match is placed by reading
+// its page up to it, and the matches before |from| on its page are skipped.
+bool PagedText::Find(const wxString& text, const wxPoint& from, wxPoint* found) const {
+  TRACE_SCOPE("PagedText::Find");
+  if (text.IsEmpty() || text.find_first_of(wxT("\r\n")) != wxString::npos ||
+      from.y < 0 || static_cast<size_t>(from.y) >= line_count_) {
+    return false;
+  }
+  wxString file_text = text;
+  file_text.Replace(wxString(wxT('\t'), tab_size_), wxT("\t"), true);
+  if (encoding_ == FILE_ENCODING_LATIN1 && !IsLatin1(file_text)) {
+    return false;
+  }
+  std::string pattern;
+  EncodeText(file_text, encoding_, &pattern);
+
+  std::vector<char> buffer;
+  std::vector<char> bytes;
+  for (unsigned long long offset = page_offsets_[FindLinePage(from.y)]; offset < file_size_; offset += kScanChunkSize) {
+    size_t size = static_cast<size_t>(std::min<unsigned long long>(kScanChunkSize + pattern.size() - 1,
+                                                                     file_size_ - offset));
+    if (size < pattern.size() || !ReadBytes(offset, size, &buffer)) {
+      return false;
+    }
+    const char* data = &buffer[0];
+    size_t end = std::min(size - pattern.size() + 1, kScanChunkSize);
+    for (size_t i = 0; i < end; ++i) {
+      const char* match = static_cast<const char*>(memchr(data + i, pattern[0], end - i));
+      if (match == NULL) {
+        break;
+      }
+      i = match - data;
+      if (memcmp(match, pattern.data(), pattern.size()) != 0) {
+        continue;
+      }
+
+      unsigned long long match_offset = offset + i;
+      size_t page = FindOffsetPage(match_offset);
+      unsigned long long page_offset = page_offsets_[page];
+      // Past the head of a long line, which is all that's shown of it. The
+      // head may lose the bytes of a char cut at its end.
+      if (match_offset + pattern.size() - page_offset > kMaxLineSize - 3) {
+        continue;
+      }
+      if (!ReadBytes(page_offset, static_cast<size_t>(match_offset - page_offset), &bytes)) {
+        return false;
+      }
+      const char* page_data = bytes.empty() ? NULL : &bytes[0];
+      LineIndex line_index;
+      line_index.Build(page_data, bytes.size());
+      size_t last_line = line_index.GetLineCount() - 1;
+      size_t line_offset = line_index.GetLineOffset(last_line);
+      wxPoint position(static_cast<int>(DecodeBytes(page_data + line_offset, bytes.size() - line_offset).Len()),
+                       static_cast<int>(page_first_lines_[page] + last_line));
+      if (!IsBefore(position, from)) {
+        *found = position;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void PagedText::GetMemoryUsage(MemoryUsage* usage) const {
+  usage->Add(MEMORY_PAGE_INDEX, GetVectorMemoryUsage(page_offsets_) + GetVectorMemoryUsage(page_first_lines_) +
+                                GetVectorMemoryUsage(pages_));
+  // A node of std::list has two links besides the page number.
+  usage->Add(MEMORY_PAGE_CACHE, cache_bytes_ + used_pages_.size() * 3 * sizeof(void*));
+}
+
+}  // namespace editor
@@ -0,0 +1,100 @@
+#ifndef EDITOR_PAGED_TEXT_H_
+#define EDITOR_PAGED_TEXT_H_
+#pragma once
+
+#include <list>
+#include <vector>
+#include "wx/ffile.h"
+#include "wx/gdicmn.h"
+#include "wx/string.h"
+#include "editor/encoding.h"
+#include "editor/text_line.h"
+
+namespace editor {
+
+class MemoryUsage;
+
+// The lines of a file too big to be read whole, for viewing only. The file
+// is scanned once for line breaks, and only where each page of lines starts
+// is kept. A page is read when one of its lines is used, and the least
+// recently used pages are dropped to keep their lines under a budget, so the
+// memory doesn't grow with the file.
+class PagedText {
+public:
+  PagedText();
+  ~PagedText();
+
+  // Scan the file. The tabs of the lines are expanded to |tab_size| tabs the
+  // way the lines of a text read whole are. UTF-16 files can't be paged,
+  // their line breaks aren't single bytes.
+  bool Open(const wxString& path, int tab_size, size_t cache_size);
+
+  // Scan the bytes appended to the file since it was scanned. The lines from
+  // |first_line| on may have changed. Return false if the file is shorter.
+  bool ReadAppended(size_t* first_line);
+
+  size_t GetLineCount() const { return line_count_; }
+
+  // The bytes of the longest line, which is about its chars.
+  size_t GetMaxLineSize() const { return max_line_size_; }
+
+  FileEncoding GetEncoding() const { return encoding_; }
+  bool HasBom() const { return bom_size_ != 0; }
+
+  // The line stays valid until lines of two other pages are used. Lines
+  // longer than kMaxLineSize bytes are cut.
+  TextLine& GetLine(size_t line) const;
+
+  // Find |text|, as the lines show it, from |from| on. The bytes are searched
+  // without reading them into pages. A text of several lines isn't found.
+  bool Find(const wxString& text, const wxPoint& from, wxPoint* found) const;
+
+  // Add the memory of the page index and the pages read.
+  void GetMemoryUsage(MemoryUsage* usage) const;
+
+  static const size_t kMaxLineSize = 1024 * 1024;
+
+private:
+  struct Page;
+
+  // The page where the line or the byte at the offset is.
+  size_t FindLinePage(size_t line) const;
+  size_t FindOffsetPage(unsigned long long offset) const;
+
+  unsigned long long GetPageEnd(size_t page) const;
+
+  bool ReadBytes(unsigned long long offset, size_t size, std::vector<char>* bytes) const;
+
+  // Scan from the start of the last page to the end of the file.
+  bool Scan();
+  void EndLine(unsigned long long line_start, unsigned long long line_end, unsigned long long next_line_start);
+
+  Page* ReadPage(size_t page) const;
+  wxString DecodeBytes(const char* data, size_t size) const;
+  void DropPages(size_t first_page) const;
+
+private:
+  mutable wxFFile file_;
+  unsigned long long file_size_;
+  size_t bom_size_;
+  FileEncoding encoding_;
+  int tab_size_;
+
+  // Page i has the lines from page_first_lines_[i] on, which start at the
+  // byte page_offsets_[i].
+  std::vector<unsigned long long> page_offsets_;
+  std::vector<size_t> page_first_lines_;
+
+  size_t line_count_;
+  size_t max_line_size_;
+
+  // The pages read, NULL if not, and their numbers by use, the latest first.
+  mutable std::vector<Page*> pages_;
+  mutable std::list<size_t> used_pages_;
+  mutable size_t cache_bytes_;
+  size_t cache_size_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_PAGED_TEXT_H_
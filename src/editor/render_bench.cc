@@ -0,0 +1,324 @@
+// editor_render_bench paints a TextScrollWindow into a wxMemoryDC while it
+// replays scripted scroll, typing and selection sequences, and writes the
+// frame times as JSON:
+//
+//   editor_render_bench [--scale=<factor>] [--lines=<count>]
+//                       [--filter=<name>] [--out=<path>]
+//
+// A frame is the handling of one step plus a full paint of the text and line
+// number panels. The windows are never shown, but wxWidgets still needs a
+// display, so run it under xvfb-run on a headless box.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "wx/app.h"
+#include "wx/bitmap.h"
+#include "wx/dcmemory.h"
+#include "wx/ffile.h"
+#include "wx/filefn.h"
+#include "wx/filename.h"
+#include "wx/frame.h"
+#include "editor/bench_stats.h"
+#include "editor/config.h"
+#include "editor/document.h"
+#include "editor/document_manager.h"
+#include "editor/line_number_panel.h"
+#include "editor/text_file.h"
+#include "editor/text_panel.h"
+#include "editor/text_scroll_window.h"
+
+namespace editor {
+
+const size_t kDefaultLineCount = 200000;
+const int kViewWidth = 1280;
+const int kViewHeight = 800;
+
+class RenderBench {
+public:
+  RenderBench(size_t line_count, double scale)
+      : frame_(NULL), window_(NULL), document_manager_(&config_), line_count_(line_count), scale_(scale) {
+  }
+
+  ~RenderBench();
+
+  bool Init();
+  void Run(const std::string& filter, BenchReport* report);
+
+private:
+  typedef void (RenderBench::*StepFunc)(size_t frame);
+
+  struct Case {
+    const char* name;
+    size_t line_length;  // A line of 0 chars is one long line.
+    bool is_word_wrap;
+    StepFunc step;
+    size_t frame_count;
+  };
+
+  bool WriteFile(const wxString& file_path, size_t line_length);
+  void OpenFile(const Case& c);
+  void CloseFile();
+
+  // Paint both panels the way their paint handlers do.
+  void PaintFrame();
+
+  void ScrollStep(size_t frame);
+  void HScrollStep(size_t frame);
+  void TypeStep(size_t frame);
+  void SelectStep(size_t frame);
+
+  wxFrame* frame_;
+  TextScrollWindow* window_;
+  Config config_;
+  DocumentManager document_manager_;
+  wxBitmap text_bitmap_;
+  wxBitmap line_number_bitmap_;
+  wxString file_path_;
+  size_t line_count_;
+  double scale_;
+};
+
+RenderBench::~RenderBench() {
+  CloseFile();
+  if (frame_ != NULL) {
+    frame_->Destroy();
+  }
+  if (!file_path_.IsEmpty()) {
+    wxRemoveFile(file_path_);
+  }
+}
+
+bool RenderBench::Init() {
+  frame_ = new wxFrame(NULL, wxID_ANY, wxT("editor_render_bench"));
+  file_path_ = wxFileName::CreateTempFileName(wxT("editor_render_bench"));
+  text_bitmap_.Create(kViewWidth, kViewHeight);
+  line_number_bitmap_.Create(kViewWidth / 8, kViewHeight);
+  return !file_path_.IsEmpty() && text_bitmap_.IsOk() && line_number_bitmap_.IsOk();
+}
+
+bool RenderBench::WriteFile(const wxString& file_path, size_t line_length) {
+  wxFFile file(file_path, wxT("wb"));
+  if (!file.IsOpened()) {
+    return false;
+  }
+
+  static const char* kWords[] = {
+    "int ", "return ", "text_file_ ", "= ", "line ", "{ ", "} ", "\t", "for ", "size_t ", "i", "; ",
+  };
+  const size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+  // The long line case is one line of line_count_ * 60 chars.
+  size_t line_count = line_length == 0 ? 1 : line_count_;
+  size_t length = line_length == 0 ? line_count_ * 60 : line_length;
+  std::string line;
+  for (size_t i = 0; i < line_count; ++i) {
+    line.clear();
+    for (size_t j = i; line.size() < length; ++j) {
+      line.append(kWords[j % kWordCount]);
+    }
+    line.resize(length);
+    line.append("\n");
+    if (!file.Write(line.data(), line.size())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void RenderBench::OpenFile(const Case& c) {
+  WriteFile(file_path_, c.line_length);
+
+  window_ = new TextScrollWindow(&config_);
+  window_->Create(frame_);
+  window_->SetSize(0, 0, kViewWidth + kViewWidth / 8, kViewHeight);
+  window_->Layout();
+  Document* document = document_manager_.Open(file_path_);
+  window_->SetDocument(document);
+  document_manager_.Activate(document);
+
+  // A hidden window may not get its size events, so send the one the text
+  // panel would get.
+  wxSizeEvent event(window_->text_panel_->GetSize());
+  window_->HandleTextSize(event);
+  window_->SetWordWrap(c.is_word_wrap);
+  window_->UpdateCaret();
+}
+
+void RenderBench::CloseFile() {
+  if (window_ != NULL) {
+    Document* document = window_->GetDocument();
+    window_->SetDocument(NULL);
+    document_manager_.Release(document);
+    window_->Destroy();
+    window_ = NULL;
+  }
+}
+
+void RenderBench::PaintFrame() {
+  wxMemoryDC dc(text_bitmap_);
+  dc.SetFont(window_->text_panel_->GetFont());
+  dc.SetBackground(wxBrush(window_->text_panel_->GetBackgroundColour()));
+  dc.Clear();
+  window_->PrepareDC(dc);
+  window_->HandleTextPaint(dc);
+  dc.SelectObject(wxNullBitmap);
+
+  wxMemoryDC line_number_dc(line_number_bitmap_);
+  line_number_dc.SetFont(window_->line_number_panel_->GetFont());
+  line_number_dc.SetBackground(wxBrush(window_->line_number_panel_->GetBackgroundColour()));
+  line_number_dc.Clear();
+  window_->PrepareDC(line_number_dc);
+  window_->HandleLineNumberPaint(line_number_dc);
+  line_number_dc.SelectObject(wxNullBitmap);
+}
+
+// Scroll down by the wheel with a page jump every 50 frames.
+void RenderBench::ScrollStep(size_t frame) {
+  int rows = window_->client_height_ / window_->char_height_;
+  int y = window_->GetViewStart().y + (frame % 50 == 49 ? rows : 3);
+  if (y >= window_->GetRowCount()) {
+    y = 0;
+  }
+  window_->Scroll(0, y);
+}
+
+// Scroll to the right through a long line.
+void RenderBench::HScrollStep(size_t frame) {
+  int columns = window_->client_width_ / window_->char_width_;
+  int x = static_cast<int>(frame % 1000) * columns;
+  window_->Scroll(x, 0);
+}
+
+// Type a word and a new line every 60 chars in the middle of the file.
+void RenderBench::TypeStep(size_t frame) {
+  if (frame == 0) {
+    window_->caret_pos_ = wxPoint(0, window_->text_file_->GetLineCount() / 2);
+    window_->UpdateCaret();
+  }
+
+  wxKeyEvent event(wxEVT_CHAR);
+  event.m_uniChar = static_cast<wxChar>(frame % 60 == 59 ? WXK_RETURN : wxT('a') + frame % 26);
+  event.m_keyCode = event.m_uniChar;
+  window_->HandleTextKeyChar(event);
+}
+
+// Extend a selection down the file, the way dragging the mouse does.
+void RenderBench::SelectStep(size_t frame) {
+  if (frame == 0) {
+    window_->caret_pos_ = wxPoint(10, 0);
+    window_->selection_start_ = window_->caret_pos_;
+  }
+  window_->MoveCaretByKey(WXK_DOWN);
+  window_->UpdateCaret();
+  window_->UpdateSelectionRegion();
+}
+
+void RenderBench::Run(const std::string& filter, BenchReport* report) {
+  const Case kCases[] = {
+    { "scroll", 80, false, &RenderBench::ScrollStep, 5000 },
+    { "scroll_wrap", 300, true, &RenderBench::ScrollStep, 5000 },
+    { "long_line_hscroll", 0, false, &RenderBench::HScrollStep, 2000 },
+    { "long_line_wrap", 0, true, &RenderBench::ScrollStep, 2000 },
+    { "type", 80, false, &RenderBench::TypeStep, 5000 },
+    { "select", 80, false, &RenderBench::SelectStep, 5000 },
+  };
+
+  for (const Case& c : kCases) {
+    if (!filter.empty() && std::string(c.name).find(filter) == std::string::npos) {
+      continue;
+    }
+
+    OpenFile(c);
+    BenchStats stats(std::string("render.") + c.name);
+    stats.set_unit_name("frames");
+    size_t frame_count = std::max(static_cast<size_t>(c.frame_count * scale_), static_cast<size_t>(1));
+    BenchTimer timer;
+    for (size_t frame = 0; frame < frame_count; ++frame) {
+      timer.Restart();
+      (this->*c.step)(frame);
+      PaintFrame();
+      stats.AddSample(timer.ElapsedMicros());
+      stats.AddUnits(1);
+    }
+    CloseFile();
+    report->AddCase(stats);
+  }
+}
+
+class RenderBenchApp : public wxApp {
+public:
+  virtual bool OnInit() override;
+  virtual int OnRun() override;
+
+private:
+  double scale_;
+  size_t line_count_;
+  std::string filter_;
+  std::string out_path_;
+};
+
+static bool StartsWith(const char* str, const char* prefix, const char** rest) {
+  size_t len = strlen(prefix);
+  if (strncmp(str, prefix, len) != 0) {
+    return false;
+  }
+  *rest = str + len;
+  return true;
+}
+
+bool RenderBenchApp::OnInit() {
+  scale_ = 1;
+  line_count_ = kDefaultLineCount;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i].ToStdString();
+    const char* value = NULL;
+    if (StartsWith(arg.c_str(), "--scale=", &value)) {
+      scale_ = atof(value);
+    } else if (StartsWith(arg.c_str(), "--lines=", &value)) {
+      line_count_ = std::max(atol(value), 1L);
+    } else if (StartsWith(arg.c_str(), "--filter=", &value)) {
+      filter_ = value;
+    } else if (StartsWith(arg.c_str(), "--out=", &value)) {
+      out_path_ = value;
+    } else {
+      std::cerr << "Usage: editor_render_bench [--scale=<factor>] [--lines=<count>] "
+                   "[--filter=<name>] [--out=<path>]" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// The cases run instead of the main loop.
+int RenderBenchApp::OnRun() {
+  BenchReport report("editor_render_bench");
+  {
+    RenderBench bench(line_count_, scale_);
+    if (!bench.Init()) {
+      std::cerr << "Can't create the bench window." << std::endl;
+      return 1;
+    }
+    bench.Run(filter_, &report);
+  }
+
+  if (out_path_.empty()) {
+    report.WriteJson(std::cout);
+  } else {
+    std::ofstream ofs(out_path_.c_str());
+    report.WriteJson(ofs);
+  }
+  return 0;
+}
+
+}  // namespace editor
+
+IMPLEMENT_APP_NO_MAIN(editor::RenderBenchApp);
+
+int main(int argc, char** argv) {
+  return wxEntry(argc, argv);
+}
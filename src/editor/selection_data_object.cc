@@ -0,0 +1,254 @@
+#include "editor/selection_data_object.h"
+#include <cstring>
+#include "editor/text_file.h"
+
+namespace editor {
+
+const wxChar* kBlockFormatId = wxT("application/x-editor-block");
+
+// Writes the text of the editor in the clipboard format of the platform.
+// The tab chars of an expanded tab are written as one tab again.
+class TextExporter {
+public:
+  TextExporter(char* buf, int tab_size)
+      : buf_(buf),
+        size_(0),
+        tab_size_(tab_size),
+        tab_count_(0) {
+  }
+
+  void Append(const wxChar* chars, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      if (chars[i] == wxT('\t')) {
+        ++tab_count_;
+      } else {
+        FlushTabs();
+        PutChar(chars[i]);
+      }
+    }
+  }
+
+  void AppendLineBreak() {
+    FlushTabs();
+#if defined(__WXMSW__)
+    PutChar(wxT('\r'));
+#endif
+    PutChar(wxT('\n'));
+  }
+
+  size_t Finish() {
+    FlushTabs();
+#if defined(__WXMSW__) || defined(__WXOSX__)
+    PutChar(0);
+#endif
+    return size_;
+  }
+
+private:
+  void FlushTabs() {
+    size_t tabs = (tab_count_ + tab_size_ - 1) / tab_size_;
+    for (size_t i = 0; i < tabs; ++i) {
+      PutChar(wxT('\t'));
+    }
+    tab_count_ = 0;
+  }
+
+#if defined(__WXMSW__) || defined(__WXOSX__)
+  // UTF-16 in the byte order of the machine.
+  void PutChar(wxUint32 ch) {
+    if (ch >= 0x10000) {
+      ch -= 0x10000;
+      PutUnit(0xD800 + (ch >> 10));
+      PutUnit(0xDC00 + (ch & 0x3FF));
+    } else {
+      PutUnit(ch);
+    }
+  }
+
+  void PutUnit(wxUint32 unit) {
+    if (buf_ != NULL) {
+      wxUint16 value = static_cast<wxUint16>(unit);
+      memcpy(buf_ + size_, &value, sizeof(value));
+    }
+    size_ += sizeof(wxUint16);
+  }
+#else
+  // UTF-8.
+  void PutChar(wxUint32 ch) {
+    if (ch < 0x80) {
+      PutByte(ch);
+    } else if (ch < 0x800) {
+      PutByte(0xC0 | (ch >> 6));
+      PutByte(0x80 | (ch & 0x3F));
+    } else if (ch < 0x10000) {
+      PutByte(0xE0 | (ch >> 12));
+      PutByte(0x80 | ((ch >> 6) & 0x3F));
+      PutByte(0x80 | (ch & 0x3F));
+    } else {
+      PutByte(0xF0 | (ch >> 18));
+      PutByte(0x80 | ((ch >> 12) & 0x3F));
+      PutByte(0x80 | ((ch >> 6) & 0x3F));
+      PutByte(0x80 | (ch & 0x3F));
+    }
+  }
+
+  void PutByte(wxUint32 byte) {
+    if (buf_ != NULL) {
+      buf_[size_] = static_cast<char>(byte);
+    }
+    ++size_;
+  }
+#endif
+
+private:
+  char* buf_;
+  size_t size_;
+  size_t tab_size_;
+  size_t tab_count_;
+};
+
+// SelectionSource
+
+SelectionSource::SelectionSource(TextFile* text_file, const SelectionRegion& region, int tab_size)
+    : text_file_(text_file),
+      region_(region),
+      is_block_(region.is_rectangular()),
+      tab_size_(tab_size) {
+  text_file_->AttachListener(this);
+}
+
+SelectionSource::SelectionSource(const wxString& text, bool is_block, int tab_size)
+    : text_file_(NULL),
+      text_(text),
+      is_block_(is_block),
+      tab_size_(tab_size) {
+}
+
+SelectionSource::~SelectionSource() {
+  if (text_file_ != NULL) {
+    text_file_->DetachListener(this);
+  }
+}
+
+void SelectionSource::Materialize() {
+  if (text_file_ == NULL) {
+    return;
+  }
+  text_ = text_file_->GetText(region_);
+  text_file_->DetachListener(this);
+  text_file_ = NULL;
+}
+
+void SelectionSource::OnTextChanging() {
+  Materialize();
+}
+
+size_t SelectionSource::Export(char* buf) const {
+  TextExporter exporter(buf, tab_size_);
+
+  if (text_file_ == NULL) {
+    const wxChar* chars = text_.wc_str();
+    size_t len = text_.Len();
+    size_t line_start = 0;
+    for (size_t i = 0; i < len; ++i) {
+      if (chars[i] == wxT('\r')) {
+        exporter.Append(chars + line_start, i - line_start);
+        exporter.AppendLineBreak();
+        line_start = i + 1;
+      }
+    }
+    exporter.Append(chars + line_start, len - line_start);
+    return exporter.Finish();
+  }
+
+  int start_line = region_.start_pos().y;
+  int end_line = region_.end_pos().y;
+  for (int i = start_line; i <= end_line; ++i) {
+    if (i != start_line) {
+      exporter.AppendLineBreak();
+    }
+    const wxString& line = text_file_->GetLine(i).GetData();
+    size_t from = 0;
+    size_t count = 0;
+    region_.GetLineRange(i, line.Len(), &from, &count);
+    exporter.Append(line.wc_str() + from, count);
+  }
+  return exporter.Finish();
+}
+
+// SelectionDataObject
+
+SelectionDataObject::SelectionDataObject(SelectionSource* source)
+    : source_(source) {
+}
+
+SelectionDataObject::~SelectionDataObject() {
+  delete source_;
+}
+
+wxDataFormat SelectionDataObject::GetPreferredFormat(Direction dir) const {
+  return wxDataFormat(wxDF_UNICODETEXT);
+}
+
+size_t SelectionDataObject::GetFormatCount(Direction dir) const {
+  if (dir != Get) {
+    return 0;
+  }
+  return source_->is_block() ? 2 : 1;
+}
+
+void SelectionDataObject::GetAllFormats(wxDataFormat* formats, Direction dir) const {
+  if (dir != Get) {
+    return;
+  }
+  formats[0] = wxDataFormat(wxDF_UNICODETEXT);
+  if (source_->is_block()) {
+    formats[1] = GetBlockDataFormat();
+  }
+}
+
+size_t SelectionDataObject::GetDataSize(const wxDataFormat& format) const {
+  if (format == GetBlockDataFormat()) {
+    return 1;
+  }
+  return source_->Export(NULL);
+}
+
+bool SelectionDataObject::GetDataHere(const wxDataFormat& format, void* buf) const {
+  if (format == GetBlockDataFormat()) {
+    *static_cast<char*>(buf) = 1;
+    return true;
+  }
+  source_->Export(static_cast<char*>(buf));
+  return true;
+}
+
+wxDataFormat GetBlockDataFormat() {
+  static wxDataFormat format(kBlockFormatId);
+  return format;
+}
+
+wxString ImportClipboardText(const wxString& text, int tab_size) {
+  wxString result;
+  result.reserve(text.Len());
+
+  for (wxString::const_iterator it = text.begin(); it != text.end(); ++it) {
+    wxChar ch = *it;
+    if (ch == wxT('\r')) {
+      wxString::const_iterator next = it + 1;
+      if (next != text.end() && *next == wxT('\n')) {
+        ++it;
+      }
+      result.append(1, wxT('\r'));
+    } else if (ch == wxT('\n')) {
+      result.append(1, wxT('\r'));
+    } else if (ch == wxT('\t')) {
+      result.append(tab_size, wxT('\t'));
+    } else if (ch != 0) {
+      result.append(1, ch);
+    }
+  }
+  return result;
+}
+
+}  // namespace editor
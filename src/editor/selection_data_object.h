@@ -0,0 +1,74 @@
+#ifndef EDITOR_SELECTION_DATA_OBJECT_H_
+#define EDITOR_SELECTION_DATA_OBJECT_H_
+#pragma once
+
+#include "wx/dataobj.h"
+#include "wx/string.h"
+#include "editor/selection_region.h"
+#include "editor/text_listener.h"
+
+namespace editor {
+
+class TextFile;
+
+// SelectionSource
+// The copied text of a selection. A large selection is not copied when it
+// is put on the clipboard: the source keeps a reference to the text file and
+// serializes the region on demand. Before the text file is changed the
+// region is materialized, so the clipboard keeps the text as it was copied.
+class SelectionSource : public TextListener {
+public:
+  SelectionSource(TextFile* text_file, const SelectionRegion& region, int tab_size);
+  SelectionSource(const wxString& text, bool is_block, int tab_size);
+  virtual ~SelectionSource();
+
+  bool is_block() const { return is_block_; }
+  bool is_materialized() const { return text_file_ == NULL; }
+
+  // Copies the text now and stops following the text file.
+  void Materialize();
+
+  // Writes the text in the clipboard text format of the platform and
+  // returns its size in bytes. Only counts the size if |buf| is NULL.
+  size_t Export(char* buf) const;
+
+  virtual void OnLineUpdate(const wxPoint& position, bool is_multi_lines) override {}
+  virtual void OnTextChanging() override;
+
+private:
+  TextFile* text_file_;
+  SelectionRegion region_;
+  wxString text_;
+  bool is_block_;
+  int tab_size_;
+};
+
+// SelectionDataObject
+// Puts a selection source on the clipboard as plain text. A block
+// selection also has the block format, so that it can be pasted as a
+// block again. Takes the ownership of the source.
+class SelectionDataObject : public wxDataObject {
+public:
+  explicit SelectionDataObject(SelectionSource* source);
+  virtual ~SelectionDataObject();
+
+  virtual wxDataFormat GetPreferredFormat(Direction dir = Get) const override;
+  virtual size_t GetFormatCount(Direction dir = Get) const override;
+  virtual void GetAllFormats(wxDataFormat* formats, Direction dir = Get) const override;
+  virtual size_t GetDataSize(const wxDataFormat& format) const override;
+  virtual bool GetDataHere(const wxDataFormat& format, void* buf) const override;
+
+private:
+  SelectionSource* source_;
+};
+
+// The format which marks the clipboard text as a block.
+wxDataFormat GetBlockDataFormat();
+
+// Converts text from the clipboard into the text of the editor: line breaks
+// become '\r' and every tab is expanded to |tab_size| tab chars.
+wxString ImportClipboardText(const wxString& text, int tab_size);
+
+}  // namespace editor
+
+#endif  // EDITOR_SELECTION_DATA_OBJECT_H_
@@ -1,18 +1,21 @@
 ﻿#include "editor/selection_region.h"
+#include <algorithm>
 
 namespace editor {
 
-SelectionRegion::SelectionRegion() {
+SelectionRegion::SelectionRegion() : is_rectangular_(false) {
 }
 
 SelectionRegion::SelectionRegion(const wxPoint& start_pos, const wxPoint& end_pos)
     : start_pos_(start_pos),
-      end_pos_(end_pos) {
+      end_pos_(end_pos),
+      is_rectangular_(false) {
 }
 
 SelectionRegion::SelectionRegion(const SelectionRegion& region)
     : start_pos_(region.start_pos_),
-      end_pos_(region.end_pos_) {
+      end_pos_(region.end_pos_),
+      is_rectangular_(region.is_rectangular_) {
 }
 
 SelectionRegion& SelectionRegion::operator=(const SelectionRegion& region) {
@@ -22,6 +25,7 @@ SelectionRegion& SelectionRegion::operator=(const SelectionRegion& region) {
 
   start_pos_ = region.start_pos_;
   end_pos_ = region.end_pos_;
+  is_rectangular_ = region.is_rectangular_;
   return *this;
 }
 
@@ -29,4 +33,24 @@ bool SelectionRegion::IsEmpty() const {
   return start_pos_ == end_pos_;
 }
 
+void SelectionRegion::GetLineRange(int line, size_t line_length, size_t* from, size_t* count) const {
+  size_t begin = 0;
+  size_t end = line_length;
+
+  if (is_rectangular_) {
+    begin = std::min(static_cast<size_t>(start_pos_.x), line_length);
+    end = std::min(static_cast<size_t>(end_pos_.x), line_length);
+  } else {
+    if (line == start_pos_.y) {
+      begin = std::min(static_cast<size_t>(start_pos_.x), line_length);
+    }
+    if (line == end_pos_.y) {
+      end = std::min(static_cast<size_t>(end_pos_.x), line_length);
+    }
+  }
+
+  *from = begin;
+  *count = end > begin ? end - begin : 0;
+}
+
 }  // namespace editor
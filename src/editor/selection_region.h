@@ -20,11 +20,21 @@ public:
   wxPoint end_pos() const { return end_pos_; }
   void set_end_pos(const wxPoint& end_pos) { end_pos_ = end_pos; }
 
+  // A rectangular (column) region covers the columns [start.x, end.x) of
+  // every line from start.y to end.y, no matter how long the lines are.
+  bool is_rectangular() const { return is_rectangular_; }
+  void set_rectangular(bool is_rectangular) { is_rectangular_ = is_rectangular; }
+
   bool IsEmpty() const;
 
+  // Get the chars of a line with the given length covered by the region,
+  // without the line break.
+  void GetLineRange(int line, size_t line_length, size_t* from, size_t* count) const;
+
 private:
   wxPoint start_pos_;
   wxPoint end_pos_;
+  bool is_rectangular_;
 };
 
 }  // namespace editor
@@ -0,0 +1,145 @@
+#include "editor/session.h"
+#include <cstdlib>
+#include <string>
+#include "wx/ffile.h"
+#include "wx/filefn.h"
+#include "wx/filename.h"
+#include "tinyxml/tinyxml.h"
+
+namespace editor {
+
+const char* kSessionKey = "session";
+const char* kFileKey = "file";
+const char* kActiveKey = "active";
+const char* kProjectDirKey = "project_dir";
+const char* kPathKey = "path";
+const char* kSizeKey = "size";
+const char* kMtimeKey = "mtime";
+const char* kLastUsedKey = "last_used";
+const char* kCaretLineKey = "caret_line";
+const char* kCaretColumnKey = "caret_column";
+const char* kTopLineKey = "top_line";
+const char* kWordWrapKey = "word_wrap";
+
+SessionFile::SessionFile()
+    : size_(0),
+      mtime_(0),
+      last_used_(0),
+      caret_pos_(0, 0),
+      top_line_(0),
+      is_word_wrap_(false) {
+}
+
+SessionFile::SessionFile(const wxString& path)
+    : path_(path),
+      size_(0),
+      mtime_(0),
+      last_used_(0),
+      caret_pos_(0, 0),
+      top_line_(0),
+      is_word_wrap_(false) {
+}
+
+void SessionFile::UpdateStamp() {
+  size_ = wxFileName(path_).GetSize().GetValue();
+  mtime_ = wxFileModificationTime(path_);
+}
+
+bool SessionFile::IsStampValid() const {
+  return wxFileName(path_).GetSize().GetValue() == size_ && wxFileModificationTime(path_) == mtime_;
+}
+
+Session::Session() : active_file_(-1) {
+}
+
+static int GetIntAttribute(const TiXmlElement* element, const char* key) {
+  int value = 0;
+  element->QueryIntAttribute(key, &value);
+  return value < 0 ? 0 : value;
+}
+
+static unsigned long long GetULongLongAttribute(const TiXmlElement* element, const char* key) {
+  const char* value = element->Attribute(key);
+  return value == NULL ? 0 : strtoull(value, NULL, 10);
+}
+
+bool Session::LoadFile(const wxString& file_path) {
+  wxFFile file(file_path, wxT("rb"));
+  if (!file.IsOpened()) {
+    return false;
+  }
+
+  TiXmlDocument doc;
+  if (!doc.LoadFile(file.fp())) {
+    return false;
+  }
+
+  TiXmlElement* root = doc.FirstChildElement(kSessionKey);
+  if (root == NULL) {
+    return false;
+  }
+  if (root->QueryIntAttribute(kActiveKey, &active_file_) != TIXML_SUCCESS) {
+    active_file_ = -1;
+  }
+  const char* project_dir = root->Attribute(kProjectDirKey);
+  if (project_dir != NULL) {
+    project_dir_ = wxString::FromUTF8(project_dir);
+  }
+
+  for (TiXmlElement* element = root->FirstChildElement(kFileKey);
+       element != NULL;
+       element = element->NextSiblingElement(kFileKey)) {
+    const char* path = element->Attribute(kPathKey);
+    if (path == NULL) {
+      continue;
+    }
+
+    SessionFile session_file(wxString::FromUTF8(path));
+    session_file.size_ = GetULongLongAttribute(element, kSizeKey);
+    session_file.mtime_ = static_cast<time_t>(GetULongLongAttribute(element, kMtimeKey));
+    session_file.last_used_ = static_cast<unsigned long>(GetULongLongAttribute(element, kLastUsedKey));
+    session_file.caret_pos_.y = GetIntAttribute(element, kCaretLineKey);
+    session_file.caret_pos_.x = GetIntAttribute(element, kCaretColumnKey);
+    session_file.top_line_ = GetIntAttribute(element, kTopLineKey);
+    session_file.is_word_wrap_ = GetIntAttribute(element, kWordWrapKey) != 0;
+    files_.push_back(session_file);
+  }
+
+  if (active_file_ >= static_cast<int>(files_.size())) {
+    active_file_ = -1;
+  }
+  return true;
+}
+
+bool Session::SaveFile(const wxString& file_path) const {
+  TiXmlDocument doc;
+  doc.LinkEndChild(new TiXmlDeclaration("1.0", "UTF-8", ""));
+
+  TiXmlElement* root = new TiXmlElement(kSessionKey);
+  root->SetAttribute(kActiveKey, active_file_);
+  if (!project_dir_.IsEmpty()) {
+    root->SetAttribute(kProjectDirKey, project_dir_.ToUTF8().data());
+  }
+  doc.LinkEndChild(root);
+
+  for (const SessionFile& session_file : files_) {
+    TiXmlElement* element = new TiXmlElement(kFileKey);
+    element->SetAttribute(kPathKey, session_file.path_.ToUTF8().data());
+    element->SetAttribute(kSizeKey, std::to_string(session_file.size_));
+    element->SetAttribute(kMtimeKey, std::to_string(static_cast<long long>(session_file.mtime_)));
+    element->SetAttribute(kLastUsedKey, std::to_string(session_file.last_used_));
+    element->SetAttribute(kCaretLineKey, session_file.caret_pos_.y);
+    element->SetAttribute(kCaretColumnKey, session_file.caret_pos_.x);
+    element->SetAttribute(kTopLineKey, session_file.top_line_);
+    element->SetAttribute(kWordWrapKey, session_file.is_word_wrap_ ? 1 : 0);
+    root->LinkEndChild(element);
+  }
+
+  wxFFile file(file_path, wxT("wb"));
+  if (!file.IsOpened()) {
+    return false;
+  }
+  return doc.SaveFile(file.fp());
+}
+
+}  // namespace editor
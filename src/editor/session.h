@@ -0,0 +1,56 @@
+#ifndef EDITOR_SESSION_H_
+#define EDITOR_SESSION_H_
+#pragma once
+
+#include <ctime>
+#include <vector>
+#include "wx/gdicmn.h"
+#include "wx/string.h"
+
+namespace editor {
+
+// A file open when the session was saved, with the viewport of its tab.
+class SessionFile {
+public:
+  SessionFile();
+  explicit SessionFile(const wxString& path);
+
+  // Get the size and the modification time of the file.
+  void UpdateStamp();
+
+  // True if the file isn't changed since UpdateStamp(), so the viewport
+  // still shows the same text.
+  bool IsStampValid() const;
+
+public:
+  wxString path_;
+  unsigned long long size_;
+  time_t mtime_;
+
+  unsigned long last_used_;
+  wxPoint caret_pos_;
+  int top_line_;
+  bool is_word_wrap_;
+};
+
+// The open files, which are saved on exit and reopened on startup.
+class Session {
+public:
+  Session();
+
+  bool LoadFile(const wxString& file_path);
+  bool SaveFile(const wxString& file_path) const;
+
+public:
+  std::vector<SessionFile> files_;
+
+  // The index of the file shown, or -1.
+  int active_file_;
+
+  // The folder whose symbols are indexed, empty if none is.
+  wxString project_dir_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_SESSION_H_
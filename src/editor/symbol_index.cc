@@ -0,0 +1,692 @@
+#include "editor/symbol_index.h"
+#include <algorithm>
+#include <cstring>
+#include "wx/dir.h"
+#include "wx/event.h"
+#include "wx/ffile.h"
+#include "wx/filefn.h"
+#include "wx/filename.h"
+#include "wx/thread.h"
+#include "editor/encoding.h"
+#include "editor/line_index.h"
+#include "editor/mapped_file.h"
+#include "editor/memory_usage.h"
+#include "editor/trace.h"
+
+namespace editor {
+
+const char kCacheMagic[4] = { 'S', 'I', 'D', 'X' };
+const unsigned int kCacheVersion = 1;
+
+// Bigger files are most likely generated, and are skipped.
+const size_t kMaxSourceFileSize = 16 * 1024 * 1024;
+
+static const wxChar* const kSourceExtensions[] = {
+  wxT("c"), wxT("cc"), wxT("cpp"), wxT("cxx"), wxT("h"), wxT("hh"), wxT("hpp"), wxT("hxx"), wxT("inl"),
+};
+
+const size_t kNoFile = static_cast<size_t>(-1);
+
+static wxString g_cache_dir;
+
+// 64-bit FNV-1a.
+const unsigned long long kFnvOffsetBasis = 14695981039346656037ULL;
+const unsigned long long kFnvPrime = 1099511628211ULL;
+
+static unsigned long long HashBytes(const char* data, size_t size) {
+  unsigned long long hash = kFnvOffsetBasis;
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * kFnvPrime;
+  }
+  return hash;
+}
+
+static wxString GetCachePath(const wxString& dir) {
+  wxScopedCharBuffer utf8 = dir.ToUTF8();
+  unsigned long long hash = HashBytes(utf8.data(), utf8.length());
+  return g_cache_dir + wxT("/") + wxString::Format(wxT("%016") wxLongLongFmtSpec wxT("x.sidx"), hash);
+}
+
+// The cache header is followed by the names of all the symbols, then by
+// varints: per file, the length of its UTF-8 path, the path, its
+// modification time and its symbol count, then per symbol, its kind, the
+// length of its name, its line and its column.
+struct CacheHeader {
+  char magic[4];
+  unsigned int version;
+  unsigned int tab_size;
+  unsigned long long file_count;
+  unsigned long long symbol_count;
+  unsigned long long names_size;
+};
+
+static void AppendVarint(unsigned long long value, std::vector<unsigned char>* buffer) {
+  while (value >= 0x80) {
+    buffer->push_back(static_cast<unsigned char>(value | 0x80));
+    value >>= 7;
+  }
+  buffer->push_back(static_cast<unsigned char>(value));
+}
+
+static bool ReadVarint(const std::vector<unsigned char>& buffer, size_t* offset, unsigned long long* value) {
+  *value = 0;
+  for (int shift = 0; *offset < buffer.size() && shift < 64; shift += 7) {
+    unsigned char byte = buffer[(*offset)++];
+    *value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool IsSourceFile(const wxString& path) {
+  size_t dot = path.find_last_of(wxT("./\\"));
+  if (dot == wxString::npos || path[dot] != wxT('.')) {
+    return false;
+  }
+  wxString extension = path.Mid(dot + 1).Lower();
+  for (const wxChar* source_extension : kSourceExtensions) {
+    if (extension == source_extension) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// ASCII letters are compared without case, as names are.
+static int CompareNames(const char* lhs, size_t lhs_length, const char* rhs, size_t rhs_length) {
+  size_t length = std::min(lhs_length, rhs_length);
+  for (size_t i = 0; i < length; ++i) {
+    unsigned char lhs_ch = static_cast<unsigned char>(lhs[i]);
+    unsigned char rhs_ch = static_cast<unsigned char>(rhs[i]);
+    if (lhs_ch >= 'A' && lhs_ch <= 'Z') {
+      lhs_ch += 'a' - 'A';
+    }
+    if (rhs_ch >= 'A' && rhs_ch <= 'Z') {
+      rhs_ch += 'a' - 'A';
+    }
+    if (lhs_ch != rhs_ch) {
+      return lhs_ch < rhs_ch ? -1 : 1;
+    }
+  }
+  if (lhs_length == rhs_length) {
+    return 0;
+  }
+  return lhs_length < rhs_length ? -1 : 1;
+}
+
+class SymbolIndexBuilder : public wxThread {
+public:
+  SymbolIndexBuilder(const wxString& dir, int tab_size, wxEvtHandler* handler, int event_id);
+
+  void Stop();
+  bool IsStopping() const;
+
+  // The index built, once IsBuilt().
+  SymbolIndex* index() { return &index_; }
+  bool IsBuilt() const;
+
+  // Run by the threads of the pool until there is no file left to parse.
+  void ParseFiles();
+
+protected:
+  virtual ExitCode Entry() override;
+
+private:
+  void ListFiles(std::vector<wxString>* paths) const;
+  void ParseFile(const wxString& path, std::vector<syntax::Definition>* definitions) const;
+  void RunPool();
+  void SortSymbols();
+
+  static size_t FindFile(const SymbolIndex& index, const wxString& path);
+  static void AddSymbols(const SymbolIndex& from, size_t from_file, size_t file, SymbolIndex* to);
+  static void AddDefinitions(const std::vector<syntax::Definition>& definitions, size_t file, SymbolIndex* to);
+
+  bool ReadCache(SymbolIndex* index) const;
+  bool WriteCache() const;
+
+private:
+  wxString dir_;
+  int tab_size_;
+  wxEvtHandler* handler_;
+  int event_id_;
+
+  SymbolIndex index_;
+
+  // Guards the members below, which the threads of the pool use.
+  mutable wxMutex mutex_;
+  bool is_built_;
+  bool is_stopping_;
+  std::vector<wxString> job_paths_;
+  size_t next_job_;
+  std::vector<std::vector<syntax::Definition> > job_definitions_;
+};
+
+// A thread of the pool which parses the files.
+class SymbolParser : public wxThread {
+public:
+  explicit SymbolParser(SymbolIndexBuilder* builder)
+      : wxThread(wxTHREAD_JOINABLE),
+        builder_(builder) {
+  }
+
+protected:
+  virtual ExitCode Entry() override {
+    builder_->ParseFiles();
+    return static_cast<ExitCode>(0);
+  }
+
+private:
+  SymbolIndexBuilder* builder_;
+};
+
+// The hidden dirs, e.g. of git, aren't walked.
+class SourceFileTraverser : public wxDirTraverser {
+public:
+  SourceFileTraverser(const SymbolIndexBuilder* builder, std::vector<wxString>* paths)
+      : builder_(builder),
+        paths_(paths) {
+  }
+
+  virtual wxDirTraverseResult OnFile(const wxString& path) override {
+    if (IsSourceFile(path)) {
+      paths_->push_back(path);
+    }
+    return builder_->IsStopping() ? wxDIR_STOP : wxDIR_CONTINUE;
+  }
+
+  virtual wxDirTraverseResult OnDir(const wxString& WXUNUSED(path)) override {
+    return builder_->IsStopping() ? wxDIR_STOP : wxDIR_CONTINUE;
+  }
+
+private:
+  const SymbolIndexBuilder* builder_;
+  std::vector<wxString>* paths_;
+};
+
+// The symbols are sorted by name without case, then by their files.
+class SymbolNameLess {
+public:
+  explicit SymbolNameLess(const SymbolIndex* index) : index_(index) {
+  }
+
+  bool operator()(unsigned int lhs, unsigned int rhs) const;
+
+private:
+  const SymbolIndex* index_;
+};
+
+SymbolIndexBuilder::SymbolIndexBuilder(const wxString& dir, int tab_size, wxEvtHandler* handler, int event_id)
+    : wxThread(wxTHREAD_JOINABLE),
+      dir_(dir),
+      tab_size_(tab_size),
+      handler_(handler),
+      event_id_(event_id),
+      is_built_(false),
+      is_stopping_(false),
+      next_job_(0) {
+  index_.dir_ = dir;
+}
+
+void SymbolIndexBuilder::Stop() {
+  wxMutexLocker locker(mutex_);
+  is_stopping_ = true;
+}
+
+bool SymbolIndexBuilder::IsBuilt() const {
+  wxMutexLocker locker(mutex_);
+  return is_built_;
+}
+
+bool SymbolIndexBuilder::IsStopping() const {
+  wxMutexLocker locker(mutex_);
+  return is_stopping_;
+}
+
+// The symbols of a file not changed since the cache was written are taken
+// from the cache. The others are parsed by the pool.
+wxThread::ExitCode SymbolIndexBuilder::Entry() {
+  TRACE_SCOPE("SymbolIndexBuilder::Entry");
+  SymbolIndex cached_index;
+  ReadCache(&cached_index);
+
+  std::vector<wxString> paths;
+  ListFiles(&paths);
+  if (IsStopping()) {
+    return static_cast<ExitCode>(0);
+  }
+
+  std::vector<size_t> cached_files(paths.size(), kNoFile);
+  index_.files_.resize(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    SymbolIndex::File& file = index_.files_[i];
+    file.path = paths[i];
+    file.mtime = static_cast<long long>(wxFileModificationTime(paths[i]));
+    file.first_symbol = 0;
+    file.symbol_count = 0;
+    size_t cached_file = FindFile(cached_index, paths[i]);
+    if (cached_file != kNoFile && cached_index.files_[cached_file].mtime == file.mtime) {
+      cached_files[i] = cached_file;
+    } else {
+      job_paths_.push_back(paths[i]);
+    }
+  }
+
+  job_definitions_.resize(job_paths_.size());
+  RunPool();
+  if (IsStopping()) {
+    return static_cast<ExitCode>(0);
+  }
+
+  size_t job = 0;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    if (cached_files[i] != kNoFile) {
+      AddSymbols(cached_index, cached_files[i], i, &index_);
+    } else {
+      AddDefinitions(job_definitions_[job++], i, &index_);
+    }
+  }
+  std::vector<std::vector<syntax::Definition> >().swap(job_definitions_);
+  SortSymbols();
+
+  if (!job_paths_.empty() || paths.size() != cached_index.files_.size()) {
+    WriteCache();
+  }
+  {
+    wxMutexLocker locker(mutex_);
+    is_built_ = true;
+  }
+  wxQueueEvent(handler_, new wxThreadEvent(wxEVT_THREAD, event_id_));
+  return static_cast<ExitCode>(0);
+}
+
+void SymbolIndexBuilder::ListFiles(std::vector<wxString>* paths) const {
+  TRACE_SCOPE("SymbolIndexBuilder::ListFiles");
+  wxDir dir(dir_);
+  if (!dir.IsOpened()) {
+    return;
+  }
+  SourceFileTraverser traverser(this, paths);
+  dir.Traverse(traverser, wxEmptyString, wxDIR_FILES | wxDIR_DIRS);
+  std::sort(paths->begin(), paths->end());
+}
+
+// This thread parses files too, besides the others of the pool.
+void SymbolIndexBuilder::RunPool() {
+  TRACE_SCOPE("SymbolIndexBuilder::RunPool");
+  std::vector<SymbolParser*> parsers;
+  int thread_count = std::min(wxThread::GetCPUCount(), static_cast<int>(job_paths_.size()));
+  for (int i = 1; i < thread_count; ++i) {
+    SymbolParser* parser = new SymbolParser(this);
+    if (parser->Run() != wxTHREAD_NO_ERROR) {
+      delete parser;
+      break;
+    }
+    parsers.push_back(parser);
+  }
+
+  ParseFiles();
+  for (SymbolParser* parser : parsers) {
+    parser->Wait();
+    delete parser;
+  }
+}
+
+void SymbolIndexBuilder::ParseFiles() {
+  std::vector<syntax::Definition> definitions;
+  while (true) {
+    size_t job = 0;
+    {
+      wxMutexLocker locker(mutex_);
+      if (is_stopping_ || next_job_ == job_paths_.size()) {
+        break;
+      }
+      job = next_job_++;
+    }
+
+    definitions.clear();
+    ParseFile(job_paths_[job], &definitions);
+
+    wxMutexLocker locker(mutex_);
+    job_definitions_[job].swap(definitions);
+  }
+}
+
+// The file is read as TextFile::Read() does, and the tabs are expanded as
+// the documents do, so the columns are the ones shown.
+void SymbolIndexBuilder::ParseFile(const wxString& path, std::vector<syntax::Definition>* definitions) const {
+  TRACE_SCOPE("SymbolIndexBuilder::ParseFile");
+  MappedFile mapped_file;
+  if (!mapped_file.Open(path) || mapped_file.data() == NULL || mapped_file.size() > kMaxSourceFileSize) {
+    return;
+  }
+  size_t bom_size = 0;
+  FileEncoding encoding = DetectEncoding(mapped_file.data(), mapped_file.size(), &bom_size);
+  const char* data = mapped_file.data() + bom_size;
+  size_t size = mapped_file.size() - bom_size;
+
+  std::string utf8;
+  if (encoding == FILE_ENCODING_UTF16LE || encoding == FILE_ENCODING_UTF16BE) {
+    Utf16ToUtf8(data, size, encoding == FILE_ENCODING_UTF16BE, &utf8);
+    data = utf8.data();
+    size = utf8.size();
+    encoding = FILE_ENCODING_UTF8;
+  }
+
+  LineIndex line_index;
+  line_index.Build(data, size);
+  wxString tab(wxT(' '), tab_size_);
+  syntax::CppDefinitionFinder finder;
+  for (size_t i = 0; i < line_index.GetLineCount(); ++i) {
+    wxString line = DecodeLine(data + line_index.GetLineOffset(i), line_index.GetLineLength(i), encoding);
+    line.Replace(wxT("\t"), tab, true);
+    finder.ParseLine(line, definitions);
+  }
+}
+
+void SymbolIndexBuilder::SortSymbols() {
+  TRACE_SCOPE("SymbolIndexBuilder::SortSymbols");
+  std::vector<unsigned int>& sorted_symbols = index_.sorted_symbols_;
+  sorted_symbols.resize(index_.symbols_.size());
+  for (size_t i = 0; i < sorted_symbols.size(); ++i) {
+    sorted_symbols[i] = static_cast<unsigned int>(i);
+  }
+  std::sort(sorted_symbols.begin(), sorted_symbols.end(), SymbolNameLess(&index_));
+}
+
+size_t SymbolIndexBuilder::FindFile(const SymbolIndex& index, const wxString& path) {
+  size_t low = 0;
+  size_t high = index.files_.size();
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (index.files_[mid].path < path) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low != index.files_.size() && index.files_[low].path == path ? low : kNoFile;
+}
+
+void SymbolIndexBuilder::AddSymbols(const SymbolIndex& from, size_t from_file, size_t file, SymbolIndex* to) {
+  const SymbolIndex::File& from_index_file = from.files_[from_file];
+  SymbolIndex::File& to_file = to->files_[file];
+  to_file.first_symbol = static_cast<unsigned int>(to->symbols_.size());
+  to_file.symbol_count = from_index_file.symbol_count;
+  for (size_t i = 0; i < from_index_file.symbol_count; ++i) {
+    SymbolIndex::Symbol symbol = from.symbols_[from_index_file.first_symbol + i];
+    const char* name = from.names_.data() + symbol.name_offset;
+    symbol.name_offset = static_cast<unsigned int>(to->names_.size());
+    symbol.file = static_cast<unsigned int>(file);
+    to->names_.append(name, symbol.name_length);
+    to->symbols_.push_back(symbol);
+  }
+}
+
+void SymbolIndexBuilder::AddDefinitions(const std::vector<syntax::Definition>& definitions, size_t file, SymbolIndex* to) {
+  SymbolIndex::File& to_file = to->files_[file];
+  to_file.first_symbol = static_cast<unsigned int>(to->symbols_.size());
+  to_file.symbol_count = static_cast<unsigned int>(definitions.size());
+  for (const syntax::Definition& definition : definitions) {
+    wxScopedCharBuffer name = definition.name.ToUTF8();
+    SymbolIndex::Symbol symbol;
+    symbol.name_offset = static_cast<unsigned int>(to->names_.size());
+    symbol.name_length = static_cast<unsigned int>(name.length());
+    symbol.file = static_cast<unsigned int>(file);
+    symbol.line = definition.line;
+    symbol.column = definition.column;
+    symbol.kind = static_cast<unsigned char>(definition.kind);
+    to->names_.append(name.data(), name.length());
+    to->symbols_.push_back(symbol);
+  }
+}
+
+// A cache which doesn't add up is ignored, and so is one of another tab
+// size, since the columns are of the tabs expanded.
+bool SymbolIndexBuilder::ReadCache(SymbolIndex* index) const {
+  TRACE_SCOPE("SymbolIndexBuilder::ReadCache");
+  if (g_cache_dir.IsEmpty()) {
+    return false;
+  }
+  wxFFile file(GetCachePath(dir_), wxT("rb"));
+  if (!file.IsOpened()) {
+    return false;
+  }
+  CacheHeader header;
+  if (file.Read(&header, sizeof(header)) != sizeof(header) ||
+      memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+      header.version != kCacheVersion ||
+      header.tab_size != static_cast<unsigned int>(tab_size_) ||
+      header.names_size > static_cast<unsigned long long>(file.Length()) - sizeof(header)) {
+    return false;
+  }
+
+  index->names_.resize(static_cast<size_t>(header.names_size));
+  std::vector<unsigned char> buffer(static_cast<size_t>(file.Length()) - sizeof(header) - index->names_.size());
+  if ((!index->names_.empty() && file.Read(&index->names_[0], index->names_.size()) != index->names_.size()) ||
+      (!buffer.empty() && file.Read(&buffer[0], buffer.size()) != buffer.size())) {
+    return false;
+  }
+
+  size_t offset = 0;
+  size_t name_offset = 0;
+  for (unsigned long long i = 0; i < header.file_count; ++i) {
+    unsigned long long path_length = 0;
+    if (!ReadVarint(buffer, &offset, &path_length) || path_length > buffer.size() - offset) {
+      return false;
+    }
+    SymbolIndex::File file_entry;
+    file_entry.path = wxString::FromUTF8(reinterpret_cast<const char*>(&buffer[offset]), static_cast<size_t>(path_length));
+    offset += static_cast<size_t>(path_length);
+
+    unsigned long long mtime = 0;
+    unsigned long long symbol_count = 0;
+    if (!ReadVarint(buffer, &offset, &mtime) || !ReadVarint(buffer, &offset, &symbol_count)) {
+      return false;
+    }
+    file_entry.mtime = static_cast<long long>(mtime);
+    file_entry.first_symbol = static_cast<unsigned int>(index->symbols_.size());
+    file_entry.symbol_count = static_cast<unsigned int>(symbol_count);
+
+    for (unsigned long long j = 0; j < symbol_count; ++j) {
+      unsigned long long values[4];
+      for (unsigned long long& value : values) {
+        if (!ReadVarint(buffer, &offset, &value)) {
+          return false;
+        }
+      }
+      SymbolIndex::Symbol symbol;
+      symbol.kind = static_cast<unsigned char>(values[0]);
+      symbol.name_offset = static_cast<unsigned int>(name_offset);
+      symbol.name_length = static_cast<unsigned int>(values[1]);
+      symbol.file = static_cast<unsigned int>(index->files_.size());
+      symbol.line = static_cast<int>(values[2]);
+      symbol.column = static_cast<int>(values[3]);
+      name_offset += symbol.name_length;
+      if (symbol.kind > syntax::DEFINITION_MACRO || name_offset > index->names_.size()) {
+        return false;
+      }
+      index->symbols_.push_back(symbol);
+    }
+    index->files_.push_back(file_entry);
+  }
+  return index->symbols_.size() == header.symbol_count && name_offset == index->names_.size();
+}
+
+// The cache is written to a temporary file and renamed, so a reader never
+// sees a partial one.
+bool SymbolIndexBuilder::WriteCache() const {
+  TRACE_SCOPE("SymbolIndexBuilder::WriteCache");
+  if (g_cache_dir.IsEmpty()) {
+    return false;
+  }
+  if (!wxDirExists(g_cache_dir) && !wxMkdir(g_cache_dir)) {
+    return false;
+  }
+
+  CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.version = kCacheVersion;
+  header.tab_size = static_cast<unsigned int>(tab_size_);
+  header.file_count = index_.files_.size();
+  header.symbol_count = index_.symbols_.size();
+  header.names_size = index_.names_.size();
+
+  std::vector<unsigned char> buffer;
+  for (const SymbolIndex::File& file : index_.files_) {
+    wxScopedCharBuffer path = file.path.ToUTF8();
+    AppendVarint(path.length(), &buffer);
+    buffer.insert(buffer.end(), path.data(), path.data() + path.length());
+    AppendVarint(static_cast<unsigned long long>(file.mtime), &buffer);
+    AppendVarint(file.symbol_count, &buffer);
+    for (size_t i = 0; i < file.symbol_count; ++i) {
+      const SymbolIndex::Symbol& symbol = index_.symbols_[file.first_symbol + i];
+      AppendVarint(symbol.kind, &buffer);
+      AppendVarint(symbol.name_length, &buffer);
+      AppendVarint(static_cast<unsigned long long>(symbol.line), &buffer);
+      AppendVarint(static_cast<unsigned long long>(symbol.column), &buffer);
+    }
+  }
+
+  wxString cache_path = GetCachePath(dir_);
+  wxString temp_path = wxFileName::CreateTempFileName(cache_path);
+  if (temp_path.IsEmpty()) {
+    return false;
+  }
+  {
+    wxFFile file(temp_path, wxT("wb"));
+    if (!file.IsOpened() ||
+        file.Write(&header, sizeof(header)) != sizeof(header) ||
+        file.Write(index_.names_.data(), index_.names_.size()) != index_.names_.size() ||
+        file.Write(buffer.data(), buffer.size()) != buffer.size() ||
+        !file.Close()) {
+      wxRemoveFile(temp_path);
+      return false;
+    }
+  }
+  return wxRenameFile(temp_path, cache_path, true);
+}
+
+bool SymbolNameLess::operator()(unsigned int lhs, unsigned int rhs) const {
+  const SymbolIndex::Symbol& lhs_symbol = index_->symbols_[lhs];
+  const SymbolIndex::Symbol& rhs_symbol = index_->symbols_[rhs];
+  int result = CompareNames(index_->names_.data() + lhs_symbol.name_offset, lhs_symbol.name_length,
+                            index_->names_.data() + rhs_symbol.name_offset, rhs_symbol.name_length);
+  return result < 0 || (result == 0 && lhs < rhs);
+}
+
+SymbolIndex::SymbolIndex() : builder_(NULL) {
+}
+
+SymbolIndex::~SymbolIndex() {
+  Stop();
+}
+
+void SymbolIndex::SetCacheDir(const wxString& cache_dir) {
+  g_cache_dir = cache_dir;
+}
+
+void SymbolIndex::Start(const wxString& dir, int tab_size, wxEvtHandler* handler, int event_id) {
+  Stop();
+  dir_ = dir;
+  builder_ = new SymbolIndexBuilder(dir, tab_size, handler, event_id);
+  if (builder_->Run() != wxTHREAD_NO_ERROR) {
+    delete builder_;
+    builder_ = NULL;
+  }
+}
+
+void SymbolIndex::Stop() {
+  if (builder_ != NULL) {
+    builder_->Stop();
+    builder_->Wait();
+    delete builder_;
+    builder_ = NULL;
+  }
+}
+
+bool SymbolIndex::TakeIndex() {
+  if (builder_ == NULL || !builder_->IsBuilt()) {
+    return false;
+  }
+  builder_->Wait();
+  SymbolIndex* index = builder_->index();
+  files_.swap(index->files_);
+  symbols_.swap(index->symbols_);
+  names_.swap(index->names_);
+  sorted_symbols_.swap(index->sorted_symbols_);
+  delete builder_;
+  builder_ = NULL;
+  return true;
+}
+
+size_t SymbolIndex::FindSorted(const char* name, size_t length) const {
+  size_t low = 0;
+  size_t high = sorted_symbols_.size();
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    const Symbol& symbol = symbols_[sorted_symbols_[mid]];
+    if (CompareNames(names_.data() + symbol.name_offset, symbol.name_length, name, length) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+void SymbolIndex::FindDefinitions(const wxString& name, std::vector<SymbolLocation>* locations) const {
+  TRACE_SCOPE("SymbolIndex::FindDefinitions");
+  locations->clear();
+  wxScopedCharBuffer utf8 = name.ToUTF8();
+  for (size_t i = FindSorted(utf8.data(), utf8.length()); i < sorted_symbols_.size(); ++i) {
+    const Symbol& symbol = symbols_[sorted_symbols_[i]];
+    const char* symbol_name = names_.data() + symbol.name_offset;
+    if (CompareNames(symbol_name, symbol.name_length, utf8.data(), utf8.length()) != 0) {
+      break;
+    }
+    if (memcmp(symbol_name, utf8.data(), utf8.length()) == 0) {
+      AddLocation(sorted_symbols_[i], locations);
+    }
+  }
+}
+
+void SymbolIndex::FindSymbols(const wxString& prefix, size_t max_count, std::vector<SymbolLocation>* locations) const {
+  TRACE_SCOPE("SymbolIndex::FindSymbols");
+  locations->clear();
+  wxScopedCharBuffer utf8 = prefix.ToUTF8();
+  for (size_t i = FindSorted(utf8.data(), utf8.length());
+       i < sorted_symbols_.size() && locations->size() < max_count;
+       ++i) {
+    const Symbol& symbol = symbols_[sorted_symbols_[i]];
+    size_t length = std::min(static_cast<size_t>(symbol.name_length), utf8.length());
+    if (CompareNames(names_.data() + symbol.name_offset, length, utf8.data(), utf8.length()) != 0) {
+      break;
+    }
+    AddLocation(sorted_symbols_[i], locations);
+  }
+}
+
+void SymbolIndex::AddLocation(unsigned int symbol_index, std::vector<SymbolLocation>* locations) const {
+  const Symbol& symbol = symbols_[symbol_index];
+  SymbolLocation location;
+  location.name = wxString::FromUTF8(names_.data() + symbol.name_offset, symbol.name_length);
+  location.kind = static_cast<syntax::DefinitionKind>(symbol.kind);
+  location.path = files_[symbol.file].path;
+  location.line = symbol.line;
+  location.column = symbol.column;
+  locations->push_back(location);
+}
+
+size_t SymbolIndex::GetMemoryUsage() const {
+  size_t bytes = GetVectorMemoryUsage(files_) + GetVectorMemoryUsage(symbols_) +
+      names_.capacity() + GetVectorMemoryUsage(sorted_symbols_);
+  for (const File& file : files_) {
+    bytes += GetStringMemoryUsage(file.path);
+  }
+  return bytes;
+}
+
+}  // namespace editor
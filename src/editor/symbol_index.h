@@ -0,0 +1,109 @@
+#ifndef EDITOR_SYMBOL_INDEX_H_
+#define EDITOR_SYMBOL_INDEX_H_
+#pragma once
+
+#include <string>
+#include <vector>
+#include "wx/string.h"
+#include "syntax/cpp_definition_finder.h"
+
+class wxEvtHandler;
+
+namespace editor {
+
+class SymbolIndexBuilder;
+
+// A definition in the files of the index.
+struct SymbolLocation {
+  wxString name;
+  syntax::DefinitionKind kind;
+  wxString path;
+  int line;
+  int column;
+};
+
+// The definitions of the classes, the functions and the macros of the C++
+// files under a project folder, found by syntax::CppDefinitionFinder, so a
+// definition is found without a language server.
+//
+// The index is built by a thread, which parses the files with a pool of a
+// thread per CPU. It's kept in the cache dir with the modification time of
+// each file, so only the files changed since are parsed again. The names
+// are sorted without case, so a name or a prefix is found by a binary
+// search.
+class SymbolIndex {
+public:
+  SymbolIndex();
+  ~SymbolIndex();
+
+  // The indexes are kept in |cache_dir|. None is read or written if it's
+  // empty, which is the default.
+  static void SetCacheDir(const wxString& cache_dir);
+
+  // Index the files under |dir| in the background. A wxThreadEvent of
+  // |event_id| is queued to |handler| when it's done, then TakeIndex() is
+  // called. The old index is used until then. The columns are of the lines
+  // with their tabs expanded to |tab_size| spaces, as in the documents.
+  void Start(const wxString& dir, int tab_size, wxEvtHandler* handler, int event_id);
+  void Stop();
+
+  const wxString& dir() const { return dir_; }
+  bool is_building() const { return builder_ != NULL; }
+
+  // Replace the index by the one built. Return false if it isn't built,
+  // e.g. the event was queued by a thread stopped since.
+  bool TakeIndex();
+
+  size_t file_count() const { return files_.size(); }
+  size_t symbol_count() const { return symbols_.size(); }
+
+  // The definitions of |name|, in the order of their paths.
+  void FindDefinitions(const wxString& name, std::vector<SymbolLocation>* locations) const;
+
+  // At most |max_count| definitions whose names start with |prefix|,
+  // ignoring case, sorted by name.
+  void FindSymbols(const wxString& prefix, size_t max_count, std::vector<SymbolLocation>* locations) const;
+
+  size_t GetMemoryUsage() const;
+
+private:
+  friend class SymbolIndexBuilder;
+  friend class SymbolNameLess;
+
+  struct File {
+    wxString path;
+    long long mtime;
+    unsigned int first_symbol;
+    unsigned int symbol_count;
+  };
+
+  struct Symbol {
+    unsigned int name_offset;  // in names_
+    unsigned int name_length;
+    unsigned int file;
+    int line;
+    int column;
+    unsigned char kind;
+  };
+
+  // The first sorted symbol whose name isn't before the UTF-8 |name|.
+  size_t FindSorted(const char* name, size_t length) const;
+  void AddLocation(unsigned int symbol_index, std::vector<SymbolLocation>* locations) const;
+
+private:
+  wxString dir_;
+  SymbolIndexBuilder* builder_;
+
+  // The files are sorted by path, and the symbols of a file follow those of
+  // the file before it.
+  std::vector<File> files_;
+  std::vector<Symbol> symbols_;
+  std::string names_;  // the UTF-8 names of the symbols, one after another
+
+  // The symbols sorted by name without case.
+  std::vector<unsigned int> sorted_symbols_;
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_SYMBOL_INDEX_H_
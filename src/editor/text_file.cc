@@ -1,55 +1,99 @@
 ﻿#include "editor/text_file.h"
 #include <cassert>
+#include <cstring>
+#include "wx/ffile.h"
+#include "wx/filefn.h"
+#include "wx/filename.h"
 #include <vector>
 #include <fstream>
 #include <algorithm>
+#include <iterator>
 #include "editor/text_line.h"
 #include "editor/text_listener.h"
+#include "editor/trace.h"
 #include "editor/edit_command.h"
+#include "editor/encoding.h"
+#include "editor/hex_text.h"
+#include "editor/line_index.h"
+#include "editor/mapped_file.h"
+#include "editor/memory_usage.h"
+#include "editor/paged_text.h"
+#include "editor/selection_region.h"
 
 namespace editor {
 
-static void SplitString(const wxString& str, wxChar separator, std::vector<wxString>& result) {
-  size_t len = str.Len();
-  size_t start = 0;
-  size_t end = 0;
-  wxString sep = wxString(separator);
-
-  for (size_t i = 0; i < len; ++i) {
-    if (str[i] == separator) {
-      start = end;
-      end = i;
-      wxString tem = str.SubString(start, end - 1);
-      if (!tem.IsEmpty()) {
-        result.push_back(tem);
-      }
-      if (tem != sep) {
-        result.push_back(sep);
-      }
-      ++end;
-    }
-  }
+static unsigned long long g_paged_min_file_size = 0;
+static size_t g_page_cache_size = 0;
 
-  if (start == end && !str.IsEmpty()) {
-    result.push_back(str);
-    end = len;
-  }
+// The head of a file looked at for a zero byte, as git does.
+const size_t kBinaryDetectSize = 8000;
 
-  if (end != len) {
-    result.push_back(str.SubString(end, len - 1));
+// Split the text into lines at '\r'. There is always one line more than the
+// separators.
+static void SplitLines(const wxString& text, std::vector<wxString>* lines) {
+  size_t start = 0;
+  size_t end = 0;
+  while ((end = text.find(wxT('\r'), start)) != wxString::npos) {
+    lines->push_back(text.substr(start, end - start));
+    start = end + 1;
   }
+  lines->push_back(text.substr(start));
 }
 
-TextFile::TextFile() {
+TextFile::TextFile()
+    : redo_bytes_(0),
+      undo_bytes_(0),
+      batch_depth_(0),
+      is_batch_changed_(false),
+      is_batch_multi_lines_(false),
+      is_batch_lines_changed_(false),
+      batch_first_line_(0),
+      batch_end_line_(0),
+      batch_line_delta_(0),
+      is_modified_(false),
+      read_size_(0),
+      tail_offset_(0),
+      tail_line_count_(0),
+      trimmed_line_count_(0),
+      file_size_(0),
+      file_mtime_(0),
+      encoding_(FILE_ENCODING_UTF8),
+      has_bom_(false),
+      paged_text_(NULL),
+      hex_text_(NULL) {
 }
 
 TextFile::TextFile(const wxString& path)
-    : path_(path) {
+    : redo_bytes_(0),
+      undo_bytes_(0),
+      batch_depth_(0),
+      is_batch_changed_(false),
+      is_batch_multi_lines_(false),
+      is_batch_lines_changed_(false),
+      batch_first_line_(0),
+      batch_end_line_(0),
+      batch_line_delta_(0),
+      path_(path),
+      is_modified_(false),
+      read_size_(0),
+      tail_offset_(0),
+      tail_line_count_(0),
+      trimmed_line_count_(0),
+      file_size_(0),
+      file_mtime_(0),
+      encoding_(FILE_ENCODING_UTF8),
+      has_bom_(false),
+      paged_text_(NULL),
+      hex_text_(NULL) {
 }
 
 TextFile::~TextFile() {
+  // The text is going away, which is the last change of it.
+  NotifyTextChanging();
   ClearRedoCommands();
   ClearUndoCommands();
+  delete paged_text_;
+  delete hex_text_;
 }
 
 void TextFile::AttachListener(TextListener* text_listener){
@@ -64,7 +108,49 @@ void TextFile::DetachListener(TextListener* text_listener){
   }
 }
 
+void TextFile::BeginBatch() {
+  ++batch_depth_;
+}
+
+void TextFile::EndBatch() {
+  TRACE_SCOPE("TextFile::EndBatch");
+  assert(batch_depth_ > 0);
+  if (--batch_depth_ != 0) {
+    return;
+  }
+  if (is_batch_lines_changed_) {
+    is_batch_lines_changed_ = false;
+    size_t new_count = batch_end_line_ - batch_first_line_;
+    NotifyLinesChanged(batch_first_line_, new_count - batch_line_delta_, new_count);
+  }
+  if (is_batch_changed_) {
+    is_batch_changed_ = false;
+    NotifyLineUpdate(batch_position_, is_batch_multi_lines_);
+  }
+}
+
 void TextFile::NotifyLineUpdate(const wxPoint& position, bool is_multi_lines){
+  TRACE_SCOPE("TextFile::NotifyLineUpdate");
+  // Within a batch only remember the topmost position. The edits are spread
+  // over several lines, so the listeners have to refresh from there on.
+  if (batch_depth_ > 0) {
+    if (!is_batch_changed_) {
+      is_batch_changed_ = true;
+      is_batch_multi_lines_ = is_multi_lines;
+      batch_position_ = position;
+      return;
+    }
+    if (position.y != batch_position_.y) {
+      is_batch_multi_lines_ = true;
+    }
+    is_batch_multi_lines_ = is_batch_multi_lines_ || is_multi_lines;
+    if (position.y < batch_position_.y ||
+        (position.y == batch_position_.y && position.x < batch_position_.x)) {
+      batch_position_ = position;
+    }
+    return;
+  }
+
   //for (std::list<TextListener*>::iterator iter = text_listeners_.begin();
   //     iter != text_listeners_.end();
   //     ++iter) {
@@ -75,97 +161,475 @@ void TextFile::NotifyLineUpdate(const wxPoint& position, bool is_multi_lines){
   }
 }
 
-void TextFile::DeleteText(const wxPoint& position, const wxString& text) {
-  std::vector<wxString> str_vec;
-  SplitString(text, '\r', str_vec);
-
-  if (str_vec.empty()) {
+void TextFile::NotifyLinesChanged(size_t first_line, size_t old_count, size_t new_count) {
+  TRACE_SCOPE("TextFile::NotifyLinesChanged");
+  // Within a batch merge the changed lines into one range. The end of the
+  // range is moved by the lines inserted or deleted before it.
+  if (batch_depth_ > 0) {
+    size_t end_line = first_line + new_count;
+    if (!is_batch_lines_changed_) {
+      is_batch_lines_changed_ = true;
+      batch_first_line_ = first_line;
+      batch_end_line_ = end_line;
+      batch_line_delta_ = static_cast<int>(new_count) - static_cast<int>(old_count);
+      return;
+    }
+    if (batch_end_line_ >= first_line + old_count) {
+      batch_end_line_ = batch_end_line_ + new_count - old_count;
+    } else if (batch_end_line_ > first_line) {
+      batch_end_line_ = end_line;
+    }
+    batch_first_line_ = std::min(batch_first_line_, first_line);
+    batch_end_line_ = std::max(batch_end_line_, end_line);
+    batch_line_delta_ += static_cast<int>(new_count) - static_cast<int>(old_count);
     return;
   }
 
-  for (size_t i = 0; i < str_vec.size(); ++i) {
-    if (str_vec[i][0] != '\r') {
-      DeleteString(position, str_vec[i]);
-    } else {
-      DeleteLine(position);
-    }
+  for (TextListener*& text_listener : text_listeners_) {
+    text_listener->OnLinesChanged(first_line, old_count, new_count);
   }
+}
 
-  bool is_multi_lines = str_vec.size() > 1 || str_vec[0][0] == '\r';
-  NotifyLineUpdate(position, is_multi_lines);
+void TextFile::NotifyTextChanging() {
+  // A listener may detach itself while it's notified.
+  std::list<TextListener*>::iterator iter = text_listeners_.begin();
+  while (iter != text_listeners_.end()) {
+    TextListener* text_listener = *iter++;
+    text_listener->OnTextChanging();
+  }
 }
 
+// The lines between the first and the last line of the text are erased as one
+// block, so the lines after it are moved only once.
+void TextFile::DeleteText(const wxPoint& position, const wxString& text) {
+  TRACE_SCOPE("TextFile::DeleteText");
+  if (text.IsEmpty()) {
+    return;
+  }
+  NotifyTextChanging();
+  is_modified_ = true;
+
+  std::vector<wxString> lines;
+  SplitLines(text, &lines);
+  size_t line_count = lines.size() - 1;
+
+  TextLine& first_line = GetLine(position.y);
+  if (line_count == 0) {
+    first_line.Remove(position.x, text.Len());
+  } else {
+    const TextLine& last_line = GetLine(position.y + line_count);
+    wxString tail = last_line.GetData().Mid(lines.back().Len());
+    first_line.Remove(position.x, first_line.Len() - position.x);
+    first_line.Append(tail);
+    first_line.SetLineEndType(last_line.GetLineEndType());
+    text_lines_.erase(text_lines_.begin() + position.y + 1,
+                      text_lines_.begin() + position.y + line_count + 1);
+  }
+
+  NotifyLinesChanged(position.y, line_count + 1, 1);
+  NotifyLineUpdate(position, line_count != 0);
+}
+
+// The new lines are inserted as one block, so the lines after them are moved
+// only once.
 void TextFile::InsertText(const wxPoint& position, const wxString& text) {
+  TRACE_SCOPE("TextFile::InsertText");
+  if (text.IsEmpty()) {
+    return;
+  }
+  NotifyTextChanging();
+  is_modified_ = true;
+
+  std::vector<wxString> lines;
+  SplitLines(text, &lines);
+  size_t line_count = lines.size() - 1;
+
   wxPoint pos(position);
-  std::vector<wxString> str_vec;
-  SplitString(text, '\r', str_vec);
+  TextLine& first_line = GetLine(position.y);
+  if (line_count == 0) {
+    first_line.Insert(position.x, text);
+    pos.x += text.Len();
+  } else {
+    LineEndType type = GetSplitLineEndType(position.y);
+    wxString tail = first_line.GetData().Mid(position.x);
+    first_line.Remove(position.x, tail.Len());
+    first_line.Append(lines[0]);
+
+    std::vector<TextLine> new_lines;
+    new_lines.reserve(line_count);
+    for (size_t i = 1; i <= line_count; ++i) {
+      new_lines.push_back(TextLine(lines[i], type));
+    }
+    new_lines.back().Append(tail);
+    new_lines.back().SetLineEndType(first_line.GetLineEndType());
+    first_line.SetLineEndType(type);
+    text_lines_.insert(text_lines_.begin() + position.y + 1,
+                       std::make_move_iterator(new_lines.begin()),
+                       std::make_move_iterator(new_lines.end()));
+    pos = wxPoint(lines.back().Len(), position.y + line_count);
+  }
+
+  // The listeners refresh the lines from position.y in OnLinesChanged().
+  NotifyLinesChanged(position.y, 1, line_count + 1);
+  NotifyLineUpdate(pos, line_count != 0);
+}
 
-  if (str_vec.empty()) {
+// From the last one, the split line end of each replacement is found first,
+// since a replacement which ends on the line of the next one takes the line
+// end the next one leaves there. The lines from the first replacement to
+// the last one are then built in one pass, with the lines between them
+// moved, and put in place of the old ones with one move of the lines after.
+void TextFile::ReplaceTexts(const std::vector<TextReplacement>& replacements, bool from_last) {
+  TRACE_SCOPE("TextFile::ReplaceTexts");
+  assert(!IsFileLines());
+  if (replacements.empty()) {
     return;
   }
+  NotifyTextChanging();
+  is_modified_ = true;
+
+  size_t count = replacements.size();
+  std::vector<LineEndType> split_types(count);
+  LineEndType next_type = LINE_END_TYPE_NONE;  // of the line the next one starts on
+  for (size_t i = from_last ? count : 0; i > 0; --i) {
+    const TextReplacement& replacement = replacements[i - 1];
+    int old_end_line = GetTextEndPosition(replacement.position, *replacement.old_text).y;
+    LineEndType type = text_lines_[old_end_line].GetLineEndType();
+    if (i < count && replacements[i].position.y == old_end_line) {
+      type = next_type;
+    }
+    if (replacement.new_text->find(wxT('\r')) == wxString::npos) {
+      next_type = type;
+      continue;
+    }
+    if (type == LINE_END_TYPE_NONE && replacement.position.y > 0) {
+      type = text_lines_[replacement.position.y - 1].GetLineEndType();
+    }
+    split_types[i - 1] = type == LINE_END_TYPE_NONE ? kDefaultLineEndType : type;
+    next_type = split_types[i - 1];
+  }
 
-  for (size_t i = 0; i < str_vec.size(); ++i) {
-    if (str_vec[i][0] != '\r') {
-      InsertString(pos, str_vec[i]);
-      NotifyLineUpdate(pos, false);  // TODO
-    } else {
-      InsertLine(pos);
+  size_t first_line = replacements.front().position.y;
+  std::vector<TextLine> new_lines;
+  std::vector<wxString> lines;
+  wxString line;
+  size_t old_line = first_line;
+  size_t old_column = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const TextReplacement& replacement = replacements[i];
+    for (; old_line < static_cast<size_t>(replacement.position.y); ++old_line, old_column = 0) {
+      TextLine& text_line = text_lines_[old_line];
+      if (line.IsEmpty() && old_column == 0) {
+        new_lines.push_back(std::move(text_line));
+      } else {
+        line.append(text_line.GetData(), old_column, wxString::npos);
+        new_lines.push_back(TextLine(line, text_line.GetLineEndType()));
+        line.clear();
+      }
+    }
+
+    line.append(text_lines_[old_line].GetData(), old_column, replacement.position.x - old_column);
+    lines.clear();
+    SplitLines(*replacement.new_text, &lines);
+    line.append(lines[0]);
+    wxPoint old_end = GetTextEndPosition(replacement.position, *replacement.old_text);
+    if (!from_last && lines.size() > 1) {
+      // The line before is the one the replacements above have left.
+      LineEndType type = text_lines_[old_end.y].GetLineEndType();
+      if (type == LINE_END_TYPE_NONE) {
+        if (!new_lines.empty()) {
+          type = new_lines.back().GetLineEndType();
+        } else if (first_line > 0) {
+          type = text_lines_[first_line - 1].GetLineEndType();
+        }
+      }
+      split_types[i] = type == LINE_END_TYPE_NONE ? kDefaultLineEndType : type;
     }
+    for (size_t j = 1; j < lines.size(); ++j) {
+      new_lines.push_back(TextLine(line, split_types[i]));
+      line = lines[j];
+    }
+
+    old_line = old_end.y;
+    old_column = old_end.x;
+  }
+  const TextLine& last_line = text_lines_[old_line];
+  line.append(last_line.GetData(), old_column, wxString::npos);
+  new_lines.push_back(TextLine(line, last_line.GetLineEndType()));
+
+  size_t old_count = old_line + 1 - first_line;
+  size_t new_count = new_lines.size();
+  if (new_count > old_count) {
+    text_lines_.insert(text_lines_.begin() + first_line + old_count, new_count - old_count, TextLine());
+  } else if (new_count < old_count) {
+    text_lines_.erase(text_lines_.begin() + first_line + new_count,
+                      text_lines_.begin() + first_line + old_count);
   }
-  // TODO
-  bool is_multi_lines = str_vec.size() > 1 || str_vec[0][0] == '\r';
-  NotifyLineUpdate(pos, is_multi_lines);
+  std::move(new_lines.begin(), new_lines.end(), text_lines_.begin() + first_line);
+
+  NotifyLinesChanged(first_line, old_count, new_count);
+  NotifyLineUpdate(replacements.front().position, old_count != 1 || new_count != 1);
 }
 
+// The size of the text is counted first, so it's copied once into a buffer of
+// the right size instead of growing it with temporary sub strings.
+wxString TextFile::GetText(const SelectionRegion& region) const {
+  int start_line = region.start_pos().y;
+  int end_line = region.end_pos().y;
+  size_t from = 0;
+  size_t count = 0;
+
+  size_t size = end_line - start_line;
+  for (int i = start_line; i <= end_line; ++i) {
+    region.GetLineRange(i, GetLine(i).Len(), &from, &count);
+    size += count;
+  }
+
+  wxString text;
+  text.reserve(size);
+  for (int i = start_line; i <= end_line; ++i) {
+    if (i != start_line) {
+      text.append(1, '\r');
+    }
+    const TextLine& text_line = GetLine(i);
+    region.GetLineRange(i, text_line.Len(), &from, &count);
+    text.append(text_line.GetData(), from, count);
+  }
+  return text;
+}
+
+// The file is mapped instead of read, and the lines are cut at the offsets
+// of its line index, which is read from the cache if the file isn't changed
+// since it was scanned. Each line is decoded on its own, so a multi-byte
+// char is never split. UTF-16 is transcoded to UTF-8 first, and such a file
+// can't be followed since the offsets are the ones of the UTF-8 bytes.
+// The stamp is taken before the bytes are read, so a change while they're
+// read is noticed later.
 bool TextFile::Read() {
-  std::ifstream ifs(path_.fn_str(), std::ios::in);
-  if (!ifs.is_open() || !ifs.good()) {
+  TRACE_SCOPE("TextFile::Read");
+  UpdateFileStamp();
+  MappedFile mapped_file;
+  if (!mapped_file.Open(path_)) {
     return false;
   }
-  const size_t BUFFER_SIZE = 4096;
-  wxString text;
-  char temp[BUFFER_SIZE] = "";
-  while (!ifs.eof()) {
-    ifs.read(temp, BUFFER_SIZE);
-    text.Append(temp, static_cast<size_t>(ifs.gcount()));
+  size_t bom_size = 0;
+  encoding_ = DetectEncoding(mapped_file.data(), mapped_file.size(), &bom_size);
+  has_bom_ = bom_size != 0;
+  const char* data = mapped_file.data() + bom_size;
+  size_t size = mapped_file.size() - bom_size;
+
+  std::string utf8;
+  bool is_utf16 = encoding_ == FILE_ENCODING_UTF16LE || encoding_ == FILE_ENCODING_UTF16BE;
+  if (is_utf16) {
+    Utf16ToUtf8(data, size, encoding_ == FILE_ENCODING_UTF16BE, &utf8);
+    data = utf8.data();
+    size = utf8.size();
+  }
+
+  LineIndex line_index;
+  if (!line_index.ReadCache(path_, data, size)) {
+    line_index.Build(data, size);
+    line_index.WriteCache(path_, data, size);
   }
-  ifs.close();
-  ParseTextData(text);
 
+  text_lines_.reserve(text_lines_.size() + line_index.GetLineCount());
+  for (size_t i = 0; i < line_index.GetLineCount(); ++i) {
+    AddLine(DecodeLine(data + line_index.GetLineOffset(i), line_index.GetLineLength(i), encoding_),
+            line_index.GetLineEndType(i));
+  }
+
+  read_size_ = mapped_file.size();
+  GetTail(line_index, &tail_offset_, &tail_line_count_);
+  tail_offset_ += bom_size;
+  if (is_utf16) {
+    tail_line_count_ = 0;
+  }
   return true;
 }
 
-void TextFile::ParseTextData(const wxString& text) {
-  wxString::const_iterator start = text.begin();
-  wxString::const_iterator end = text.end();
-  for (wxString::const_iterator it = start; it != end; it++) {
-    const wxChar ch = *it;
-    LineEndType line_type = LINE_END_TYPE_NONE;
-    if (ch == '\r') {
-      wxString::const_iterator next = it + 1;
-      if (next != end && *next == '\n') {
-        line_type = LINE_END_TYPE_DOS;
-      } else {
-        line_type = LINE_END_TYPE_MAC;
-      }
-      AddLine(wxString(start, it), line_type);
-      if (line_type == LINE_END_TYPE_DOS) {
-        it++;
-      }
-      start = it + 1;
-    } 
-    if (ch == '\n'){
-      line_type = LINE_END_TYPE_UNIX;
-      AddLine(wxString(start, it), line_type);
-      start = it + 1;
-    }
+void TextFile::SetPagedLimits(unsigned long long min_file_size, size_t cache_size) {
+  g_paged_min_file_size = min_file_size;
+  g_page_cache_size = cache_size;
+}
+
+bool TextFile::IsPagedFile(const wxString& path) {
+  return g_paged_min_file_size != 0 && wxFileName(path).GetSize().GetValue() >= g_paged_min_file_size;
+}
+
+bool TextFile::ReadPaged(int tab_size) {
+  TRACE_SCOPE("TextFile::ReadPaged");
+  UpdateFileStamp();
+  PagedText* paged_text = new PagedText();
+  if (!paged_text->Open(path_, tab_size, g_page_cache_size)) {
+    delete paged_text;
+    return false;
+  }
+  paged_text_ = paged_text;
+  encoding_ = paged_text_->GetEncoding();
+  has_bom_ = paged_text_->HasBom();
+  return true;
+}
+
+bool TextFile::IsBinaryFile(const wxString& path) {
+  wxFFile file(path, wxT("rb"));
+  if (!file.IsOpened()) {
+    return false;
+  }
+  char head[kBinaryDetectSize];
+  size_t size = file.Read(head, sizeof(head));
+  size_t bom_size = 0;
+  FileEncoding encoding = DetectEncoding(head, size, &bom_size);
+  if (encoding == FILE_ENCODING_UTF16LE || encoding == FILE_ENCODING_UTF16BE) {
+    return false;
+  }
+  return memchr(head, 0, size) != NULL;
+}
+
+bool TextFile::ReadHex() {
+  TRACE_SCOPE("TextFile::ReadHex");
+  UpdateFileStamp();
+  HexText* hex_text = new HexText();
+  if (!hex_text->Open(path_)) {
+    delete hex_text;
+    return false;
   }
+  hex_text_ = hex_text;
+  return true;
+}
 
-  wxString last_line(start, end);
-  AddLine(last_line, LINE_END_TYPE_NONE);
+TextLine& TextFile::GetFileLine(size_t n) const {
+  return paged_text_ != NULL ? paged_text_->GetLine(n) : hex_text_->GetLine(n);
+}
+
+// The lines at the end which may still change when bytes are appended: the
+// last line, which has no line end yet, and the line before it if it ends
+// with a '\r' at the end of the file, which may be the first half of a "\r\n".
+void TextFile::GetTail(const LineIndex& line_index, size_t* offset, size_t* line_count) {
+  size_t last_line = line_index.GetLineCount() - 1;
+  *line_count = 1;
+  if (last_line > 0 &&
+      line_index.GetLineLength(last_line) == 0 &&
+      line_index.GetLineEndType(last_line - 1) == LINE_END_TYPE_MAC) {
+    *line_count = 2;
+  }
+  *offset = line_index.GetLineOffset(last_line + 1 - *line_count);
+}
+
+// Only the tail lines are read again, together with the bytes appended.
+bool TextFile::ReadAppended(size_t* first_line) {
+  TRACE_SCOPE("TextFile::ReadAppended");
+  if (IsFileLines()) {
+    return ReadFileLinesAppended(first_line);
+  }
+  if (tail_line_count_ == 0) {
+    return false;
+  }
+  *first_line = text_lines_.size() - tail_line_count_;
+
+  wxFFile file(path_, wxT("rb"));
+  if (!file.IsOpened()) {
+    return false;
+  }
+  wxFileOffset length = file.Length();
+  if (length < 0 || static_cast<size_t>(length) < read_size_) {
+    return false;
+  }
+  if (static_cast<size_t>(length) == read_size_) {
+    return true;
+  }
+
+  std::vector<char> buffer(static_cast<size_t>(length) - tail_offset_);
+  if (!file.Seek(tail_offset_) || file.Read(&buffer[0], buffer.size()) != buffer.size()) {
+    return false;
+  }
+  // Bytes which aren't UTF-8 are Latin-1, which the whole file is read as.
+  if (encoding_ == FILE_ENCODING_UTF8 && !IsValidUtf8(&buffer[0], buffer.size())) {
+    return false;
+  }
+  LineIndex line_index;
+  line_index.Build(&buffer[0], buffer.size());
+
+  NotifyTextChanging();
+  size_t old_count = tail_line_count_;
+  text_lines_.erase(text_lines_.end() - old_count, text_lines_.end());
+  text_lines_.reserve(text_lines_.size() + line_index.GetLineCount());
+  for (size_t i = 0; i < line_index.GetLineCount(); ++i) {
+    AddLine(DecodeLine(&buffer[0] + line_index.GetLineOffset(i), line_index.GetLineLength(i), encoding_),
+            line_index.GetLineEndType(i));
+  }
+
+  read_size_ = static_cast<size_t>(length);
+  UpdateFileStamp();
+  size_t tail_offset = 0;
+  GetTail(line_index, &tail_offset, &tail_line_count_);
+  tail_offset_ += tail_offset;
+
+  NotifyLinesChanged(*first_line, old_count, line_index.GetLineCount());
+  NotifyLineUpdate(wxPoint(0, *first_line), true);
+  return true;
+}
+
+// The pages from the one of the last line on are scanned again, or the file
+// of a hex text is mapped again.
+bool TextFile::ReadFileLinesAppended(size_t* first_line) {
+  size_t old_line_count = GetLineCount();
+  bool is_read = paged_text_ != NULL ? paged_text_->ReadAppended(first_line) : hex_text_->ReadAppended(first_line);
+  if (!is_read) {
+    return false;
+  }
+  UpdateFileStamp();
+  if (*first_line == old_line_count) {
+    return true;
+  }
+  NotifyTextChanging();
+  NotifyLinesChanged(*first_line, old_line_count - *first_line, GetLineCount() - *first_line);
+  NotifyLineUpdate(wxPoint(0, *first_line), true);
+  return true;
+}
+
+// The lines are dropped in blocks of a tenth of the limit, so they aren't
+// moved for every append. The undo history refers to the lines by number,
+// so it's cleared.
+void TextFile::TrimLines(size_t max_line_count) {
+  TRACE_SCOPE("TextFile::TrimLines");
+  if (max_line_count == 0 || text_lines_.size() <= max_line_count + max_line_count / 10) {
+    return;
+  }
+  NotifyTextChanging();
+  ClearUndoCommands();
+  ClearRedoCommands();
+
+  size_t count = text_lines_.size() - max_line_count;
+  text_lines_.erase(text_lines_.begin(), text_lines_.begin() + count);
+  trimmed_line_count_ += count;
+
+  NotifyLinesChanged(0, count, 0);
+  NotifyLineUpdate(wxPoint(0, 0), true);
+}
+
+bool TextFile::IsFileChanged() const {
+  return wxFileName(path_).GetSize().GetValue() != file_size_ || wxFileModificationTime(path_) != file_mtime_;
+}
+
+void TextFile::UpdateFileStamp() {
+  file_size_ = wxFileName(path_).GetSize().GetValue();
+  file_mtime_ = wxFileModificationTime(path_);
+}
+
+void TextFile::SetFileState(const TextFile& text_file) {
+  is_modified_ = false;
+  read_size_ = text_file.read_size_;
+  tail_offset_ = text_file.tail_offset_;
+  tail_line_count_ = text_file.tail_line_count_;
+  trimmed_line_count_ = 0;
+  encoding_ = text_file.encoding_;
+  has_bom_ = text_file.has_bom_;
+  file_size_ = text_file.file_size_;
+  file_mtime_ = text_file.file_mtime_;
 }
 
 bool TextFile::Write() {
+  TRACE_SCOPE("TextFile::Write");
   return Write(path_);
 }
 
@@ -184,25 +648,155 @@ bool TextFile::Write() {
 //  return true;
 //}
 
-bool TextFile::Write(const wxString& path) {
-  std::ofstream ofs(path_.fn_str(), std::ios::out);
-  if (!ofs.is_open() || !ofs.good()) {
+// Each run of |tab_size| tabs becomes one tab, as wxString::Replace() does.
+static void CollapseTabs(const wxString& data, int tab_size, wxString* line) {
+  line->clear();
+  int tab_count = 0;
+  for (wxString::const_iterator it = data.begin(); it != data.end(); ++it) {
+    if (*it == wxT('\t')) {
+      if (++tab_count == tab_size) {
+        line->append(1, wxT('\t'));
+        tab_count = 0;
+      }
+      continue;
+    }
+    if (tab_count > 0) {
+      line->append(tab_count, wxT('\t'));
+      tab_count = 0;
+    }
+    line->append(1, *it);
+  }
+  line->append(tab_count, wxT('\t'));
+}
+
+// The lines are encoded into a buffer which is written whenever it's full,
+// so the text is never copied whole. The line ends are encoded once. The
+// file is written in binary, so the line ends are the ones of the lines.
+// Only the lines with tabs are copied to collapse them. A hex text writes
+// its bytes, see HexText::Write().
+bool TextFile::Write(const wxString& path, int tab_size) {
+  TRACE_SCOPE("TextFile::Write");
+  const size_t kWriteBufferSize = 1024 * 1024;
+  if (paged_text_ != NULL) {
     return false;
   }
-  wxString temp;
-  //for (size_t i = 0; i < text_lines_.size(); ++i) {
-  //  temp.Append(text_lines_[i].GetData());
-  //  temp.Append(GetEOL(text_lines_[i].GetLineEndType()));
-  //}
-  for (TextLine& text_line : text_lines_) {
-    temp.Append(text_line.GetData());
-    temp.Append(GetEOL(text_line.GetLineEndType()));
+  if (hex_text_ != NULL) {
+    if (!hex_text_->Write(path)) {
+      return false;
+    }
+    is_modified_ = false;
+    UpdateFileStamp();
+    return true;
   }
-  ofs << temp.ToStdString();
-  ofs.close();
+
+  // A Latin-1 text which has got other chars is written as UTF-8, which
+  // loses nothing.
+  if (encoding_ == FILE_ENCODING_LATIN1) {
+    for (const TextLine& text_line : text_lines_) {
+      if (!IsLatin1(text_line.GetData())) {
+        encoding_ = FILE_ENCODING_UTF8;
+        has_bom_ = false;
+        break;
+      }
+    }
+  }
+
+  wxFFile file(path, wxT("wb"));
+  if (!file.IsOpened()) {
+    return false;
+  }
+  std::string eols[LINE_END_TYPE_MAC + 1];
+  for (int type = LINE_END_TYPE_NONE; type <= LINE_END_TYPE_MAC; ++type) {
+    EncodeText(GetEOL(static_cast<LineEndType>(type)), encoding_, &eols[type]);
+  }
+
+  std::string buffer;
+  buffer.reserve(kWriteBufferSize + kWriteBufferSize / 4);
+  if (has_bom_) {
+    buffer = GetBom(encoding_);
+  }
+  wxString line;
+  for (const TextLine& text_line : text_lines_) {
+    const wxString& data = text_line.GetData();
+    if (tab_size > 1 && data.find(wxT('\t')) != wxString::npos) {
+      CollapseTabs(data, tab_size, &line);
+      EncodeText(line, encoding_, &buffer);
+    } else {
+      EncodeText(data, encoding_, &buffer);
+    }
+    buffer.append(eols[text_line.GetLineEndType()]);
+    if (buffer.size() >= kWriteBufferSize) {
+      if (file.Write(buffer.data(), buffer.size()) != buffer.size()) {
+        return false;
+      }
+      buffer.clear();
+    }
+  }
+  if (!buffer.empty() && file.Write(buffer.data(), buffer.size()) != buffer.size()) {
+    return false;
+  }
+  if (!file.Close()) {
+    return false;
+  }
+  is_modified_ = false;
+  UpdateFileStamp();
+  // The line ends written may be others than the ones read, so the appended
+  // bytes can't be found any more.
+  tail_line_count_ = 0;
   return true;
 }
 
+LineEndType TextFile::GetSplitLineEndType(size_t line) const {
+  LineEndType type = text_lines_[line].GetLineEndType();
+  if (type == LINE_END_TYPE_NONE && line > 0) {
+    type = text_lines_[line - 1].GetLineEndType();
+  }
+  return type == LINE_END_TYPE_NONE ? kDefaultLineEndType : type;
+}
+
+// Only a byte per line is written, so millions of lines take milliseconds.
+// A file whose lines end the same way has one run.
+void TextFile::ConvertLineEnds(LineEndType type, std::vector<LineEndRun>* old_runs) {
+  TRACE_SCOPE("TextFile::ConvertLineEnds");
+  for (size_t i = 0; i + 1 < text_lines_.size(); ++i) {
+    LineEndType old_type = text_lines_[i].GetLineEndType();
+    if (old_runs->empty() || old_runs->back().type != old_type) {
+      LineEndRun run = { 0, old_type };
+      old_runs->push_back(run);
+    }
+    ++old_runs->back().count;
+    text_lines_[i].SetLineEndType(type);
+  }
+  is_modified_ = true;
+}
+
+// The lines of the bytes are made again, and the listeners refresh them.
+void TextFile::OverwriteBytes(unsigned long long offset, const std::string& bytes, const wxPoint& caret_pos) {
+  TRACE_SCOPE("TextFile::OverwriteBytes");
+  if (bytes.empty()) {
+    return;
+  }
+  NotifyTextChanging();
+  is_modified_ = true;
+  hex_text_->SetBytes(offset, bytes);
+
+  size_t first_line = static_cast<size_t>(offset / HexText::kBytesPerLine);
+  size_t line_count = static_cast<size_t>((offset + bytes.size() - 1) / HexText::kBytesPerLine) + 1 - first_line;
+  NotifyLinesChanged(first_line, line_count, line_count);
+  NotifyLineUpdate(caret_pos, line_count != 1);
+}
+
+void TextFile::RestoreLineEnds(const std::vector<LineEndRun>& runs) {
+  TRACE_SCOPE("TextFile::RestoreLineEnds");
+  size_t line = 0;
+  for (const LineEndRun& run : runs) {
+    for (size_t i = 0; i < run.count && line < text_lines_.size(); ++i, ++line) {
+      text_lines_[line].SetLineEndType(run.type);
+    }
+  }
+  is_modified_ = true;
+}
+
 wxString TextFile::GetEOL(LineEndType type) const {
   switch (type) {
     case LINE_END_TYPE_NONE:
@@ -210,8 +804,7 @@ wxString TextFile::GetEOL(LineEndType type) const {
     case LINE_END_TYPE_UNIX:
       return wxT("\n");
     case LINE_END_TYPE_DOS:
-      //return wxT("\r\n");
-      return wxT("\n");
+      return wxT("\r\n");
     case LINE_END_TYPE_MAC:
       return wxT("\r");
     default:
@@ -229,6 +822,12 @@ wxString TextFile::GetEOL(LineEndType type) const {
 //}
 
 size_t TextFile::GetMaxLineSize() const {
+  if (paged_text_ != NULL) {
+    return paged_text_->GetMaxLineSize();
+  }
+  if (hex_text_ != NULL) {
+    return hex_text_->GetLineSize();
+  }
   size_t line_size = 0;
   for (size_t i = 0; i != text_lines_.size(); ++i) {
     size_t length = text_lines_[i].Len();
@@ -237,33 +836,6 @@ size_t TextFile::GetMaxLineSize() const {
   return line_size;
 }
 
-void TextFile::DeleteString(const wxPoint& position, const wxString& str) {
-  wxString& current_line = GetLine(position.y).GetData();
-  current_line.Remove(position.x, str.Len());
-}
-
-void TextFile::DeleteLine(const wxPoint& position) {
-  wxString& current_line = GetLine(position.y).GetData();
-  wxString& next_line = GetLine(position.y + 1).GetData();
-  current_line.Append(next_line);
-  DeleteLine(position.y + 1);
-}
-
-void TextFile::InsertString(wxPoint& position, const wxString& str) {
-  wxString& current_line = GetLine(position.y).GetData();
-  current_line.insert(position.x, str);
-  position.x += str.Len();
-}
-
-void TextFile::InsertLine(wxPoint& position) {
-  wxString& current_line = GetLine(position.y).GetData();
-  wxString left_str = current_line.SubString(0, position.x - 1);
-  wxString right_str = current_line.SubString(position.x, current_line.Len());
-  current_line = left_str;
-  InsertLine(right_str, ++position.y);
-  position.x = 0;
-}
-
 //void TextFile::InsertLine(const wxString& str, size_t n, LineEndType type) {
 //  text_lines_.insert(text_lines_.begin() + n, str);
 //  line_end_types_.insert(line_end_types_.begin() + n, type);
@@ -279,29 +851,55 @@ void TextFile::InsertLine(wxPoint& position) {
 //  line_end_types_.erase(line_end_types_.begin() + n);
 //}
 
-void TextFile::InsertLine(const wxString& str, size_t n, LineEndType type) {
-  text_lines_.insert(text_lines_.begin() + n, TextLine(str, type));
-}
-
 void TextFile::AddLine(const wxString& str, LineEndType type) {
   text_lines_.push_back(TextLine(str, type));
 }
 
-void TextFile::DeleteLine(size_t n) {
-  text_lines_.erase(text_lines_.begin() + n);
+size_t TextFile::GetLineCount() const {
+  if (paged_text_ != NULL) {
+    return paged_text_->GetLineCount();
+  }
+  return hex_text_ == NULL ? text_lines_.size() : hex_text_->GetLineCount();
 }
 
-size_t TextFile::GetLineCount() const {
-  return text_lines_.size();
+// The lines of a paged text are searched in the file, see PagedText::Find(),
+// and a hex text for the bytes of the text, see HexText::Find().
+bool TextFile::Find(const wxString& text, const wxPoint& from, wxPoint* found) const {
+  TRACE_SCOPE("TextFile::Find");
+  if (paged_text_ != NULL) {
+    return paged_text_->Find(text, from, found);
+  }
+  if (hex_text_ != NULL) {
+    return hex_text_->Find(text, from, found);
+  }
+  if (text.IsEmpty() || from.y < 0) {
+    return false;
+  }
+  for (size_t i = from.y; i < text_lines_.size(); ++i) {
+    size_t pos = text_lines_[i].GetData().find(text, static_cast<int>(i) == from.y ? from.x : 0);
+    if (pos != wxString::npos) {
+      *found = wxPoint(static_cast<int>(pos), static_cast<int>(i));
+      return true;
+    }
+  }
+  return false;
 }
 
+// A paged text is read only, its commands are dropped.
 void TextFile::Execute(EditCommand* command) {
+  TRACE_SCOPE("TextFile::Execute");
+  if (paged_text_ != NULL) {
+    delete command;
+    return;
+  }
   command->Execute();
   undo_commands_.push_back(command);
+  undo_bytes_ += command->GetMemoryUsage();
   ClearRedoCommands();
 }
 
 void TextFile::Redo() {
+  TRACE_SCOPE("TextFile::Redo");
   if (redo_commands_.empty()) {
     return;
   }
@@ -310,9 +908,13 @@ void TextFile::Redo() {
   command->Execute();
   undo_commands_.push_back(command);
   redo_commands_.pop_back();
+  size_t bytes = command->GetMemoryUsage();
+  undo_bytes_ += bytes;
+  redo_bytes_ -= bytes;
 }
 
 void TextFile::Undo() {
+  TRACE_SCOPE("TextFile::Undo");
   if (undo_commands_.empty()) {
     return;
   }
@@ -321,6 +923,9 @@ void TextFile::Undo() {
   command->Undo();
   redo_commands_.push_back(command);
   undo_commands_.pop_back();
+  size_t bytes = command->GetMemoryUsage();
+  redo_bytes_ += bytes;
+  undo_bytes_ -= bytes;
 }
 
 void TextFile::ClearRedoCommands() {
@@ -328,6 +933,7 @@ void TextFile::ClearRedoCommands() {
     delete edit_command;
   }
   redo_commands_.clear();
+  redo_bytes_ = 0;
 }
 
 void TextFile::ClearUndoCommands() {
@@ -335,6 +941,25 @@ void TextFile::ClearUndoCommands() {
     delete edit_command;
   }
   undo_commands_.clear();
+  undo_bytes_ = 0;
+}
+
+void TextFile::GetMemoryUsage(MemoryUsage* usage) const {
+  if (paged_text_ != NULL) {
+    paged_text_->GetMemoryUsage(usage);
+  }
+  if (hex_text_ != NULL) {
+    hex_text_->GetMemoryUsage(usage);
+  }
+  usage->Add(MEMORY_LINES, GetVectorMemoryUsage(text_lines_));
+  for (const TextLine& line : text_lines_) {
+    line.GetMemoryUsage(usage);
+  }
+
+  // A node of std::list has two links besides the pointer.
+  const size_t kListNodeSize = 3 * sizeof(void*);
+  usage->Add(MEMORY_UNDO, undo_bytes_ + undo_commands_.size() * kListNodeSize);
+  usage->Add(MEMORY_REDO, redo_bytes_ + redo_commands_.size() * kListNodeSize);
 }
 
 bool TextFile::CanUndo() const {
@@ -2,10 +2,13 @@
 #define EDITOR_TEXT_FILE_H_
 #pragma once
 
+#include <ctime>
 #include <vector>
 #include <list>
+#include <string>
 #include "wx/string.h"
 #include "wx/gdicmn.h"
+#include "editor/encoding.h"
 #include "editor/text_line.h"
 
 namespace editor {
@@ -13,6 +16,19 @@ namespace editor {
 class TextListener;
 class EditCommand;
 class TextLine;
+class SelectionRegion;
+class MemoryUsage;
+class LineIndex;
+class PagedText;
+class HexText;
+
+// The text |old_text| at |position| replaced by |new_text|, see
+// TextFile::ReplaceTexts().
+struct TextReplacement {
+  wxPoint position;
+  const wxString* old_text;
+  const wxString* new_text;
+};
 
 class TextFile {
 public:
@@ -22,8 +38,62 @@ public:
   ~TextFile();
 
   bool Read();
+
+  // Viewer mode for files too big to be read whole. Only the lines in use are
+  // read, with the tabs expanded to |tab_size| tabs. A paged text is read
+  // only, it can't be edited or written.
+  bool ReadPaged(int tab_size);
+  bool IsPaged() const { return paged_text_ != NULL; }
+
+  // Files of |min_file_size| bytes or more are paged, with about |cache_size|
+  // bytes of lines kept in memory. No file is paged if |min_file_size| is 0,
+  // which is the default. Set them before any file is read.
+  static void SetPagedLimits(unsigned long long min_file_size, size_t cache_size);
+  static bool IsPagedFile(const wxString& path);
+
+  // Hex mode for binary files. Each line shows 16 bytes, made from the
+  // mapped file when it's used, see HexText. The bytes can only be
+  // overwritten, with OverwriteBytes().
+  bool ReadHex();
+  bool IsHex() const { return hex_text_ != NULL; }
+  HexText* hex_text() const { return hex_text_; }
+
+  // A file with a zero byte in its head which isn't UTF-16.
+  static bool IsBinaryFile(const wxString& path);
+
+  // The lines of a paged or a hex text are made from the file as they're
+  // used, so they can't be edited as text, and walking them all would read
+  // the whole file.
+  bool IsFileLines() const { return paged_text_ != NULL || hex_text_ != NULL; }
+
   bool Write();
-  bool Write(const wxString& path);
+
+  // With a |tab_size|, each |tab_size| tabs the lines got on read are
+  // written as one, leaving the lines as they are.
+  bool Write(const wxString& path, int tab_size = 0);
+
+  // Follow mode. Add the bytes appended to the file since it was read, and
+  // set |first_line| to the first line changed. Return false if the file
+  // can't be read, it's shorter than it was, e.g. a rotated log, or the text
+  // was written since it was read. The text should then be read again.
+  bool ReadAppended(size_t* first_line);
+
+  // Drop the first lines so that no more than about |max_line_count| lines
+  // are kept. No line is dropped if it's 0.
+  void TrimLines(size_t max_line_count);
+
+  // True if lines were dropped, so the text is no longer the whole file.
+  bool IsTrimmed() const { return trimmed_line_count_ != 0; }
+
+  // True if the size or the modification time of the file isn't the one of
+  // the last read or write, i.e. another program changed the file.
+  bool IsFileChanged() const;
+  void UpdateFileStamp();
+
+  // The text is changed to the one of |text_file|, which is the file read
+  // again. Take its state of the file, so the text isn't modified and the
+  // bytes appended later are found.
+  void SetFileState(const TextFile& text_file);
 
   void Execute(EditCommand* command);
   void Redo();
@@ -32,17 +102,63 @@ public:
   bool CanRedo() const;
   bool CanUndo() const;
 
+  // Collect the listener notifications of the edits between BeginBatch()
+  // and EndBatch() into a single one. Batches can be nested.
+  void BeginBatch();
+  void EndBatch();
+
   void AttachListener(TextListener* text_listener);
   void DetachListener(TextListener* text_listener);
 
   void AddLine(const wxString& str, LineEndType type = kDefaultLineEndType);
 
+  // The lines split by an insert end the way the split line does, and a
+  // joined line ends the way the last of the lines joined does, so the line
+  // ends of the file are kept.
   void DeleteText(const wxPoint& position, const wxString& text);
   void InsertText(const wxPoint& position, const wxString& text);
 
+  // Replace the texts of |replacements|, which are sorted and don't overlap,
+  // with their positions in the text before any of them. The result is the
+  // one of replacing them one by one, from the last one if |from_last|, or
+  // else from the first one, each at its position moved by the ones above,
+  // as an undo does. The lines are moved once, and the listeners are
+  // notified once.
+  void ReplaceTexts(const std::vector<TextReplacement>& replacements, bool from_last);
+
+  // Set the line end of every line but the last one, which has none, and
+  // append the old line ends to |old_runs|. The chars of the lines aren't
+  // changed, so the listeners aren't notified.
+  void ConvertLineEnds(LineEndType type, std::vector<LineEndRun>* old_runs);
+
+  // Set the line ends back from the first line on.
+  void RestoreLineEnds(const std::vector<LineEndRun>& runs);
+
+  // Overwrite the bytes of a hex text and put the carets of the editing view
+  // at |caret_pos|.
+  void OverwriteBytes(unsigned long long offset, const std::string& bytes, const wxPoint& caret_pos);
+
+  // Get the text of the region. Lines are separated by '\r'.
+  wxString GetText(const SelectionRegion& region) const;
+
+  // Find |text|, which has no line break, from |from| on.
+  bool Find(const wxString& text, const wxPoint& from, wxPoint* found) const;
+
   size_t GetMaxLineSize() const;
   size_t GetLineCount() const;
   const wxString& GetPath() const { return path_; }
+  void SetPath(const wxString& path) { path_ = path; }
+
+  // The encoding of the file, and whether it starts with a byte order mark,
+  // which are kept when it's written. A new file is UTF-8 without one.
+  FileEncoding GetEncoding() const { return encoding_; }
+  bool HasBom() const { return has_bom_; }
+
+  // True if the text is changed since it's read or written.
+  bool IsModified() const { return is_modified_; }
+
+  // Add the memory of the lines and the undo history.
+  void GetMemoryUsage(MemoryUsage* usage) const;
 
   //LineEndType GetLineEndType(size_t n) const { return line_end_types_[n].; }
 
@@ -52,7 +168,7 @@ public:
   //wxString& operator[](size_t n) { return text_lines_[n]; }
   //const wxString& operator[](size_t n) const { return text_lines_[n]; }
 
-  LineEndType GetLineEndType(size_t n) const { return text_lines_[n].GetLineEndType(); }
+  LineEndType GetLineEndType(size_t n) const { return GetLine(n).GetLineEndType(); }
 
   // return wxString or TextLine ?
   //wxString& GetLine(size_t n) { return text_lines_[n].GetString(); }
@@ -61,27 +177,31 @@ public:
   //wxString& operator[](size_t n) { return text_lines_[n].GetString(); }
   //const wxString& operator[](size_t n) const { return text_lines_[n].GetString(); }
 
-  TextLine& GetLine(size_t n) { return text_lines_[n]; }
-  const TextLine& GetLine(size_t n) const { return text_lines_[n]; }
+  // A line of a paged text stays valid until lines of two other pages are
+  // used, see PagedText::GetLine(), and one of a hex text until 256 other
+  // lines are.
+  TextLine& GetLine(size_t n) { return IsFileLines() ? GetFileLine(n) : text_lines_[n]; }
+  const TextLine& GetLine(size_t n) const { return IsFileLines() ? GetFileLine(n) : text_lines_[n]; }
 
-  TextLine& operator[](size_t n) { return text_lines_[n]; }
-  const TextLine& operator[](size_t n) const { return text_lines_[n]; }
+  TextLine& operator[](size_t n) { return GetLine(n); }
+  const TextLine& operator[](size_t n) const { return GetLine(n); }
 
 private:
-  wxString GetEOL(LineEndType type) const;
+  TextLine& GetFileLine(size_t n) const;
 
-  void ParseTextData(const wxString& text);
+  wxString GetEOL(LineEndType type) const;
 
-  void NotifyLineUpdate(const wxPoint& position, bool is_multi_lines);
+  // The line end of the lines added by splitting the line: its own, or the
+  // one of the line above if it's the last line, which has none.
+  LineEndType GetSplitLineEndType(size_t line) const;
 
-  void InsertLine(const wxString& str, size_t n, LineEndType type = kDefaultLineEndType);
-  void InsertLine(wxPoint& position);
+  static void GetTail(const LineIndex& line_index, size_t* offset, size_t* line_count);
 
-  void DeleteLine(const wxPoint& position);
-  void DeleteLine(size_t n);
+  bool ReadFileLinesAppended(size_t* first_line);
 
-  void InsertString(wxPoint& position, const wxString& str);
-  void DeleteString(const wxPoint& position, const wxString& str);
+  void NotifyLineUpdate(const wxPoint& position, bool is_multi_lines);
+  void NotifyLinesChanged(size_t first_line, size_t old_count, size_t new_count);
+  void NotifyTextChanging();
 
   void ClearRedoCommands();
   void ClearUndoCommands();
@@ -90,11 +210,51 @@ private:
   std::list<EditCommand*> redo_commands_;
   std::list<EditCommand*> undo_commands_;
 
+  // The bytes of the commands in the lists, counted when they're moved
+  // between the lists so the history is never walked.
+  size_t redo_bytes_;
+  size_t undo_bytes_;
+
   std::vector<TextLine> text_lines_;
 
   std::list<TextListener*> text_listeners_;
 
+  int batch_depth_;
+  bool is_batch_changed_;
+  bool is_batch_multi_lines_;
+  wxPoint batch_position_;
+
+  // The lines changed in a batch are [batch_first_line_, batch_end_line_),
+  // which were batch_line_delta_ lines less before the batch.
+  bool is_batch_lines_changed_;
+  size_t batch_first_line_;
+  size_t batch_end_line_;
+  int batch_line_delta_;
+
   wxString path_;
+  bool is_modified_;
+
+  // The bytes of the file read, and where the tail lines start in them, see
+  // ReadAppended(). tail_line_count_ is 0 if the file can't be followed.
+  size_t read_size_;
+  size_t tail_offset_;
+  size_t tail_line_count_;
+
+  size_t trimmed_line_count_;
+
+  // The stamp of the file when it's read or written.
+  unsigned long long file_size_;
+  time_t file_mtime_;
+
+  FileEncoding encoding_;
+  bool has_bom_;
+
+  // NULL unless the text is paged, then it has the lines instead of
+  // text_lines_.
+  PagedText* paged_text_;
+
+  // NULL unless the text is a hex one, then it has the lines instead.
+  HexText* hex_text_;
 };
 
 }  // namespace editor
@@ -0,0 +1,318 @@
+// editor_bench replays edit traces on a TextFile without any GUI and writes
+// the latencies of every kind of edit as JSON:
+//
+//   editor_bench [--scale=<factor>] [--lines=<count>] [--filter=<name>]
+//                [--out=<path>] [<trace>...]
+//
+// The synthetic traces run unless --filter leaves them out. Each trace file
+// (see edit_trace.h) is replayed as a case named after the file. --scale
+// multiplies the number of edits, --lines sets the size of the big files.
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "editor/bench_stats.h"
+#include "editor/edit_command.h"
+#include "editor/edit_trace.h"
+#include "editor/selection_region.h"
+#include "editor/text_file.h"
+
+namespace editor {
+
+const size_t kBigFileLineCount = 1000000;
+
+// A fixed generator, so the synthetic traces are the same in every run.
+class Random {
+public:
+  explicit Random(unsigned int seed) : state_(seed == 0 ? 1 : seed) {}
+
+  size_t Next(size_t n) {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 17;
+    state_ ^= state_ << 5;
+    return n == 0 ? 0 : state_ % n;
+  }
+
+private:
+  unsigned int state_;
+};
+
+static wxString MakeLine(size_t index, size_t length) {
+  static const wxChar* kWords[] = {
+    wxT("int"), wxT("return"), wxT("text_file_"), wxT("="), wxT("line"), wxT("{"),
+    wxT("}"), wxT("GetLineCount()"), wxT("for"), wxT("size_t"), wxT("i"), wxT(";"),
+  };
+  const size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+  wxString line;
+  line.reserve(length + 16);
+  for (size_t i = index; line.Len() < length; ++i) {
+    line.Append(kWords[i % kWordCount]);
+    line.Append(wxT(' '), 1);
+  }
+  line.Truncate(length);
+  return line;
+}
+
+static wxString MakeText(Random* random, size_t line_count, size_t line_length) {
+  wxString text;
+  text.reserve(line_count * (line_length + 1));
+  size_t seed = random->Next(1000);
+  for (size_t i = 0; i < line_count; ++i) {
+    if (i != 0) {
+      text.Append(wxT('\r'), 1);
+    }
+    text.Append(MakeLine(seed + i, line_length));
+  }
+  return text;
+}
+
+static TextFile* NewTextFile(size_t line_count, size_t line_length) {
+  TextFile* text_file = new TextFile();
+  for (size_t i = 0; i < line_count; ++i) {
+    text_file->AddLine(MakeLine(i, line_length));
+  }
+  return text_file;
+}
+
+// Typing a few lines into a 10K-line file with a new line every 60 chars.
+static EditTrace MakeTypingTrace(size_t op_count) {
+  EditTrace trace;
+  trace.SetInitialSize(10000, 60);
+  wxPoint caret(0, 5000);
+  for (size_t i = 0; i < op_count; ++i) {
+    if (caret.x == 60) {
+      trace.AddInsert(caret, wxString(wxT('\r'), 1));
+      caret = wxPoint(0, caret.y + 1);
+    } else {
+      trace.AddInsert(caret, wxString(wxT('a') + static_cast<wxChar>(i % 26), 1));
+      ++caret.x;
+    }
+  }
+  return trace;
+}
+
+// Pasting 100K lines into the middle of a big file and undoing it.
+static EditTrace MakeLargePasteTrace(size_t op_count, size_t line_count) {
+  EditTrace trace;
+  trace.SetInitialSize(line_count, 60);
+  Random random(7);
+  wxString text = MakeText(&random, 100000, 60);
+  for (size_t i = 0; i < op_count; ++i) {
+    trace.AddInsert(wxPoint(30, line_count / 2), text);
+    trace.AddUndo();
+  }
+  return trace;
+}
+
+static void AddRandomEdit(Random* random, size_t line_count, EditTrace* trace) {
+  wxPoint position(random->Next(60), random->Next(line_count));
+  size_t kind = random->Next(10);
+  if (kind < 4) {
+    trace->AddInsert(position, wxString(wxT('x'), 1 + random->Next(8)));
+  } else if (kind < 6) {
+    trace->AddInsert(position, MakeText(random, 2 + random->Next(4), random->Next(60)));
+  } else if (kind < 9) {
+    trace->AddDelete(position, wxPoint(position.x + 1 + random->Next(8), position.y));
+  } else {
+    trace->AddDelete(position, wxPoint(random->Next(60), position.y + 1 + random->Next(4)));
+  }
+}
+
+// Random edits all over a big file.
+static EditTrace MakeRandomEditTrace(size_t op_count, size_t line_count) {
+  EditTrace trace;
+  trace.SetInitialSize(line_count, 60);
+  Random random(11);
+  for (size_t i = 0; i < op_count; ++i) {
+    AddRandomEdit(&random, line_count, &trace);
+  }
+  return trace;
+}
+
+// Random edits, then undoing all of them and redoing them again.
+static EditTrace MakeUndoStormTrace(size_t edit_count, size_t line_count) {
+  EditTrace trace;
+  trace.SetInitialSize(line_count, 60);
+  Random random(13);
+  for (size_t i = 0; i < edit_count; ++i) {
+    AddRandomEdit(&random, line_count, &trace);
+  }
+  for (size_t i = 0; i < edit_count; ++i) {
+    trace.AddUndo();
+  }
+  for (size_t i = 0; i < edit_count; ++i) {
+    trace.AddRedo();
+  }
+  return trace;
+}
+
+static wxPoint ClampPosition(const TextFile* text_file, const wxPoint& position) {
+  wxPoint point(std::max(position.x, 0), std::max(position.y, 0));
+  int last_line = static_cast<int>(text_file->GetLineCount()) - 1;
+  point.y = std::min(point.y, last_line);
+  point.x = std::min(point.x, static_cast<int>(text_file->GetLine(point.y).Len()));
+  return point;
+}
+
+static bool IsBefore(const wxPoint& lhs, const wxPoint& rhs) {
+  return lhs.y < rhs.y || (lhs.y == rhs.y && lhs.x < rhs.x);
+}
+
+// Replay a trace the way the editor makes the edits, and add a case for each
+// kind of edit in it.
+static void ReplayTrace(const std::string& name, const EditTrace& trace, BenchReport* report) {
+  TextFile* text_file = NewTextFile(trace.initial_line_count(), trace.initial_line_length());
+
+  std::vector<BenchStats> stats;
+  for (int i = 0; i < EditTrace::kOpTypeCount; ++i) {
+    EditTrace::OpType type = static_cast<EditTrace::OpType>(i);
+    stats.push_back(BenchStats(name + "." + EditTrace::GetOpName(type)));
+    stats.back().set_unit_name(type == EditTrace::kInsert || type == EditTrace::kDelete ? "chars" : "ops");
+  }
+
+  BenchTimer timer;
+  for (const EditTrace::Op& op : trace.ops()) {
+    size_t units = 1;
+    timer.Restart();
+    if (op.type == EditTrace::kInsert) {
+      wxPoint position = ClampPosition(text_file, op.position);
+      text_file->Execute(new ReplaceTextCommand(text_file, position, wxEmptyString, op.text));
+      units = op.text.Len();
+    } else if (op.type == EditTrace::kDelete) {
+      wxPoint position = ClampPosition(text_file, op.position);
+      wxPoint end_position = ClampPosition(text_file, op.end_position);
+      if (IsBefore(end_position, position)) {
+        std::swap(position, end_position);
+      }
+      wxString text = text_file->GetText(SelectionRegion(position, end_position));
+      text_file->Execute(new ReplaceTextCommand(text_file, position, text, wxEmptyString));
+      units = text.Len();
+    } else if (op.type == EditTrace::kUndo) {
+      text_file->Undo();
+    } else if (op.type == EditTrace::kRedo) {
+      text_file->Redo();
+    }
+    stats[op.type].AddSample(timer.ElapsedMicros());
+    stats[op.type].AddUnits(units);
+  }
+  delete text_file;
+
+  for (const BenchStats& op_stats : stats) {
+    if (op_stats.sample_count() != 0) {
+      report->AddCase(op_stats);
+    }
+  }
+}
+
+// Convert the line ends of a big file back and forth, and undo and redo it.
+static void BenchConvertLineEnds(size_t op_count, size_t line_count, BenchReport* report) {
+  TextFile* text_file = NewTextFile(line_count, 60);
+  BenchStats stats("convert_line_endings");
+  stats.set_unit_name("lines");
+
+  BenchTimer timer;
+  for (size_t i = 0; i < op_count; ++i) {
+    LineEndType type = i % 2 == 0 ? LINE_END_TYPE_DOS : LINE_END_TYPE_UNIX;
+    timer.Restart();
+    text_file->Execute(new ConvertLineEndingsCommand(text_file, type));
+    text_file->Undo();
+    text_file->Redo();
+    stats.AddSample(timer.ElapsedMicros());
+    stats.AddUnits(line_count * 3);
+  }
+  delete text_file;
+  report->AddCase(stats);
+}
+
+static std::string GetBaseName(const std::string& path) {
+  size_t pos = path.find_last_of("/\\");
+  return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+static bool StartsWith(const char* str, const char* prefix, const char** rest) {
+  size_t len = strlen(prefix);
+  if (strncmp(str, prefix, len) != 0) {
+    return false;
+  }
+  *rest = str + len;
+  return true;
+}
+
+static int RunBench(int argc, char** argv) {
+  double scale = 1;
+  size_t line_count = kBigFileLineCount;
+  std::string filter;
+  std::string out_path;
+  std::vector<std::string> trace_paths;
+
+  for (int i = 1; i < argc; ++i) {
+    const char* value = NULL;
+    if (StartsWith(argv[i], "--scale=", &value)) {
+      scale = atof(value);
+    } else if (StartsWith(argv[i], "--lines=", &value)) {
+      line_count = std::max(atol(value), 1L);
+    } else if (StartsWith(argv[i], "--filter=", &value)) {
+      filter = value;
+    } else if (StartsWith(argv[i], "--out=", &value)) {
+      out_path = value;
+    } else if (argv[i][0] == '-') {
+      std::cerr << "Usage: editor_bench [--scale=<factor>] [--lines=<count>] "
+                   "[--filter=<name>] [--out=<path>] [<trace>...]" << std::endl;
+      return 1;
+    } else {
+      trace_paths.push_back(argv[i]);
+    }
+  }
+
+  struct Case {
+    const char* name;
+    EditTrace (*make_trace)(size_t op_count, size_t line_count);
+    size_t op_count;
+  };
+  const Case kCases[] = {
+    { "typing", [](size_t n, size_t) { return MakeTypingTrace(n); }, 200000 },
+    { "large_paste", MakeLargePasteTrace, 20 },
+    { "undo_storm", MakeUndoStormTrace, 20000 },
+    { "random_edits_1m", MakeRandomEditTrace, 100000 },
+  };
+
+  BenchReport report("editor_bench");
+  for (const Case& c : kCases) {
+    if (!filter.empty() && std::string(c.name).find(filter) == std::string::npos) {
+      continue;
+    }
+    size_t op_count = std::max(static_cast<size_t>(c.op_count * scale), static_cast<size_t>(1));
+    ReplayTrace(c.name, c.make_trace(op_count, line_count), &report);
+  }
+  if (filter.empty() || std::string("convert_line_endings").find(filter) != std::string::npos) {
+    size_t op_count = std::max(static_cast<size_t>(10 * scale), static_cast<size_t>(1));
+    BenchConvertLineEnds(op_count, line_count * 5, &report);
+  }
+
+  for (const std::string& path : trace_paths) {
+    EditTrace trace;
+    if (!trace.Read(wxString::FromUTF8(path.c_str()))) {
+      std::cerr << "Can't read the trace " << path << std::endl;
+      return 1;
+    }
+    ReplayTrace(GetBaseName(path), trace, &report);
+  }
+
+  if (out_path.empty()) {
+    report.WriteJson(std::cout);
+  } else {
+    std::ofstream ofs(out_path.c_str());
+    report.WriteJson(ofs);
+  }
+  return 0;
+}
+
+}  // namespace editor
+
+int main(int argc, char** argv) {
+  return editor::RunBench(argc, argv);
+}
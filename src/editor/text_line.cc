@@ -1,18 +1,78 @@
 ﻿#include "editor/text_line.h"
+#include <algorithm>
+#include <utility>
+#include "editor/memory_usage.h"
 
 namespace editor {
 
-TextLine::TextLine() : line_end_type_(kDefaultLineEndType) {
+// Lines of this size or longer cache their wrap breaks.
+const size_t kLongLineSize = 4096;
+
+struct TextLine::WrapCache {
+  int wrap_columns;
+  // The columns where the rows after the first one start.
+  std::vector<size_t> breaks;
+};
+
+// Return the column where the row starting at |start| is broken, or the line
+// length if the rest fits. Break after the last blank of the row if there is
+// one, otherwise in the middle of the word.
+static size_t NextWrapBreak(const wxString& line, size_t start, int wrap_columns) {
+  size_t len = line.Len();
+  size_t columns = wrap_columns < 1 ? 1 : static_cast<size_t>(wrap_columns);
+  if (len - start <= columns) {
+    return len;
+  }
+
+  size_t end = start + columns;
+  for (size_t i = end; i > start; --i) {
+    if (line[i - 1] == wxT(' ') || line[i - 1] == wxT('\t')) {
+      return i;
+    }
+  }
+  return end;
+}
+
+static void WrapLine(const wxString& line, int wrap_columns, std::vector<size_t>* breaks) {
+  breaks->clear();
+  size_t len = line.Len();
+  size_t start = 0;
+  while ((start = NextWrapBreak(line, start, wrap_columns)) != len) {
+    breaks->push_back(start);
+  }
+}
+
+TextLine::TextLine()
+    : line_end_type_(kDefaultLineEndType),
+      wrap_cache_(NULL) {
 }
 
 TextLine::TextLine(const TextLine& text_line)
     : line_data_(text_line.line_data_),
-      line_end_type_(text_line.line_end_type_) {
+      line_end_type_(text_line.line_end_type_),
+      wrap_cache_(NULL) {
+  if (text_line.wrap_cache_ != NULL) {
+    wrap_cache_ = new WrapCache(*text_line.wrap_cache_);
+  }
+}
+
+// Lines are moved instead of copied when the vector of a file grows or lines
+// are inserted before them.
+TextLine::TextLine(TextLine&& text_line) noexcept
+    : line_data_(std::move(text_line.line_data_)),
+      line_end_type_(text_line.line_end_type_),
+      wrap_cache_(text_line.wrap_cache_) {
+  text_line.wrap_cache_ = NULL;
 }
 
 TextLine::TextLine(const wxString& data, LineEndType line_end_type)
     : line_data_(data),
-      line_end_type_(line_end_type) {
+      line_end_type_(line_end_type),
+      wrap_cache_(NULL) {
+}
+
+TextLine::~TextLine() {
+  delete wrap_cache_;
 }
 
 TextLine& TextLine::operator=(const TextLine& text_line) {
@@ -22,7 +82,144 @@ TextLine& TextLine::operator=(const TextLine& text_line) {
 
   line_data_ = text_line.line_data_;
   line_end_type_ = text_line.line_end_type_;
+  delete wrap_cache_;
+  wrap_cache_ = NULL;
+  if (text_line.wrap_cache_ != NULL) {
+    wrap_cache_ = new WrapCache(*text_line.wrap_cache_);
+  }
+  return *this;
+}
+
+TextLine& TextLine::operator=(TextLine&& text_line) noexcept {
+  if (this == &text_line) {
+    return *this;
+  }
+
+  line_data_ = std::move(text_line.line_data_);
+  line_end_type_ = text_line.line_end_type_;
+  delete wrap_cache_;
+  wrap_cache_ = text_line.wrap_cache_;
+  text_line.wrap_cache_ = NULL;
   return *this;
 }
 
+void TextLine::SetData(const wxString& data) {
+  line_data_ = data;
+  delete wrap_cache_;
+  wrap_cache_ = NULL;
+}
+
+void TextLine::Insert(size_t pos, const wxString& str) {
+  line_data_.insert(pos, str);
+  UpdateWrapCache(pos, 0, str.Len());
+}
+
+void TextLine::Remove(size_t pos, size_t count) {
+  count = std::min(count, line_data_.Len() - pos);
+  line_data_.Remove(pos, count);
+  UpdateWrapCache(pos, count, 0);
+}
+
+void TextLine::Append(const wxString& str) {
+  size_t pos = line_data_.Len();
+  line_data_.Append(str);
+  UpdateWrapCache(pos, 0, str.Len());
+}
+
+int TextLine::GetWrapRowCount(int wrap_columns) const {
+  std::vector<size_t> buffer;
+  return static_cast<int>(GetWrapBreaks(wrap_columns, &buffer).size()) + 1;
+}
+
+size_t TextLine::GetWrapRow(int wrap_columns, size_t column) const {
+  std::vector<size_t> buffer;
+  const std::vector<size_t>& breaks = GetWrapBreaks(wrap_columns, &buffer);
+  return std::upper_bound(breaks.begin(), breaks.end(), column) - breaks.begin();
+}
+
+void TextLine::GetWrapRowRange(int wrap_columns, size_t row, size_t* from, size_t* to) const {
+  std::vector<size_t> buffer;
+  const std::vector<size_t>& breaks = GetWrapBreaks(wrap_columns, &buffer);
+  row = std::min(row, breaks.size());
+  *from = (row == 0) ? 0 : breaks[row - 1];
+  *to = (row == breaks.size()) ? line_data_.Len() : breaks[row];
+}
+
+void TextLine::GetMemoryUsage(MemoryUsage* usage) const {
+  usage->Add(MEMORY_LINE_DATA, GetStringMemoryUsage(line_data_));
+  if (wrap_cache_ != NULL) {
+    usage->Add(MEMORY_WRAP_CACHE, sizeof(WrapCache) + GetVectorMemoryUsage(wrap_cache_->breaks));
+  }
+}
+
+// Short lines are wrapped into |buffer| every time.
+const std::vector<size_t>& TextLine::GetWrapBreaks(int wrap_columns,
+                                                   std::vector<size_t>* buffer) const {
+  if (line_data_.Len() < kLongLineSize) {
+    WrapLine(line_data_, wrap_columns, buffer);
+    return *buffer;
+  }
+
+  if (wrap_cache_ == NULL) {
+    wrap_cache_ = new WrapCache;
+    wrap_cache_->wrap_columns = 0;
+  }
+  if (wrap_cache_->wrap_columns != wrap_columns) {
+    wrap_cache_->wrap_columns = wrap_columns;
+    WrapLine(line_data_, wrap_columns, &wrap_cache_->breaks);
+  }
+  return wrap_cache_->breaks;
+}
+
+// [pos, pos + old_count) was replaced by [pos, pos + new_count). A row which
+// starts more than a row before pos can't see the edit, so the rows are
+// wrapped again from there. After the edit, as soon as a break is an old one
+// moved by the edit, the following breaks are the old ones moved too.
+void TextLine::UpdateWrapCache(size_t pos, size_t old_count, size_t new_count) {
+  if (wrap_cache_ == NULL) {
+    return;
+  }
+  if (line_data_.Len() < kLongLineSize) {
+    delete wrap_cache_;
+    wrap_cache_ = NULL;
+    return;
+  }
+
+  std::vector<size_t>& breaks = wrap_cache_->breaks;
+  int wrap_columns = wrap_cache_->wrap_columns;
+  size_t columns = wrap_columns < 1 ? 1 : static_cast<size_t>(wrap_columns);
+
+  size_t first = pos > columns ? pos - columns : 0;
+  size_t keep_count = std::lower_bound(breaks.begin(), breaks.end(), first) - breaks.begin();
+  size_t start = (keep_count == 0) ? 0 : breaks[keep_count - 1];
+
+  size_t len = line_data_.Len();
+  size_t edit_end = pos + new_count;
+  size_t old_index = keep_count;
+  bool is_aligned = false;
+  std::vector<size_t> new_breaks;
+  while ((start = NextWrapBreak(line_data_, start, wrap_columns)) != len) {
+    if (start >= edit_end) {
+      size_t old_start = start + old_count - new_count;
+      while (old_index < breaks.size() && breaks[old_index] < old_start) {
+        ++old_index;
+      }
+      if (old_index < breaks.size() && breaks[old_index] == old_start) {
+        is_aligned = true;
+        break;
+      }
+    }
+    new_breaks.push_back(start);
+  }
+
+  if (!is_aligned) {
+    old_index = breaks.size();
+  }
+  for (size_t i = old_index; i < breaks.size(); ++i) {
+    breaks[i] = breaks[i] + new_count - old_count;
+  }
+  breaks.erase(breaks.begin() + keep_count, breaks.begin() + old_index);
+  breaks.insert(breaks.begin() + keep_count, new_breaks.begin(), new_breaks.end());
+}
+
 }  // namespace editor
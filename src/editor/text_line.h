@@ -2,10 +2,13 @@
 #define EDITOR_TEXT_LINE_H_
 #pragma once
 
+#include <vector>
 #include "wx/string.h"
 
 namespace editor {
 
+class MemoryUsage;
+
 enum LineEndType {
   LINE_END_TYPE_NONE = 0,  // incomplete (the last line of the file only)
   LINE_END_TYPE_UNIX,  // line is terminated with 'LF' = 0xA = 10 = '\n'
@@ -17,31 +20,65 @@ const LineEndType kDefaultLineEndType =
 #if defined(__WINDOWS__)
   LINE_END_TYPE_DOS;
 #elif defined(__UNIX__)
-  TEXT_FILE_TYPE_UNIX;
+  LINE_END_TYPE_UNIX;
 #else
-  TEXT_FILE_TYPE_NONE;
+  LINE_END_TYPE_NONE;
   #error  "wxTextBuffer: unsupported platform."
 #endif
 
+// |count| lines in a row which end the same way.
+struct LineEndRun {
+  size_t count;
+  LineEndType type;
+};
+
 class TextLine {
 public:
   TextLine();
   TextLine(const TextLine& text_line);
+  TextLine(TextLine&& text_line) noexcept;
   TextLine(const wxString& line_string, LineEndType line_end_type = kDefaultLineEndType);
 
+  ~TextLine();
+
   TextLine& operator=(const TextLine& text_line);
+  TextLine& operator=(TextLine&& text_line) noexcept;
 
-  wxString& GetData() { return line_data_; }
   const wxString& GetData() const { return line_data_; }
+  void SetData(const wxString& data);
+
+  void Insert(size_t pos, const wxString& str);
+  void Remove(size_t pos, size_t count);
+  void Append(const wxString& str);
 
   LineEndType GetLineEndType() const { return line_end_type_; }
   void SetLineEndType(LineEndType type) { line_end_type_ = type; }
 
   size_t Len() const { return line_data_.Len(); }
 
+  // Soft wrap at |wrap_columns|. A column is a char of the line, since tabs
+  // are expanded and the font is fixed. Long lines keep the columns where
+  // the rows start, so a row is looked up in O(log n) and an edit rewraps
+  // the rows from the edited one on.
+  int GetWrapRowCount(int wrap_columns) const;
+  size_t GetWrapRow(int wrap_columns, size_t column) const;
+  void GetWrapRowRange(int wrap_columns, size_t row, size_t* from, size_t* to) const;
+
+  // Add the heap memory of the line, not the line object itself.
+  void GetMemoryUsage(MemoryUsage* usage) const;
+
+private:
+  struct WrapCache;
+
+  const std::vector<size_t>& GetWrapBreaks(int wrap_columns, std::vector<size_t>* buffer) const;
+  void UpdateWrapCache(size_t pos, size_t old_count, size_t new_count);
+
 private:
   wxString line_data_;
   LineEndType line_end_type_;
+
+  // NULL unless the line is long and was wrapped.
+  mutable WrapCache* wrap_cache_;
 };
 
 }  // namespace editor
@@ -2,6 +2,8 @@
 #define EDITOR_TEXT_LISTENER_H_
 #pragma once
 
+#include <cstddef>
+
 class wxPoint;
 
 namespace editor {
@@ -11,6 +13,13 @@ public:
   virtual ~TextListener() {}
 
   virtual void OnLineUpdate(const wxPoint& position, bool is_multi_lines) = 0;
+
+  // Called after the lines [first_line, first_line + old_count) are replaced
+  // by the lines [first_line, first_line + new_count), before OnLineUpdate().
+  virtual void OnLinesChanged(size_t first_line, size_t old_count, size_t new_count) {}
+
+  // Called before the text is changed or destroyed.
+  virtual void OnTextChanging() {}
 };
 
 }  // namespace editor
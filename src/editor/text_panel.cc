@@ -6,7 +6,9 @@
 #include "wx/dcbuffer.h"
 #include "editor/text_file.h"
 #include "editor/config.h"
+#include "editor/latency_tracker.h"
 #include "editor/line_number_panel.h"
+#include "editor/minimap_panel.h"
 #include "editor/text_scroll_window.h"
 
 namespace editor {
@@ -15,6 +17,7 @@ wxBEGIN_EVENT_TABLE(TextPanel, wxPanel)
 EVT_PAINT(TextPanel::OnPaint)
 EVT_SIZE(TextPanel::OnSize)
 EVT_KEY_DOWN(TextPanel::OnKeyDown)
+EVT_KEY_UP(TextPanel::OnKeyUp)
 EVT_CHAR(TextPanel::OnChar)
 EVT_LEFT_DOWN(TextPanel::OnMouseLeftDown)
 EVT_MOTION(TextPanel::OnMouseMotion)
@@ -36,9 +39,19 @@ bool TextPanel::Create(TextScrollWindow* parent) {
   return true;
 }
 
+// RefreshRect() also calls it.
+void TextPanel::Refresh(bool erase_background, const wxRect* rect) {
+  wxPanel::Refresh(erase_background, rect);
+  LatencyTracker::Get().AddRefresh();
+}
+
 void TextPanel::ScrollWindow(int dx, int dy, const wxRect* rect) {
   wxPanel::ScrollWindow(dx, dy, rect);
+  LatencyTracker::Get().AddRefresh();
   owner_->GetLineNumberPanel()->ScrollWindow(0, dy, rect);
+  if (dy != 0) {
+    owner_->GetMinimapPanel()->Refresh();
+  }
 }
 
 void TextPanel::OnSize(wxSizeEvent& event) {
@@ -62,18 +75,44 @@ void TextPanel::OnMouseLeftUp(wxMouseEvent& event) {
 }
 
 void TextPanel::OnPaint(wxPaintEvent& event) {
-  wxAutoBufferedPaintDC dc(this);
-  dc.Clear();
-  owner_->PrepareDC(dc);
-  owner_->HandleTextPaint(dc);
+  {
+    wxAutoBufferedPaintDC dc(this);
+    dc.Clear();
+    owner_->PrepareDC(dc);
+    owner_->HandleTextPaint(dc);
+  }
+  // The buffer is on the window after the dc is destroyed.
+  LatencyTracker::Get().AddPaint();
+}
+
+static bool IsModifierKey(int key_code) {
+  return key_code == WXK_SHIFT || key_code == WXK_ALT || key_code == WXK_CONTROL ||
+      key_code == WXK_RAW_CONTROL || key_code == WXK_MENU ||
+      key_code == WXK_WINDOWS_LEFT || key_code == WXK_WINDOWS_RIGHT;
 }
 
+// A keystroke is timed from its key down event. Its char event, if any, is
+// sent after the key down event is skipped, and the input ends after it, or
+// at the latest when the key is released, whether it was handled or not. A
+// modifier key alone changes nothing and isn't timed.
 void TextPanel::OnKeyDown(wxKeyEvent& event) {
+  if (!IsModifierKey(event.GetKeyCode())) {
+    LatencyTracker::Get().BeginInput();
+  }
   owner_->HandleTextKeyDown(event);
+  if (!event.GetSkipped()) {
+    LatencyTracker::Get().EndInput();
+  }
 }
 
 void TextPanel::OnChar(wxKeyEvent& event) {
   owner_->HandleTextKeyChar(event);
+  LatencyTracker::Get().EndInput();
+}
+
+void TextPanel::OnKeyUp(wxKeyEvent& event) {
+  LatencyTracker::Get().EndInput();
+  event.Skip();
 }
 
 }  // namespace editor
@@ -17,12 +17,15 @@ public:
   explicit TextPanel(Config* config);
   bool Create(TextScrollWindow* parent);
 
+  virtual void Refresh(bool erase_background = true, const wxRect* rect = NULL) override;
+
 private:
   virtual void ScrollWindow(int dx, int dy, const wxRect* rect) override;
 
   void OnPaint(wxPaintEvent& event);
   void OnChar(wxKeyEvent& event);
   void OnKeyDown(wxKeyEvent& event);
+  void OnKeyUp(wxKeyEvent& event);
   void OnSize(wxSizeEvent& event);
   void OnMouseLeftDown(wxMouseEvent& event);
   void OnMouseLeftUp(wxMouseEvent& event);
@@ -1,14 +1,30 @@
 ﻿#include "editor/text_scroll_window.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
 #include "wx/sizer.h"
 #include "wx/caret.h"
 #include "wx/dcclient.h"
 #include "wx/msgdlg.h"
+#include "wx/clipboard.h"
+#include "wx/numdlg.h"
+#include "wx/textdlg.h"
+#include "wx/utils.h"
+#include "wx/image.h"
+#include "wx/menu.h"
 #include "editor/line_number_panel.h"
+#include "editor/minimap_panel.h"
 #include "editor/text_file.h"
 #include "editor/text_panel.h"
+#include "editor/trace.h"
 #include "editor/main_frame.h"
 #include "editor/edit_command.h"
+#include "editor/hex_text.h"
 #include "editor/config.h"
+#include "editor/document.h"
+#include "editor/memory_usage.h"
+#include "editor/selection_data_object.h"
+#include "syntax/cpp_parser.h"
 
 namespace editor {
 
@@ -18,18 +34,63 @@ EVT_MENU(wxID_UNDO, TextScrollWindow::OnUndo)
 EVT_MENU(wxID_PASTE, TextScrollWindow::OnPaste)
 EVT_MENU(wxID_COPY, TextScrollWindow::OnCopy)
 EVT_MENU(wxID_CUT, TextScrollWindow::OnCut)
+EVT_MENU(ID_SELECT_ALL_OCCURRENCES, TextScrollWindow::OnSelectAllOccurrences)
+EVT_MENU(ID_WORD_WRAP, TextScrollWindow::OnWordWrap)
+EVT_MENU(wxID_FIND, TextScrollWindow::OnFind)
+EVT_MENU(ID_FIND_NEXT, TextScrollWindow::OnFindNext)
+EVT_MENU(ID_GO_TO_LINE, TextScrollWindow::OnGoToLine)
+EVT_MENU(ID_GO_TO_MATCHING_BRACKET, TextScrollWindow::OnGoToMatchingBracket)
+EVT_MENU(ID_COMPLETE_WORD, TextScrollWindow::OnCompleteWord)
+EVT_MENU(ID_TOGGLE_FOLD, TextScrollWindow::OnToggleFold)
+EVT_MENU(ID_UNFOLD_ALL, TextScrollWindow::OnUnfoldAll)
+EVT_IDLE(TextScrollWindow::OnIdle)
 wxEND_EVENT_TABLE()
 
 const int kDefaultCaretWidth = 1;
 
+// Selections larger than this (in chars) are put on the clipboard without
+// copying the text. It's serialized when another application pastes it.
+const size_t kLazyCopySize = 1024 * 1024;
+
+// The number of lines rewrapped in one idle event after a resize.
+const size_t kWrapLinesPerIdle = 5000;
+
+// The number of lines lexed for word completion in one idle event.
+const size_t kCompletionLinesPerIdle = 5000;
+
+// The most words offered to complete a word.
+const size_t kMaxCompletionCount = 12;
+
+// The height in pixels of a minimap row if the panel has room for all rows.
+const int kMinimapRowHeight = 2;
+
+static bool IsRegionBefore(const SelectionRegion& lhs, const SelectionRegion& rhs) {
+  const wxPoint& l = lhs.start_pos();
+  const wxPoint& r = rhs.start_pos();
+  return l.y < r.y || (l.y == r.y && l.x < r.x);
+}
+
+static bool IsCursorBeforeLine(const Cursor& cursor, int line) {
+  return cursor.caret_pos().y < line;
+}
+
+static bool IsLineBeforeCursor(int line, const Cursor& cursor) {
+  return line < cursor.caret_pos().y;
+}
+
 TextScrollWindow::TextScrollWindow(Config* config)
     : config_(config),
       caret_pos_(0, 0),
       selection_start_(0, 0),
       selection_text_(wxT("")),
+      is_block_selecting_(false),
+      block_column_(0),
+      extra_selection_span_(0),
       line_number_panel_(NULL),
       text_panel_(NULL),
+      minimap_panel_(NULL),
       text_file_(NULL),
+      document_(NULL),
       char_width_(0),
       char_height_(0),
       line_padding_(0),
@@ -37,11 +98,21 @@ TextScrollWindow::TextScrollWindow(Config* config)
       client_height_(0),
       vscroll_pos_(0),
       hscroll_pos_(0),
-      is_file_changed_(false),
-      is_new_file_(true) {
+      line_number_digit_count_(1),
+      top_line_(0),
+      is_word_wrap_(false),
+      has_bracket_match_(false),
+      bracket_pos_(0, 0),
+      bracket_match_pos_(0, 0),
+      is_editing_(false),
+      is_caret_following_(false) {
 }
 
 TextScrollWindow::~TextScrollWindow() {
+  if (document_ != NULL) {
+    DetachTextFile();
+    document_->RemoveView(this);
+  }
 }
 
 bool TextScrollWindow::Create(wxWindow* parent,
@@ -66,9 +137,15 @@ bool TextScrollWindow::Create(wxWindow* parent,
   text_panel_->SetCaret(new wxCaret(text_panel_, kDefaultCaretWidth, char_height_));
   text_panel_->GetCaret()->Show();
 
+  MinimapPanel* minimap_panel = new MinimapPanel();
+  minimap_panel_ = minimap_panel;
+  minimap_panel_->Create(this);
+  minimap_panel_->SetInitialSize(wxSize(Minimap::kColumnCount, 0));
+
   wxBoxSizer* hsizer = new wxBoxSizer(wxHORIZONTAL);
   hsizer->Add(line_number_panel, 0, wxEXPAND);
   hsizer->Add(text_panel, 1, wxEXPAND | wxLEFT, 2);
+  hsizer->Add(minimap_panel, 0, wxEXPAND | wxLEFT, 2);
   SetSizer(hsizer);
 
   SetScrollRate(char_width_, char_height_);
@@ -80,6 +157,7 @@ bool TextScrollWindow::Create(wxWindow* parent,
 void TextScrollWindow::Init() {
   line_number_panel_ = NULL;
   text_panel_ = NULL;
+  minimap_panel_ = NULL;
   text_file_ = NULL;
   char_width_ = 0;
   char_height_ = 0;
@@ -88,23 +166,29 @@ void TextScrollWindow::Init() {
   client_height_ = 0;
   vscroll_pos_ = 0;
   hscroll_pos_ = 0;
-  is_file_changed_ = false;
-  is_new_file_ = true;
 }
 
 void TextScrollWindow::InitMenuShortcut() {
-  const int kEntryCount = 5;
+  const int kEntryCount = 12;
   wxAcceleratorEntry entries[kEntryCount];
   entries[0].Set(wxACCEL_CTRL, (int)'Z', wxID_UNDO);
   entries[1].Set(wxACCEL_CTRL, (int)'Y', wxID_REDO);
   entries[2].Set(wxACCEL_CTRL, (int)'C', wxID_COPY);
   entries[3].Set(wxACCEL_CTRL, (int)'X', wxID_CUT);
   entries[4].Set(wxACCEL_CTRL, (int)'V', wxID_PASTE);
+  entries[5].Set(wxACCEL_CTRL | wxACCEL_SHIFT, (int)'L', ID_SELECT_ALL_OCCURRENCES);
+  entries[6].Set(wxACCEL_CTRL, (int)'F', wxID_FIND);
+  entries[7].Set(wxACCEL_NORMAL, WXK_F3, ID_FIND_NEXT);
+  entries[8].Set(wxACCEL_CTRL, (int)'G', ID_GO_TO_LINE);
+  entries[9].Set(wxACCEL_CTRL | wxACCEL_SHIFT, (int)'[', ID_TOGGLE_FOLD);
+  entries[10].Set(wxACCEL_CTRL, (int)']', ID_GO_TO_MATCHING_BRACKET);
+  entries[11].Set(wxACCEL_CTRL, WXK_SPACE, ID_COMPLETE_WORD);
   wxAcceleratorTable accel(kEntryCount, entries);
   SetAcceleratorTable(accel);
 }
 
 void TextScrollWindow::HandleLineNumberPaint(wxDC& dc) {
+  TRACE_SCOPE("TextScrollWindow::HandleLineNumberPaint");
   //size_t line_count = (text_file_ == NULL) ? 1 : text_file_->GetLineCount();
   //for (size_t i = 0; i != line_count; i++) {
   //  wxPoint point = GetViewStart();
@@ -113,71 +197,114 @@ void TextScrollWindow::HandleLineNumberPaint(wxDC& dc) {
   //  dc.DrawText(wxString::Format(wxT("%u"), i + 1), x, y);
   //}
 
-  size_t line_count = (text_file_ == NULL) ? 1 : text_file_->GetLineCount();
-  for (size_t i = 0; i != line_count; ++i) {
-    wxPoint point = GetViewStart();
+  // Only the numbers of the visible lines are drawn.
+  int line_count = (text_file_ == NULL) ? 1 : text_file_->GetLineCount();
+  int first_row = GetViewStart().y;
+  int end_row = first_row + client_height_ / char_height_ + 2;
+  int line = RowToLine(first_row);
+  for (int row = LineToRow(line); line < line_count && row < end_row;) {
     int panel_width = line_number_panel_->GetSize().GetWidth();
-    const int KLeftPadding = 0.5 * char_width_;
     const int kRightPadding = 1.5 * char_width_;
-    wxCoord x = panel_width - kRightPadding - char_width_ * CountDigitNumber(i + 1);
-    wxCoord y = i * char_height_ + line_padding_;
-    dc.DrawText(wxString::Format(wxT("%u"), i + 1), x, y);
+    wxCoord x = panel_width - kRightPadding - char_width_ * CountDigitNumber(line + 1);
+    wxCoord y = row * char_height_ + line_padding_;
+    dc.DrawText(wxString::Format(wxT("%u"), line + 1), x, y);
+    row += GetLineRowCount(line);
+    line = static_cast<int>(fold_index_.GetNextShownLine(line));
   }
 }
 
-// TODO : Need to be optimized after syntax highlighting.
-void TextScrollWindow::HandleTextPaint(wxDC& dc) {
-  if (text_file_ == NULL) {
+// The bitmap is made again only when a tile is built or the panel is
+// resized. The lines in the window are framed.
+void TextScrollWindow::HandleMinimapPaint(wxDC& dc) {
+  TRACE_SCOPE("TextScrollWindow::HandleMinimapPaint");
+  if (text_file_ == NULL || !minimap_.is_active()) {
+    return;
+  }
+  int height = GetMinimapHeight();
+  if (height <= 0) {
     return;
   }
 
-  wxColor norm_bg_color(wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOW));;
-  wxColor selected_bg_color(0xFFD6AD);
+  bool is_changed = minimap_.CopyPixels(&minimap_pixels_);
+  if (is_changed || !minimap_bitmap_.IsOk() || minimap_bitmap_.GetHeight() != height) {
+    int row_count = static_cast<int>(minimap_.row_count());
+    wxImage image(Minimap::kColumnCount, row_count);
+    unsigned char* data = image.GetData();
+    for (size_t i = 0; i < minimap_pixels_.size(); ++i) {
+      unsigned char grey = 255 - minimap_pixels_[i];
+      data[3 * i] = grey;
+      data[3 * i + 1] = grey;
+      data[3 * i + 2] = grey;
+    }
+    minimap_bitmap_ = wxBitmap(image.Scale(Minimap::kColumnCount, height, wxIMAGE_QUALITY_HIGH));
+  }
+  dc.DrawBitmap(minimap_bitmap_, 0, 0);
+
+  int first_row = GetViewStart().y;
+  int first_line = RowToLine(first_row);
+  int end_line = RowToLine(first_row + client_height_ / char_height_) + 1;
+  int top = MinimapLineToY(first_line, height);
+  int bottom = MinimapLineToY(end_line, height);
+  dc.SetPen(*wxGREY_PEN);
+  dc.SetBrush(*wxTRANSPARENT_BRUSH);
+  dc.DrawRectangle(0, top, Minimap::kColumnCount, std::max(bottom - top, 2));
+}
 
-  // Draw white background.
-  dc.SetPen(*wxTRANSPARENT_PEN);
-  dc.SetBrush(norm_bg_color);
-  for (size_t i = 0; i != text_file_->GetLineCount(); i++) {
-    wxCoord x = 0;
-    wxCoord y = i * char_height_ + line_padding_;
-    wxCoord width = char_width_ * (text_file_->GetLine(i).Len() + 1);
-    wxCoord height = char_height_;
-    dc.DrawRectangle(x, y, width, height);
+// Scroll the line under the point to the middle of the window.
+void TextScrollWindow::HandleMinimapMouse(const wxPoint& point) {
+  if (text_file_ == NULL || !minimap_.is_active()) {
+    return;
+  }
+  int height = GetMinimapHeight();
+  if (height <= 0) {
+    return;
   }
 
-  // Draw selected background.
-  dc.SetBrush(selected_bg_color);
-  wxPoint start = selection_region_.start_pos();
-  wxPoint end = selection_region_.end_pos();
-  for (int i = start.y; i <= end.y; i++) {
-    wxCoord x = 0;
-    wxCoord y = i * char_height_ + line_padding_;
-    wxCoord width = char_width_ * (text_file_->GetLine(i).Len() + 1);
-    wxCoord height = char_height_;
-
-    if (i == start.y) {
-      x = start.x * char_width_;
-      if (end.y > start.y) {
-        width = width - start.x * char_width_;
-      } else {
-        width = (end.x - start.x) * char_width_;
-      }
-      dc.DrawRectangle(x, y, width, height);
-    } else if (i == end.y) {
-      width = char_width_ * end.x;
-      dc.DrawRectangle(x, y, width, height);
-    } else {
-      dc.DrawRectangle(x, y, width, height);
-    }
+  long long y = std::min(std::max(point.y, 0), height - 1);
+  size_t line = static_cast<size_t>(y * minimap_.row_count() * minimap_.lines_per_row() / height);
+  line = fold_index_.GetShownLine(std::min(line, text_file_->GetLineCount() - 1));
+  vscroll_pos_ = std::max(LineToRow(static_cast<int>(line)) - client_height_ / char_height_ / 2, 0);
+  Scroll(hscroll_pos_, vscroll_pos_);
+}
+
+int TextScrollWindow::GetMinimapHeight() const {
+  int row_height = static_cast<int>(minimap_.row_count()) * kMinimapRowHeight;
+  return std::min(minimap_panel_->GetClientSize().GetHeight(), row_height);
+}
+
+int TextScrollWindow::MinimapLineToY(int line, int height) const {
+  long long line_count = minimap_.row_count() * minimap_.lines_per_row();
+  return static_cast<int>(static_cast<long long>(line) * height / line_count);
+}
+
+// TODO : Need to be optimized after syntax highlighting.
+void TextScrollWindow::HandleTextPaint(wxDC& dc) {
+  TRACE_SCOPE("TextScrollWindow::HandleTextPaint");
+  if (text_file_ == NULL) {
+    return;
+  }
+
+  // Only the visible rows are drawn.
+  WrapVisibleLines();
+  int line_count = text_file_->GetLineCount();
+  int first_row = GetViewStart().y;
+  int end_row = first_row + client_height_ / char_height_ + 2;
+  int first_line = RowToLine(first_row);
+  int line = first_line;
+  for (int row = LineToRow(line); line < line_count && row < end_row;) {
+    DrawLine(dc, line, row);
+    row += GetLineRowCount(line);
+    line = static_cast<int>(fold_index_.GetNextShownLine(line));
   }
 
-  // Draw text.
-  for (size_t i = 0; i != text_file_->GetLineCount(); i++) {
-    wxCoord x = 0;
-    wxCoord y = i * char_height_ + line_padding_;
-    wxString current_line = (*text_file_)[i].GetData();
-    current_line.Replace(wxT("\t"), wxT(" "), true);
-    dc.DrawText(current_line, x, y);
+  // Draw the extra carets on the lines drawn. The primary one is the wxCaret
+  // of the text panel.
+  dc.SetPen(*wxBLACK_PEN);
+  std::vector<Cursor>::const_iterator it =
+      std::lower_bound(extra_cursors_.begin(), extra_cursors_.end(), first_line, IsCursorBeforeLine);
+  for (; it != extra_cursors_.end() && it->caret_pos().y < line; ++it) {
+    wxPoint point = TextCoordsToLogicalCoords(it->caret_pos());
+    dc.DrawLine(point.x, point.y + line_padding_, point.x, point.y + char_height_ - line_padding_);
   }
 
   //for (wxRegionIterator upd(text_panel_->GetUpdateRegion()); upd; ++upd) {
@@ -217,13 +344,145 @@ void TextScrollWindow::HandleTextPaint(wxDC& dc) {
   //        (wxSYS_COLOUR_WINDOWTEXT));
 }
 
+// Draw the visible part of a line, which starts at |row|. A long line is
+// never copied or drawn as a whole, only the columns in the window are.
+void TextScrollWindow::DrawLine(wxDC& dc, int line, int row) {
+  wxColor norm_bg_color(wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOW));
+  wxColor selected_bg_color(0xFFD6AD);
+  wxColor bracket_bg_color(0xB0E8B0);
+
+  const wxString& line_data = text_file_->GetLine(line).GetData();
+  wxPoint view_start = GetViewStart();
+  int first_sub_row = std::max(view_start.y - row, 0);
+  int end_sub_row = std::min(view_start.y + client_height_ / char_height_ + 2 - row,
+                             GetLineRowCount(line));
+  size_t first_column = view_start.x;
+  size_t column_count = client_width_ / char_width_ + 2;
+
+  // The extra carets whose selections may have the line.
+  std::vector<Cursor>::const_iterator first_cursor =
+      std::lower_bound(extra_cursors_.cbegin(), extra_cursors_.cend(),
+                       line - extra_selection_span_, IsCursorBeforeLine);
+  std::vector<Cursor>::const_iterator end_cursor =
+      std::upper_bound(first_cursor, extra_cursors_.cend(),
+                       line + extra_selection_span_, IsLineBeforeCursor);
+
+  for (int i = first_sub_row; i < end_sub_row; ++i) {
+    size_t from = 0;
+    size_t to = 0;
+    GetRowRange(line, i, &from, &to);
+    wxCoord y = (row + i) * char_height_ + line_padding_;
+
+    // The visible columns of the row, the line end included.
+    size_t visible_from = from + first_column;
+    size_t visible_to = std::min(to + 1, visible_from + column_count);
+    if (visible_from >= visible_to) {
+      continue;
+    }
+    wxCoord x = (visible_from - from) * char_width_;
+
+    // Draw white background.
+    dc.SetPen(*wxTRANSPARENT_PEN);
+    dc.SetBrush(norm_bg_color);
+    dc.DrawRectangle(x, y, (visible_to - visible_from) * char_width_, char_height_);
+
+    // Draw selected background.
+    dc.SetBrush(selected_bg_color);
+    bool is_last_row = (i == GetLineRowCount(line) - 1);
+    DrawSelectionBackground(dc, selection_region_, line, is_last_row, from, to, y);
+    for (std::vector<Cursor>::const_iterator it = first_cursor; it != end_cursor; ++it) {
+      if (it->HasSelection()) {
+        DrawSelectionBackground(dc, it->GetSelectionRegion(), line, is_last_row, from, to, y);
+      }
+    }
+
+    // Draw the bracket at the caret and its match.
+    if (has_bracket_match_) {
+      dc.SetBrush(bracket_bg_color);
+      wxPoint brackets[2] = { bracket_pos_, bracket_match_pos_ };
+      for (int j = 0; j < 2; ++j) {
+        size_t column = brackets[j].x;
+        if (brackets[j].y == line && column >= visible_from && column < std::min(to, visible_to)) {
+          dc.DrawRectangle((column - from) * char_width_, y, char_width_, char_height_);
+        }
+      }
+    }
+
+    // Draw text.
+    if (visible_from < to) {
+      wxString text = line_data.Mid(visible_from, std::min(to, visible_to) - visible_from);
+      text.Replace(wxT("\t"), wxT(" "), true);
+      dc.DrawText(text, x, y);
+    }
+  }
+
+  // A folded line ends with a mark of the lines it hides.
+  if (fold_index_.IsFolded(line) && first_sub_row < end_sub_row &&
+      end_sub_row == GetLineRowCount(line)) {
+    size_t from = 0;
+    size_t to = 0;
+    GetRowRange(line, end_sub_row - 1, &from, &to);
+    wxCoord x = (to - from + 1) * char_width_;
+    wxCoord y = (row + end_sub_row - 1) * char_height_ + line_padding_;
+    dc.SetTextForeground(*wxLIGHT_GREY);
+    dc.DrawText(wxT("..."), x, y);
+    dc.SetTextForeground(wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOWTEXT));
+  }
+}
+
+// Draw the selected part of the row [from, to) of a line at |y|.
+void TextScrollWindow::DrawSelectionBackground(wxDC& dc,
+                                               const SelectionRegion& region,
+                                               int line,
+                                               bool is_last_row,
+                                               size_t from,
+                                               size_t to,
+                                               wxCoord y) {
+  wxPoint start = region.start_pos();
+  wxPoint end = region.end_pos();
+  if (line < start.y || line > end.y) {
+    return;
+  }
+
+  // The selected columns. The line end is selected too if the selection goes
+  // on to the next line, and a rectangle may be wider than the line.
+  size_t selected_from = 0;
+  size_t selected_to = text_file_->GetLine(line).Len() + 1;
+  if (region.is_rectangular()) {
+    selected_from = start.x;
+    selected_to = end.x;
+  } else {
+    if (line == start.y) {
+      selected_from = start.x;
+    }
+    if (line == end.y) {
+      selected_to = end.x;
+    }
+  }
+
+  // Clip to the row and to the window.
+  size_t first_column = from + GetViewStart().x;
+  size_t end_column = first_column + client_width_ / char_width_ + 2;
+  size_t x_from = std::max(std::max(selected_from, from), first_column);
+  size_t x_to = std::min(is_last_row ? selected_to : std::min(selected_to, to), end_column);
+  if (x_from < x_to) {
+    wxCoord x = (x_from - from) * char_width_;
+    dc.DrawRectangle(x, y, (x_to - x_from) * char_width_, char_height_);
+  }
+}
+
 void TextScrollWindow::HandleTextKeyDown(wxKeyEvent& event) {
+  TRACE_SCOPE("TextScrollWindow::HandleTextKeyDown");
   if (text_file_ == NULL) {
-    SetTextFile(wxT("temp"));
+    return;
   }
   wxChar ch = event.GetKeyCode();
 
-  if (ch == WXK_UP || ch == WXK_DOWN || ch == WXK_LEFT || ch == WXK_RIGHT ||
+  if (event.ControlDown() && event.AltDown() && (ch == WXK_UP || ch == WXK_DOWN)) {
+    AddCursorOnLine(ch == WXK_UP ? -1 : 1);
+  } else if (ch == WXK_ESCAPE) {
+    ClearExtraCursors();
+  } else if (ch == WXK_UP || ch == WXK_DOWN || ch == WXK_LEFT || ch == WXK_RIGHT ||
       ch == WXK_HOME || ch == WXK_END || ch == WXK_PAGEDOWN || ch == WXK_PAGEUP) {
     MoveCaret(ch);
   } else if (ch == WXK_RETURN || ch == WXK_TAB) {
@@ -239,6 +498,7 @@ void TextScrollWindow::HandleTextKeyDown(wxKeyEvent& event) {
 }
 
 void TextScrollWindow::HandleTextKeyChar(wxKeyEvent& event) {
+  TRACE_SCOPE("TextScrollWindow::HandleTextKeyChar");
   wxChar ch = event.GetUnicodeKey();
   InsertChar(ch);
 }
@@ -250,8 +510,23 @@ void TextScrollWindow::HandleTextMouseLeftDown(wxMouseEvent& event) {
     return;
   }
   text_panel_->SetFocus();
+  // Ctrl + click adds a caret, a plain click drops the extra ones. The
+  // start of a block selection may be past the end of its line.
+  if (event.ControlDown()) {
+    wxPoint anchor_pos = HasSelection() ? selection_start_ : caret_pos_;
+    anchor_pos.x = std::min(anchor_pos.x, static_cast<int>(text_file_->GetLine(anchor_pos.y).Len()));
+    extra_cursors_.push_back(Cursor(caret_pos_, anchor_pos));
+  } else {
+    ClearExtraCursors();
+  }
   caret_pos_ = DeviceCoordsToTextCoords(event.GetPosition());
   selection_start_ = caret_pos_;
+  is_block_selecting_ = event.AltDown() && !event.ControlDown();
+  if (is_block_selecting_) {
+    block_column_ = DeviceCoordsToColumn(event.GetPosition());
+    selection_start_.x = block_column_;
+  }
+  NormalizeCursors();
   UpdateCaret();
   UpdateSelectionRegion();
 }
@@ -273,6 +548,9 @@ void TextScrollWindow::HandleTextMouseMotion(wxMouseEvent& event) {
 
   if (event.Dragging() && event.LeftIsDown()) {
     caret_pos_ = DeviceCoordsToTextCoords(event.GetPosition());
+    if (is_block_selecting_) {
+      block_column_ = DeviceCoordsToColumn(event.GetPosition());
+    }
     UpdateCaret();
     UpdateSelectionRegion();
     if (!text_panel_->HasCapture()) {
@@ -286,6 +564,17 @@ bool TextScrollWindow::HasSelection() const {
 }
 
 void TextScrollWindow::UpdateSelectionRegion() {
+  if (is_block_selecting_) {
+    wxPoint start(std::min(selection_start_.x, block_column_), std::min(selection_start_.y, caret_pos_.y));
+    wxPoint end(std::max(selection_start_.x, block_column_), std::max(selection_start_.y, caret_pos_.y));
+    selection_region_.set_start_pos(start);
+    selection_region_.set_end_pos(end);
+    selection_region_.set_rectangular(true);
+    text_panel_->Refresh();
+    return;
+  }
+
+  selection_region_.set_rectangular(false);
   if (selection_start_.y > caret_pos_.y) {
     selection_region_.set_start_pos(caret_pos_);
     selection_region_.set_end_pos(selection_start_);
@@ -305,34 +594,41 @@ void TextScrollWindow::UpdateSelectionRegion() {
 
 void TextScrollWindow::ClearSelectionRegion() {
   wxPoint pos = selection_region_.start_pos();
+  if (selection_region_.is_rectangular()) {
+    pos = caret_pos_;
+    selection_region_.set_rectangular(false);
+    is_block_selecting_ = false;
+  }
   selection_region_.set_start_pos(pos);
   selection_region_.set_end_pos(pos);
   text_panel_->Refresh();
 }
 
+// With several carets the selections are joined line by line in document order.
 void TextScrollWindow::UpdateSelectionText() {
-  wxPoint start = selection_region_.start_pos();
-  wxPoint end = selection_region_.end_pos();
-
-  if (end.y - start.y == 0) {
-    wxString& line = text_file_->GetLine(start.y).GetData();
-    selection_text_ = line.SubString(start.x, end.x - 1);
+  selection_text_ = text_file_->GetText(selection_region_);
+  if (!HasExtraCursors()) {
     return;
-  } 
+  }
 
-  selection_text_.Clear();
+  std::vector<SelectionRegion> regions;
+  regions.push_back(selection_region_);
+  for (const Cursor& cursor : extra_cursors_) {
+    if (cursor.HasSelection()) {
+      regions.push_back(cursor.GetSelectionRegion());
+    }
+  }
+  std::sort(regions.begin(), regions.end(), IsRegionBefore);
 
-  for (int i = start.y; i <= end.y; ++i) {
-    wxString& line = text_file_->GetLine(i).GetData();
-    if (i == start.y) {
-      selection_text_.Append(line.SubString(start.x, line.Len()));
-      selection_text_.Append('\r', 1);
-    } else if (i == end.y) {
-      selection_text_.Append(line.SubString(0, end.x - 1));
-    } else {
-      selection_text_.Append(line);
+  selection_text_.Clear();
+  for (const SelectionRegion& region : regions) {
+    if (region.IsEmpty()) {
+      continue;
+    }
+    if (!selection_text_.IsEmpty()) {
       selection_text_.Append('\r', 1);
     }
+    selection_text_.Append(text_file_->GetText(region));
   }
 }
 
@@ -341,40 +637,168 @@ void TextScrollWindow::ClearSelectionText() {
 }
 
 void TextScrollWindow::DeleteSelectionText() {
+  if (HasExtraCursors()) {
+    EditAtCursors(wxEmptyString, 0);
+    return;
+  }
+  if (selection_region_.is_rectangular()) {
+    DeleteBlockSelectionText();
+    return;
+  }
   UpdateSelectionText();
   ClearSelectionRegion();
   EditCommand* command = new DeleteTextCommand(text_file_, selection_region_.start_pos(), selection_text_);
-  text_file_->Execute(command);
+  Execute(command);
+}
+
+// Delete the block row by row as one command.
+void TextScrollWindow::DeleteBlockSelectionText() {
+  wxPoint start = selection_region_.start_pos();
+  wxPoint end = selection_region_.end_pos();
+
+  std::vector<ReplaceTextCommand*> commands;
+  for (int i = start.y; i <= end.y; ++i) {
+    size_t from = 0;
+    size_t count = 0;
+    selection_region_.GetLineRange(i, text_file_->GetLine(i).Len(), &from, &count);
+    if (count != 0) {
+      wxString text = text_file_->GetLine(i).GetData().Mid(from, count);
+      commands.push_back(new ReplaceTextCommand(text_file_, wxPoint(from, i), text, wxEmptyString));
+    }
+  }
+
+  caret_pos_ = wxPoint(start.x, start.y);
+  CheckColumnBounds();
+  ClearSelectionRegion();
+
+  if (!commands.empty()) {
+    Execute(new CompositeEditCommand(text_file_, commands));
+  }
+  caret_pos_ = wxPoint(start.x, start.y);
+  CheckColumnBounds();
+  UpdateCaret();
+}
+
+// Paste the rows of a block at the caret column of successive lines. Short
+// lines are padded with spaces and lines are added after the end if needed.
+void TextScrollWindow::PasteBlockText(const wxString& text) {
+  std::vector<ReplaceTextCommand*> commands;
+  size_t line_count = text_file_->GetLineCount();
+  size_t column = caret_pos_.x;
+  size_t line = caret_pos_.y;
+  wxString tail;
+
+  size_t row_start = 0;
+  while (row_start <= text.Len()) {
+    size_t row_end = text.find('\r', row_start);
+    if (row_end == wxString::npos) {
+      row_end = text.Len();
+    }
+    wxString row = text.Mid(row_start, row_end - row_start);
+
+    if (line < line_count) {
+      size_t len = text_file_->GetLine(line).Len();
+      if (len < column) {
+        row.insert(0, column - len, ' ');
+      }
+      wxPoint position(std::min(column, len), line);
+      commands.push_back(new ReplaceTextCommand(text_file_, position, wxEmptyString, row));
+    } else {
+      tail.append(1, '\r');
+      tail.append(column, ' ');
+      tail.append(row);
+    }
+
+    ++line;
+    row_start = row_end + 1;
+  }
+
+  if (!tail.IsEmpty()) {
+    wxPoint position(text_file_->GetLine(line_count - 1).Len(), line_count - 1);
+    commands.push_back(new ReplaceTextCommand(text_file_, position, wxEmptyString, tail));
+  }
+
+  wxPoint caret_pos = caret_pos_;
+  Execute(new CompositeEditCommand(text_file_, commands));
+  caret_pos_ = caret_pos;
+  UpdateCaret();
 }
 
 // Handle the TextPanel resize event.
 
 void TextScrollWindow::HandleTextSize(wxSizeEvent& event) {
+  TRACE_SCOPE("TextScrollWindow::HandleTextSize");
   text_panel_->GetClientSize(&client_width_, &client_height_);
+  // Rewrap the visible lines now and the others when idle.
+  if (wrap_index_.is_active() && wrap_index_.SetWrapColumns(GetWrapColumns())) {
+    WrapVisibleLines();
+    text_panel_->Refresh();
+    line_number_panel_->Refresh();
+  }
   RefreshScrollbars();
+  minimap_panel_->Refresh();
  // RefreshLines(caret_pos_.y, false);
 }
 
 // Transform text coords into logical coords.
 
 wxPoint TextScrollWindow::TextCoordsToLogicalCoords(const wxPoint& point) const {
+  wxPoint row_point = TextCoordsToRowCoords(point);
   wxPoint logical_point;
-  logical_point.x = point.x * char_width_;
-  logical_point.y = point.y * char_height_;
+  logical_point.x = row_point.x * char_width_;
+  logical_point.y = row_point.y * char_height_;
   return logical_point;
 }
 
+// Transform text coords into the column in the row and the row.
+
+wxPoint TextScrollWindow::TextCoordsToRowCoords(const wxPoint& point) const {
+  if (!wrap_index_.is_active()) {
+    return wxPoint(point.x, LineToRow(point.y));
+  }
+  const TextLine& text_line = text_file_->GetLine(point.y);
+  int sub_row = text_line.GetWrapRow(wrap_index_.wrap_columns(), point.x);
+  sub_row = std::max(std::min(sub_row, GetLineRowCount(point.y) - 1), 0);
+
+  size_t from = 0;
+  size_t to = 0;
+  GetRowRange(point.y, sub_row, &from, &to);
+  return wxPoint(point.x - from, LineToRow(point.y) + sub_row);
+}
+
+wxPoint TextScrollWindow::RowCoordsToTextCoords(const wxPoint& point) const {
+  if (!wrap_index_.is_active()) {
+    return wxPoint(point.x, RowToLine(point.y));
+  }
+  int line = RowToLine(point.y);
+  int row_count = GetLineRowCount(line);
+  int sub_row = std::min(point.y - LineToRow(line), row_count - 1);
+
+  size_t from = 0;
+  size_t to = 0;
+  GetRowRange(line, sub_row, &from, &to);
+
+  // The column of a break is the start of the next row, stay on this one.
+  size_t x = from + point.x;
+  if (sub_row != row_count - 1 && x >= to) {
+    x = to - 1;
+  }
+  return wxPoint(x, line);
+}
+
 // Transform device coords into text coords.
 
 wxPoint TextScrollWindow::DeviceCoordsToTextCoords(const wxPoint& point) const {
-  wxPoint text_point = point;
-
-  text_point.x = point.x / char_width_ + GetViewStart().x;
-  text_point.y = point.y / char_height_ + GetViewStart().y;
+  wxPoint row_point;
+  row_point.x = point.x / char_width_ + GetViewStart().x;
+  row_point.y = point.y / char_height_ + GetViewStart().y;
 
-  if (text_point.y >= text_file_->GetLineCount()) {
+  wxPoint text_point;
+  if (row_point.y >= GetRowCount()) {
     text_point.y = text_file_->GetLineCount() - 1;
     text_point.x = text_file_->GetLine(text_point.y).Len();
+  } else {
+    text_point = RowCoordsToTextCoords(row_point);
   }
   if (text_point.x > text_file_->GetLine(text_point.y).Len()) {
     text_point.x = text_file_->GetLine(text_point.y).Len();
@@ -385,7 +809,31 @@ wxPoint TextScrollWindow::DeviceCoordsToTextCoords(const wxPoint& point) const {
   return text_point;
 }
 
+// Transform device coords into a column which may be after the line end.
+
+int TextScrollWindow::DeviceCoordsToColumn(const wxPoint& point) const {
+  int column = point.x / char_width_ + GetViewStart().x;
+  return column < 0 ? 0 : column;
+}
+
 void TextScrollWindow::OnLineUpdate(const wxPoint& position, bool is_multi_lines) {
+  TRACE_SCOPE("TextScrollWindow::OnLineUpdate");
+  // The text is edited by another view. Its rows are refreshed already and
+  // the caret is kept where it is.
+  if (!is_editing_) {
+    RefreshScrollbars();
+    if (is_multi_lines) {
+      RefreshLineNumber();
+    }
+    if (is_caret_following_) {
+      is_caret_following_ = false;
+      UpdateCaret();
+    } else {
+      PlaceCaret();
+    }
+    return;
+  }
+
   caret_pos_ = position;
   RefreshLines(position.y, is_multi_lines);
   RefreshScrollbars();
@@ -395,22 +843,138 @@ void TextScrollWindow::OnLineUpdate(const wxPoint& position, bool is_multi_lines
   UpdateCaret();
 }
 
+void TextScrollWindow::OnLinesChanged(size_t first_line, size_t old_count, size_t new_count) {
+  TRACE_SCOPE("TextScrollWindow::OnLinesChanged");
+  int row_count = GetRowCount();
+  int top_line = RowToLine(GetViewStart().y);
+  bool is_unfolded = fold_index_.OnLinesChanged(first_line, old_count, new_count);
+  bracket_index_.OnLinesChanged(first_line, old_count, new_count);
+  minimap_.OnLinesChanged(first_line, old_count, new_count);
+  if (wrap_index_.is_active()) {
+    wrap_index_.OnLinesChanged(first_line, old_count, new_count);
+    if (is_unfolded) {
+      wrap_index_.UpdateHiddenLines(0, text_file_->GetLineCount());
+    }
+  }
+
+  if (!is_editing_) {
+    // A caret on the last line stays at the end of the text, and the window
+    // scrolls with it, e.g. to follow a log.
+    size_t old_line_count = text_file_->GetLineCount() + old_count - new_count;
+    bool is_caret_at_end = static_cast<size_t>(caret_pos_.y) + 1 == old_line_count &&
+                           first_line + old_count == old_line_count &&
+                           new_count != 0 &&
+                           !HasSelection();
+
+    KeepPositions(first_line, old_count, new_count);
+
+    if (is_caret_at_end) {
+      int last_line = text_file_->GetLineCount() - 1;
+      caret_pos_ = wxPoint(text_file_->GetLine(last_line).Len(), last_line);
+      selection_start_ = caret_pos_;
+      selection_region_ = SelectionRegion(caret_pos_, caret_pos_);
+      is_caret_following_ = true;
+    }
+
+    // The lines shown are kept in place if the rows above them are changed.
+    // Scrolling moves the pixels, so the window is painted again anyway.
+    int row_delta = GetRowCount() - row_count;
+    if (row_delta != 0 && static_cast<int>(first_line + old_count) <= top_line) {
+      vscroll_pos_ = GetViewStart().y + row_delta;
+      RefreshScrollbars();
+      Scroll(hscroll_pos_, vscroll_pos_);
+      text_panel_->Refresh();
+      line_number_panel_->Refresh();
+      return;
+    }
+  }
+
+  // The rows below are moved if the number of rows is changed.
+  int first_row = LineToRow(first_line);
+  if (old_count != new_count || row_count != GetRowCount()) {
+    RefreshRows(first_row, -1);
+    line_number_panel_->Refresh();
+  } else {
+    RefreshRows(first_row, LineToRow(first_line + new_count) - first_row);
+  }
+}
+
+// The minimap builder doesn't read the text until the lines are updated.
+void TextScrollWindow::OnTextChanging() {
+  minimap_.Pause();
+}
+
+// Move a position of this view with the text after the lines
+// [first_line, first_line + old_count) are replaced by new_count lines.
+static void KeepPosition(const TextFile* text_file,
+                         size_t first_line,
+                         size_t old_count,
+                         size_t new_count,
+                         wxPoint* pos) {
+  size_t line = static_cast<size_t>(pos->y);
+  if (line < first_line) {
+    return;
+  }
+  if (line >= first_line + old_count) {
+    pos->y = static_cast<int>(line + new_count - old_count);
+    return;
+  }
+  // The lines are dropped, e.g. trimmed by follow mode.
+  if (new_count == 0) {
+    pos->y = static_cast<int>(std::min(first_line, text_file->GetLineCount() - 1));
+    pos->x = 0;
+    return;
+  }
+  pos->y = static_cast<int>(std::min(line, first_line + new_count - 1));
+  pos->x = std::min(pos->x, static_cast<int>(text_file->GetLine(pos->y).Len()));
+}
+
+// The carets and the selection of a view stay on their text while another
+// view edits it.
+void TextScrollWindow::KeepPositions(size_t first_line, size_t old_count, size_t new_count) {
+  KeepPosition(text_file_, first_line, old_count, new_count, &caret_pos_);
+  KeepPosition(text_file_, first_line, old_count, new_count, &selection_start_);
+
+  wxPoint start = selection_region_.start_pos();
+  wxPoint end = selection_region_.end_pos();
+  KeepPosition(text_file_, first_line, old_count, new_count, &start);
+  KeepPosition(text_file_, first_line, old_count, new_count, &end);
+  selection_region_.set_start_pos(start);
+  selection_region_.set_end_pos(end);
+
+  for (Cursor& cursor : extra_cursors_) {
+    wxPoint caret_pos = cursor.caret_pos();
+    wxPoint anchor_pos = cursor.anchor_pos();
+    KeepPosition(text_file_, first_line, old_count, new_count, &caret_pos);
+    KeepPosition(text_file_, first_line, old_count, new_count, &anchor_pos);
+    cursor.set_caret_pos(caret_pos);
+    cursor.set_anchor_pos(anchor_pos);
+  }
+  NormalizeCursors();
+}
+
 // Refresh display
 
 void TextScrollWindow::UpdateCaret() {
+  TRACE_SCOPE("TextScrollWindow::UpdateCaret");
   wxPoint point = GetViewStart();
-  int xpos = caret_pos_.x * char_width_ - point.x * char_width_;
-  int ypos = (char_height_) * (caret_pos_.y - point.y);
+  wxPoint row_pos = TextCoordsToRowCoords(caret_pos_);
+  int xpos = row_pos.x * char_width_ - point.x * char_width_;
+  int ypos = (char_height_) * (row_pos.y - point.y);
 
   if (ypos > client_height_ - char_height_) {
-    vscroll_pos_ = caret_pos_.y - client_height_ / char_height_ + 1;
+    vscroll_pos_ = row_pos.y - client_height_ / char_height_ + 1;
     Scroll(hscroll_pos_, vscroll_pos_);
   }
   if (ypos < 0) {
-    vscroll_pos_ = caret_pos_.y;
+    vscroll_pos_ = row_pos.y;
     Scroll(hscroll_pos_, vscroll_pos_);
   }
-  if (xpos > client_width_ - char_width_) {
+  // Wrapped rows never scroll horizontally, but the lines scrolled into the
+  // window may be stale.
+  if (wrap_index_.is_active()) {
+    WrapVisibleLines();
+  } else if (xpos > client_width_ - char_width_) {
     hscroll_pos_ = caret_pos_.x - client_width_ / char_width_ + 6;
     Scroll(hscroll_pos_, vscroll_pos_);
   }
@@ -421,10 +985,50 @@ void TextScrollWindow::UpdateCaret() {
     }
     Scroll(hscroll_pos_, vscroll_pos_);
   }
-  point = GetViewStart();
-  xpos = caret_pos_.x * char_width_ - point.x * char_width_;
-  ypos = char_height_ * (caret_pos_.y - point.y);
+  PlaceCaret();
+}
+
+// Move the caret to its position in the window without scrolling to it.
+void TextScrollWindow::PlaceCaret() {
+  wxPoint point = GetViewStart();
+  wxPoint row_pos = TextCoordsToRowCoords(caret_pos_);
+  int xpos = row_pos.x * char_width_ - point.x * char_width_;
+  int ypos = char_height_ * (row_pos.y - point.y);
   text_panel_->GetCaret()->Move(xpos, ypos);
+  UpdateBracketMatch();
+}
+
+// The bracket after the caret is matched first, then the one before it.
+// Brackets aren't matched for several carets.
+void TextScrollWindow::UpdateBracketMatch() {
+  bool had_match = has_bracket_match_;
+  wxPoint old_pos = bracket_pos_;
+  wxPoint old_match_pos = bracket_match_pos_;
+
+  bracket_pos_ = caret_pos_;
+  has_bracket_match_ = false;
+  if (!HasExtraCursors()) {
+    has_bracket_match_ = bracket_index_.FindMatch(bracket_pos_, &bracket_match_pos_);
+    if (!has_bracket_match_ && caret_pos_.x > 0) {
+      --bracket_pos_.x;
+      has_bracket_match_ = bracket_index_.FindMatch(bracket_pos_, &bracket_match_pos_);
+    }
+  }
+
+  if (had_match == has_bracket_match_ &&
+      (!had_match || (old_pos == bracket_pos_ && old_match_pos == bracket_match_pos_))) {
+    return;
+  }
+  // The old lines may be gone after an edit, which refreshed them anyway.
+  int line_count = text_file_->GetLineCount();
+  if (had_match && old_pos.y < line_count && old_match_pos.y < line_count) {
+    RefreshLines(old_pos.y, false);
+    RefreshLines(old_match_pos.y, false);
+  }
+  if (has_bracket_match_) {
+    RefreshLines(bracket_pos_.y, false);
+    RefreshLines(bracket_match_pos_.y, false);
+  }
 }
 
 int TextScrollWindow::CountDigitNumber(int n) const {
@@ -438,11 +1042,10 @@ int TextScrollWindow::CountDigitNumber(int n) const {
 }
 
 void TextScrollWindow::RefreshLineNumber() {
-  static int digit_number= 1;
   int n = text_file_->GetLineCount();
   int count = CountDigitNumber(n);
 
-  if (digit_number != count) {
+  if (line_number_digit_count_ != count) {
     const int padding = 2 * char_width_;
     int width = 0;
 
@@ -454,138 +1057,654 @@ void TextScrollWindow::RefreshLineNumber() {
 
     line_number_panel_->SetInitialSize(wxSize(width, 0));
     Layout();
-    digit_number = count;
+    line_number_digit_count_ = count;
   }
 
   line_number_panel_->Refresh();
 }
 
 void TextScrollWindow::RefreshScrollbars() {
+  TRACE_SCOPE("TextScrollWindow::RefreshScrollbars");
   if (text_file_ == NULL) {
     return;
   }
   int width = 0;
-  int height = char_height_ * text_file_->GetLineCount() + client_height_;
-  int max_column_width = text_file_->GetMaxLineSize() * char_width_;
-  if (max_column_width > client_width_ * 2 / 3) {
-    width = client_width_ + max_column_width - client_width_ * 2 / 3;
+  // The pixels of the rows of a huge paged or hex text overflow an int. Its lines
+  // past the limit can't be scrolled to.
+  long long rows_height = static_cast<long long>(char_height_) * GetRowCount() + client_height_;
+  int height = static_cast<int>(std::min<long long>(rows_height, INT_MAX));
+  // The wrapped lines needn't scroll horizontally.
+  if (!wrap_index_.is_active()) {
+    int max_column_width = text_file_->GetMaxLineSize() * char_width_;
+    if (max_column_width > client_width_ * 2 / 3) {
+      width = client_width_ + max_column_width - client_width_ * 2 / 3;
+    }
   }
   text_panel_->SetVirtualSize(width, height);
   AdjustScrollbars();
 }
 
 void TextScrollWindow::RefreshLines(int line_number, bool is_multi_lines) {
-  int x = 0;
-  int y = 0;
+  if (is_multi_lines) {
+    RefreshRows(LineToRow(line_number) - 1, -1);
+  } else {
+    RefreshRows(LineToRow(line_number), GetLineRowCount(line_number));
+  }
+}
+
+// Refresh |row_count| rows from |first_row|, or all of them below it if
+// |row_count| is negative.
+void TextScrollWindow::RefreshRows(int first_row, int row_count) {
   int width = 0;
   int height = 0;
-  GetViewStart(&x, &y);
   text_panel_->GetVirtualSize(&width, &height);
-  x = 0;
-  height = is_multi_lines ? (height - y * char_height_) : char_height_;
-  y = (line_number - y) * char_height_;
-  y = is_multi_lines ? (y - char_height_) : y;
-  text_panel_->RefreshRect(wxRect(x, y, width, height));
+  int y = (first_row - GetViewStart().y) * char_height_;
+  height = row_count < 0 ? (client_height_ - y) : row_count * char_height_;
+  text_panel_->RefreshRect(wxRect(0, y, width, height));
 }
 
-// Undo/Redo
-
-void TextScrollWindow::OnUndo(wxCommandEvent& event) {
-  text_file_->Undo();
-}
+// Soft wrap
 
-void TextScrollWindow::OnRedo(wxCommandEvent& event) {
-  text_file_->Redo();
+int TextScrollWindow::GetWrapColumns() const {
+  int columns = client_width_ / char_width_;
+  return columns < 1 ? 1 : columns;
 }
 
-// Copy/Cut/Paste
-
-void TextScrollWindow::OnCopy(wxCommandEvent& event) {
-  //wxMessageBox("1");
-  UpdateSelectionText();
+int TextScrollWindow::GetRowCount() const {
+  if (wrap_index_.is_active()) {
+    return wrap_index_.GetRowCount();
+  }
+  return text_file_ == NULL ? 1 : text_file_->GetLineCount() - fold_index_.GetHiddenCount();
 }
 
-void TextScrollWindow::OnCut(wxCommandEvent& event) {
-  DeleteSelectionText();
+int TextScrollWindow::GetLineRowCount(int line) const {
+  if (wrap_index_.is_active()) {
+    return wrap_index_.GetLineRowCount(line);
+  }
+  return fold_index_.IsHidden(line) ? 0 : 1;
 }
 
-void TextScrollWindow::OnPaste(wxCommandEvent& event) {
-  EditCommand* command = new InsertTextCommand(text_file_, caret_pos_, selection_text_);
-  text_file_->Execute(command);
+int TextScrollWindow::LineToRow(int line) const {
+  if (wrap_index_.is_active()) {
+    return wrap_index_.LineToRow(line);
+  }
+  return fold_index_.HasFolds() ? fold_index_.LineToRow(line) : line;
 }
 
-// Move caret according to keyboard event.
-
-void TextScrollWindow::MoveCaret(wxChar ch){
-   if (ch == WXK_UP) {
-    MoveToPrevLine();
-  } else if (ch == WXK_DOWN) {
-    MoveToNextLine();
-  } else if (ch == WXK_LEFT) {
-    MoveToPrevChar();
-  } else if (ch == WXK_RIGHT) {
-    MoveToNextChar();
-  } else if (ch == WXK_HOME) {
-    MoveToLineHome();
-  } else if (ch == WXK_END){
-    MoveToLineEnd();
-  } else if (ch == WXK_PAGEUP) {
-    MoveToPrevPage();
-  } else if (ch == WXK_PAGEDOWN) {
-    MoveToNextPage();
+int TextScrollWindow::RowToLine(int row) const {
+  if (wrap_index_.is_active()) {
+    return wrap_index_.RowToLine(row);
   }
-  ClearSelectionRegion();
+  return fold_index_.HasFolds() && row > 0 ? fold_index_.RowToLine(row) : row;
 }
 
-void TextScrollWindow::MoveToPrevLine() {
-  if (caret_pos_.y != 0) {
-    size_t cols = text_file_->GetLine(--caret_pos_.y).Len();
-    caret_pos_.x = caret_pos_.x > cols ? cols : caret_pos_.x;
-    CheckTabBounds(caret_pos_);
+// Get the columns [from, to) of the row of a line.
+void TextScrollWindow::GetRowRange(int line, int sub_row, size_t* from, size_t* to) const {
+  const TextLine& text_line = text_file_->GetLine(line);
+  if (wrap_index_.is_active()) {
+    text_line.GetWrapRowRange(wrap_index_.wrap_columns(), sub_row, from, to);
+  } else {
+    *from = 0;
+    *to = text_line.Len();
   }
 }
 
-void TextScrollWindow::MoveToNextLine() {
-  if (caret_pos_.y != (text_file_->GetLineCount() - 1)) {
-    size_t cols = text_file_->GetLine(++(caret_pos_.y)).Len();
-    caret_pos_.x = caret_pos_.x > cols ? cols : caret_pos_.x;
-    CheckTabBounds(caret_pos_);
+// Rewrap the stale lines in the window. The rows of a line may change, which
+// brings other lines into the window, so repeat until nothing changes.
+bool TextScrollWindow::WrapVisibleLines() {
+  if (!wrap_index_.is_active()) {
+    return false;
   }
+  bool is_changed = false;
+  int first_row = GetViewStart().y;
+  int end_row = first_row + client_height_ / char_height_ + 1;
+  while (wrap_index_.WrapLines(RowToLine(first_row), RowToLine(end_row) + 1)) {
+    is_changed = true;
+  }
+  return is_changed;
 }
 
-void TextScrollWindow::MoveToPrevChar() {
-  const wxString& current_line = text_file_->GetLine(caret_pos_.y).GetData();
-  if (caret_pos_.x != 0) {
-    if (current_line[caret_pos_.x - 1] != wxT('\t')) {
-      --(caret_pos_.x);
-    } else {
-      caret_pos_.x -= config_->tab_size_;
-    }
-  } else {
-    if (caret_pos_.y != 0) {
-      caret_pos_.x = (text_file_->GetLine(--caret_pos_.y)).Len();
-    }
+void TextScrollWindow::SetWordWrap(bool is_word_wrap) {
+  if (is_word_wrap == is_word_wrap_) {
+    return;
   }
-}
+  // The lines are wrapped when the text is attached.
+  if (text_file_ == NULL) {
+    is_word_wrap_ = is_word_wrap;
+    return;
+  }
+  int top_line = RowToLine(GetViewStart().y);
 
-void TextScrollWindow::MoveToNextChar() {
-  const wxString& current_line = text_file_->GetLine(caret_pos_.y).GetData();
-  if (caret_pos_.x != current_line.Len()) {
-    if (current_line[caret_pos_.x] != wxT('\t')) {
-      ++(caret_pos_.x);
-    } else {
-      caret_pos_.x += config_->tab_size_;
-    }
+  is_word_wrap_ = is_word_wrap;
+  if (is_word_wrap_ && !text_file_->IsFileLines()) {
+    wrap_index_.Reset(text_file_, GetWrapColumns(), &fold_index_);
   } else {
-    if (caret_pos_.y != text_file_->GetLineCount() - 1) {
-      caret_pos_.y++;
-      caret_pos_.x = 0;
-    }
+    wrap_index_.Clear();
   }
-}
 
-void TextScrollWindow::MoveToLineEnd() {
-  caret_pos_.x = text_file_->GetLine(caret_pos_.y).Len();
+  // Keep the top line in the window.
+  RefreshScrollbars();
+  hscroll_pos_ = 0;
+  vscroll_pos_ = LineToRow(top_line);
+  Scroll(hscroll_pos_, vscroll_pos_);
+  WrapVisibleLines();
+  RefreshScrollbars();
+  UpdateCaret();
+  text_panel_->Refresh();
+  line_number_panel_->Refresh();
+}
+
+void TextScrollWindow::GetMemoryUsage(MemoryUsage* usage) const {
+  usage->Add(MEMORY_SELECTION, GetStringMemoryUsage(selection_text_) + GetVectorMemoryUsage(extra_cursors_));
+  usage->Add(MEMORY_WRAP_INDEX, wrap_index_.GetMemoryUsage());
+  usage->Add(MEMORY_FOLD_INDEX, fold_index_.GetMemoryUsage());
+  usage->Add(MEMORY_BRACKET_INDEX, bracket_index_.GetMemoryUsage());
+  usage->Add(MEMORY_MINIMAP, minimap_.GetMemoryUsage() + GetVectorMemoryUsage(minimap_pixels_));
+}
+
+void TextScrollWindow::OnWordWrap(wxCommandEvent& event) {
+  SetWordWrap(event.IsChecked());
+}
+
+// Rewrap the lines out of the window bit by bit. The top line stays in place
+// while the rows above it change. The words of the document are lexed for
+// completion bit by bit too. The minimap is resumed in case the text was
+// paused for a change which didn't replace any line.
+void TextScrollWindow::OnIdle(wxIdleEvent& event) {
+  TRACE_SCOPE("TextScrollWindow::OnIdle");
+  event.Skip();
+  minimap_.Resume();
+  if (text_file_ != NULL && document_->completion_index().ScanStaleLines(kCompletionLinesPerIdle)) {
+    event.RequestMore();
+  }
+  if (!wrap_index_.HasStaleLines()) {
+    return;
+  }
+
+  int first_row = GetViewStart().y;
+  int top_line = RowToLine(first_row);
+  int top_offset = first_row - LineToRow(top_line);
+
+  if (wrap_index_.WrapStaleLines(kWrapLinesPerIdle)) {
+    event.RequestMore();
+  }
+  RefreshScrollbars();
+
+  int new_first_row = LineToRow(top_line) + top_offset;
+  if (new_first_row != first_row) {
+    vscroll_pos_ = new_first_row;
+    Scroll(hscroll_pos_, vscroll_pos_);
+    UpdateCaret();
+    text_panel_->Refresh();
+    line_number_panel_->Refresh();
+  }
+}
+
+// Undo/Redo
+
+void TextScrollWindow::OnUndo(wxCommandEvent& event) {
+  if (text_file_ == NULL) {
+    return;
+  }
+  ClearExtraCursors();
+  is_editing_ = true;
+  text_file_->Undo();
+  is_editing_ = false;
+}
+
+void TextScrollWindow::OnRedo(wxCommandEvent& event) {
+  if (text_file_ == NULL) {
+    return;
+  }
+  ClearExtraCursors();
+  is_editing_ = true;
+  text_file_->Redo();
+  is_editing_ = false;
+}
+
+// The text may be shown by other views too. Only the view which edits it
+// moves its caret to the edit, see OnLineUpdate().
+void TextScrollWindow::Execute(EditCommand* command) {
+  is_editing_ = true;
+  text_file_->Execute(command);
+  is_editing_ = false;
+}
+
+// Copy/Cut/Paste
+
+void TextScrollWindow::OnCopy(wxCommandEvent& event) {
+  CopyToClipboard();
+}
+
+void TextScrollWindow::OnCut(wxCommandEvent& event) {
+  if (CopyToClipboard() && !text_file_->IsFileLines()) {
+    DeleteSelectionText();
+  }
+}
+
+void TextScrollWindow::OnPaste(wxCommandEvent& event) {
+  if (text_file_ == NULL || text_file_->IsFileLines()) {
+    return;
+  }
+  wxString text;
+  bool is_block = false;
+  if (!ReadClipboard(&text, &is_block)) {
+    return;
+  }
+
+  if (HasExtraCursors()) {
+    EditAtCursors(text, 0);
+    return;
+  }
+  if (is_block) {
+    PasteBlockText(text);
+    return;
+  }
+  EditCommand* command = new InsertTextCommand(text_file_, caret_pos_, text);
+  Execute(command);
+}
+
+size_t TextScrollWindow::GetSelectionSize() const {
+  size_t size = 0;
+  wxPoint start = selection_region_.start_pos();
+  wxPoint end = selection_region_.end_pos();
+  for (int i = start.y; i <= end.y; ++i) {
+    size_t from = 0;
+    size_t count = 0;
+    selection_region_.GetLineRange(i, text_file_->GetLine(i).Len(), &from, &count);
+    size += count + 1;
+  }
+  return size;
+}
+
+bool TextScrollWindow::CopyToClipboard() {
+  if (text_file_ == NULL || !HasSelection()) {
+    return false;
+  }
+
+  SelectionSource* source = NULL;
+  if (HasExtraCursors()) {
+    UpdateSelectionText();
+    source = new SelectionSource(selection_text_, false, config_->tab_size_);
+  } else {
+    source = new SelectionSource(text_file_, selection_region_, config_->tab_size_);
+    if (GetSelectionSize() < kLazyCopySize) {
+      source->Materialize();
+    }
+  }
+
+  wxClipboardLocker locker;
+  if (!locker) {
+    delete source;
+    return false;
+  }
+  wxTheClipboard->SetData(new SelectionDataObject(source));
+  return true;
+}
+
+bool TextScrollWindow::ReadClipboard(wxString* text, bool* is_block) {
+  wxClipboardLocker locker;
+  if (!locker || !wxTheClipboard->IsSupported(wxDF_UNICODETEXT)) {
+    return false;
+  }
+
+  wxTextDataObject data;
+  if (!wxTheClipboard->GetData(data)) {
+    return false;
+  }
+
+  *text = ImportClipboardText(data.GetText(), config_->tab_size_);
+  *is_block = wxTheClipboard->IsSupported(GetBlockDataFormat());
+  return true;
+}
+
+// Puts a caret with selection on every occurrence of the selected text.
+// A paged or a hex text isn't searched line by line, it would be read whole.
+void TextScrollWindow::OnSelectAllOccurrences(wxCommandEvent& event) {
+  if (text_file_ == NULL || text_file_->IsFileLines() || !HasSelection() ||
+      selection_region_.start_pos().y != selection_region_.end_pos().y) {
+    return;
+  }
+
+  wxString pattern = text_file_->GetText(selection_region_);
+  size_t pattern_len = pattern.Len();
+
+  extra_cursors_.clear();
+  for (size_t i = 0; i != text_file_->GetLineCount(); ++i) {
+    const wxString& line = text_file_->GetLine(i).GetData();
+    size_t pos = line.find(pattern);
+    while (pos != wxString::npos) {
+      wxPoint anchor_pos(pos, i);
+      wxPoint caret_pos(pos + pattern_len, i);
+      // The selection itself is the primary cursor, whichever end its caret is at.
+      if (anchor_pos != selection_region_.start_pos()) {
+        extra_cursors_.push_back(Cursor(caret_pos, anchor_pos));
+      }
+      pos = line.find(pattern, pos + pattern_len);
+    }
+  }
+  NormalizeCursors();
+
+  text_panel_->Refresh();
+}
+
+// Find/Go to
+
+void TextScrollWindow::OnFind(wxCommandEvent& event) {
+  if (text_file_ == NULL) {
+    return;
+  }
+  wxString text = wxGetTextFromUser(wxT("Find:"), wxT("Find"), find_text_, this);
+  if (text.IsEmpty()) {
+    return;
+  }
+  find_text_ = text;
+  FindNext();
+}
+
+void TextScrollWindow::OnFindNext(wxCommandEvent& event) {
+  if (text_file_ == NULL) {
+    return;
+  }
+  if (find_text_.IsEmpty()) {
+    OnFind(event);
+    return;
+  }
+  FindNext();
+}
+
+// The caret is left at the end of the match, so the next search goes on from
+// there. A paged or a hex text is searched in its file, which takes a while
+// if it's huge.
+void TextScrollWindow::FindNext() {
+  wxPoint found;
+  bool is_found = false;
+  {
+    wxBusyCursor busy_cursor;
+    is_found = text_file_->Find(find_text_, caret_pos_, &found);
+  }
+  if (!is_found) {
+    wxMessageBox(wxT("Can't find \"") + find_text_ + wxT("\"."), wxT("Find"), wxOK | wxICON_INFORMATION, this);
+    return;
+  }
+  ClearExtraCursors();
+  is_block_selecting_ = false;
+  ShowLine(found.y);
+  selection_start_ = found;
+  caret_pos_ = wxPoint(found.x + find_text_.Len(), found.y);
+  UpdateCaret();
+  UpdateSelectionRegion();
+}
+
+void TextScrollWindow::OnGoToLine(wxCommandEvent& event) {
+  if (text_file_ == NULL) {
+    return;
+  }
+  long line = wxGetNumberFromUser(wxEmptyString,
+                                  wxT("Line number:"),
+                                  wxT("Go to Line"),
+                                  caret_pos_.y + 1,
+                                  1,
+                                  static_cast<long>(text_file_->GetLineCount()),
+                                  this);
+  // -1 if it's canceled.
+  if (line < 1) {
+    return;
+  }
+  GoToPosition(wxPoint(0, static_cast<int>(line - 1)));
+}
+
+// The caret goes before the matching bracket, so going again comes back.
+void TextScrollWindow::OnGoToMatchingBracket(wxCommandEvent& event) {
+  if (text_file_ == NULL || !has_bracket_match_) {
+    return;
+  }
+  GoToPosition(bracket_match_pos_);
+}
+
+// A view not attached goes there when it's attached. The position is
+// clamped to the text, which may be changed since it was found.
+void TextScrollWindow::GoToPosition(const wxPoint& pos) {
+  if (text_file_ == NULL) {
+    SetViewport(pos, pos.y);
+    return;
+  }
+  int line = std::min(pos.y, static_cast<int>(text_file_->GetLineCount()) - 1);
+  int column = std::min(pos.x, static_cast<int>(text_file_->GetLine(line).Len()));
+  ClearExtraCursors();
+  is_block_selecting_ = false;
+  ShowLine(line);
+  caret_pos_ = wxPoint(column, line);
+  selection_start_ = caret_pos_;
+  selection_region_ = SelectionRegion(caret_pos_, caret_pos_);
+  UpdateCaret();
+  text_panel_->Refresh();
+}
+
+wxString TextScrollWindow::GetWordAtCaret() const {
+  if (text_file_ == NULL || text_file_->IsFileLines()) {
+    return wxEmptyString;
+  }
+  const wxString& line = text_file_->GetLine(caret_pos_.y).GetData();
+  int first_column = caret_pos_.x;
+  while (first_column > 0 && syntax::CppParser::IsIdentifierChar(line[first_column - 1])) {
+    --first_column;
+  }
+  int end_column = caret_pos_.x;
+  while (end_column < static_cast<int>(line.Len()) && syntax::CppParser::IsIdentifierChar(line[end_column])) {
+    ++end_column;
+  }
+  return line.Mid(first_column, end_column - first_column);
+}
+
+// Word completion
+
+// Complete the identifier before the caret with the words of the document.
+// A single word is inserted at once, more are offered in a popup menu below
+// the identifier.
+void TextScrollWindow::OnCompleteWord(wxCommandEvent& event) {
+  if (text_file_ == NULL || text_file_->IsFileLines() || HasSelection() || HasExtraCursors()) {
+    return;
+  }
+  const wxString& line = text_file_->GetLine(caret_pos_.y).GetData();
+  int column = caret_pos_.x;
+  while (column > 0 && syntax::CppParser::IsIdentifierChar(line[column - 1])) {
+    --column;
+  }
+  if (column == caret_pos_.x) {
+    return;
+  }
+
+  wxString prefix = line.Mid(column, caret_pos_.x - column);
+  std::vector<wxString> words;
+  document_->completion_index().Find(prefix, kMaxCompletionCount, &words);
+  if (words.empty()) {
+    return;
+  }
+
+  size_t index = 0;
+  if (words.size() > 1) {
+    wxMenu menu;
+    for (size_t i = 0; i < words.size(); ++i) {
+      menu.Append(static_cast<int>(i) + 1, words[i]);
+    }
+    wxPoint point = GetViewStart();
+    wxPoint row_pos = TextCoordsToRowCoords(wxPoint(column, caret_pos_.y));
+    wxPoint menu_pos((row_pos.x - point.x) * char_width_, (row_pos.y - point.y + 1) * char_height_);
+    int id = text_panel_->GetPopupMenuSelectionFromUser(menu, menu_pos);
+    if (id == wxID_NONE) {
+      return;
+    }
+    index = static_cast<size_t>(id - 1);
+  }
+  Execute(new InsertTextCommand(text_file_, caret_pos_, words[index].Mid(prefix.Len())));
+}
+
+// Code folding
+
+// Unfold the line at the caret if it's folded, or else fold the region at
+// the caret. The caret moves out of the lines folded.
+void TextScrollWindow::OnToggleFold(wxCommandEvent& event) {
+  if (text_file_ == NULL || !fold_index_.is_active()) {
+    return;
+  }
+  Interval lines;
+  bool is_changed = false;
+  {
+    wxBusyCursor busy_cursor;
+    if (fold_index_.IsFolded(caret_pos_.y)) {
+      is_changed = fold_index_.Unfold(caret_pos_.y, &lines);
+    } else {
+      is_changed = fold_index_.Fold(caret_pos_.y, &lines);
+    }
+  }
+  if (!is_changed) {
+    return;
+  }
+  ClearExtraCursors();
+  is_block_selecting_ = false;
+  if (fold_index_.IsHidden(caret_pos_.y)) {
+    caret_pos_.y = static_cast<int>(fold_index_.GetShownLine(caret_pos_.y));
+    caret_pos_.x = text_file_->GetLine(caret_pos_.y).Len();
+  }
+  selection_start_ = caret_pos_;
+  selection_region_ = SelectionRegion(caret_pos_, caret_pos_);
+  OnFoldsChanged(lines);
+}
+
+void TextScrollWindow::OnUnfoldAll(wxCommandEvent& event) {
+  if (text_file_ == NULL || !fold_index_.HasFolds()) {
+    return;
+  }
+  fold_index_.UnfoldAll();
+  Interval lines = { 0, text_file_->GetLineCount() - 1 };
+  OnFoldsChanged(lines);
+}
+
+void TextScrollWindow::ShowLine(int line) {
+  Interval lines;
+  if (fold_index_.ShowLine(line, &lines)) {
+    OnFoldsChanged(lines);
+  }
+}
+
+// The lines were folded or unfolded. Only the rows of a wrapped text are
+// updated with them, the others are mapped by the fold index.
+void TextScrollWindow::OnFoldsChanged(const Interval& lines) {
+  wrap_index_.UpdateHiddenLines(lines.first, lines.last + 1);
+  WrapVisibleLines();
+  RefreshScrollbars();
+  UpdateCaret();
+  text_panel_->Refresh();
+  line_number_panel_->Refresh();
+}
+
+// Move caret according to keyboard event.
+
+void TextScrollWindow::MoveCaret(wxChar ch){
+  if (HasExtraCursors()) {
+    MoveExtraCursors(ch);
+  }
+  MoveCaretByKey(ch);
+  ClearSelectionRegion();
+}
+
+void TextScrollWindow::MoveCaretByKey(wxChar ch){
+   if (ch == WXK_UP) {
+    MoveToPrevLine();
+  } else if (ch == WXK_DOWN) {
+    MoveToNextLine();
+  } else if (ch == WXK_LEFT) {
+    MoveToPrevChar();
+  } else if (ch == WXK_RIGHT) {
+    MoveToNextChar();
+  } else if (ch == WXK_HOME) {
+    MoveToLineHome();
+  } else if (ch == WXK_END){
+    MoveToLineEnd();
+  } else if (ch == WXK_PAGEUP) {
+    MoveToPrevPage();
+  } else if (ch == WXK_PAGEDOWN) {
+    MoveToNextPage();
+  }
+}
+
+void TextScrollWindow::MoveToPrevLine() {
+  if (caret_pos_.y != 0) {
+    caret_pos_.y = static_cast<int>(fold_index_.GetPrevShownLine(caret_pos_.y));
+    size_t cols = text_file_->GetLine(caret_pos_.y).Len();
+    caret_pos_.x = caret_pos_.x > cols ? cols : caret_pos_.x;
+    CheckTabBounds(caret_pos_);
+  }
+}
+
+void TextScrollWindow::MoveToNextLine() {
+  size_t line = fold_index_.GetNextShownLine(caret_pos_.y);
+  if (line < text_file_->GetLineCount()) {
+    caret_pos_.y = static_cast<int>(line);
+    size_t cols = text_file_->GetLine(caret_pos_.y).Len();
+    caret_pos_.x = caret_pos_.x > cols ? cols : caret_pos_.x;
+    CheckTabBounds(caret_pos_);
+  }
+}
+
+// The caret steps over the hidden lines from the end of a folded line.
+void TextScrollWindow::MoveToPrevChar() {
+  caret_pos_ = GetPrevCharPosition(caret_pos_);
+  if (fold_index_.IsHidden(caret_pos_.y)) {
+    caret_pos_.y = static_cast<int>(fold_index_.GetShownLine(caret_pos_.y));
+    caret_pos_.x = text_file_->GetLine(caret_pos_.y).Len();
+  }
+}
+
+void TextScrollWindow::MoveToNextChar() {
+  wxPoint next_pos = GetNextCharPosition(caret_pos_);
+  if (fold_index_.IsHidden(next_pos.y)) {
+    next_pos = wxPoint(0, static_cast<int>(fold_index_.GetNextShownLine(caret_pos_.y)));
+    if (next_pos.y >= text_file_->GetLineCount()) {
+      return;
+    }
+  }
+  caret_pos_ = next_pos;
+}
+
+wxPoint TextScrollWindow::GetPrevCharPosition(const wxPoint& pos) const {
+  wxPoint prev_pos(pos);
+  const wxString& current_line = text_file_->GetLine(pos.y).GetData();
+  if (pos.x != 0) {
+    if (current_line[pos.x - 1] != wxT('\t')) {
+      --(prev_pos.x);
+    } else {
+      prev_pos.x -= config_->tab_size_;
+    }
+  } else {
+    if (pos.y != 0) {
+      prev_pos.x = (text_file_->GetLine(--prev_pos.y)).Len();
+    }
+  }
+  return prev_pos;
+}
+
+wxPoint TextScrollWindow::GetNextCharPosition(const wxPoint& pos) const {
+  wxPoint next_pos(pos);
+  const wxString& current_line = text_file_->GetLine(pos.y).GetData();
+  if (pos.x != current_line.Len()) {
+    if (current_line[pos.x] != wxT('\t')) {
+      ++(next_pos.x);
+    } else {
+      next_pos.x += config_->tab_size_;
+    }
+  } else {
+    if (pos.y != text_file_->GetLineCount() - 1) {
+      next_pos.y++;
+      next_pos.x = 0;
+    }
+  }
+  return next_pos;
+}
+
+void TextScrollWindow::MoveToLineEnd() {
+  caret_pos_.x = text_file_->GetLine(caret_pos_.y).Len();
 }
 
 void TextScrollWindow::MoveToLineHome() {
@@ -623,14 +1742,16 @@ void TextScrollWindow::CheckColumnBounds() {
 
 void TextScrollWindow::CheckRowBounds() {
   size_t line_count = text_file_->GetLineCount();
+  int row_count = GetRowCount();
   if (vscroll_pos_ < 0 || caret_pos_.y < 0) {
     caret_pos_.y = 0;
     vscroll_pos_ = 0;
   }
-  if ((size_t)vscroll_pos_ >= line_count || caret_pos_.y >= line_count) {
+  if (vscroll_pos_ >= row_count || caret_pos_.y >= line_count) {
     caret_pos_.y = line_count - 1;
-    vscroll_pos_ = line_count - 1;
+    vscroll_pos_ = row_count - 1;
   }
+  caret_pos_.y = static_cast<int>(fold_index_.GetShownLine(caret_pos_.y));
 }
 
 void TextScrollWindow::CheckTabBounds(wxPoint& point) const {
@@ -647,72 +1768,110 @@ void TextScrollWindow::CheckTabBounds(wxPoint& point) const {
   }
 }
 
-void TextScrollWindow::SetTextFile(const wxString& file_name) {
-  text_file_ = new TextFile(file_name);
-
-  if (text_file_->Read()) {
-    wxString tab(wxT('\t'), config_->tab_size_);
-    for (size_t i = 0; i != text_file_->GetLineCount(); ++i) {
-      wxString& line = text_file_->GetLine(i).GetData();
-      line.Replace(wxT("\t"), tab, true);
-    }
+void TextScrollWindow::SetDocument(Document* document) {
+  if (document_ != NULL) {
+    DetachTextFile();
+    document_->RemoveView(this);
   }
 
-  if (text_file_->GetLineCount() == 0) {
-    text_file_->AddLine(wxT(""), LINE_END_TYPE_NONE);
+  document_ = document;
+  caret_pos_ = wxPoint(0, 0);
+  selection_start_ = caret_pos_;
+  selection_region_ = SelectionRegion(caret_pos_, caret_pos_);
+  top_line_ = 0;
+  vscroll_pos_ = 0;
+  hscroll_pos_ = 0;
+  Scroll(hscroll_pos_, vscroll_pos_);
+
+  if (document_ != NULL) {
+    document_->AddView(this);
+    if (document_->IsLoaded()) {
+      AttachTextFile();
+    }
   }
+}
 
+// The text may be another one than the last time, e.g. the document was
+// unloaded and the file was changed by another program, so the caret is
+// checked.
+void TextScrollWindow::AttachTextFile() {
+  TRACE_SCOPE("TextScrollWindow::AttachTextFile");
+  text_file_ = document_->text_file();
   text_file_->AttachListener(this);
-  RefreshScrollbars();
-  text_panel_->Refresh();
-  RefreshLineNumber();
-}
+  extra_cursors_.clear();
 
-bool TextScrollWindow::IsFileChanged() {
-  return is_file_changed_;
+  if (!text_file_->IsFileLines()) {
+    fold_index_.Reset(text_file_);
+    bracket_index_.Reset(text_file_);
+    minimap_.Reset(text_file_, minimap_panel_, minimap_panel_->GetId());
+  }
+  if (is_word_wrap_ && !text_file_->IsFileLines()) {
+    wrap_index_.Reset(text_file_, GetWrapColumns(), &fold_index_);
+  }
+  ApplyViewport();
 }
 
-bool TextScrollWindow::IsNewFile() {
-  return is_new_file_;
-}
+// The rows of the top line may be others than the last time if the lines are
+// wrapped, so the top line is kept instead of the scroll position. The caret
+// isn't scrolled into the window, it's left where it was.
+void TextScrollWindow::ApplyViewport() {
+  int last_line = text_file_->GetLineCount() - 1;
+  caret_pos_.y = static_cast<int>(fold_index_.GetShownLine(std::min(caret_pos_.y, last_line)));
+  caret_pos_.x = std::min(caret_pos_.x, static_cast<int>(text_file_->GetLine(caret_pos_.y).Len()));
+  selection_start_ = caret_pos_;
+  selection_region_ = SelectionRegion(caret_pos_, caret_pos_);
 
-void TextScrollWindow::SetFileNew(bool state) {
-  is_new_file_ = state;
+  RefreshScrollbars();
+  vscroll_pos_ = LineToRow(std::min(top_line_, last_line));
+  Scroll(hscroll_pos_, vscroll_pos_);
+  WrapVisibleLines();
+  PlaceCaret();
+  text_panel_->Refresh();
+  RefreshLineNumber();
 }
 
-void TextScrollWindow::SetFileChanged(bool state) {
-  is_file_changed_ = state;
+int TextScrollWindow::GetTopLine() const {
+  return text_file_ == NULL ? top_line_ : RowToLine(GetViewStart().y);
 }
 
-void TextScrollWindow::SaveFile() {
-  wxString tab(wxT('\t'), config_->tab_size_);
-  for (size_t i = 0; i != text_file_->GetLineCount(); ++i) {
-    wxString& line = text_file_->GetLine(i).GetData();
-    line.Replace(tab, wxT('\t'), true);
+void TextScrollWindow::SetViewport(const wxPoint& caret_pos, int top_line) {
+  caret_pos_ = caret_pos;
+  top_line_ = top_line;
+  hscroll_pos_ = 0;
+  if (text_file_ != NULL) {
+    ApplyViewport();
   }
-  text_file_->Write();
 }
 
-void TextScrollWindow::CloseFile() {
-}
-
-void TextScrollWindow::CreateNewFile(const wxString& file_name) {
-  TextFile file(file_name);
-  size_t line_count = text_file_->GetLineCount();
-  if (line_count > 1) {
-    file.AddLine((*text_file_)[0].GetData());
-  }
-  for (size_t n = 1; n != line_count; n++) {
-    file.AddLine((*text_file_)[n].GetData(), text_file_->GetLineEndType(n));
+// The caret and the top line are kept for the next time.
+void TextScrollWindow::DetachTextFile() {
+  if (text_file_ == NULL) {
+    return;
   }
-  file.Write();
-
-  is_file_changed_ = false;
-  is_new_file_ = false;
-  SetTextFile(file_name);
+  top_line_ = RowToLine(GetViewStart().y);
+  text_file_->DetachListener(this);
+  text_file_ = NULL;
+  extra_cursors_.clear();
+  wrap_index_.Clear();
+  fold_index_.Clear();
+  bracket_index_.Clear();
+  has_bracket_match_ = false;
+  minimap_.Clear();
+  minimap_bitmap_ = wxNullBitmap;
+  text_panel_->Refresh();
+  line_number_panel_->Refresh();
+  minimap_panel_->Refresh();
 }
 
+// A paged text is read only, and a hex text is only overwritten.
 void TextScrollWindow::InsertChar(wxChar ch) {
+  if (text_file_->IsHex()) {
+    OverwriteHexChar(ch);
+    return;
+  }
+  if (text_file_->IsPaged()) {
+    return;
+  }
   wxString text;
 
   if (ch > 31 && ch < 127 || ch == WXK_RETURN) {
@@ -722,16 +1881,31 @@ void TextScrollWindow::InsertChar(wxChar ch) {
   } else {
   }
 
+  if (HasExtraCursors()) {
+    if (!text.IsEmpty()) {
+      EditAtCursors(text, 0);
+    }
+    return;
+  }
+
   if (HasSelection()) {
     DeleteSelectionText();
     ClearSelectionText();
   }
 
   EditCommand* command = new InsertTextCommand(text_file_, caret_pos_, text);
-  text_file_->Execute(command);
+  Execute(command);
 }
 
 void TextScrollWindow::DeleteChar(wxChar ch) {
+  if (text_file_->IsFileLines()) {
+    return;
+  }
+  if (HasExtraCursors()) {
+    EditAtCursors(wxEmptyString, ch);
+    return;
+  }
+
   if (HasSelection()) {
     DeleteSelectionText();
     ClearSelectionText();
@@ -746,7 +1920,7 @@ void TextScrollWindow::DeleteChar(wxChar ch) {
   }
 
   wxString text;
-  wxString& current_line = text_file_->GetLine(caret_pos_.y).GetData();
+  const wxString& current_line = text_file_->GetLine(caret_pos_.y).GetData();
 
   if (caret_pos_.x == current_line.Len()) {
     if (caret_pos_.y == text_file_->GetLineCount() - 1) {
@@ -760,10 +1934,192 @@ void TextScrollWindow::DeleteChar(wxChar ch) {
   }
 
   EditCommand* command = new DeleteTextCommand(text_file_, caret_pos_, text);
-  text_file_->Execute(command);
+  Execute(command);
   ClearSelectionRegion();
 }
 
+// The byte is overwritten as a whole, so undoing a digit restores its byte.
+// The extra carets are ignored.
+void TextScrollWindow::OverwriteHexChar(wxChar ch) {
+  HexText* hex_text = text_file_->hex_text();
+  unsigned long long offset = 0;
+  char byte = 0;
+  wxPoint end_pos;
+  if (!hex_text->GetTypedByte(caret_pos_, ch, &offset, &byte, &end_pos)) {
+    return;
+  }
+  ClearExtraCursors();
+  ClearSelectionRegion();
+  std::string old_bytes(1, static_cast<char>(hex_text->GetByte(offset)));
+  Execute(new OverwriteBytesCommand(text_file_, offset, old_bytes, std::string(1, byte), caret_pos_, end_pos));
+}
+
+// Multi-cursor editing
+
+void TextScrollWindow::AddCursorOnLine(int line_offset) {
+  int line = caret_pos_.y + line_offset;
+  if (line >= 0 && fold_index_.IsHidden(line)) {
+    line = static_cast<int>(line_offset < 0 ? fold_index_.GetShownLine(line) : fold_index_.GetNextShownLine(line));
+  }
+  if (line < 0 || line >= static_cast<int>(text_file_->GetLineCount())) {
+    return;
+  }
+
+  extra_cursors_.push_back(Cursor(caret_pos_, caret_pos_));
+  caret_pos_.y = line;
+  CheckColumnBounds();
+  CheckTabBounds(caret_pos_);
+  ClearSelectionRegion();
+  NormalizeCursors();
+}
+
+void TextScrollWindow::MoveExtraCursors(wxChar ch) {
+  // Paging scrolls the view, so it only makes sense for one caret.
+  if (ch == WXK_PAGEUP || ch == WXK_PAGEDOWN) {
+    ClearExtraCursors();
+    return;
+  }
+
+  wxPoint caret_pos = caret_pos_;
+  for (Cursor& cursor : extra_cursors_) {
+    caret_pos_ = cursor.caret_pos();
+    MoveCaretByKey(ch);
+    cursor.set_caret_pos(caret_pos_);
+    cursor.set_anchor_pos(caret_pos_);
+  }
+  caret_pos_ = caret_pos;
+  NormalizeCursors();
+}
+
+// Keeps the extra carets sorted and drops the ones which collapsed into
+// another caret.
+void TextScrollWindow::NormalizeCursors() {
+  std::sort(extra_cursors_.begin(), extra_cursors_.end());
+  extra_cursors_.erase(std::unique(extra_cursors_.begin(), extra_cursors_.end()),
+                       extra_cursors_.end());
+  std::vector<Cursor>::iterator it = std::lower_bound(extra_cursors_.begin(),
+                                                      extra_cursors_.end(),
+                                                      Cursor(caret_pos_, caret_pos_));
+  if (it != extra_cursors_.end() && it->caret_pos() == caret_pos_) {
+    extra_cursors_.erase(it);
+  }
+
+  extra_selection_span_ = 0;
+  for (const Cursor& cursor : extra_cursors_) {
+    extra_selection_span_ = std::max(extra_selection_span_, std::abs(cursor.anchor_pos().y - cursor.caret_pos().y));
+  }
+}
+
+void TextScrollWindow::ClearExtraCursors() {
+  if (extra_cursors_.empty()) {
+    return;
+  }
+  extra_cursors_.clear();
+  text_panel_->Refresh();
+}
+
+// Builds the edit of one caret: replaces the selection with |text| if there
+// is one, otherwise inserts |text|, or deletes one char if |key| is WXK_BACK
+// or WXK_DELETE. Returns NULL if there is nothing to do.
+ReplaceTextCommand* TextScrollWindow::NewCursorCommand(const wxPoint& caret_pos,
+                                                       const SelectionRegion& region,
+                                                       const wxString& text,
+                                                       int key) {
+  if (!region.IsEmpty()) {
+    return new ReplaceTextCommand(text_file_, region.start_pos(), text_file_->GetText(region), text);
+  }
+  if (!text.IsEmpty()) {
+    return new ReplaceTextCommand(text_file_, caret_pos, wxEmptyString, text);
+  }
+
+  wxPoint start = caret_pos;
+  wxPoint end = caret_pos;
+  if (key == WXK_BACK) {
+    start = GetPrevCharPosition(caret_pos);
+  } else if (key == WXK_DELETE) {
+    end = GetNextCharPosition(caret_pos);
+  }
+  if (start == end) {
+    return NULL;
+  }
+  return new ReplaceTextCommand(text_file_, start, text_file_->GetText(SelectionRegion(start, end)), wxEmptyString);
+}
+
+static bool IsReplaceCommandBefore(const ReplaceTextCommand* lhs, const ReplaceTextCommand* rhs) {
+  return IsRegionBefore(SelectionRegion(lhs->position(), lhs->position()),
+                        SelectionRegion(rhs->position(), rhs->position()));
+}
+
+// Applies the same edit at every caret as one composite command, so that it
+// is a single undo step and the listeners are notified only once.
+void TextScrollWindow::EditAtCursors(const wxString& text, int key) {
+  std::vector<ReplaceTextCommand*> commands;
+  commands.reserve(extra_cursors_.size() + 1);
+
+  ReplaceTextCommand* primary_command = NewCursorCommand(caret_pos_, selection_region_, text, key);
+  if (primary_command != NULL) {
+    commands.push_back(primary_command);
+  }
+  for (const Cursor& cursor : extra_cursors_) {
+    ReplaceTextCommand* command = NewCursorCommand(cursor.caret_pos(),
+                                                   cursor.GetSelectionRegion(),
+                                                   text,
+                                                   key);
+    if (command != NULL) {
+      commands.push_back(command);
+    }
+  }
+
+  // Drop the edits which overlap the one before, e.g. two carets deleting
+  // the same line break.
+  std::stable_sort(commands.begin(), commands.end(), IsReplaceCommandBefore);
+  size_t count = 0;
+  wxPoint prev_end(-1, -1);
+  for (size_t i = 0; i < commands.size(); ++i) {
+    ReplaceTextCommand* command = commands[i];
+    const wxPoint& start = command->position();
+    if (start.y < prev_end.y || (start.y == prev_end.y && start.x < prev_end.x)) {
+      if (command == primary_command) {
+        primary_command = commands[count - 1];
+      }
+      delete command;
+      continue;
+    }
+    prev_end = GetTextEndPosition(start, command->old_text());
+    commands[count++] = command;
+  }
+  commands.resize(count);
+
+  if (commands.empty()) {
+    return;
+  }
+  if (primary_command == NULL) {
+    primary_command = commands.front();
+  }
+
+  CompositeEditCommand* composite_command = new CompositeEditCommand(text_file_, commands);
+  Execute(composite_command);
+
+  // Put the carets after the edited text.
+  extra_cursors_.clear();
+  const std::vector<ReplaceTextCommand*>& done_commands = composite_command->commands();
+  const std::vector<wxPoint>& end_positions = composite_command->end_positions();
+  for (size_t i = 0; i < done_commands.size(); ++i) {
+    if (done_commands[i] == primary_command) {
+      caret_pos_ = end_positions[i];
+    } else {
+      extra_cursors_.push_back(Cursor(end_positions[i], end_positions[i]));
+    }
+  }
+
+  selection_start_ = caret_pos_;
+  selection_region_.set_start_pos(caret_pos_);
+  selection_region_.set_end_pos(caret_pos_);
+  NormalizeCursors();
+  UpdateCaret();
+  text_panel_->Refresh();
+}
+
 void TextScrollWindow::SetCharSize() {
   SetFont(config_->font_);
   wxClientDC dc(this);
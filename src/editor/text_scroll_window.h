@@ -3,10 +3,17 @@
 #pragma once
 
 #include <list>
+#include <vector>
 #include "wx/scrolwin.h"
 #include "wx/gdicmn.h"
+#include "wx/bitmap.h"
+#include "editor/bracket_index.h"
+#include "editor/cursor.h"
+#include "editor/fold_index.h"
+#include "editor/minimap.h"
 #include "editor/selection_region.h"
 #include "editor/text_listener.h"
+#include "editor/wrap_index.h"
 
 namespace editor {
 
@@ -14,7 +21,23 @@ class Config;
 class TextFile;
 class TextPanel;
 class LineNumberPanel;
+class MinimapPanel;
 class EditCommand;
+class ReplaceTextCommand;
+class MemoryUsage;
+class Document;
+
+// Ids of the edit commands which have no stock id.
+enum {
+  ID_SELECT_ALL_OCCURRENCES = wxID_HIGHEST + 1,
+  ID_WORD_WRAP,
+  ID_FIND_NEXT,
+  ID_GO_TO_LINE,
+  ID_GO_TO_MATCHING_BRACKET,
+  ID_TOGGLE_FOLD,
+  ID_UNFOLD_ALL,
+  ID_COMPLETE_WORD,
+};
 
 class TextScrollWindow : public wxScrolledWindow, public TextListener {
   wxDECLARE_EVENT_TABLE();
@@ -29,19 +52,37 @@ public:
               const wxSize& size = wxDefaultSize,
               long style = wxScrolledWindowStyle);
 
-  // TODO : need reconstruct
-  void SetTextFile(const wxString& file_name);
-  bool IsFileChanged();
-  bool IsNewFile();
-  void SetFileNew(bool state);
-  void SetFileChanged(bool state);
-  void CreateNewFile(const wxString& file_name);
-  void SaveFile();
-  void CloseFile();
+  // The window is a view of the document. It's attached to the text of the
+  // document while the document is loaded.
+  void SetDocument(Document* document);
+  Document* GetDocument() const { return document_; }
+  void AttachTextFile();
+  void DetachTextFile();
+
+  // The viewport is restored from the last session. The caret is clamped to
+  // the text when it's attached.
+  wxPoint GetCaretPosition() const { return caret_pos_; }
+  int GetTopLine() const;
+  void SetViewport(const wxPoint& caret_pos, int top_line);
+
+  // Move the caret to |pos| and scroll it into view, unfolding its line.
+  void GoToPosition(const wxPoint& pos);
+
+  // The identifier the caret is in or next to, empty if there is none.
+  wxString GetWordAtCaret() const;
 
   LineNumberPanel* GetLineNumberPanel() { return line_number_panel_; }
+  MinimapPanel* GetMinimapPanel() { return minimap_panel_; }
+
+  void SetWordWrap(bool is_word_wrap);
+  bool IsWordWrap() const { return is_word_wrap_; }
+
+  // Add the memory of the view. The text is counted by its document.
+  void GetMemoryUsage(MemoryUsage* usage) const;
 
   virtual void OnLineUpdate(const wxPoint& position, bool is_multi_lines) override;
+  virtual void OnLinesChanged(size_t first_line, size_t old_count, size_t new_count) override;
+  virtual void OnTextChanging() override;
 
 private:
   void Init();
@@ -52,14 +93,46 @@ private:
   void OnCopy(wxCommandEvent& event);
   void OnCut(wxCommandEvent& event);
   void OnPaste(wxCommandEvent& event);
+  void OnSelectAllOccurrences(wxCommandEvent& event);
+  void OnWordWrap(wxCommandEvent& event);
+  void OnFind(wxCommandEvent& event);
+  void OnFindNext(wxCommandEvent& event);
+  void OnGoToLine(wxCommandEvent& event);
+  void OnGoToMatchingBracket(wxCommandEvent& event);
+  void OnCompleteWord(wxCommandEvent& event);
+  void OnToggleFold(wxCommandEvent& event);
+  void OnUnfoldAll(wxCommandEvent& event);
+  void OnIdle(wxIdleEvent& event);
 
   void SetCharSize();
   void MoveCaret(wxChar ch);
+  void MoveCaretByKey(wxChar ch);
   void UpdateCaret();
+  void PlaceCaret();
+  void UpdateBracketMatch();
+  void ApplyViewport();
+
+  void Execute(EditCommand* command);
+  void KeepPositions(size_t first_line, size_t old_count, size_t new_count);
 
   void RefreshScrollbars();
   void RefreshLineNumber();
   void RefreshLines(int line_number, bool is_multi_lines);
+  void RefreshRows(int first_row, int row_count);
+
+  // Soft wrap. A row is a line of the screen, which is also a line of the
+  // text if it's neither wrapped nor folded. A folded line has no rows.
+  int GetWrapColumns() const;
+  int GetRowCount() const;
+  int GetLineRowCount(int line) const;
+  int LineToRow(int line) const;
+  int RowToLine(int row) const;
+  void GetRowRange(int line, int sub_row, size_t* from, size_t* to) const;
+  bool WrapVisibleLines();
+
+  // Code folding. The caret is never on a hidden line.
+  void ShowLine(int line);
+  void OnFoldsChanged(const Interval& lines);
 
   void MoveToPrevLine();
   void MoveToNextLine();
@@ -73,12 +146,45 @@ private:
   void InsertChar(wxChar ch);
   void DeleteChar(wxChar ch);
 
+  // Overwrite the byte of a hex text at the caret.
+  void OverwriteHexChar(wxChar ch);
+
+  // Select the next match of find_text_ from the caret on.
+  void FindNext();
+
+  wxPoint GetPrevCharPosition(const wxPoint& pos) const;
+  wxPoint GetNextCharPosition(const wxPoint& pos) const;
+
+  // Multi-cursor editing.
+  bool HasExtraCursors() const { return !extra_cursors_.empty(); }
+  void AddCursorOnLine(int line_offset);
+  void MoveExtraCursors(wxChar ch);
+  void NormalizeCursors();
+  void ClearExtraCursors();
+  void EditAtCursors(const wxString& text, int key);
+  ReplaceTextCommand* NewCursorCommand(const wxPoint& caret_pos,
+                                       const SelectionRegion& region,
+                                       const wxString& text,
+                                       int key);
+
   void CheckColumnBounds();
   void CheckRowBounds();
   void CheckTabBounds(wxPoint& point) const;
 
   void HandleTextPaint(wxDC& dc);
+  void DrawLine(wxDC& dc, int line, int row);
+  void DrawSelectionBackground(wxDC& dc,
+                               const SelectionRegion& region,
+                               int line,
+                               bool is_last_row,
+                               size_t from,
+                               size_t to,
+                               wxCoord y);
   void HandleLineNumberPaint(wxDC& dc);
+  void HandleMinimapPaint(wxDC& dc);
+  void HandleMinimapMouse(const wxPoint& point);
+  int GetMinimapHeight() const;
+  int MinimapLineToY(int line, int height) const;
   void HandleTextKeyDown(wxKeyEvent& event);
   void HandleTextKeyChar(wxKeyEvent& event);
   void HandleTextMouseLeftDown(wxMouseEvent& event);
@@ -87,7 +193,10 @@ private:
   void HandleTextSize(wxSizeEvent& event);
 
   wxPoint DeviceCoordsToTextCoords(const wxPoint& point) const;
+  int DeviceCoordsToColumn(const wxPoint& point) const;
   wxPoint TextCoordsToLogicalCoords(const wxPoint& point) const;
+  wxPoint TextCoordsToRowCoords(const wxPoint& point) const;
+  wxPoint RowCoordsToTextCoords(const wxPoint& point) const;
 
   bool HasSelection() const;
 
@@ -96,22 +205,29 @@ private:
 
   void UpdateSelectionText();
   void DeleteSelectionText();
+  void DeleteBlockSelectionText();
+  void PasteBlockText(const wxString& text);
+
+  size_t GetSelectionSize() const;
+  bool CopyToClipboard();
+  bool ReadClipboard(wxString* text, bool* is_block);
   void ClearSelectionText();
 
   int CountDigitNumber(int n) const;
 
 private:
   friend class LineNumberPanel;
+  friend class MinimapPanel;
   friend class TextPanel;
+  friend class RenderBench;
 
   LineNumberPanel* line_number_panel_;
   TextPanel* text_panel_;
+  MinimapPanel* minimap_panel_;
   TextFile* text_file_;
+  Document* document_;
   Config* config_;
 
-  bool is_file_changed_;
-  bool is_new_file_;
-
   int char_width_;
   int char_height_;
   int client_width_;
@@ -121,10 +237,58 @@ private:
   int vscroll_pos_;
   int hscroll_pos_;
 
+  int line_number_digit_count_;
+
+  // The first line in the window while the text isn't attached.
+  int top_line_;
+
   wxPoint caret_pos_;
   wxPoint selection_start_;
   SelectionRegion selection_region_;
   wxString selection_text_;
+
+  // Alt + drag selects a rectangle. The columns are not clamped to the
+  // line length while selecting.
+  bool is_block_selecting_;
+  int block_column_;
+
+  // The carets besides caret_pos_, sorted by position, and the most lines
+  // between the caret and the anchor of one, so the ones with a selection
+  // on a line are found by a binary search.
+  std::vector<Cursor> extra_cursors_;
+  int extra_selection_span_;
+
+  // The lines of a paged or a hex text are never wrapped, wrapping them
+  // would read them all, so the index may be inactive while is_word_wrap_
+  // is set.
+  bool is_word_wrap_;
+  WrapIndex wrap_index_;
+
+  // The folds of the view. A paged or a hex text isn't folded.
+  FoldIndex fold_index_;
+
+  // The bracket at the caret, or just before it, and its match, which are
+  // highlighted.
+  BracketIndex bracket_index_;
+  bool has_bracket_match_;
+  wxPoint bracket_pos_;
+  wxPoint bracket_match_pos_;
+
+  // The minimap of a paged or a hex text isn't built. The pixels last
+  // copied from it are kept to scale them again when the panel is resized.
+  Minimap minimap_;
+  std::vector<unsigned char> minimap_pixels_;
+  wxBitmap minimap_bitmap_;
+
+  wxString find_text_;
+
+  // True while the view executes an edit. The other views of the text
+  // follow the edit without moving their carets to it.
+  bool is_editing_;
+
+  // Set when another view or follow mode adds text after a caret on the
+  // last line. The window is scrolled to the caret once the text is updated.
+  bool is_caret_following_;
 };
 
 }  // namespace editor
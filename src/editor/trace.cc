@@ -0,0 +1,152 @@
+#include "editor/trace.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include "wx/thread.h"
+
+namespace editor {
+
+// About 2 MB of events per thread.
+const size_t kTraceBufferSize = 1 << 16;
+
+TraceBuffer::TraceBuffer(int thread_id, bool is_main_thread)
+    : thread_id_(thread_id),
+      is_main_thread_(is_main_thread),
+      events_(kTraceBufferSize),
+      begin_count_(0),
+      write_count_(0),
+      discard_count_(0) {
+}
+
+// A sequence lock without the retry: the begin count is stored before the
+// event, so a reader which copied the event also sees the count.
+void TraceBuffer::Add(const TraceEvent& event) {
+  size_t count = write_count_.load(std::memory_order_relaxed);
+  begin_count_.store(count + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  events_[count % events_.size()] = event;
+  write_count_.store(count + 1, std::memory_order_release);
+}
+
+void TraceBuffer::GetEvents(std::vector<TraceEvent>* events) const {
+  size_t count = write_count_.load(std::memory_order_acquire);
+  size_t first = std::max(count - std::min(count, events_.size()), discard_count_.load());
+  size_t old_size = events->size();
+  for (size_t i = first; i < count; ++i) {
+    events->push_back(events_[i % events_.size()]);
+  }
+
+  // The events the owner thread has begun to overwrite since may be torn.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  size_t begin_count = begin_count_.load(std::memory_order_relaxed);
+  if (begin_count > first + events_.size()) {
+    size_t torn_count = std::min(begin_count - events_.size() - first, count - first);
+    events->erase(events->begin() + old_size, events->begin() + old_size + torn_count);
+  }
+}
+
+void TraceBuffer::Discard() {
+  discard_count_.store(write_count_.load(std::memory_order_acquire));
+}
+
+std::atomic<bool> Tracer::is_enabled_(false);
+
+Tracer::Tracer() {
+  Now();
+}
+
+Tracer::~Tracer() {
+  for (TraceBuffer* buffer : buffers_) {
+    delete buffer;
+  }
+}
+
+Tracer& Tracer::Get() {
+  static Tracer tracer;
+  return tracer;
+}
+
+long long Tracer::Now() {
+  typedef std::chrono::steady_clock Clock;
+  static const Clock::time_point kStart = Clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - kStart).count();
+}
+
+void Tracer::Enable(bool is_enabled) {
+  is_enabled_.store(is_enabled, std::memory_order_relaxed);
+}
+
+// The buffer is created the first time a thread traces, which is the only
+// time the mutex is taken on the tracing path.
+TraceBuffer* Tracer::GetThreadBuffer() {
+  static thread_local TraceBuffer* thread_buffer = NULL;
+  if (thread_buffer == NULL) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread_buffer = new TraceBuffer(static_cast<int>(buffers_.size()) + 1, wxIsMainThread());
+    buffers_.push_back(thread_buffer);
+  }
+  return thread_buffer;
+}
+
+void Tracer::AddEvent(const char* name, long long start_us, long long duration_us) {
+  TraceEvent event = { name, start_us, duration_us };
+  GetThreadBuffer()->Add(event);
+}
+
+static void WriteJsonString(std::ostream& os, const char* str) {
+  os << '"';
+  for (; *str != '\0'; ++str) {
+    if (*str == '"' || *str == '\\') {
+      os << '\\';
+    }
+    os << *str;
+  }
+  os << '"';
+}
+
+void Tracer::WriteChromeJson(std::ostream& os) {
+  std::vector<TraceBuffer*> buffers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers = buffers_;
+  }
+
+  os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  bool is_first = true;
+  std::vector<TraceEvent> events;
+  for (const TraceBuffer* buffer : buffers) {
+    os << (is_first ? "\n" : ",\n");
+    is_first = false;
+    os << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->thread_id()
+       << ", \"args\": {\"name\": \"" << (buffer->is_main_thread() ? "main" : "worker") << "\"}}";
+
+    events.clear();
+    buffer->GetEvents(&events);
+    for (const TraceEvent& event : events) {
+      os << ",\n{\"name\": ";
+      WriteJsonString(os, event.name);
+      os << ", \"cat\": \"editor\", \"ph\": \"X\", \"ts\": " << event.start_us
+         << ", \"dur\": " << event.duration_us
+         << ", \"pid\": 1, \"tid\": " << buffer->thread_id() << "}";
+    }
+  }
+  os << "\n]}\n";
+}
+
+bool Tracer::WriteChromeJson(const wxString& file_path) {
+  std::ofstream ofs(file_path.fn_str());
+  if (!ofs) {
+    return false;
+  }
+  WriteChromeJson(ofs);
+  return ofs.good();
+}
+
+void Tracer::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (TraceBuffer* buffer : buffers_) {
+    buffer->Discard();
+  }
+}
+
+}  // namespace editor
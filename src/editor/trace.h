@@ -0,0 +1,122 @@
+#ifndef EDITOR_TRACE_H_
+#define EDITOR_TRACE_H_
+#pragma once
+
+// Scoped trace points for the hot paths of the editor. A trace point costs
+// one relaxed atomic load when tracing is off. When it's on, the time of the
+// scope is written to a ring buffer of the current thread without locking,
+// and the buffers can be dumped as Chrome trace events (chrome://tracing).
+//
+//   void TextFile::InsertText(...) {
+//     TRACE_SCOPE("TextFile::InsertText");
+//     ...
+//   }
+
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include "wx/string.h"
+
+namespace editor {
+
+struct TraceEvent {
+  const char* name;  // Must be a string literal.
+  long long start_us;
+  long long duration_us;
+};
+
+// The events of one thread. Only the owner thread writes; the oldest events
+// are overwritten when it's full.
+class TraceBuffer {
+public:
+  TraceBuffer(int thread_id, bool is_main_thread);
+
+  int thread_id() const { return thread_id_; }
+  bool is_main_thread() const { return is_main_thread_; }
+
+  void Add(const TraceEvent& event);
+
+  // The events still in the buffer, from the oldest. Any thread may call it
+  // while the owner thread adds events; those overwritten meanwhile are
+  // dropped.
+  void GetEvents(std::vector<TraceEvent>* events) const;
+
+  // Drop the events added so far. Any thread may call it.
+  void Discard();
+
+private:
+  int thread_id_;
+  bool is_main_thread_;
+  std::vector<TraceEvent> events_;
+  // The events begun to be written, and those written.
+  std::atomic<size_t> begin_count_;
+  std::atomic<size_t> write_count_;
+  // The events before it are discarded.
+  std::atomic<size_t> discard_count_;
+};
+
+class Tracer {
+public:
+  static Tracer& Get();
+
+  static bool IsEnabled() {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  // The microseconds since the tracer was created.
+  static long long Now();
+
+  void Enable(bool is_enabled);
+
+  // Record a finished scope in the buffer of the calling thread.
+  void AddEvent(const char* name, long long start_us, long long duration_us);
+
+  // Write the recorded events in the Chrome trace event format. The threads
+  // go on tracing meanwhile, and the events they overwrite are left out.
+  void WriteChromeJson(std::ostream& os);
+  bool WriteChromeJson(const wxString& file_path);
+
+  // Drop the recorded events.
+  void Clear();
+
+private:
+  Tracer();
+  ~Tracer();
+
+  TraceBuffer* GetThreadBuffer();
+
+  static std::atomic<bool> is_enabled_;
+
+  // The buffers of all threads which have traced, also of the finished ones.
+  std::mutex mutex_;
+  std::vector<TraceBuffer*> buffers_;
+};
+
+class TraceScope {
+public:
+  explicit TraceScope(const char* name) : name_(NULL), start_us_(0) {
+    if (Tracer::IsEnabled()) {
+      name_ = name;
+      start_us_ = Tracer::Now();
+    }
+  }
+
+  ~TraceScope() {
+    if (name_ != NULL) {
+      Tracer::Get().AddEvent(name_, start_us_, Tracer::Now() - start_us_);
+    }
+  }
+
+private:
+  const char* name_;
+  long long start_us_;
+};
+
+#define TRACE_SCOPE_CONCAT_(a, b) a##b
+#define TRACE_SCOPE_NAME_(line) TRACE_SCOPE_CONCAT_(trace_scope_, line)
+#define TRACE_SCOPE(name) ::editor::TraceScope TRACE_SCOPE_NAME_(__LINE__)(name)
+
+}  // namespace editor
+
+#endif  // EDITOR_TRACE_H_
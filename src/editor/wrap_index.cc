@@ -0,0 +1,150 @@
+#include "editor/wrap_index.h"
+#include <cassert>
+#include <vector>
+#include "editor/fold_index.h"
+#include "editor/text_file.h"
+#include "editor/trace.h"
+
+namespace editor {
+
+WrapIndex::WrapIndex()
+    : text_file_(NULL),
+      fold_index_(NULL),
+      wrap_columns_(0) {
+}
+
+void WrapIndex::Reset(const TextFile* text_file, int wrap_columns, const FoldIndex* fold_index) {
+  text_file_ = text_file;
+  fold_index_ = fold_index;
+  wrap_columns_ = wrap_columns;
+
+  // A hidden line has no rows and isn't stale.
+  std::vector<int> row_counts(text_file_->GetLineCount(), 1);
+  if (fold_index_->HasFolds()) {
+    for (size_t i = 0; i < row_counts.size(); ++i) {
+      if (fold_index_->IsHidden(i)) {
+        row_counts[i] = 0;
+      }
+    }
+  }
+  rows_.Assign(row_counts);
+  stale_lines_.Assign(row_counts);
+}
+
+void WrapIndex::Clear() {
+  text_file_ = NULL;
+  fold_index_ = NULL;
+  rows_.Clear();
+  stale_lines_.Clear();
+}
+
+bool WrapIndex::SetWrapColumns(int wrap_columns) {
+  if (wrap_columns == wrap_columns_) {
+    return false;
+  }
+  wrap_columns_ = wrap_columns;
+  stale_lines_.Assign(std::vector<int>(rows_.size(), 1));
+  return true;
+}
+
+// The trees keep a gap where the lines were last inserted or removed, so
+// the lines of an edit near the last one are inserted or removed in
+// O(log n) each. The new lines are wrapped only once.
+void WrapIndex::OnLinesChanged(size_t first_line, size_t old_count, size_t new_count) {
+  TRACE_SCOPE("WrapIndex::OnLinesChanged");
+  if (!is_active()) {
+    return;
+  }
+  assert(first_line + old_count <= rows_.size());
+
+  if (old_count != new_count) {
+    rows_.Erase(first_line, old_count);
+    stale_lines_.Erase(first_line, old_count);
+    rows_.Insert(first_line, new_count, 0);
+    stale_lines_.Insert(first_line, new_count, 0);
+  }
+
+  for (size_t i = first_line; i != first_line + new_count; ++i) {
+    if (old_count == new_count) {
+      stale_lines_.Set(i, 0);
+    }
+    rows_.Set(i, GetWrapRowCount(i));
+  }
+}
+
+bool WrapIndex::WrapLine(size_t line) {
+  stale_lines_.Set(line, 0);
+
+  int row_count = GetWrapRowCount(line);
+  if (row_count == rows_.Get(line)) {
+    return false;
+  }
+  rows_.Set(line, row_count);
+  return true;
+}
+
+int WrapIndex::GetWrapRowCount(size_t line) const {
+  if (fold_index_->IsHidden(line)) {
+    return 0;
+  }
+  return text_file_->GetLine(line).GetWrapRowCount(wrap_columns_);
+}
+
+size_t WrapIndex::FindStaleLine(size_t line) const {
+  return stale_lines_.FindCount(stale_lines_.PrefixSum(line));
+}
+
+bool WrapIndex::WrapLines(size_t first_line, size_t end_line) {
+  bool is_changed = false;
+  for (size_t i = FindStaleLine(first_line); i < end_line; i = FindStaleLine(i + 1)) {
+    if (WrapLine(i)) {
+      is_changed = true;
+    }
+  }
+  return is_changed;
+}
+
+// A hidden line is never stale. A line shown again keeps one row until it's
+// rewrapped.
+void WrapIndex::UpdateHiddenLines(size_t first_line, size_t end_line) {
+  if (!is_active()) {
+    return;
+  }
+  if (end_line > rows_.size()) {
+    end_line = rows_.size();
+  }
+
+  for (size_t i = first_line; i < end_line; ++i) {
+    if (fold_index_->IsHidden(i)) {
+      stale_lines_.Set(i, 0);
+      rows_.Set(i, 0);
+    } else if (rows_.Get(i) == 0) {
+      rows_.Set(i, 1);
+      stale_lines_.Set(i, 1);
+    }
+  }
+}
+
+bool WrapIndex::WrapStaleLines(size_t max_count) {
+  TRACE_SCOPE("WrapIndex::WrapStaleLines");
+  size_t line = FindStaleLine(0);
+  for (size_t count = 0; count < max_count && line < rows_.size(); ++count) {
+    WrapLine(line);
+    line = FindStaleLine(line + 1);
+  }
+  return line < rows_.size();
+}
+
+size_t WrapIndex::RowToLine(int row) const {
+  if (rows_.size() == 0) {
+    return 0;
+  }
+  size_t line = rows_.FindCount(row < 0 ? 0 : row);
+  return line < rows_.size() ? line : rows_.size() - 1;
+}
+
+size_t WrapIndex::GetMemoryUsage() const {
+  return rows_.GetMemoryUsage() + stale_lines_.GetMemoryUsage();
+}
+
+}  // namespace editor
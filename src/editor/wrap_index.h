@@ -0,0 +1,77 @@
+#ifndef EDITOR_WRAP_INDEX_H_
+#define EDITOR_WRAP_INDEX_H_
+#pragma once
+
+#include "editor/fenwick_tree.h"
+
+namespace editor {
+
+class FoldIndex;
+class TextFile;
+
+// The wrapped rows of the lines of a text file. The row count of each line
+// is kept in a Fenwick tree, so a line and its first row are mapped to each
+// other in O(log n). After an edit only the changed lines are rewrapped, and
+// the lines inserted or removed are in O(log n) each.
+//
+// When the wrap width changes, all lines become stale. They keep their old
+// row counts until they're rewrapped, visible ones first and the rest in
+// small steps. The stale lines are another Fenwick tree of ones, so the next
+// one is found by its prefix sum.
+//
+// A line hidden by a fold has no rows.
+class WrapIndex {
+public:
+  WrapIndex();
+
+  void Reset(const TextFile* text_file, int wrap_columns, const FoldIndex* fold_index);
+  void Clear();
+
+  bool is_active() const { return text_file_ != NULL; }
+  int wrap_columns() const { return wrap_columns_; }
+
+  // Return false if the width isn't changed.
+  bool SetWrapColumns(int wrap_columns);
+
+  // The lines [first_line, first_line + old_count) were replaced by
+  // [first_line, first_line + new_count). The new lines are wrapped now.
+  void OnLinesChanged(size_t first_line, size_t old_count, size_t new_count);
+
+  // Rewrap the stale lines in [first_line, end_line). Return true if any
+  // row count is changed.
+  bool WrapLines(size_t first_line, size_t end_line);
+
+  // The lines [first_line, end_line) were folded or unfolded. The lines
+  // shown again become stale.
+  void UpdateHiddenLines(size_t first_line, size_t end_line);
+
+  // Rewrap at most |max_count| stale lines. Return true if any is left.
+  bool WrapStaleLines(size_t max_count);
+  bool HasStaleLines() const { return stale_lines_.TotalSum() != 0; }
+
+  int GetRowCount() const { return rows_.TotalSum(); }
+  int GetLineRowCount(size_t line) const { return rows_.Get(line); }
+  int LineToRow(size_t line) const { return rows_.PrefixSum(line); }
+  size_t RowToLine(int row) const;
+
+  size_t GetMemoryUsage() const;
+
+private:
+  bool WrapLine(size_t line);
+  int GetWrapRowCount(size_t line) const;
+
+  // The first stale line at or after |line|, or the line count if none.
+  size_t FindStaleLine(size_t line) const;
+
+private:
+  const TextFile* text_file_;
+  const FoldIndex* fold_index_;
+  int wrap_columns_;
+
+  FenwickTree rows_;
+  FenwickTree stale_lines_;  // 1 for a stale line
+};
+
+}  // namespace editor
+
+#endif  // EDITOR_WRAP_INDEX_H_
@@ -0,0 +1,119 @@
+#include "editor/wrap_index.h"
+#include "editor/fold_index.h"
+#include "editor/text_file.h"
+#include "editor/text_listener.h"
+#include "gtest/gtest.h"
+
+using namespace editor;
+
+namespace {
+
+// Check each line and its rows against the rows the line wraps to.
+void ExpectRows(const TextFile& text_file, const FoldIndex& fold_index, const WrapIndex& wrap_index) {
+  int row = 0;
+  for (size_t i = 0; i < text_file.GetLineCount(); ++i) {
+    int row_count = 0;
+    if (!fold_index.IsHidden(i)) {
+      row_count = text_file.GetLine(i).GetWrapRowCount(wrap_index.wrap_columns());
+    }
+    EXPECT_EQ(row, wrap_index.LineToRow(i));
+    EXPECT_EQ(row_count, wrap_index.GetLineRowCount(i));
+    for (int j = 0; j < row_count; ++j) {
+      EXPECT_EQ(i, wrap_index.RowToLine(row + j));
+    }
+    row += row_count;
+  }
+  EXPECT_EQ(row, wrap_index.GetRowCount());
+}
+
+// Keeps the indexes up to date with the edits of the text, as a view does.
+class WrapIndexTest : public testing::Test, public TextListener {
+protected:
+  virtual void SetUp() override {
+    for (int i = 0; i < 100; ++i) {
+      text_file_.AddLine(wxString(wxT('a'), i % 30) + wxT(" bb ccc"));
+    }
+    fold_index_.Reset(&text_file_);
+    wrap_index_.Reset(&text_file_, 8, &fold_index_);
+    while (wrap_index_.WrapStaleLines(16)) {
+    }
+    text_file_.AttachListener(this);
+  }
+
+  virtual void OnLineUpdate(const wxPoint& position, bool is_multi_lines) override {
+  }
+
+  virtual void OnLinesChanged(size_t first_line, size_t old_count, size_t new_count) override {
+    bool is_unfolded = fold_index_.OnLinesChanged(first_line, old_count, new_count);
+    wrap_index_.OnLinesChanged(first_line, old_count, new_count);
+    if (is_unfolded) {
+      wrap_index_.UpdateHiddenLines(0, text_file_.GetLineCount());
+    }
+  }
+
+  // Delete the lines [first_line, first_line + count).
+  void DeleteLines(size_t first_line, size_t count) {
+    wxString text;
+    for (size_t i = first_line; i < first_line + count; ++i) {
+      text += text_file_.GetLine(i).GetData() + wxT("\r");
+    }
+    text_file_.DeleteText(wxPoint(0, static_cast<int>(first_line)), text);
+  }
+
+  TextFile text_file_;
+  FoldIndex fold_index_;
+  WrapIndex wrap_index_;
+};
+
+}  // namespace
+
+TEST_F(WrapIndexTest, Rows) {
+  ExpectRows(text_file_, fold_index_, wrap_index_);
+  EXPECT_EQ(0u, wrap_index_.RowToLine(-1));
+  EXPECT_EQ(99u, wrap_index_.RowToLine(wrap_index_.GetRowCount() + 10));
+}
+
+TEST_F(WrapIndexTest, LinesChanged) {
+  text_file_.InsertText(wxPoint(3, 10), wxString(wxT('x'), 40));
+  ExpectRows(text_file_, fold_index_, wrap_index_);
+
+  text_file_.InsertText(wxPoint(0, 20), wxT("a b c d\re f g h i j k l\r\r"));
+  ExpectRows(text_file_, fold_index_, wrap_index_);
+
+  DeleteLines(22, 10);
+  DeleteLines(80, 7);
+  text_file_.InsertText(wxPoint(0, 0), wxT("a\rbbbb bbbb bbbb\r"));
+  ExpectRows(text_file_, fold_index_, wrap_index_);
+}
+
+TEST_F(WrapIndexTest, Folds) {
+  text_file_.InsertText(wxPoint(0, 10), wxT("void f() {\r  int a = 0;\r  int b = 1;\r}\r"));
+  Interval lines;
+  ASSERT_TRUE(fold_index_.Fold(10, &lines));
+  wrap_index_.UpdateHiddenLines(lines.first, lines.last + 1);
+  EXPECT_EQ(0, wrap_index_.GetLineRowCount(11));
+  ExpectRows(text_file_, fold_index_, wrap_index_);
+
+  // A line shown again is rewrapped.
+  ASSERT_TRUE(fold_index_.Unfold(10, &lines));
+  wrap_index_.UpdateHiddenLines(lines.first, lines.last + 1);
+  EXPECT_TRUE(wrap_index_.HasStaleLines());
+  wrap_index_.WrapLines(lines.first, lines.last + 1);
+  ExpectRows(text_file_, fold_index_, wrap_index_);
+}
+
+TEST_F(WrapIndexTest, WrapColumns) {
+  EXPECT_FALSE(wrap_index_.SetWrapColumns(8));
+  EXPECT_TRUE(wrap_index_.SetWrapColumns(12));
+  EXPECT_TRUE(wrap_index_.HasStaleLines());
+
+  // The visible lines are wrapped first.
+  wrap_index_.WrapLines(40, 50);
+  for (size_t i = 40; i < 50; ++i) {
+    EXPECT_EQ(text_file_.GetLine(i).GetWrapRowCount(12), wrap_index_.GetLineRowCount(i));
+  }
+  while (wrap_index_.WrapStaleLines(7)) {
+  }
+  EXPECT_FALSE(wrap_index_.HasStaleLines());
+  ExpectRows(text_file_, fold_index_, wrap_index_);
+}
@@ -0,0 +1,294 @@
+#include "syntax/cpp_definition_finder.h"
+#include <cstring>
+
+namespace syntax {
+
+static bool IsTokenText(const wxString& line, const Token& token, const char* text) {
+  if (static_cast<size_t>(token.length) != strlen(text)) {
+    return false;
+  }
+  wxString::const_iterator it = line.begin() + token.column;
+  for (int i = 0; i < token.length; ++i, ++it) {
+    if (*it != static_cast<wxChar>(text[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool IsPunctuation(const wxString& line, const Token& token, wxChar ch) {
+  return token.kind == TOKEN_PUNCTUATION && line[token.column] == ch;
+}
+
+// A directive is continued on the next line if it ends with a backslash.
+static bool IsContinued(const wxString& line) {
+  for (size_t i = line.Len(); i > 0; --i) {
+    wxChar ch = line[i - 1];
+    if (ch != wxT(' ') && ch != wxT('\t')) {
+      return ch == wxT('\\');
+    }
+  }
+  return false;
+}
+
+CppDefinitionFinder::CppDefinitionFinder()
+    : line_(0),
+      lexer_state_(CppParser::STATE_NORMAL),
+      is_in_directive_(false),
+      skip_depth_(0),
+      is_next_brace_scope_(false),
+      paren_depth_(0),
+      initializer_brace_depth_(0),
+      class_state_(CLASS_NONE),
+      class_line_(0),
+      class_column_(0),
+      function_state_(FUNCTION_NONE),
+      function_line_(0),
+      function_column_(0) {
+}
+
+void CppDefinitionFinder::ParseLine(const wxString& line, std::vector<Definition>* definitions) {
+  tokens_.clear();
+  lexer_state_ = CppParser::ParseLine(line, lexer_state_, &tokens_);
+
+  if (is_in_directive_) {
+    is_in_directive_ = IsContinued(line);
+  } else if (!tokens_.empty() && IsPunctuation(line, tokens_[0], wxT('#'))) {
+    ParseDirective(line, definitions);
+    is_in_directive_ = IsContinued(line);
+  } else if (skip_depth_ == 0) {
+    for (size_t i = 0; i < tokens_.size(); ++i) {
+      ParseToken(line, i, definitions);
+    }
+  }
+  ++line_;
+}
+
+// Only the first branch of an #if is read, so the braces its branches open
+// or close in more than one way are counted once.
+void CppDefinitionFinder::ParseDirective(const wxString& line, std::vector<Definition>* definitions) {
+  if (tokens_.size() < 2) {
+    return;
+  }
+  const Token& directive = tokens_[1];
+  if (IsTokenText(line, directive, "if") ||
+      IsTokenText(line, directive, "ifdef") ||
+      IsTokenText(line, directive, "ifndef")) {
+    if (skip_depth_ > 0) {
+      ++skip_depth_;
+    }
+  } else if (IsTokenText(line, directive, "else") || IsTokenText(line, directive, "elif")) {
+    if (skip_depth_ == 0) {
+      skip_depth_ = 1;
+    }
+  } else if (IsTokenText(line, directive, "endif")) {
+    if (skip_depth_ > 0) {
+      --skip_depth_;
+    }
+  } else if (skip_depth_ == 0 && IsTokenText(line, directive, "define") &&
+             tokens_.size() > 2 && tokens_[2].kind == TOKEN_IDENTIFIER) {
+    AddDefinition(DEFINITION_MACRO, line.substr(tokens_[2].column, tokens_[2].length),
+                  line_, tokens_[2].column, definitions);
+  }
+}
+
+void CppDefinitionFinder::ParseToken(const wxString& line, size_t index, std::vector<Definition>* definitions) {
+  const Token& token = tokens_[index];
+  switch (token.kind) {
+    case TOKEN_IDENTIFIER:
+      ParseIdentifier(line, index);
+      break;
+    case TOKEN_KEYWORD:
+      ParseKeyword(line, token);
+      break;
+    case TOKEN_PUNCTUATION:
+      ParsePunctuation(line, index, definitions);
+      break;
+    default:
+      if (paren_depth_ == 0 && function_state_ == FUNCTION_NAME) {
+        function_state_ = FUNCTION_NONE;
+      }
+      break;
+  }
+}
+
+void CppDefinitionFinder::ParseIdentifier(const wxString& line, size_t index) {
+  if (paren_depth_ > 0 || initializer_brace_depth_ > 0) {
+    return;
+  }
+  const Token& token = tokens_[index];
+  if (class_state_ == CLASS_KEY && !IsTokenText(line, token, "final")) {
+    class_name_.assign(line, token.column, token.length);
+    class_line_ = line_;
+    class_column_ = token.column;
+  }
+  if ((function_state_ == FUNCTION_NONE || function_state_ == FUNCTION_NAME) && IsAtScope()) {
+    SetFunctionName(line, index);
+    function_state_ = FUNCTION_NAME;
+  }
+}
+
+void CppDefinitionFinder::ParseKeyword(const wxString& line, const Token& token) {
+  if (paren_depth_ > 0 || initializer_brace_depth_ > 0) {
+    return;
+  }
+  if (IsTokenText(line, token, "class") ||
+      IsTokenText(line, token, "struct") ||
+      IsTokenText(line, token, "union") ||
+      IsTokenText(line, token, "enum")) {
+    // "enum class" is one class key.
+    if (class_state_ == CLASS_NONE) {
+      class_state_ = CLASS_KEY;
+      class_name_.clear();
+    }
+  } else if (IsTokenText(line, token, "namespace") || IsTokenText(line, token, "extern")) {
+    is_next_brace_scope_ = true;
+  } else if (function_state_ == FUNCTION_NAME) {
+    function_state_ = FUNCTION_NONE;
+  }
+}
+
+void CppDefinitionFinder::ParsePunctuation(const wxString& line, size_t index, std::vector<Definition>* definitions) {
+  wxChar ch = line[tokens_[index].column];
+  if (ch == wxT('(')) {
+    if (paren_depth_ == 0 && initializer_brace_depth_ == 0) {
+      if (function_state_ == FUNCTION_NAME) {
+        function_state_ = FUNCTION_PARAMETERS;
+      } else if (function_state_ == FUNCTION_DECLARATOR && IsCallAfterDeclarator(line, index)) {
+        SetFunctionName(line, index - 1);
+        function_state_ = FUNCTION_PARAMETERS;
+      }
+      if (class_state_ == CLASS_KEY) {
+        class_state_ = CLASS_NONE;
+      }
+    }
+    ++paren_depth_;
+    return;
+  }
+  if (ch == wxT(')')) {
+    if (paren_depth_ > 0 && --paren_depth_ == 0 && function_state_ == FUNCTION_PARAMETERS) {
+      function_state_ = FUNCTION_DECLARATOR;
+    }
+    return;
+  }
+  // The braces in parentheses, e.g. of a lambda, are balanced there.
+  if (paren_depth_ > 0) {
+    return;
+  }
+
+  switch (ch) {
+    case wxT('{'):
+      OpenBrace(line, index, definitions);
+      break;
+    case wxT('}'):
+      if (initializer_brace_depth_ > 0) {
+        --initializer_brace_depth_;
+        break;
+      }
+      if (!scopes_.empty()) {
+        scopes_.pop_back();
+      }
+      EndDeclaration();
+      break;
+    case wxT(';'):
+      if (initializer_brace_depth_ == 0) {
+        EndDeclaration();
+      }
+      break;
+    case wxT(':'):
+      if (initializer_brace_depth_ > 0 || IsScopeOperator(line, index)) {
+        break;
+      }
+      if (function_state_ == FUNCTION_DECLARATOR) {
+        function_state_ = FUNCTION_INITIALIZERS;
+      } else if (function_state_ == FUNCTION_NAME) {
+        function_state_ = FUNCTION_NONE;
+      }
+      if (class_state_ == CLASS_KEY) {
+        class_state_ = CLASS_BASES;
+      }
+      break;
+    default:
+      if (initializer_brace_depth_ > 0) {
+        break;
+      }
+      if (class_state_ == CLASS_KEY) {
+        class_state_ = CLASS_NONE;
+      }
+      if (function_state_ == FUNCTION_NAME ||
+          (function_state_ == FUNCTION_DECLARATOR && (ch == wxT(',') || ch == wxT('=')))) {
+        function_state_ = FUNCTION_NONE;
+      }
+      break;
+  }
+}
+
+// A brace after a member name in an initializer list initializes it.
+void CppDefinitionFinder::OpenBrace(const wxString& line, size_t index, std::vector<Definition>* definitions) {
+  if (initializer_brace_depth_ > 0 ||
+      (function_state_ == FUNCTION_INITIALIZERS && index > 0 &&
+       (tokens_[index - 1].kind == TOKEN_IDENTIFIER || IsPunctuation(line, tokens_[index - 1], wxT('>'))))) {
+    ++initializer_brace_depth_;
+    return;
+  }
+
+  bool is_scope = false;
+  if (class_state_ != CLASS_NONE) {
+    if (!class_name_.IsEmpty()) {
+      AddDefinition(DEFINITION_CLASS, class_name_, class_line_, class_column_, definitions);
+    }
+    is_scope = true;
+  } else if (function_state_ == FUNCTION_DECLARATOR || function_state_ == FUNCTION_INITIALIZERS) {
+    AddDefinition(DEFINITION_FUNCTION, function_name_, function_line_, function_column_, definitions);
+  } else {
+    is_scope = is_next_brace_scope_;
+  }
+  scopes_.push_back(is_scope);
+  EndDeclaration();
+}
+
+void CppDefinitionFinder::EndDeclaration() {
+  class_state_ = CLASS_NONE;
+  function_state_ = FUNCTION_NONE;
+  is_next_brace_scope_ = false;
+}
+
+void CppDefinitionFinder::SetFunctionName(const wxString& line, size_t index) {
+  const Token& token = tokens_[index];
+  function_name_.clear();
+  if (index > 0 && IsPunctuation(line, tokens_[index - 1], wxT('~'))) {
+    function_name_ += wxT('~');
+  }
+  function_name_.append(line, token.column, token.length);
+  function_line_ = line_;
+  function_column_ = token.column;
+}
+
+// Two colons next to each other.
+bool CppDefinitionFinder::IsScopeOperator(const wxString& line, size_t index) const {
+  int column = tokens_[index].column;
+  return (index > 0 && tokens_[index - 1].column == column - 1 && IsPunctuation(line, tokens_[index - 1], wxT(':'))) ||
+      (index + 1 < tokens_.size() && tokens_[index + 1].column == column + 1 &&
+       IsPunctuation(line, tokens_[index + 1], wxT(':')));
+}
+
+// After the parameters, a name and parameters are of a function after a
+// macro call with no semicolon, but a compiler attribute isn't.
+bool CppDefinitionFinder::IsCallAfterDeclarator(const wxString& line, size_t index) const {
+  if (index == 0 || tokens_[index - 1].kind != TOKEN_IDENTIFIER) {
+    return false;
+  }
+  const Token& name = tokens_[index - 1];
+  return !(name.length >= 2 && line[name.column] == wxT('_') && line[name.column + 1] == wxT('_'));
+}
+
+void CppDefinitionFinder::AddDefinition(DefinitionKind kind,
+                                        const wxString& name,
+                                        int line,
+                                        int column,
+                                        std::vector<Definition>* definitions) const {
+  Definition definition = { kind, name, line, column };
+  definitions->push_back(definition);
+}
+
+}  // namespace syntax
@@ -0,0 +1,100 @@
+#ifndef SYNTAX_CPP_DEFINITION_FINDER_H_
+#define SYNTAX_CPP_DEFINITION_FINDER_H_
+#pragma once
+
+#include <vector>
+#include "wx/string.h"
+#include "syntax/cpp_parser.h"
+
+namespace syntax {
+
+enum DefinitionKind {
+  DEFINITION_CLASS = 0,  // a class, a struct, a union or an enum
+  DEFINITION_FUNCTION,
+  DEFINITION_MACRO,
+};
+
+struct Definition {
+  DefinitionKind kind;
+  wxString name;
+  int line;
+  int column;
+};
+
+// Finds the definitions of a C++ file from the tokens of its lines, with no
+// real parsing, so code it can't tell apart, e.g. made by macros, may be
+// missed or taken for a definition. A class is a class key and a name
+// followed by a body, a function is a name and its parameters at namespace
+// or class scope followed by a body or a constructor initializer list, and
+// a macro is a #define. A destructor is named with its ~.
+class CppDefinitionFinder {
+public:
+  CppDefinitionFinder();
+
+  // Append the definitions of the next line of the file to |definitions|.
+  void ParseLine(const wxString& line, std::vector<Definition>* definitions);
+
+private:
+  enum ClassState {
+    CLASS_NONE = 0,
+    CLASS_KEY,  // after the class key, the last identifier is the name
+    CLASS_BASES,  // after the : of the base classes
+  };
+
+  enum FunctionState {
+    FUNCTION_NONE = 0,
+    FUNCTION_NAME,  // after an identifier at scope
+    FUNCTION_PARAMETERS,
+    FUNCTION_DECLARATOR,  // after the parameters
+    FUNCTION_INITIALIZERS,  // after the : of a constructor
+  };
+
+  // The tokens are of the line being parsed, and |index| is of one of them.
+  void ParseDirective(const wxString& line, std::vector<Definition>* definitions);
+  void ParseToken(const wxString& line, size_t index, std::vector<Definition>* definitions);
+  void ParseIdentifier(const wxString& line, size_t index);
+  void ParseKeyword(const wxString& line, const Token& token);
+  void ParsePunctuation(const wxString& line, size_t index, std::vector<Definition>* definitions);
+  void OpenBrace(const wxString& line, size_t index, std::vector<Definition>* definitions);
+  void EndDeclaration();
+
+  void SetFunctionName(const wxString& line, size_t index);
+
+  bool IsAtScope() const { return scopes_.empty() || scopes_.back(); }
+  bool IsScopeOperator(const wxString& line, size_t index) const;
+  bool IsCallAfterDeclarator(const wxString& line, size_t index) const;
+
+  void AddDefinition(DefinitionKind kind,
+                     const wxString& name,
+                     int line,
+                     int column,
+                     std::vector<Definition>* definitions) const;
+
+private:
+  int line_;
+  CppParser::State lexer_state_;
+  bool is_in_directive_;  // a directive continued by a backslash
+  int skip_depth_;  // the #if nesting in a branch after the first one
+  std::vector<Token> tokens_;
+
+  // Whether each brace open is a namespace, a class or an extern block,
+  // whose definitions are looked for.
+  std::vector<bool> scopes_;
+  bool is_next_brace_scope_;
+  int paren_depth_;
+  int initializer_brace_depth_;
+
+  ClassState class_state_;
+  wxString class_name_;
+  int class_line_;
+  int class_column_;
+
+  FunctionState function_state_;
+  wxString function_name_;
+  int function_line_;
+  int function_column_;
+};
+
+}  // namespace syntax
+
+#endif  // SYNTAX_CPP_DEFINITION_FINDER_H_
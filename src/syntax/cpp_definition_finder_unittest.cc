@@ -0,0 +1,93 @@
+#include "syntax/cpp_definition_finder.h"
+#include "gtest/gtest.h"
+
+using namespace syntax;
+
+namespace {
+
+std::vector<Definition> FindDefinitions(const wxChar* const* lines, size_t count) {
+  CppDefinitionFinder finder;
+  std::vector<Definition> definitions;
+  for (size_t i = 0; i < count; ++i) {
+    finder.ParseLine(lines[i], &definitions);
+  }
+  return definitions;
+}
+
+void ExpectDefinition(const Definition& definition, DefinitionKind kind, const wxString& name, int line, int column) {
+  EXPECT_EQ(kind, definition.kind);
+  EXPECT_EQ(name, definition.name);
+  EXPECT_EQ(line, definition.line);
+  EXPECT_EQ(column, definition.column);
+}
+
+}  // namespace
+
+TEST(CppDefinitionFinderTest, Classes) {
+  const wxChar* lines[] = {
+    wxT("class Foo;"),
+    wxT("struct Bar final : public Foo {"),
+    wxT("  enum class Kind { A, B };"),
+    wxT("};"),
+    wxT("union U"),
+    wxT("{"),
+    wxT("};"),
+  };
+  std::vector<Definition> definitions = FindDefinitions(lines, 7);
+  ASSERT_EQ(3u, definitions.size());
+  ExpectDefinition(definitions[0], DEFINITION_CLASS, wxT("Bar"), 1, 7);
+  ExpectDefinition(definitions[1], DEFINITION_CLASS, wxT("Kind"), 2, 13);
+  ExpectDefinition(definitions[2], DEFINITION_CLASS, wxT("U"), 4, 6);
+}
+
+TEST(CppDefinitionFinderTest, Functions) {
+  const wxChar* lines[] = {
+    wxT("int Declared(int a);"),
+    wxT("namespace ns {"),
+    wxT("static int Add(int a, int b) {"),
+    wxT("  return Call(a, [](int x) { return x; });"),
+    wxT("}"),
+    wxT("Foo::Foo(int a)"),
+    wxT("    : a_(a), b_{a} {"),
+    wxT("}"),
+    wxT("Foo::~Foo() {}"),
+    wxT("}  // namespace ns"),
+  };
+  std::vector<Definition> definitions = FindDefinitions(lines, 10);
+  ASSERT_EQ(3u, definitions.size());
+  ExpectDefinition(definitions[0], DEFINITION_FUNCTION, wxT("Add"), 2, 11);
+  ExpectDefinition(definitions[1], DEFINITION_FUNCTION, wxT("Foo"), 5, 5);
+  ExpectDefinition(definitions[2], DEFINITION_FUNCTION, wxT("~Foo"), 8, 6);
+}
+
+TEST(CppDefinitionFinderTest, Macros) {
+  const wxChar* lines[] = {
+    wxT("#define MAX(a, b) \\"),
+    wxT("  ((a) > (b) ? (a) : (b))"),
+    wxT("#ifdef X"),
+    wxT("#define ONE 1"),
+    wxT("#else"),
+    wxT("#define TWO 2"),
+    wxT("#endif"),
+  };
+  std::vector<Definition> definitions = FindDefinitions(lines, 7);
+
+  // Only the first branch of an #if is read.
+  ASSERT_EQ(2u, definitions.size());
+  ExpectDefinition(definitions[0], DEFINITION_MACRO, wxT("MAX"), 0, 8);
+  ExpectDefinition(definitions[1], DEFINITION_MACRO, wxT("ONE"), 3, 8);
+}
+
+TEST(CppDefinitionFinderTest, CommentsAndStrings) {
+  const wxChar* lines[] = {
+    wxT("/* void Commented() {"),
+    wxT("} */"),
+    wxT("const char* s = \"void Quoted() {}\";  // void Comment() {}"),
+    wxT("void Real() {"),
+    wxT("  if (a) { b(); }"),
+    wxT("}"),
+  };
+  std::vector<Definition> definitions = FindDefinitions(lines, 6);
+  ASSERT_EQ(1u, definitions.size());
+  ExpectDefinition(definitions[0], DEFINITION_FUNCTION, wxT("Real"), 3, 5);
+}
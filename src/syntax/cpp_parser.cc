@@ -1,199 +1,143 @@
 #include "syntax/cpp_parser.h"
+#include <cstring>
 
-//static bool IsCppKeyword(LPCTSTR pszChars, int nLength) {
-//  for (int L = 0; s_apszCppKeywordList[L] != NULL; L++) {
-//    if (strncmp(s_apszCppKeywordList[L], pszChars, nLength) == 0
-//        && s_apszCppKeywordList[L][nLength] == 0)
-//        return TRUE;
-//  }
-//  return FALSE;
-//}
-//
-//static bool IsCppNumber(LPCTSTR pszChars, int nLength) {
-//  if (nLength > 2 && pszChars[0] == '0' && pszChars[1] == 'x') {
-//    for (int I = 2; I < nLength; I++) {
-//      if (isdigit(pszChars[I]) || (pszChars[I] >= 'A' && pszChars[I] <= 'F') ||
-//          (pszChars[I] >= 'a' && pszChars[I] <= 'f'))
-//          continue;
-//      return FALSE;
-//    }
-//    return TRUE;
-//  }
-//  if (!isdigit(pszChars[0]))
-//    return FALSE;
-//  for (int I = 1; I < nLength; I++) {
-//    if (!isdigit(pszChars[I]) && pszChars[I] != '+' &&
-//        pszChars[I] != '-' && pszChars[I] != '.' && pszChars[I] != 'e' &&
-//        pszChars[I] != 'E')
-//        return FALSE;
-//  }
-//  return TRUE;
-//}
+namespace syntax {
 
-//#define DEFINE_BLOCK(pos, colorindex)	\
-//	ASSERT((pos) >= 0 && (pos) <= nLength);\
-//	if (pBuf != NULL)\
-//  	{\
-//		if (nActualItems == 0 || pBuf[nActualItems - 1].m_nCharPos <= (pos)){\
-//		pBuf[nActualItems].m_nCharPos = (pos);\
-//		pBuf[nActualItems].m_nColorIndex = (colorindex);\
-//		nActualItems ++;}\
-//  	}
-//
-//#define COOKIE_COMMENT			0x0001
-//#define COOKIE_PREPROCESSOR		0x0002
-//#define COOKIE_EXT_COMMENT		0x0004
-//#define COOKIE_STRING			0x0008
-//#define COOKIE_CHAR				0x0010
-//
-//DWORD CSampleView::ParseLine(DWORD dwCookie, int nLineIndex, TEXTBLOCK *pBuf, int &nActualItems) {
-//  int nLength = GetLineLength(nLineIndex);
-//  if (nLength <= 0)
-//    return dwCookie & COOKIE_EXT_COMMENT;
-//
-//  LPCTSTR pszChars = GetLineChars(nLineIndex);
-//  bool bFirstChar = (dwCookie & ~COOKIE_EXT_COMMENT) == 0;
-//  bool bRedefineBlock = TRUE;
-//  bool bDecIndex = FALSE;
-//  int nIdentBegin = -1;
-//  for (int I = 0;; I++) {
-//    if (bRedefineBlock) {
-//      int nPos = I;
-//      if (bDecIndex)
-//        nPos--;
-//      if (dwCookie & (COOKIE_COMMENT | COOKIE_EXT_COMMENT)) {
-//        DEFINE_BLOCK(nPos, COLORINDEX_COMMENT);
-//      } else
-//        if (dwCookie & (COOKIE_CHAR | COOKIE_STRING)) {
-//          DEFINE_BLOCK(nPos, COLORINDEX_STRING);
-//        } else
-//          if (dwCookie & COOKIE_PREPROCESSOR) {
-//            DEFINE_BLOCK(nPos, COLORINDEX_PREPROCESSOR);
-//          } else {
-//            DEFINE_BLOCK(nPos, COLORINDEX_NORMALTEXT);
-//          }
-//        bRedefineBlock = FALSE;
-//        bDecIndex = FALSE;
-//    }
-//
-//    if (I == nLength)
-//      break;
-//
-//    if (dwCookie & COOKIE_COMMENT)  // ˫бעͣеĶע
-//    {
-//
-//      (I, COLORINDEX_COMMENT);
-//      dwCookie |= COOKIE_COMMENT;
-//      break;
-//    }
-//
-//    //	String constant "...."
-//    if (dwCookie & COOKIE_STRING) {
-//      if (pszChars[I] == '"' && (I == 0 || pszChars[I - 1] != '\\')) {
-//        dwCookie &= ~COOKIE_STRING; // cookie_stringԣ൱
-//        bRedefineBlock = TRUE;  // µblock
-//      }
-//      continue;
-//    }
-//
-//    //	Char constant '..'
-//    if (dwCookie & COOKIE_CHAR)  //  ͬ
-//    {
-//      if (pszChars[I] == '\'' && (I == 0 || pszChars[I - 1] != '\\')) {
-//        dwCookie &= ~COOKIE_CHAR;
-//        bRedefineBlock = TRUE;
-//      }
-//      continue;
-//    }
-//
-//    //	Extended comment /*....*/
-//    if (dwCookie & COOKIE_EXT_COMMENT)  // һ/*עͣ
-//    {
-//      if (I > 0 && pszChars[I] == '/' && pszChars[I - 1] == '*') // */עͣ¿block
-//      {
-//        dwCookie &= ~COOKIE_EXT_COMMENT;
-//        bRedefineBlock = TRUE;
-//      }
-//      continue;
-//    }
-//
-//    if (I > 0 && pszChars[I] == '/' && pszChars[I - 1] == '/')  // //жblock
-//    {                                                      //пԽΪ//ֱע͵Ķ
-//      DEFINE_BLOCK(I - 1, COLORINDEX_COMMENT);
-//      dwCookie |= COOKIE_COMMENT;
-//      break;
-//    }
-//
-//    //	Preprocessor directive #....
-//    if (dwCookie & COOKIE_PREPROCESSOR)  // һԤ/*ʱע͡
-//    {
-//      if (I > 0 && pszChars[I] == '*' && pszChars[I - 1] == '/') {
-//        DEFINE_BLOCK(I - 1, COLORINDEX_COMMENT);
-//        dwCookie |= COOKIE_EXT_COMMENT;
-//      }
-//      continue;
-//    }
-//
-//    //	Normal text
-//    if (pszChars[I] == '"') {
-//      DEFINE_BLOCK(I, COLORINDEX_STRING);
-//      dwCookie |= COOKIE_STRING;
-//      continue;
-//    }
-//    if (pszChars[I] == '\'') {
-//      DEFINE_BLOCK(I, COLORINDEX_STRING);
-//      dwCookie |= COOKIE_CHAR;
-//      continue;
-//    }
-//    if (I > 0 && pszChars[I] == '*' && pszChars[I - 1] == '/') {
-//      DEFINE_BLOCK(I - 1, COLORINDEX_COMMENT);
-//      dwCookie |= COOKIE_EXT_COMMENT;
-//      continue;
-//    }
-//
-//    if (bFirstChar) {
-//      if (pszChars[I] == '#') {
-//        DEFINE_BLOCK(I, COLORINDEX_PREPROCESSOR);
-//        dwCookie |= COOKIE_PREPROCESSOR;
-//        continue;
-//      }
-//      if (!isspace(pszChars[I]))
-//        bFirstChar = FALSE;
-//    }
-//
-//    if (pBuf == NULL)
-//      continue;	//	We don't need to extract keywords,
-//    //	for faster parsing skip the rest of loop
-//
-//    if (isalnum(pszChars[I]) || pszChars[I] == '_' || pszChars[I] == '.') {
-//      if (nIdentBegin == -1)
-//        nIdentBegin = I;
-//    } else {
-//      if (nIdentBegin >= 0) {
-//        if (IsCppKeyword(pszChars + nIdentBegin, I - nIdentBegin)) {
-//          DEFINE_BLOCK(nIdentBegin, COLORINDEX_KEYWORD);
-//        } else
-//          if (IsCppNumber(pszChars + nIdentBegin, I - nIdentBegin)) {
-//            DEFINE_BLOCK(nIdentBegin, COLORINDEX_NUMBER);
-//          }
-//        bRedefineBlock = TRUE;
-//        bDecIndex = TRUE;
-//        nIdentBegin = -1;
-//      }
-//    }
-//  }
-//
-//  if (nIdentBegin >= 0) {
-//    if (IsCppKeyword(pszChars + nIdentBegin, I - nIdentBegin)) {
-//      DEFINE_BLOCK(nIdentBegin, COLORINDEX_KEYWORD);
-//    } else
-//      if (IsCppNumber(pszChars + nIdentBegin, I - nIdentBegin)) {
-//        DEFINE_BLOCK(nIdentBegin, COLORINDEX_NUMBER);
-//      }
-//  }
-//
-//  if (pszChars[nLength - 1] != '\\')
-//    dwCookie &= COOKIE_EXT_COMMENT;
-//  return dwCookie;
-//}
-//
+// Sorted for a binary search.
+static const char* const kCppKeywords[] = {
+  "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor",
+  "bool", "break", "case", "catch", "char", "char16_t", "char32_t", "class",
+  "compl", "const", "const_cast", "constexpr", "continue", "decltype",
+  "default", "delete", "do", "double", "dynamic_cast", "else", "enum",
+  "explicit", "export", "extern", "false", "float", "for", "friend", "goto",
+  "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept",
+  "not", "not_eq", "nullptr", "operator", "or", "or_eq", "private",
+  "protected", "public", "register", "reinterpret_cast", "return", "short",
+  "signed", "sizeof", "static", "static_assert", "static_cast", "struct",
+  "switch", "template", "this", "thread_local", "throw", "true", "try",
+  "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual",
+  "void", "volatile", "wchar_t", "while", "xor", "xor_eq",
+};
+
+static const size_t kMaxKeywordLength = 16;
+
+static bool IsDigit(wxChar ch) {
+  return ch >= wxT('0') && ch <= wxT('9');
+}
+
+bool CppParser::IsIdentifierChar(wxChar ch) {
+  return (ch >= wxT('a') && ch <= wxT('z')) ||
+      (ch >= wxT('A') && ch <= wxT('Z')) ||
+      IsDigit(ch) ||
+      ch == wxT('_');
+}
+
+bool CppParser::IsKeyword(wxString::const_iterator begin, wxString::const_iterator end) {
+  char word[kMaxKeywordLength + 1];
+  size_t length = 0;
+  for (wxString::const_iterator it = begin; it != end; ++it) {
+    wxChar ch = *it;
+    if (length == kMaxKeywordLength || ch > 0x7F) {
+      return false;
+    }
+    word[length++] = static_cast<char>(ch);
+  }
+  word[length] = '\0';
+
+  size_t low = 0;
+  size_t high = sizeof(kCppKeywords) / sizeof(kCppKeywords[0]);
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    int result = strcmp(kCppKeywords[mid], word);
+    if (result == 0) {
+      return true;
+    }
+    if (result < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return false;
+}
+
+// A number takes the chars of an identifier and the dots, and a sign after
+// its exponent, e.g. 0x1Fu, 1.5e-3f.
+CppParser::State CppParser::ParseLine(const wxString& line, State state, std::vector<Token>* tokens) {
+  wxString::const_iterator it = line.begin();
+  int column = 0;
+  while (it != line.end()) {
+    wxChar ch = *it;
+    wxChar next_ch = it + 1 != line.end() ? *(it + 1) : 0;
+
+    if (state == STATE_BLOCK_COMMENT) {
+      if (ch == wxT('*') && next_ch == wxT('/')) {
+        ++it;
+        ++column;
+        state = STATE_NORMAL;
+      }
+      ++it;
+      ++column;
+      continue;
+    }
+
+    if (ch == wxT(' ') || ch == wxT('\t')) {
+      ++it;
+      ++column;
+      continue;
+    }
+    if (ch == wxT('/') && next_ch == wxT('/')) {
+      break;
+    }
+    if (ch == wxT('/') && next_ch == wxT('*')) {
+      it += 2;
+      column += 2;
+      state = STATE_BLOCK_COMMENT;
+      continue;
+    }
+
+    Token token = { TOKEN_PUNCTUATION, column, 1 };
+    wxString::const_iterator begin = it;
+    if (IsDigit(ch) || (ch == wxT('.') && IsDigit(next_ch))) {
+      token.kind = TOKEN_NUMBER;
+      wxChar prev_ch = 0;
+      for (; it != line.end(); ++it, ++column) {
+        wxChar c = *it;
+        bool is_sign = (c == wxT('+') || c == wxT('-')) &&
+            (prev_ch == wxT('e') || prev_ch == wxT('E') || prev_ch == wxT('p') || prev_ch == wxT('P'));
+        if (!IsIdentifierChar(c) && c != wxT('.') && !is_sign) {
+          break;
+        }
+        prev_ch = c;
+      }
+    } else if (IsIdentifierChar(ch)) {
+      for (; it != line.end() && IsIdentifierChar(*it); ++it, ++column) {
+      }
+      token.kind = IsKeyword(begin, it) ? TOKEN_KEYWORD : TOKEN_IDENTIFIER;
+    } else if (ch == wxT('"') || ch == wxT('\'')) {
+      token.kind = TOKEN_STRING;
+      ++it;
+      ++column;
+      while (it != line.end()) {
+        wxChar c = *it;
+        ++it;
+        ++column;
+        if (c == ch) {
+          break;
+        }
+        if (c == wxT('\\') && it != line.end()) {
+          ++it;
+          ++column;
+        }
+      }
+    } else {
+      ++it;
+      ++column;
+    }
+    token.length = column - token.column;
+    tokens->push_back(token);
+  }
+  return state;
+}
+
+}  // namespace syntax
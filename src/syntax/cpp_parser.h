@@ -2,13 +2,44 @@
 #define SYNTAX_CPP_PARSER_H_
 #pragma once
 
+#include <vector>
+#include "wx/string.h"
+
 namespace syntax {
 
+enum TokenKind {
+  TOKEN_IDENTIFIER = 0,
+  TOKEN_KEYWORD,
+  TOKEN_NUMBER,
+  TOKEN_STRING,  // a string or a char literal, with its quotes
+  TOKEN_PUNCTUATION,  // a single char
+};
+
+struct Token {
+  TokenKind kind;
+  int column;
+  int length;
+};
+
+// A lexer of C++ lines. Spaces and comments are skipped. A line is lexed
+// with only the state the line before it leaves, so a changed line is lexed
+// again on its own unless the state it leaves changes too. A string ends at
+// the end of its line.
 class CppParser {
 public:
- // int ParseLine();
+  enum State {
+    STATE_NORMAL = 0,
+    STATE_BLOCK_COMMENT,  // in a /* */ comment
+  };
+
+  // Append the tokens of the line to |tokens| and return the state it
+  // leaves.
+  static State ParseLine(const wxString& line, State state, std::vector<Token>* tokens);
+
+  static bool IsIdentifierChar(wxChar ch);
+  static bool IsKeyword(wxString::const_iterator begin, wxString::const_iterator end);
 };
 
-}  // namespace editor
+}  // namespace syntax
 
 #endif  // SYNTAX_CPP_PARSER_H_